@@ -0,0 +1,205 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KALMAN_FILTER__KALMAN_FILTER_T_HPP_
+#define KALMAN_FILTER__KALMAN_FILTER_T_HPP_
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/LU>
+
+/**
+ * @file kalman_filter_t.hpp
+ * @brief kalman filter class with the dimensions known at compile time
+ */
+
+/**
+ * @brief Kalman filter with fixed-size matrices, which does not allocate memory in predict and
+ * update. The interface follows KalmanFilter, and the covariance is updated in Joseph form and
+ * symmetrized to stay symmetric and positive semi-definite.
+ * @tparam StateDim dimension of the state x
+ * @tparam MeasDim dimension of the measurement y of the measurement model set by setC and setR.
+ * Measurements of other dimensions can be given to update with their own C and R.
+ */
+template <int StateDim, int MeasDim>
+class KalmanFilterT
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  using StateVector = Eigen::Matrix<double, StateDim, 1>;
+  using StateMatrix = Eigen::Matrix<double, StateDim, StateDim>;
+  template <int Dim>
+  using MeasurementVector = Eigen::Matrix<double, Dim, 1>;
+  template <int Dim>
+  using MeasurementMatrix = Eigen::Matrix<double, Dim, StateDim>;
+  template <int Dim>
+  using MeasurementCovariance = Eigen::Matrix<double, Dim, Dim>;
+
+  /**
+   * @brief No initialization constructor.
+   */
+  KalmanFilterT()
+  : x_(StateVector::Zero()),
+    A_(StateMatrix::Identity()),
+    Q_(StateMatrix::Zero()),
+    C_(MeasurementMatrix<MeasDim>::Zero()),
+    R_(MeasurementCovariance<MeasDim>::Zero()),
+    P_(StateMatrix::Identity())
+  {
+  }
+
+  /**
+   * @brief initialization of kalman filter
+   * @param x initial state
+   * @param P initial covariance of estimated state
+   */
+  void init(const StateVector & x, const StateMatrix & P)
+  {
+    x_ = x;
+    P_ = P;
+  }
+
+  /**
+   * @brief set A of process model
+   * @param A coefficient matrix of x for process model
+   */
+  void setA(const StateMatrix & A) { A_ = A; }
+
+  /**
+   * @brief set covariance matrix Q for process model
+   * @param Q covariance matrix for process model
+   */
+  void setQ(const StateMatrix & Q) { Q_ = Q; }
+
+  /**
+   * @brief set C of measurement model
+   * @param C coefficient matrix of x for measurement model
+   */
+  void setC(const MeasurementMatrix<MeasDim> & C) { C_ = C; }
+
+  /**
+   * @brief set covariance matrix R for measurement model
+   * @param R covariance matrix for measurement model
+   */
+  void setR(const MeasurementCovariance<MeasDim> & R) { R_ = R; }
+
+  /**
+   * @brief get current kalman filter state
+   */
+  const StateVector & getX() const { return x_; }
+
+  /**
+   * @brief get current kalman filter covariance
+   */
+  const StateMatrix & getP() const { return P_; }
+
+  /**
+   * @brief get component of current kalman filter state
+   * @param i index of kalman filter state
+   * @return value of i's component of the kalman filter state x[i]
+   */
+  double getXelement(unsigned int i) const { return x_(i); }
+
+  /**
+   * @brief calculate kalman filter covariance with prediction model with x, A, Q matrix. This is
+   * mainly for EKF with variable matrix.
+   * @param x_next predicted state
+   * @param A coefficient matrix of x for process model
+   * @param Q covariance matrix for process model
+   */
+  void predict(const StateVector & x_next, const StateMatrix & A, const StateMatrix & Q)
+  {
+    x_ = x_next;
+    P_ = A * P_ * A.transpose() + Q;
+  }
+
+  /**
+   * @brief calculate kalman filter covariance with prediction model with x, A matrix, and Q being
+   * class member variable.
+   * @param x_next predicted state
+   * @param A coefficient matrix of x for process model
+   */
+  void predict(const StateVector & x_next, const StateMatrix & A) { predict(x_next, A, Q_); }
+
+  /**
+   * @brief calculate kalman filter state by prediction model with A and Q being class member
+   * variables.
+   */
+  void predict() { predict(A_ * x_, A_, Q_); }
+
+  /**
+   * @brief calculate kalman filter state by measurement model with y_pred, C and R matrix. This is
+   * mainly for EKF with variable matrix.
+   * @param y measured values
+   * @param y_pred output values expected from measurement model
+   * @param C coefficient matrix of x for measurement model
+   * @param R covariance matrix for measurement model
+   * @return false if the innovation covariance is not invertible, and the filter is not updated
+   */
+  template <int Dim>
+  bool update(
+    const MeasurementVector<Dim> & y, const MeasurementVector<Dim> & y_pred,
+    const MeasurementMatrix<Dim> & C, const MeasurementCovariance<Dim> & R)
+  {
+    const Eigen::Matrix<double, StateDim, Dim> PCT = P_ * C.transpose();
+    const MeasurementCovariance<Dim> S = C * PCT + R;
+    const Eigen::Matrix<double, StateDim, Dim> K = PCT * S.inverse();
+    if (!K.allFinite()) {
+      return false;
+    }
+
+    // Joseph form: P = (I - K C) P (I - K C)^T + K R K^T, whose products are symmetric only up to
+    // the rounding
+    const StateMatrix I_KC = StateMatrix::Identity() - K * C;
+    x_ += K * (y - y_pred);
+    const StateMatrix P = I_KC * P_ * I_KC.transpose() + K * R * K.transpose();
+    P_ = 0.5 * (P + P.transpose());
+    return true;
+  }
+
+  /**
+   * @brief calculate kalman filter state by measurement model with C and R matrix. This is mainly
+   * for EKF with variable matrix.
+   * @param y measured values
+   * @param C coefficient matrix of x for measurement model
+   * @param R covariance matrix for measurement model
+   * @return false if the innovation covariance is not invertible, and the filter is not updated
+   */
+  template <int Dim>
+  bool update(
+    const MeasurementVector<Dim> & y, const MeasurementMatrix<Dim> & C,
+    const MeasurementCovariance<Dim> & R)
+  {
+    const MeasurementVector<Dim> y_pred = C * x_;
+    return update<Dim>(y, y_pred, C, R);
+  }
+
+  /**
+   * @brief calculate kalman filter state by measurement model with C and R being class member
+   * variables.
+   * @param y measured values
+   * @return false if the innovation covariance is not invertible, and the filter is not updated
+   */
+  bool update(const MeasurementVector<MeasDim> & y) { return update<MeasDim>(y, C_, R_); }
+
+protected:
+  StateVector x_;  //!< @brief current estimated state
+  StateMatrix A_;  //!< @brief coefficient matrix of x for process model x[k+1] = A*x[k]
+  StateMatrix Q_;  //!< @brief covariance matrix for process model x[k+1] = A*x[k]
+  MeasurementMatrix<MeasDim> C_;  //!< @brief coefficient matrix of x for measurement model
+  MeasurementCovariance<MeasDim> R_;  //!< @brief covariance matrix for measurement model
+  StateMatrix P_;                     //!< @brief covariance of estimated state
+};
+
+#endif  // KALMAN_FILTER__KALMAN_FILTER_T_HPP_
@@ -46,6 +46,25 @@ public:
    */
   void init(const Eigen::MatrixXd & x, const Eigen::MatrixXd & P, const int max_delay_step);
 
+  /**
+   * @brief get the extended state, from the latest time to the oldest one
+   * @param x extended state
+   */
+  void getX(Eigen::MatrixXd & x);
+
+  /**
+   * @brief get the covariance of the extended state, from the latest time to the oldest one
+   * @param P covariance of the extended state
+   */
+  void getP(Eigen::MatrixXd & P);
+
+  /**
+   * @brief get component of the extended state
+   * @param i index of the extended state, i.e. delay_step * dim_x + index of latest state
+   * @return value of i's component of the extended state
+   */
+  double getXelement(unsigned int i);
+
   /**
    * @brief get latest time estimated state
    * @param x latest time estimated state
@@ -81,8 +100,31 @@ public:
     const int delay_step);
 
 private:
+  /**
+   * @brief index of the first row of a delay step in x_ and P_
+   * @param delay_step delay step, 0 for the latest time
+   */
+  int getOffset(const int delay_step) const
+  {
+    return ((latest_step_ + delay_step) % max_delay_step_) * dim_x_;
+  }
+
   int max_delay_step_;  //!< @brief maximum number of delay steps
   int dim_x_;           //!< @brief dimension of latest state
   int dim_x_ex_;        //!< @brief dimension of extended state with dime delay
+
+  /**
+   * @brief the steps are stored in x_ and P_ as a ring buffer of blocks, and the latest one is the
+   * block latest_step_. The prediction only overwrites the blocks of the oldest step, instead of
+   * shifting the whole covariance.
+   */
+  int latest_step_;
+
+  // buffers kept across the calls
+  Eigen::MatrixXd AP_;   //!< @brief A * (row blocks of latest step of P)
+  Eigen::MatrixXd PAT_;  //!< @brief (column blocks of latest step of P) * A'
+  Eigen::MatrixXd PCT_;  //!< @brief P * C_ex'
+  Eigen::MatrixXd CP_;   //!< @brief C_ex * P
+  Eigen::MatrixXd K_;    //!< @brief kalman gain
 };
 #endif  // KALMAN_FILTER__TIME_DELAY_KALMAN_FILTER_HPP_
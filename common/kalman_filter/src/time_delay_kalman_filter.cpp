@@ -22,6 +22,7 @@ void TimeDelayKalmanFilter::init(
   max_delay_step_ = max_delay_step;
   dim_x_ = x.rows();
   dim_x_ex_ = dim_x_ * max_delay_step;
+  latest_step_ = 0;
 
   x_ = Eigen::MatrixXd::Zero(dim_x_ex_, 1);
   P_ = Eigen::MatrixXd::Zero(dim_x_ex_, dim_x_ex_);
@@ -32,8 +33,35 @@ void TimeDelayKalmanFilter::init(
   }
 }
 
-void TimeDelayKalmanFilter::getLatestX(Eigen::MatrixXd & x) { x = x_.block(0, 0, dim_x_, 1); }
-void TimeDelayKalmanFilter::getLatestP(Eigen::MatrixXd & P) { P = P_.block(0, 0, dim_x_, dim_x_); }
+void TimeDelayKalmanFilter::getX(Eigen::MatrixXd & x)
+{
+  x.resize(dim_x_ex_, 1);
+  for (int i = 0; i < max_delay_step_; ++i) {
+    x.block(i * dim_x_, 0, dim_x_, 1) = x_.block(getOffset(i), 0, dim_x_, 1);
+  }
+}
+void TimeDelayKalmanFilter::getP(Eigen::MatrixXd & P)
+{
+  P.resize(dim_x_ex_, dim_x_ex_);
+  for (int i = 0; i < max_delay_step_; ++i) {
+    for (int j = 0; j < max_delay_step_; ++j) {
+      P.block(i * dim_x_, j * dim_x_, dim_x_, dim_x_) =
+        P_.block(getOffset(i), getOffset(j), dim_x_, dim_x_);
+    }
+  }
+}
+double TimeDelayKalmanFilter::getXelement(unsigned int i)
+{
+  return x_(getOffset(i / dim_x_) + i % dim_x_);
+}
+void TimeDelayKalmanFilter::getLatestX(Eigen::MatrixXd & x)
+{
+  x = x_.block(getOffset(0), 0, dim_x_, 1);
+}
+void TimeDelayKalmanFilter::getLatestP(Eigen::MatrixXd & P)
+{
+  P = P_.block(getOffset(0), getOffset(0), dim_x_, dim_x_);
+}
 
 bool TimeDelayKalmanFilter::predictWithDelay(
   const Eigen::MatrixXd & x_next, const Eigen::MatrixXd & A, const Eigen::MatrixXd & Q)
@@ -50,23 +78,26 @@ bool TimeDelayKalmanFilter::predictWithDelay(
    *     [A*P11*A'*+Q  A*P11  A*P12]
    * P = [     P11*A'    P11    P12]
    *     [     P21*A'    P21    P22]
+   *
+   * Only the first row and column of blocks are new. They are written in the blocks of the oldest
+   * step, which becomes the latest one, and the other blocks stay where they are.
    */
 
-  const int d_dim_x = dim_x_ex_ - dim_x_;
+  const int prev_offset = getOffset(0);
+  latest_step_ = (latest_step_ + max_delay_step_ - 1) % max_delay_step_;
+  const int offset = getOffset(0);
 
   /* slide states in the time direction */
-  Eigen::MatrixXd x_tmp = Eigen::MatrixXd::Zero(dim_x_ex_, 1);
-  x_tmp.block(0, 0, dim_x_, 1) = x_next;
-  x_tmp.block(dim_x_, 0, d_dim_x, 1) = x_.block(0, 0, d_dim_x, 1);
-  x_ = x_tmp;
+  x_.block(offset, 0, dim_x_, 1) = x_next;
 
   /* update P with delayed measurement A matrix structure */
-  Eigen::MatrixXd P_tmp = Eigen::MatrixXd::Zero(dim_x_ex_, dim_x_ex_);
-  P_tmp.block(0, 0, dim_x_, dim_x_) = A * P_.block(0, 0, dim_x_, dim_x_) * A.transpose() + Q;
-  P_tmp.block(0, dim_x_, dim_x_, d_dim_x) = A * P_.block(0, 0, dim_x_, d_dim_x);
-  P_tmp.block(dim_x_, 0, d_dim_x, dim_x_) = P_.block(0, 0, d_dim_x, dim_x_) * A.transpose();
-  P_tmp.block(dim_x_, dim_x_, d_dim_x, d_dim_x) = P_.block(0, 0, d_dim_x, d_dim_x);
-  P_ = P_tmp;
+  AP_.noalias() = A * P_.block(prev_offset, 0, dim_x_, dim_x_ex_);
+  PAT_.noalias() = P_.block(0, prev_offset, dim_x_ex_, dim_x_) * A.transpose();
+  const Eigen::MatrixXd P11 =
+    A * P_.block(prev_offset, prev_offset, dim_x_, dim_x_) * A.transpose() + Q;
+  P_.block(offset, 0, dim_x_, dim_x_ex_) = AP_;
+  P_.block(0, offset, dim_x_ex_, dim_x_) = PAT_;
+  P_.block(offset, offset, dim_x_, dim_x_) = P11;
 
   return true;
 }
@@ -79,17 +110,28 @@ bool TimeDelayKalmanFilter::updateWithDelay(
     std::cerr << "delay step is larger than max_delay_step. ignore update." << std::endl;
     return false;
   }
+  if (
+    C.cols() != dim_x_ || R.rows() != R.cols() || R.rows() != C.rows() || y.rows() != C.rows()) {
+    return false;
+  }
 
-  const int dim_y = y.rows();
-
-  /* set measurement matrix */
-  Eigen::MatrixXd C_ex = Eigen::MatrixXd::Zero(dim_y, dim_x_ex_);
-  C_ex.block(0, dim_x_ * delay_step, dim_y, dim_x_) = C;
+  /*
+   * The measurement matrix C_ex = [0 ... C ... 0] only refers to the state of delay_step, so
+   * P * C_ex' and C_ex * P are computed from its columns and rows of P.
+   */
+  const int offset = getOffset(delay_step);
+  PCT_.noalias() = P_.block(0, offset, dim_x_ex_, dim_x_) * C.transpose();
+  const Eigen::MatrixXd S = R + C * PCT_.block(offset, 0, dim_x_, PCT_.cols());
+  K_.noalias() = PCT_ * S.inverse();
 
-  /* update */
-  if (!update(y, C_ex, R)) {
+  if (isnan(K_.array()).any() || isinf(K_.array()).any()) {
     return false;
   }
 
+  const Eigen::MatrixXd y_pred = C * x_.block(offset, 0, dim_x_, 1);
+  x_.noalias() += K_ * (y - y_pred);
+  CP_.noalias() = C * P_.block(offset, 0, dim_x_, dim_x_ex_);
+  P_.noalias() -= K_ * CP_;
+
   return true;
 }
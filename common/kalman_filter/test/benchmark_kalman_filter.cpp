@@ -0,0 +1,129 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "kalman_filter/kalman_filter.hpp"
+#include "kalman_filter/kalman_filter_t.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int dim_x = 5;  // x, y, yaw, vx, wz as in the vehicle trackers
+constexpr int dim_y = 3;  // x, y, yaw
+
+struct Step
+{
+  Eigen::Matrix<double, dim_x, 1> x_next;
+  Eigen::Matrix<double, dim_x, dim_x> A;
+  Eigen::Matrix<double, dim_y, 1> y;
+};
+
+// linearized constant turn rate model, as predicted by the trackers
+std::vector<Step> createSteps(const int num_steps)
+{
+  std::mt19937 engine(0);
+  std::normal_distribution<double> noise(0.0, 0.1);
+  constexpr double dt = 0.1;
+  std::vector<Step> steps(num_steps);
+  Eigen::Matrix<double, dim_x, 1> x;
+  x << 0.0, 0.0, 0.0, 5.0, 0.1;
+  for (auto & step : steps) {
+    const double cos_yaw = std::cos(x(2));
+    const double sin_yaw = std::sin(x(2));
+    step.A.setIdentity();
+    step.A(0, 2) = -x(3) * sin_yaw * dt;
+    step.A(0, 3) = cos_yaw * dt;
+    step.A(1, 2) = x(3) * cos_yaw * dt;
+    step.A(1, 3) = sin_yaw * dt;
+    step.A(2, 4) = dt;
+    x(0) += x(3) * cos_yaw * dt;
+    x(1) += x(3) * sin_yaw * dt;
+    x(2) += x(4) * dt;
+    step.x_next = x;
+    step.y << x(0) + noise(engine), x(1) + noise(engine), x(2) + 0.1 * noise(engine);
+  }
+  return steps;
+}
+}  // namespace
+
+int main()
+{
+  constexpr int num_steps = 1000;
+  constexpr int num_repetitions = 200;
+  const auto steps = createSteps(num_steps);
+
+  Eigen::Matrix<double, dim_x, dim_x> Q = Eigen::Matrix<double, dim_x, dim_x>::Identity() * 0.01;
+  Eigen::Matrix<double, dim_y, dim_x> C = Eigen::Matrix<double, dim_y, dim_x>::Zero();
+  C(0, 0) = C(1, 1) = C(2, 2) = 1.0;
+  Eigen::Matrix<double, dim_y, dim_y> R = Eigen::Matrix<double, dim_y, dim_y>::Identity() * 0.01;
+  Eigen::Matrix<double, dim_x, 1> x0 = steps.front().x_next;
+  Eigen::Matrix<double, dim_x, dim_x> P0 = Eigen::Matrix<double, dim_x, dim_x>::Identity();
+
+  // KalmanFilter with dynamic-size matrices, used as in the trackers
+  double dynamic_time_ms = 0.0;
+  Eigen::MatrixXd dynamic_x;
+  {
+    const Eigen::MatrixXd Q_dynamic = Q;
+    const Eigen::MatrixXd C_dynamic = C;
+    const Eigen::MatrixXd R_dynamic = R;
+    const auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < num_repetitions; ++repetition) {
+      KalmanFilter kf;
+      kf.init(Eigen::MatrixXd(x0), Eigen::MatrixXd(P0));
+      for (const auto & step : steps) {
+        kf.predict(Eigen::MatrixXd(step.x_next), Eigen::MatrixXd(step.A), Q_dynamic);
+        kf.update(Eigen::MatrixXd(step.y), C_dynamic, R_dynamic);
+      }
+      kf.getX(dynamic_x);
+    }
+    dynamic_time_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // KalmanFilterT with fixed-size matrices
+  double fixed_time_ms = 0.0;
+  Eigen::Matrix<double, dim_x, 1> fixed_x;
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < num_repetitions; ++repetition) {
+      KalmanFilterT<dim_x, dim_y> kf;
+      kf.init(x0, P0);
+      kf.setQ(Q);
+      kf.setC(C);
+      kf.setR(R);
+      for (const auto & step : steps) {
+        kf.predict(step.x_next, step.A);
+        kf.update(step.y);
+      }
+      fixed_x = kf.getX();
+    }
+    fixed_time_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  const int num_cycles = num_steps * num_repetitions;
+  std::cout << "predict + update cycles: " << num_cycles << std::endl;
+  std::cout << "KalmanFilter:  " << dynamic_time_ms << " ms (" << dynamic_time_ms * 1e6 / num_cycles
+            << " ns/cycle)" << std::endl;
+  std::cout << "KalmanFilterT: " << fixed_time_ms << " ms (" << fixed_time_ms * 1e6 / num_cycles
+            << " ns/cycle)" << std::endl;
+  std::cout << "max state difference: " << (dynamic_x - fixed_x).cwiseAbs().maxCoeff()
+            << std::endl;
+  return 0;
+}
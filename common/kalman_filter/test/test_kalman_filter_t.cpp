@@ -0,0 +1,182 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "kalman_filter/kalman_filter.hpp"
+#include "kalman_filter/kalman_filter_t.hpp"
+
+#include <eigen3/Eigen/Eigenvalues>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+constexpr int dim_x = 5;  // x, y, yaw, vx, wz as in the vehicle trackers
+constexpr int dim_y = 3;  // x, y, yaw
+
+using KF = KalmanFilterT<dim_x, dim_y>;
+
+// linearized constant turn rate model, as predicted by the trackers
+KF::StateMatrix getA(const KF::StateVector & x, const double dt)
+{
+  KF::StateMatrix A = KF::StateMatrix::Identity();
+  A(0, 2) = -x(3) * std::sin(x(2)) * dt;
+  A(0, 3) = std::cos(x(2)) * dt;
+  A(1, 2) = x(3) * std::cos(x(2)) * dt;
+  A(1, 3) = std::sin(x(2)) * dt;
+  A(2, 4) = dt;
+  return A;
+}
+
+KF::StateVector getNextX(const KF::StateVector & x, const double dt)
+{
+  KF::StateVector x_next = x;
+  x_next(0) += x(3) * std::cos(x(2)) * dt;
+  x_next(1) += x(3) * std::sin(x(2)) * dt;
+  x_next(2) += x(4) * dt;
+  return x_next;
+}
+
+double getRelativeError(const Eigen::MatrixXd & actual, const Eigen::MatrixXd & expected)
+{
+  return (actual - expected).norm() / expected.norm();
+}
+}  // namespace
+
+TEST(KalmanFilterT, MatchesKalmanFilter)
+{
+  std::mt19937 engine(0);
+  std::normal_distribution<double> noise(0.0, 0.1);
+  constexpr double dt = 0.1;
+
+  KF::StateVector x0;
+  x0 << 0.0, 0.0, 0.0, 5.0, 0.1;
+  const KF::StateMatrix P0 = KF::StateMatrix::Identity();
+  const KF::StateMatrix Q = KF::StateMatrix::Identity() * 0.01;
+  KF::MeasurementMatrix<dim_y> C = KF::MeasurementMatrix<dim_y>::Zero();
+  C(0, 0) = C(1, 1) = C(2, 2) = 1.0;
+  const KF::MeasurementCovariance<dim_y> R = KF::MeasurementCovariance<dim_y>::Identity() * 0.01;
+  // a velocity measurement, whose dimension is not the one of the filter
+  KF::MeasurementMatrix<1> C_velocity = KF::MeasurementMatrix<1>::Zero();
+  C_velocity(0, 3) = 1.0;
+  const KF::MeasurementCovariance<1> R_velocity = KF::MeasurementCovariance<1>::Constant(0.04);
+
+  KalmanFilter dynamic_kf;
+  dynamic_kf.init(Eigen::MatrixXd(x0), Eigen::MatrixXd(P0));
+  KF fixed_kf;
+  fixed_kf.init(x0, P0);
+  fixed_kf.setQ(Q);
+  fixed_kf.setC(C);
+  fixed_kf.setR(R);
+
+  KF::StateVector truth = x0;
+  for (int step = 0; step < 200; ++step) {
+    SCOPED_TRACE(step);
+    truth = getNextX(truth, dt);
+
+    const KF::StateVector x = fixed_kf.getX();
+    ASSERT_TRUE(dynamic_kf.predict(
+      Eigen::MatrixXd(getNextX(x, dt)), Eigen::MatrixXd(getA(x, dt)), Eigen::MatrixXd(Q)));
+    fixed_kf.predict(getNextX(x, dt), getA(x, dt));
+
+    KF::MeasurementVector<dim_y> y;
+    y << truth(0) + noise(engine), truth(1) + noise(engine), truth(2) + 0.1 * noise(engine);
+    ASSERT_TRUE(dynamic_kf.update(Eigen::MatrixXd(y), Eigen::MatrixXd(C), Eigen::MatrixXd(R)));
+    ASSERT_TRUE(fixed_kf.update(y));
+
+    if (step % 3 == 0) {
+      const KF::MeasurementVector<1> y_velocity =
+        KF::MeasurementVector<1>::Constant(truth(3) + 0.2 * noise(engine));
+      ASSERT_TRUE(dynamic_kf.update(
+        Eigen::MatrixXd(y_velocity), Eigen::MatrixXd(C_velocity), Eigen::MatrixXd(R_velocity)));
+      ASSERT_TRUE(fixed_kf.update<1>(y_velocity, C_velocity, R_velocity));
+    }
+
+    Eigen::MatrixXd dynamic_x;
+    Eigen::MatrixXd dynamic_P;
+    dynamic_kf.getX(dynamic_x);
+    dynamic_kf.getP(dynamic_P);
+    // the Joseph form is equal to P - K C P for the optimal gain, up to the rounding
+    EXPECT_LT(getRelativeError(fixed_kf.getX(), dynamic_x), 1e-9);
+    EXPECT_LT(getRelativeError(fixed_kf.getP(), dynamic_P), 1e-9);
+  }
+}
+
+TEST(KalmanFilterT, UpdatesCovarianceInJosephForm)
+{
+  std::mt19937 engine(1);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const KF::StateMatrix L = KF::StateMatrix::NullaryExpr([&]() { return uniform(engine); });
+  const KF::StateMatrix P0 = L * L.transpose() + KF::StateMatrix::Identity();
+  const KF::StateVector x0 = KF::StateVector::NullaryExpr([&]() { return uniform(engine); });
+  const KF::MeasurementMatrix<2> C =
+    KF::MeasurementMatrix<2>::NullaryExpr([&]() { return uniform(engine); });
+  const KF::MeasurementCovariance<2> R = KF::MeasurementCovariance<2>::Identity() * 0.1;
+  const KF::MeasurementVector<2> y(0.5, -0.2);
+  const KF::MeasurementVector<2> y_pred(0.1, 0.3);
+
+  KF kf;
+  kf.init(x0, P0);
+  ASSERT_TRUE(kf.update<2>(y, y_pred, C, R));
+
+  const Eigen::Matrix<double, dim_x, 2> K =
+    P0 * C.transpose() * (C * P0 * C.transpose() + R).inverse();
+  const KF::StateMatrix I_KC = KF::StateMatrix::Identity() - K * C;
+  const KF::StateMatrix P = I_KC * P0 * I_KC.transpose() + K * R * K.transpose();
+  EXPECT_LT(getRelativeError(kf.getX(), x0 + K * (y - y_pred)), 1e-12);
+  EXPECT_LT(getRelativeError(kf.getP(), P), 1e-12);
+}
+
+TEST(KalmanFilterT, CovarianceStaysSymmetricPositiveSemiDefinite)
+{
+  // precise measurements of a very uncertain state, where the rounding of the products is large
+  // compared to the updated covariance
+  KF kf;
+  kf.init(KF::StateVector::Zero(), KF::StateMatrix::Identity() * 1e6);
+  KF::MeasurementMatrix<dim_y> C = KF::MeasurementMatrix<dim_y>::Zero();
+  C(0, 0) = C(1, 1) = C(2, 2) = 1.0;
+  C(0, 3) = C(1, 4) = 0.5;
+  kf.setC(C);
+  kf.setR(KF::MeasurementCovariance<dim_y>::Identity() * 1e-6);
+  kf.setQ(KF::StateMatrix::Identity() * 1e-9);
+
+  for (int step = 0; step < 100; ++step) {
+    SCOPED_TRACE(step);
+    kf.predict(getNextX(kf.getX(), 0.1), getA(kf.getX(), 0.1));
+    ASSERT_TRUE(kf.update(KF::MeasurementVector<dim_y>::Constant(1.0)));
+
+    const KF::StateMatrix & P = kf.getP();
+    EXPECT_EQ(P, P.transpose());
+    const Eigen::SelfAdjointEigenSolver<KF::StateMatrix> solver(P);
+    EXPECT_GT(solver.eigenvalues().minCoeff(), 0.0);
+  }
+}
+
+TEST(KalmanFilterT, RejectsSingularInnovationCovariance)
+{
+  KF::StateVector x0;
+  x0 << 1.0, 2.0, 0.3, 4.0, 0.5;
+  const KF::StateMatrix P0 = KF::StateMatrix::Identity();
+  KF kf;
+  kf.init(x0, P0);
+
+  // nothing is measured and the measurement is exact, so that the innovation covariance is zero
+  EXPECT_FALSE(kf.update<2>(
+    KF::MeasurementVector<2>::Ones(), KF::MeasurementMatrix<2>::Zero(),
+    KF::MeasurementCovariance<2>::Zero()));
+  EXPECT_EQ(kf.getX(), x0);
+  EXPECT_EQ(kf.getP(), P0);
+}
@@ -0,0 +1,111 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TIER4_AUTOWARE_UTILS__ROS__LATENCY_TRACER_HPP_
+#define TIER4_AUTOWARE_UTILS__ROS__LATENCY_TRACER_HPP_
+
+#include "tier4_autoware_utils/system/span_recorder.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <tier4_debug_msgs/msg/float64_stamped.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace tier4_autoware_utils
+{
+/**
+ * @brief Trace the processing of sensor frames by a node.
+ *
+ * startSpan() records the processing in the SpanRecorder, keyed by the header stamp of the sensor
+ * frame. publishLatency() publishes the percentiles of the latency since the sensor stamp, i.e. the
+ * latency of the chain from the sensor up to the output of this node, on ~/debug/latency_p50_ms
+ * and ~/debug/latency_p99_ms.
+ * @code
+ * void callback(const PointCloud2::ConstSharedPtr msg)
+ * {
+ *   const auto span = latency_tracer_.startSpan(msg->header.stamp);
+ *   ...
+ *   pub_->publish(output);
+ *   latency_tracer_.publishLatency(msg->header.stamp);
+ * }
+ * @endcode
+ */
+class LatencyTracer
+{
+public:
+  LatencyTracer(rclcpp::Node * node, const std::string & span_name, const size_t window_size = 100)
+  : node_(node), span_name_(SpanRecorder::instance().intern(span_name)), window_size_(window_size)
+  {
+    pub_p50_ =
+      node_->create_publisher<tier4_debug_msgs::msg::Float64Stamped>("~/debug/latency_p50_ms", 1);
+    pub_p99_ =
+      node_->create_publisher<tier4_debug_msgs::msg::Float64Stamped>("~/debug/latency_p99_ms", 1);
+    latencies_ms_.reserve(window_size_);
+  }
+
+  ScopedSpan startSpan(const rclcpp::Time & stamp) const
+  {
+    return ScopedSpan(span_name_, stamp.nanoseconds());
+  }
+
+  void publishLatency(const rclcpp::Time & stamp)
+  {
+    const auto now = node_->now();
+    const double latency_ms = (now - stamp).seconds() * 1e3;
+    if (latencies_ms_.size() < window_size_) {
+      latencies_ms_.push_back(latency_ms);
+    } else {
+      latencies_ms_.at(next_index_) = latency_ms;
+    }
+    next_index_ = (next_index_ + 1) % window_size_;
+
+    sorted_latencies_ms_ = latencies_ms_;
+    pub_p50_->publish(toMsg(percentile(0.5), now));
+    pub_p99_->publish(toMsg(percentile(0.99), now));
+  }
+
+private:
+  rclcpp::Node * node_;
+  const char * span_name_;
+  const size_t window_size_;
+  size_t next_index_ = 0;
+  std::vector<double> latencies_ms_;
+  std::vector<double> sorted_latencies_ms_;
+
+  rclcpp::Publisher<tier4_debug_msgs::msg::Float64Stamped>::SharedPtr pub_p50_;
+  rclcpp::Publisher<tier4_debug_msgs::msg::Float64Stamped>::SharedPtr pub_p99_;
+
+  double percentile(const double ratio)
+  {
+    const auto n =
+      static_cast<size_t>(ratio * static_cast<double>(sorted_latencies_ms_.size() - 1));
+    std::nth_element(
+      sorted_latencies_ms_.begin(), sorted_latencies_ms_.begin() + n, sorted_latencies_ms_.end());
+    return sorted_latencies_ms_.at(n);
+  }
+
+  static tier4_debug_msgs::msg::Float64Stamped toMsg(const double data, const rclcpp::Time & stamp)
+  {
+    tier4_debug_msgs::msg::Float64Stamped msg;
+    msg.stamp = stamp;
+    msg.data = data;
+    return msg;
+  }
+};
+}  // namespace tier4_autoware_utils
+
+#endif  // TIER4_AUTOWARE_UTILS__ROS__LATENCY_TRACER_HPP_
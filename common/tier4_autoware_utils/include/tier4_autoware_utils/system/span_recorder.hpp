@@ -0,0 +1,164 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TIER4_AUTOWARE_UTILS__SYSTEM__SPAN_RECORDER_HPP_
+#define TIER4_AUTOWARE_UTILS__SYSTEM__SPAN_RECORDER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace tier4_autoware_utils
+{
+/**
+ * @brief A processing step of one sensor frame. The trace id is the header stamp of the sensor
+ * frame, which is kept by the messages derived from it, so that the spans of all the nodes which
+ * processed the same frame can be connected.
+ */
+struct Span
+{
+  /// Interned name, see SpanRecorder::intern()
+  const char * name = nullptr;
+  /// Header stamp of the sensor frame in nanoseconds
+  int64_t trace_id = 0;
+  /// Wall clock time in nanoseconds, so that the spans of different processes can be merged
+  int64_t begin_ns = 0;
+  int64_t end_ns = 0;
+  uint32_t thread_id = 0;
+};
+
+/**
+ * @brief Process-wide recorder of spans.
+ *
+ * Every thread records into its own single-producer single-consumer ring buffer, so recording
+ * never takes a lock. If a ring buffer is full, the span is dropped and counted.
+ *
+ * The recorder is disabled unless the environment variable TIER4_TRACE_FILE is set, in which case
+ * the spans are written every second to "<TIER4_TRACE_FILE>.<pid>.json" in the Chrome trace event
+ * format, which can be opened in Perfetto or chrome://tracing. Every event is written on its own
+ * line after the opening "[" line, so that the files of several processes are merged by keeping
+ * the event lines of all of them after a single "[".
+ */
+class SpanRecorder
+{
+public:
+  static constexpr size_t ring_capacity = 4096;
+
+  static SpanRecorder & instance();
+
+  ~SpanRecorder();
+  SpanRecorder(const SpanRecorder &) = delete;
+  SpanRecorder & operator=(const SpanRecorder &) = delete;
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void setEnabled(const bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+  /// Return a pointer to a copy of name which lives as long as the process
+  const char * intern(const std::string & name);
+
+  /// Record a span from the calling thread
+  void record(const Span & span);
+
+  /// Move all the recorded spans into spans, return the number of moved spans
+  size_t drain(std::vector<Span> & spans);
+
+  /// Number of spans dropped because a ring buffer was full
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /// Write spans as Chrome trace complete events, each one followed by a comma
+  static void writeChromeTrace(std::ostream & os, const std::vector<Span> & spans);
+
+  static int64_t nowNs()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+  }
+
+private:
+  class Ring;
+
+  SpanRecorder();
+
+  Ring & localRing();
+  void runWriter();
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint64_t> dropped_{0};
+
+  std::mutex names_mutex_;
+  std::unordered_set<std::string> names_;
+
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  uint32_t next_thread_id_ = 0;
+
+  std::mutex drain_mutex_;
+
+  std::ofstream trace_file_;
+  bool stop_writer_ = false;
+  std::mutex writer_mutex_;
+  std::condition_variable writer_cv_;
+  std::thread writer_;
+};
+
+/**
+ * @brief Record the span from its construction to its destruction.
+ * @code
+ * ScopedSpan span(span_name_, msg->header.stamp);
+ * @endcode
+ */
+class ScopedSpan
+{
+public:
+  /// @param name interned name, see SpanRecorder::intern()
+  /// @param trace_id header stamp of the sensor frame in nanoseconds
+  ScopedSpan(const char * name, const int64_t trace_id)
+  : recorder_(SpanRecorder::instance()), enabled_(recorder_.enabled())
+  {
+    if (enabled_) {
+      span_.name = name;
+      span_.trace_id = trace_id;
+      span_.begin_ns = SpanRecorder::nowNs();
+    }
+  }
+
+  ~ScopedSpan()
+  {
+    if (enabled_) {
+      span_.end_ns = SpanRecorder::nowNs();
+      recorder_.record(span_);
+    }
+  }
+
+  ScopedSpan(const ScopedSpan &) = delete;
+  ScopedSpan & operator=(const ScopedSpan &) = delete;
+
+private:
+  SpanRecorder & recorder_;
+  const bool enabled_;
+  Span span_;
+};
+}  // namespace tier4_autoware_utils
+
+#endif  // TIER4_AUTOWARE_UTILS__SYSTEM__SPAN_RECORDER_HPP_
@@ -0,0 +1,182 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tier4_autoware_utils/system/span_recorder.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace tier4_autoware_utils
+{
+/// Single-producer single-consumer ring buffer, the producer is the thread owning it
+class SpanRecorder::Ring
+{
+public:
+  explicit Ring(const uint32_t thread_id) : thread_id_(thread_id) {}
+
+  uint32_t threadId() const { return thread_id_; }
+
+  bool push(const Span & span)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == ring_capacity) {
+      return false;
+    }
+    buffer_[head % ring_capacity] = span;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t popAll(std::vector<Span> & spans)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    for (size_t i = tail; i != head; ++i) {
+      spans.push_back(buffer_[i % ring_capacity]);
+    }
+    tail_.store(head, std::memory_order_release);
+    return head - tail;
+  }
+
+private:
+  const uint32_t thread_id_;
+  std::array<Span, ring_capacity> buffer_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+SpanRecorder & SpanRecorder::instance()
+{
+  static SpanRecorder recorder;
+  return recorder;
+}
+
+SpanRecorder::SpanRecorder()
+{
+  const char * trace_file = std::getenv("TIER4_TRACE_FILE");
+  if (trace_file == nullptr || std::string(trace_file).empty()) {
+    return;
+  }
+
+  trace_file_.open(std::string(trace_file) + "." + std::to_string(getpid()) + ".json");
+  if (!trace_file_) {
+    return;
+  }
+  // the closing bracket is optional in the Chrome trace format, which allows to append forever
+  trace_file_ << "[\n";
+  enabled_ = true;
+  writer_ = std::thread(&SpanRecorder::runWriter, this);
+}
+
+SpanRecorder::~SpanRecorder()
+{
+  if (writer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(writer_mutex_);
+      stop_writer_ = true;
+    }
+    writer_cv_.notify_one();
+    writer_.join();
+  }
+}
+
+const char * SpanRecorder::intern(const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(names_mutex_);
+  // the elements of an unordered_set are never moved
+  return names_.insert(name).first->c_str();
+}
+
+SpanRecorder::Ring & SpanRecorder::localRing()
+{
+  thread_local std::shared_ptr<Ring> ring;
+  if (!ring) {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    ring = std::make_shared<Ring>(next_thread_id_++);
+    rings_.push_back(ring);
+  }
+  return *ring;
+}
+
+void SpanRecorder::record(const Span & span)
+{
+  auto & ring = localRing();
+  Span thread_span = span;
+  thread_span.thread_id = ring.threadId();
+  if (!ring.push(thread_span)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+size_t SpanRecorder::drain(std::vector<Span> & spans)
+{
+  std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings = rings_;
+  }
+
+  size_t num_spans = 0;
+  for (const auto & ring : rings) {
+    num_spans += ring->popAll(spans);
+  }
+
+  // forget the rings of the threads which have exited, now that they are empty
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings.clear();
+    rings_.erase(
+      std::remove_if(
+        rings_.begin(), rings_.end(), [](const auto & ring) { return ring.use_count() == 1; }),
+      rings_.end());
+  }
+  return num_spans;
+}
+
+void SpanRecorder::writeChromeTrace(std::ostream & os, const std::vector<Span> & spans)
+{
+  const auto pid = getpid();
+  for (const auto & span : spans) {
+    // complete events, with times in microseconds
+    os << R"({"name":")" << (span.name ? span.name : "") << R"(","ph":"X","pid":)" << pid
+       << R"(,"tid":)" << span.thread_id << R"(,"ts":)" << span.begin_ns / 1000 << "."
+       << std::to_string(1000 + span.begin_ns % 1000).substr(1) << R"(,"dur":)"
+       << (span.end_ns - span.begin_ns) / 1000.0 << R"(,"args":{"trace_id":)" << span.trace_id
+       << "}},\n";
+  }
+}
+
+void SpanRecorder::runWriter()
+{
+  std::vector<Span> spans;
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  while (true) {
+    const bool stop =
+      writer_cv_.wait_for(lock, std::chrono::seconds(1), [this] { return stop_writer_; });
+    spans.clear();
+    drain(spans);
+    writeChromeTrace(trace_file_, spans);
+    trace_file_.flush();
+    if (stop) {
+      return;
+    }
+  }
+}
+}  // namespace tier4_autoware_utils
@@ -0,0 +1,113 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tier4_autoware_utils/system/span_recorder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(system, SpanRecorder_record)
+{
+  using tier4_autoware_utils::ScopedSpan;
+  using tier4_autoware_utils::Span;
+  using tier4_autoware_utils::SpanRecorder;
+
+  auto & recorder = SpanRecorder::instance();
+  recorder.setEnabled(true);
+  std::vector<Span> spans;
+  recorder.drain(spans);
+  spans.clear();
+
+  const char * name = recorder.intern("test_span");
+  EXPECT_EQ(name, recorder.intern("test_span"));
+
+  constexpr int num_threads = 4;
+  constexpr int num_spans_per_thread = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([name]() {
+      for (int i = 0; i < num_spans_per_thread; ++i) {
+        ScopedSpan span(name, i);
+      }
+    });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(recorder.drain(spans), static_cast<size_t>(num_threads * num_spans_per_thread));
+  ASSERT_EQ(spans.size(), static_cast<size_t>(num_threads * num_spans_per_thread));
+  for (const auto & span : spans) {
+    EXPECT_EQ(span.name, name);
+    EXPECT_LE(span.begin_ns, span.end_ns);
+  }
+
+  // nothing is left once drained
+  spans.clear();
+  EXPECT_EQ(recorder.drain(spans), 0U);
+
+  // disabled spans are not recorded
+  recorder.setEnabled(false);
+  {
+    ScopedSpan span(name, 0);
+  }
+  EXPECT_EQ(recorder.drain(spans), 0U);
+}
+
+TEST(system, SpanRecorder_overflow)
+{
+  using tier4_autoware_utils::Span;
+  using tier4_autoware_utils::SpanRecorder;
+
+  auto & recorder = SpanRecorder::instance();
+  std::vector<Span> spans;
+  recorder.drain(spans);
+  spans.clear();
+
+  const auto dropped = recorder.dropped();
+  Span span;
+  span.name = recorder.intern("overflow");
+  for (size_t i = 0; i < SpanRecorder::ring_capacity + 10; ++i) {
+    recorder.record(span);
+  }
+  EXPECT_EQ(recorder.dropped() - dropped, 10U);
+  EXPECT_EQ(recorder.drain(spans), SpanRecorder::ring_capacity);
+}
+
+TEST(system, SpanRecorder_writeChromeTrace)
+{
+  using tier4_autoware_utils::Span;
+  using tier4_autoware_utils::SpanRecorder;
+
+  Span span;
+  span.name = "stage";
+  span.trace_id = 42;
+  span.begin_ns = 1000002000;
+  span.end_ns = 1000005500;
+  span.thread_id = 3;
+
+  std::ostringstream oss;
+  SpanRecorder::writeChromeTrace(oss, {span});
+  const auto trace = oss.str();
+  EXPECT_NE(trace.find(R"("name":"stage")"), std::string::npos);
+  EXPECT_NE(trace.find(R"("ph":"X")"), std::string::npos);
+  EXPECT_NE(trace.find(R"("tid":3)"), std::string::npos);
+  EXPECT_NE(trace.find(R"("ts":1000002.000)"), std::string::npos);
+  EXPECT_NE(trace.find(R"("dur":3.5)"), std::string::npos);
+  EXPECT_NE(trace.find(R"("trace_id":42)"), std::string::npos);
+}
@@ -20,6 +20,7 @@
 #include <pcl/point_types.h>
 #include <pcl/search/kdtree.h>
 
+#include <memory>
 #include <vector>
 
 template <class PointSource, class PointTarget>
@@ -29,6 +30,10 @@ public:
   NormalDistributionsTransformBase();
   virtual ~NormalDistributionsTransformBase() = default;
 
+  // copy which aligns independently of this instance, also in another thread, sharing the target
+  // pointcloud and the search tree instead of building them again
+  virtual std::shared_ptr<NormalDistributionsTransformBase> clone() const = 0;
+
   virtual void align(pcl::PointCloud<PointSource> & output, const Eigen::Matrix4f & guess) = 0;
   virtual void setInputTarget(const pcl::shared_ptr<pcl::PointCloud<PointTarget>> & map_ptr) = 0;
   virtual void setInputSource(const pcl::shared_ptr<pcl::PointCloud<PointSource>> & scan_ptr) = 0;
@@ -0,0 +1,971 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NDT__IMPL__NATIVE_HPP_
+#define NDT__IMPL__NATIVE_HPP_
+
+#include "ndt/native.hpp"
+
+#include <Eigen/Geometry>
+#include <Eigen/SVD>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+template <class PointSource, class PointTarget>
+NormalDistributionsTransformNative<PointSource, PointTarget>::NormalDistributionsTransformNative()
+: max_iterations_(35),
+  resolution_(1.0f),
+  step_size_(0.1),
+  transformation_epsilon_(0.1),
+  outlier_ratio_(0.55),
+  gauss_d1_(0.0),
+  gauss_d2_(0.0),
+  num_threads_(1),
+  search_method_(pclomp::DIRECT7),
+  nr_iterations_(0),
+  transformation_probability_(0.0),
+  nearest_voxel_transformation_likelihood_(0.0),
+  final_transformation_(Eigen::Matrix4f::Identity()),
+  hessian_(Matrix6d::Zero()),
+  use_regularization_(false),
+  regularization_pose_(Eigen::Matrix4f::Identity()),
+  regularization_scale_factor_(0.0f)
+{
+#ifdef _OPENMP
+  num_threads_ = omp_get_max_threads();
+#endif
+  setNeighborhoodSearchMethod(search_method_);
+  updateGaussianParameters();
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::align(
+  pcl::PointCloud<PointSource> & output, const Eigen::Matrix4f & guess)
+{
+  nr_iterations_ = 0;
+  transformation_array_.clear();
+  final_transformation_ = guess;
+
+  if (target_ptr_ && source_cloud_ptr_ && !source_cloud_ptr_->empty()) {
+    // transformation vector of the guess, in the euler angles of the derivatives
+    const Eigen::Vector3f init_translation = guess.block<3, 1>(0, 3);
+    const Eigen::Vector3f init_rotation = guess.block<3, 3>(0, 0).eulerAngles(0, 1, 2);
+    Vector6d p;
+    p << init_translation(0), init_translation(1), init_translation(2), init_rotation(0),
+      init_rotation(1), init_rotation(2);
+
+    double score = 0.0;
+    Vector6d score_gradient;
+    Matrix6d hessian;
+    unpack(computeDerivatives(p), score, score_gradient, hessian);
+
+    bool converged = false;
+    while (!converged) {
+      // newton method, negative for the maximization (line 23 in Algorithm 2 [Magnusson 2009])
+      Eigen::JacobiSVD<Matrix6d> sv(hessian, Eigen::ComputeFullU | Eigen::ComputeFullV);
+      Vector6d delta_p = sv.solve(-score_gradient);
+
+      double delta_p_norm = delta_p.norm();
+      if (delta_p_norm == 0 || std::isnan(delta_p_norm)) {
+        break;
+      }
+
+      // step length with guaranteed sufficient decrease [More, Thuente 1994]
+      delta_p.normalize();
+      delta_p_norm = computeStepLengthMT(
+        p, delta_p, delta_p_norm, step_size_, transformation_epsilon_ / 2, score, score_gradient,
+        hessian);
+      delta_p *= delta_p_norm;
+      p += delta_p;
+      transformation_array_.push_back(final_transformation_);
+
+      if (
+        nr_iterations_ > max_iterations_ ||
+        (nr_iterations_ && std::fabs(delta_p_norm) < transformation_epsilon_)) {
+        converged = true;
+      }
+      ++nr_iterations_;
+    }
+    hessian_ = hessian;
+  }
+
+  if (source_cloud_ptr_) {
+    output = *source_cloud_ptr_;
+    for (auto & point : output.points) {
+      point.getVector3fMap() =
+        final_transformation_.block<3, 3>(0, 0) * point.getVector3fMap() +
+        final_transformation_.block<3, 1>(0, 3);
+    }
+  }
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setInputTarget(
+  const pcl::shared_ptr<pcl::PointCloud<PointTarget>> & map_ptr)
+{
+  target_cloud_ptr_ = map_ptr;
+  target_ptr_ = NativeVoxelTarget::build(*map_ptr, resolution_, num_threads_);
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setInputSource(
+  const pcl::shared_ptr<pcl::PointCloud<PointSource>> & scan_ptr)
+{
+  source_cloud_ptr_ = scan_ptr;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setMaximumIterations(
+  int max_iter)
+{
+  max_iterations_ = max_iter;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setResolution(float res)
+{
+  if (resolution_ == res) {
+    return;
+  }
+  resolution_ = res;
+  updateGaussianParameters();
+  if (target_cloud_ptr_) {
+    target_ptr_ = NativeVoxelTarget::build(*target_cloud_ptr_, resolution_, num_threads_);
+  }
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setStepSize(double step_size)
+{
+  step_size_ = step_size;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setTransformationEpsilon(
+  double trans_eps)
+{
+  transformation_epsilon_ = trans_eps;
+}
+
+template <class PointSource, class PointTarget>
+int NormalDistributionsTransformNative<PointSource, PointTarget>::getMaximumIterations()
+{
+  return max_iterations_;
+}
+
+template <class PointSource, class PointTarget>
+int NormalDistributionsTransformNative<PointSource, PointTarget>::getFinalNumIteration() const
+{
+  return nr_iterations_;
+}
+
+template <class PointSource, class PointTarget>
+float NormalDistributionsTransformNative<PointSource, PointTarget>::getResolution() const
+{
+  return resolution_;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::getStepSize() const
+{
+  return step_size_;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::getTransformationEpsilon()
+{
+  return transformation_epsilon_;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::getTransformationProbability()
+  const
+{
+  return transformation_probability_;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<
+  PointSource, PointTarget>::getNearestVoxelTransformationLikelihood() const
+{
+  return nearest_voxel_transformation_likelihood_;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::getFitnessScore()
+{
+  // mean squared distance to the nearest voxel mean, since there is no kd-tree of the target
+  if (!target_ptr_ || !source_cloud_ptr_) {
+    return std::numeric_limits<double>::max();
+  }
+  PairBuffer buffer;
+  findPairs(
+    *source_cloud_ptr_, final_transformation_.cast<double>(), 0, source_cloud_ptr_->size(),
+    buffer);
+
+  double sum_squared_distance = 0.0;
+  int num_points_with_voxels = 0;
+  for (size_t k = 0; k < buffer.size();) {
+    const int point_idx = buffer.point_indices[k];
+    double min_squared_distance = std::numeric_limits<double>::max();
+    for (; k < buffer.size() && buffer.point_indices[k] == point_idx; ++k) {
+      min_squared_distance = std::min(
+        min_squared_distance,
+        buffer.dx[k] * buffer.dx[k] + buffer.dy[k] * buffer.dy[k] + buffer.dz[k] * buffer.dz[k]);
+    }
+    sum_squared_distance += min_squared_distance;
+    ++num_points_with_voxels;
+  }
+  return num_points_with_voxels > 0 ? sum_squared_distance / num_points_with_voxels
+                                    : std::numeric_limits<double>::max();
+}
+
+template <class PointSource, class PointTarget>
+pcl::shared_ptr<const pcl::PointCloud<PointTarget>>
+NormalDistributionsTransformNative<PointSource, PointTarget>::getInputTarget() const
+{
+  return target_cloud_ptr_;
+}
+
+template <class PointSource, class PointTarget>
+pcl::shared_ptr<const pcl::PointCloud<PointSource>>
+NormalDistributionsTransformNative<PointSource, PointTarget>::getInputSource() const
+{
+  return source_cloud_ptr_;
+}
+
+template <class PointSource, class PointTarget>
+Eigen::Matrix4f
+NormalDistributionsTransformNative<PointSource, PointTarget>::getFinalTransformation() const
+{
+  return final_transformation_;
+}
+
+template <class PointSource, class PointTarget>
+std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>>
+NormalDistributionsTransformNative<PointSource, PointTarget>::getFinalTransformationArray() const
+{
+  return transformation_array_;
+}
+
+template <class PointSource, class PointTarget>
+Eigen::Matrix<double, 6, 6>
+NormalDistributionsTransformNative<PointSource, PointTarget>::getHessian() const
+{
+  return hessian_;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setRegularizationScaleFactor(
+  const float regularization_scale_factor)
+{
+  regularization_scale_factor_ = regularization_scale_factor;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setRegularizationPose(
+  const Eigen::Matrix4f & regularization_pose)
+{
+  use_regularization_ = true;
+  regularization_pose_ = regularization_pose;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::unsetRegularizationPose()
+{
+  use_regularization_ = false;
+}
+
+template <class PointSource, class PointTarget>
+pcl::shared_ptr<pcl::search::KdTree<PointTarget>>
+NormalDistributionsTransformNative<PointSource, PointTarget>::getSearchMethodTarget() const
+{
+  return nullptr;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::
+  calculateTransformationProbability(const pcl::PointCloud<PointSource> & trans_cloud) const
+{
+  if (trans_cloud.empty()) {
+    return 0.0;
+  }
+  return computeScores(trans_cloud).score / static_cast<double>(trans_cloud.size());
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::
+  calculateNearestVoxelTransformationLikelihood(
+    const pcl::PointCloud<PointSource> & trans_cloud) const
+{
+  const Derivatives scores = computeScores(trans_cloud);
+  if (scores.num_points_with_voxels == 0) {
+    return 0.0;
+  }
+  return scores.nearest_voxel_score / scores.num_points_with_voxels;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setNumThreads(int n)
+{
+  num_threads_ = std::max(n, 1);
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setNeighborhoodSearchMethod(
+  pclomp::NeighborSearchMethod method)
+{
+  search_method_ = method;
+  neighbor_offsets_ = {{0, 0, 0}};
+  if (method == pclomp::DIRECT7) {
+    neighbor_offsets_.insert(
+      neighbor_offsets_.end(),
+      {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}});
+  } else if (method == pclomp::DIRECT26 || method == pclomp::KDTREE) {
+    for (int ix = -1; ix <= 1; ++ix) {
+      for (int iy = -1; iy <= 1; ++iy) {
+        for (int iz = -1; iz <= 1; ++iz) {
+          if (ix != 0 || iy != 0 || iz != 0) {
+            neighbor_offsets_.push_back({ix, iy, iz});
+          }
+        }
+      }
+    }
+  }
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::setVoxelTarget(
+  const std::shared_ptr<const NativeVoxelTarget> & target_ptr)
+{
+  target_cloud_ptr_.reset();
+  target_ptr_ = target_ptr;
+  resolution_ = target_ptr->getResolution();
+  updateGaussianParameters();
+}
+
+template <class PointSource, class PointTarget>
+int NormalDistributionsTransformNative<PointSource, PointTarget>::getNumThreads() const
+{
+  return num_threads_;
+}
+
+template <class PointSource, class PointTarget>
+pclomp::NeighborSearchMethod
+NormalDistributionsTransformNative<PointSource, PointTarget>::getNeighborhoodSearchMethod() const
+{
+  return search_method_;
+}
+
+template <class PointSource, class PointTarget>
+std::shared_ptr<const NativeVoxelTarget>
+NormalDistributionsTransformNative<PointSource, PointTarget>::getVoxelTarget() const
+{
+  return target_ptr_;
+}
+
+template <class PointSource, class PointTarget>
+std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>>
+NormalDistributionsTransformNative<PointSource, PointTarget>::clone() const
+{
+  // the voxel target is read-only, and shared with the clone
+  auto clone_ptr = std::make_shared<NormalDistributionsTransformNative>(*this);
+  clone_ptr->pair_buffers_.clear();
+  return clone_ptr;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::PairBuffer::reserve(
+  size_t capacity)
+{
+  num_pairs = 0;
+  if (point_indices.size() >= capacity) {
+    return;
+  }
+  for (auto * array : {&x, &y, &z, &dx, &dy, &dz, &icov_xx, &icov_xy, &icov_xz, &icov_yy,
+                       &icov_yz, &icov_zz, &scores}) {
+    array->resize(capacity);
+  }
+  point_indices.resize(capacity);
+}
+
+template <class PointSource, class PointTarget>
+Eigen::Matrix4d NormalDistributionsTransformNative<PointSource, PointTarget>::toMatrix(
+  const Vector6d & p)
+{
+  return (Eigen::Translation3d(p(0), p(1), p(2)) *
+          Eigen::AngleAxisd(p(3), Eigen::Vector3d::UnitX()) *
+          Eigen::AngleAxisd(p(4), Eigen::Vector3d::UnitY()) *
+          Eigen::AngleAxisd(p(5), Eigen::Vector3d::UnitZ()))
+    .matrix();
+}
+
+template <class PointSource, class PointTarget>
+typename NormalDistributionsTransformNative<PointSource, PointTarget>::AngleDerivatives
+NormalDistributionsTransformNative<PointSource, PointTarget>::computeAngleDerivatives(
+  const Vector6d & p)
+{
+  const double cx = std::cos(p(3));
+  const double sx = std::sin(p(3));
+  const double cy = std::cos(p(4));
+  const double sy = std::sin(p(4));
+  const double cz = std::cos(p(5));
+  const double sz = std::sin(p(5));
+
+  // a, b, c, d, e, f, g and h of eq 6.19 [Magnusson 2009]
+  AngleDerivatives derivatives;
+  derivatives.jacobian = {
+    -sx * sz + cx * sy * cz, -sx * cz - cx * sy * sz, -cx * cy,
+    cx * sz + sx * sy * cz,  cx * cz - sx * sy * sz,  -sx * cy,
+    -sy * cz,                sy * sz,                 cy,
+    sx * cy * cz,            -sx * cy * sz,           sx * sy,
+    -cx * cy * cz,           cx * cy * sz,            -cx * sy,
+    -cy * sz,                -cy * cz,                0.0,
+    cx * cz - sx * sy * sz,  -cx * sz - sx * sy * cz, 0.0,
+    sx * cz + cx * sy * sz,  cx * sy * cz - sx * sz,  0.0};
+
+  // a2, a3, b2, b3, c2, c3, d1, d2, d3, e1, e2, e3, f1, f2 and f3 of eq 6.21 [Magnusson 2009]
+  derivatives.hessian = {
+    -cx * sz - sx * sy * cz, -cx * cz + sx * sy * sz, sx * cy,
+    -sx * sz + cx * sy * cz, -cx * sy * sz - sx * cz, -cx * cy,
+    cx * cy * cz,            -cx * cy * sz,           cx * sy,
+    sx * cy * cz,            -sx * cy * sz,           sx * sy,
+    -sx * cz - cx * sy * sz, sx * sz - cx * sy * cz,  0.0,
+    cx * cz - sx * sy * sz,  -sx * sy * cz - cx * sz, 0.0,
+    -cy * cz,                cy * sz,                 sy,
+    -sx * sy * cz,           sx * sy * sz,            sx * cy,
+    cx * sy * cz,            -cx * sy * sz,           -cx * cy,
+    sy * sz,                 sy * cz,                 0.0,
+    -sx * cy * sz,           -sx * cy * cz,           0.0,
+    cx * cy * sz,            cx * cy * cz,            0.0,
+    -cy * cz,                cy * sz,                 0.0,
+    -cx * sz - sx * sy * cz, -cx * cz + sx * sy * sz, 0.0,
+    -sx * sz + cx * sy * cz, -cx * sy * sz - sx * cz, 0.0};
+  return derivatives;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::findPairs(
+  const pcl::PointCloud<PointSource> & cloud, const Eigen::Matrix4d & transform, size_t begin,
+  size_t end, PairBuffer & buffer) const
+{
+  buffer.reserve((end - begin) * neighbor_offsets_.size());
+  size_t & k = buffer.num_pairs;
+  const NativeVoxelTarget & target = *target_ptr_;
+  const NativeVoxelTarget::Voxels & voxels = target.getVoxels();
+  const double inverse_resolution = 1.0 / target.getResolution();
+  // KDTREE of pclomp searches the voxel means within the resolution
+  const double max_squared_distance = search_method_ == pclomp::KDTREE
+                                        ? target.getResolution() * target.getResolution()
+                                        : std::numeric_limits<double>::max();
+
+  for (size_t i = begin; i < end; ++i) {
+    const double x = cloud.points[i].x;
+    const double y = cloud.points[i].y;
+    const double z = cloud.points[i].z;
+    const double tx =
+      transform(0, 0) * x + transform(0, 1) * y + transform(0, 2) * z + transform(0, 3);
+    const double ty =
+      transform(1, 0) * x + transform(1, 1) * y + transform(1, 2) * z + transform(1, 3);
+    const double tz =
+      transform(2, 0) * x + transform(2, 1) * y + transform(2, 2) * z + transform(2, 3);
+    const int32_t ix = NativeVoxelTarget::getIndex(tx, inverse_resolution);
+    const int32_t iy = NativeVoxelTarget::getIndex(ty, inverse_resolution);
+    const int32_t iz = NativeVoxelTarget::getIndex(tz, inverse_resolution);
+
+    for (const auto & offset : neighbor_offsets_) {
+      const int32_t voxel_idx = target.find(ix + offset[0], iy + offset[1], iz + offset[2]);
+      if (voxel_idx < 0) {
+        continue;
+      }
+      const double dx = tx - voxels.mean_x[voxel_idx];
+      const double dy = ty - voxels.mean_y[voxel_idx];
+      const double dz = tz - voxels.mean_z[voxel_idx];
+      if (dx * dx + dy * dy + dz * dz > max_squared_distance) {
+        continue;
+      }
+      buffer.point_indices[k] = static_cast<int>(i);
+      buffer.x[k] = x;
+      buffer.y[k] = y;
+      buffer.z[k] = z;
+      buffer.dx[k] = dx;
+      buffer.dy[k] = dy;
+      buffer.dz[k] = dz;
+      buffer.icov_xx[k] = voxels.icov_xx[voxel_idx];
+      buffer.icov_xy[k] = voxels.icov_xy[voxel_idx];
+      buffer.icov_xz[k] = voxels.icov_xz[voxel_idx];
+      buffer.icov_yy[k] = voxels.icov_yy[voxel_idx];
+      buffer.icov_yz[k] = voxels.icov_yz[voxel_idx];
+      buffer.icov_zz[k] = voxels.icov_zz[voxel_idx];
+      ++k;
+    }
+  }
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::accumulate(
+  const AngleDerivatives & angle_derivatives, PairBuffer & buffer,
+  Derivatives & derivatives) const
+{
+  const size_t num_pairs = buffer.size();
+  const double * x = buffer.x.data();
+  const double * y = buffer.y.data();
+  const double * z = buffer.z.data();
+  const double * dx = buffer.dx.data();
+  const double * dy = buffer.dy.data();
+  const double * dz = buffer.dz.data();
+  const double * icov_xx = buffer.icov_xx.data();
+  const double * icov_xy = buffer.icov_xy.data();
+  const double * icov_xz = buffer.icov_xz.data();
+  const double * icov_yy = buffer.icov_yy.data();
+  const double * icov_yz = buffer.icov_yz.data();
+  const double * icov_zz = buffer.icov_zz.data();
+  double * scores = buffer.scores.data();
+  const double * ja = angle_derivatives.jacobian.data();
+  const double * ha = angle_derivatives.hessian.data();
+  const double gauss_d1 = gauss_d1_;
+  const double gauss_d2 = gauss_d2_;
+
+  // exponential of eq 6.9 [Magnusson 2009], in its own loop since std::exp is not vectorized
+#pragma omp simd
+  for (size_t k = 0; k < num_pairs; ++k) {
+    const double cd_x = icov_xx[k] * dx[k] + icov_xy[k] * dy[k] + icov_xz[k] * dz[k];
+    const double cd_y = icov_xy[k] * dx[k] + icov_yy[k] * dy[k] + icov_yz[k] * dz[k];
+    const double cd_z = icov_xz[k] * dx[k] + icov_yz[k] * dy[k] + icov_zz[k] * dz[k];
+    scores[k] = -0.5 * gauss_d2 * (dx[k] * cd_x + dy[k] * cd_y + dz[k] * cd_z);
+  }
+  for (size_t k = 0; k < num_pairs; ++k) {
+    scores[k] = std::exp(scores[k]);
+  }
+
+  double score = 0.0;
+  double grad_0 = 0.0, grad_1 = 0.0, grad_2 = 0.0, grad_3 = 0.0, grad_4 = 0.0, grad_5 = 0.0;
+  double hess_00 = 0.0, hess_10 = 0.0, hess_11 = 0.0, hess_20 = 0.0, hess_21 = 0.0;
+  double hess_22 = 0.0, hess_30 = 0.0, hess_31 = 0.0, hess_32 = 0.0, hess_33 = 0.0;
+  double hess_40 = 0.0, hess_41 = 0.0, hess_42 = 0.0, hess_43 = 0.0, hess_44 = 0.0;
+  double hess_50 = 0.0, hess_51 = 0.0, hess_52 = 0.0, hess_53 = 0.0, hess_54 = 0.0;
+  double hess_55 = 0.0;
+#pragma omp simd reduction(+ : score, grad_0, grad_1, grad_2, grad_3, grad_4, grad_5, hess_00, \
+                           hess_10, hess_11, hess_20, hess_21, hess_22, hess_30, hess_31, hess_32, \
+                           hess_33, hess_40, hess_41, hess_42, hess_43, hess_44, hess_50, hess_51, \
+                           hess_52, hess_53, hess_54, hess_55)
+  for (size_t k = 0; k < num_pairs; ++k) {
+    // invalid values are skipped as pcl::NormalDistributionsTransform does
+    const double e = scores[k];
+    const double valid_e = gauss_d2 * e <= 1.0 && gauss_d2 * e >= 0.0 ? e : 0.0;
+    const double score_inc = -gauss_d1 * valid_e;
+    const double w = gauss_d1 * gauss_d2 * valid_e;
+    const double w_d2 = w * gauss_d2;
+    scores[k] = score_inc;
+
+    // C (x' - mu)
+    const double cd_x = icov_xx[k] * dx[k] + icov_xy[k] * dy[k] + icov_xz[k] * dz[k];
+    const double cd_y = icov_xy[k] * dx[k] + icov_yy[k] * dy[k] + icov_yz[k] * dz[k];
+    const double cd_z = icov_xz[k] * dx[k] + icov_yz[k] * dy[k] + icov_zz[k] * dz[k];
+
+    // columns 3 to 5 of the point jacobian (eq 6.18 [Magnusson 2009])
+    const double j3_y = ja[0] * x[k] + ja[1] * y[k] + ja[2] * z[k];
+    const double j3_z = ja[3] * x[k] + ja[4] * y[k] + ja[5] * z[k];
+    const double j4_x = ja[6] * x[k] + ja[7] * y[k] + ja[8] * z[k];
+    const double j4_y = ja[9] * x[k] + ja[10] * y[k] + ja[11] * z[k];
+    const double j4_z = ja[12] * x[k] + ja[13] * y[k] + ja[14] * z[k];
+    const double j5_x = ja[15] * x[k] + ja[16] * y[k] + ja[17] * z[k];
+    const double j5_y = ja[18] * x[k] + ja[19] * y[k] + ja[20] * z[k];
+    const double j5_z = ja[21] * x[k] + ja[22] * y[k] + ja[23] * z[k];
+
+    // C J_i for i = 3 to 5
+    const double cj3_x = icov_xy[k] * j3_y + icov_xz[k] * j3_z;
+    const double cj3_y = icov_yy[k] * j3_y + icov_yz[k] * j3_z;
+    const double cj3_z = icov_yz[k] * j3_y + icov_zz[k] * j3_z;
+    const double cj4_x = icov_xx[k] * j4_x + icov_xy[k] * j4_y + icov_xz[k] * j4_z;
+    const double cj4_y = icov_xy[k] * j4_x + icov_yy[k] * j4_y + icov_yz[k] * j4_z;
+    const double cj4_z = icov_xz[k] * j4_x + icov_yz[k] * j4_y + icov_zz[k] * j4_z;
+    const double cj5_x = icov_xx[k] * j5_x + icov_xy[k] * j5_y + icov_xz[k] * j5_z;
+    const double cj5_y = icov_xy[k] * j5_x + icov_yy[k] * j5_y + icov_yz[k] * j5_z;
+    const double cj5_z = icov_xz[k] * j5_x + icov_yz[k] * j5_y + icov_zz[k] * j5_z;
+
+    // (x' - mu)^T C J_i
+    const double g_0 = cd_x;
+    const double g_1 = cd_y;
+    const double g_2 = cd_z;
+    const double g_3 = cd_y * j3_y + cd_z * j3_z;
+    const double g_4 = cd_x * j4_x + cd_y * j4_y + cd_z * j4_z;
+    const double g_5 = cd_x * j5_x + cd_y * j5_y + cd_z * j5_z;
+
+    // (x' - mu)^T C H_ij of the point hessian (eq 6.20 [Magnusson 2009])
+    const double h_a2 = ha[0] * x[k] + ha[1] * y[k] + ha[2] * z[k];
+    const double h_a3 = ha[3] * x[k] + ha[4] * y[k] + ha[5] * z[k];
+    const double h_b2 = ha[6] * x[k] + ha[7] * y[k] + ha[8] * z[k];
+    const double h_b3 = ha[9] * x[k] + ha[10] * y[k] + ha[11] * z[k];
+    const double h_c2 = ha[12] * x[k] + ha[13] * y[k] + ha[14] * z[k];
+    const double h_c3 = ha[15] * x[k] + ha[16] * y[k] + ha[17] * z[k];
+    const double h_d1 = ha[18] * x[k] + ha[19] * y[k] + ha[20] * z[k];
+    const double h_d2 = ha[21] * x[k] + ha[22] * y[k] + ha[23] * z[k];
+    const double h_d3 = ha[24] * x[k] + ha[25] * y[k] + ha[26] * z[k];
+    const double h_e1 = ha[27] * x[k] + ha[28] * y[k] + ha[29] * z[k];
+    const double h_e2 = ha[30] * x[k] + ha[31] * y[k] + ha[32] * z[k];
+    const double h_e3 = ha[33] * x[k] + ha[34] * y[k] + ha[35] * z[k];
+    const double h_f1 = ha[36] * x[k] + ha[37] * y[k] + ha[38] * z[k];
+    const double h_f2 = ha[39] * x[k] + ha[40] * y[k] + ha[41] * z[k];
+    const double h_f3 = ha[42] * x[k] + ha[43] * y[k] + ha[44] * z[k];
+    const double ch_33 = cd_y * h_a2 + cd_z * h_a3;
+    const double ch_43 = cd_y * h_b2 + cd_z * h_b3;
+    const double ch_53 = cd_y * h_c2 + cd_z * h_c3;
+    const double ch_44 = cd_x * h_d1 + cd_y * h_d2 + cd_z * h_d3;
+    const double ch_54 = cd_x * h_e1 + cd_y * h_e2 + cd_z * h_e3;
+    const double ch_55 = cd_x * h_f1 + cd_y * h_f2 + cd_z * h_f3;
+
+    // eq 6.12 and 6.13 [Magnusson 2009], with J_j^T C J_i as the first term of the hessian
+    score += score_inc;
+    grad_0 += w * g_0;
+    grad_1 += w * g_1;
+    grad_2 += w * g_2;
+    grad_3 += w * g_3;
+    grad_4 += w * g_4;
+    grad_5 += w * g_5;
+    hess_00 += w * icov_xx[k] - w_d2 * g_0 * g_0;
+    hess_10 += w * icov_xy[k] - w_d2 * g_1 * g_0;
+    hess_11 += w * icov_yy[k] - w_d2 * g_1 * g_1;
+    hess_20 += w * icov_xz[k] - w_d2 * g_2 * g_0;
+    hess_21 += w * icov_yz[k] - w_d2 * g_2 * g_1;
+    hess_22 += w * icov_zz[k] - w_d2 * g_2 * g_2;
+    hess_30 += w * cj3_x - w_d2 * g_3 * g_0;
+    hess_31 += w * cj3_y - w_d2 * g_3 * g_1;
+    hess_32 += w * cj3_z - w_d2 * g_3 * g_2;
+    hess_33 += w * (j3_y * cj3_y + j3_z * cj3_z + ch_33) - w_d2 * g_3 * g_3;
+    hess_40 += w * cj4_x - w_d2 * g_4 * g_0;
+    hess_41 += w * cj4_y - w_d2 * g_4 * g_1;
+    hess_42 += w * cj4_z - w_d2 * g_4 * g_2;
+    hess_43 += w * (j4_x * cj3_x + j4_y * cj3_y + j4_z * cj3_z + ch_43) - w_d2 * g_4 * g_3;
+    hess_44 += w * (j4_x * cj4_x + j4_y * cj4_y + j4_z * cj4_z + ch_44) - w_d2 * g_4 * g_4;
+    hess_50 += w * cj5_x - w_d2 * g_5 * g_0;
+    hess_51 += w * cj5_y - w_d2 * g_5 * g_1;
+    hess_52 += w * cj5_z - w_d2 * g_5 * g_2;
+    hess_53 += w * (j5_x * cj3_x + j5_y * cj3_y + j5_z * cj3_z + ch_53) - w_d2 * g_5 * g_3;
+    hess_54 += w * (j5_x * cj4_x + j5_y * cj4_y + j5_z * cj4_z + ch_54) - w_d2 * g_5 * g_4;
+    hess_55 += w * (j5_x * cj5_x + j5_y * cj5_y + j5_z * cj5_z + ch_55) - w_d2 * g_5 * g_5;
+  }
+
+  derivatives = Derivatives();
+  derivatives.score = score;
+  derivatives.gradient = {grad_0, grad_1, grad_2, grad_3, grad_4, grad_5};
+  derivatives.hessian = {hess_00, hess_10, hess_11, hess_20, hess_21, hess_22, hess_30,
+                         hess_31, hess_32, hess_33, hess_40, hess_41, hess_42, hess_43,
+                         hess_44, hess_50, hess_51, hess_52, hess_53, hess_54, hess_55};
+  derivatives.num_pairs = static_cast<int>(num_pairs);
+
+  // the pairs of a point are contiguous
+  for (size_t k = 0; k < num_pairs;) {
+    const int point_idx = buffer.point_indices[k];
+    double max_score = scores[k];
+    for (++k; k < num_pairs && buffer.point_indices[k] == point_idx; ++k) {
+      max_score = std::max(max_score, scores[k]);
+    }
+    derivatives.nearest_voxel_score += max_score;
+    ++derivatives.num_points_with_voxels;
+  }
+}
+
+template <class PointSource, class PointTarget>
+typename NormalDistributionsTransformNative<PointSource, PointTarget>::Derivatives
+NormalDistributionsTransformNative<PointSource, PointTarget>::accumulateInParallel(
+  const pcl::PointCloud<PointSource> & cloud, const Vector6d & p,
+  std::vector<PairBuffer> & pair_buffers) const
+{
+  const Eigen::Matrix4d transform = toMatrix(p);
+  const AngleDerivatives angle_derivatives = computeAngleDerivatives(p);
+  const int num_threads = num_threads_;
+  pair_buffers.resize(num_threads);
+  std::vector<Derivatives> thread_derivatives(num_threads);
+
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+  {
+    int thread_idx = 0;
+    int num_running_threads = 1;
+#ifdef _OPENMP
+    thread_idx = omp_get_thread_num();
+    num_running_threads = omp_get_num_threads();
+#endif
+    const size_t begin = cloud.size() * thread_idx / num_running_threads;
+    const size_t end = cloud.size() * (thread_idx + 1) / num_running_threads;
+    findPairs(cloud, transform, begin, end, pair_buffers[thread_idx]);
+    accumulate(angle_derivatives, pair_buffers[thread_idx], thread_derivatives[thread_idx]);
+  }
+
+  // reduced in the order of the threads, so that the result does not depend on the scheduling
+  Derivatives derivatives;
+  for (const auto & d : thread_derivatives) {
+    derivatives.score += d.score;
+    for (int i = 0; i < 6; ++i) {
+      derivatives.gradient[i] += d.gradient[i];
+    }
+    for (int n = 0; n < 21; ++n) {
+      derivatives.hessian[n] += d.hessian[n];
+    }
+    derivatives.nearest_voxel_score += d.nearest_voxel_score;
+    derivatives.num_points_with_voxels += d.num_points_with_voxels;
+    derivatives.num_pairs += d.num_pairs;
+  }
+  return derivatives;
+}
+
+template <class PointSource, class PointTarget>
+typename NormalDistributionsTransformNative<PointSource, PointTarget>::Derivatives
+NormalDistributionsTransformNative<PointSource, PointTarget>::computeDerivatives(
+  const Vector6d & p)
+{
+  Derivatives derivatives = accumulateInParallel(*source_cloud_ptr_, p, pair_buffers_);
+  addRegularization(p, derivatives);
+
+  transformation_probability_ = derivatives.score / static_cast<double>(source_cloud_ptr_->size());
+  nearest_voxel_transformation_likelihood_ =
+    derivatives.num_points_with_voxels > 0
+      ? derivatives.nearest_voxel_score / derivatives.num_points_with_voxels
+      : 0.0;
+  return derivatives;
+}
+
+template <class PointSource, class PointTarget>
+typename NormalDistributionsTransformNative<PointSource, PointTarget>::Derivatives
+NormalDistributionsTransformNative<PointSource, PointTarget>::computeScores(
+  const pcl::PointCloud<PointSource> & trans_cloud) const
+{
+  if (!target_ptr_) {
+    return Derivatives();
+  }
+  std::vector<PairBuffer> pair_buffers;
+  return accumulateInParallel(trans_cloud, Vector6d::Zero(), pair_buffers);
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::addRegularization(
+  const Vector6d & p, Derivatives & derivatives) const
+{
+  if (!use_regularization_) {
+    return;
+  }
+
+  // penalty on the longitudinal distance to the regularization pose, as in pclomp
+  const double dx = regularization_pose_(0, 3) - p(0);
+  const double dy = regularization_pose_(1, 3) - p(1);
+  const double sin_yaw = std::sin(p(5));
+  const double cos_yaw = std::cos(p(5));
+  const double longitudinal_distance = dy * sin_yaw + dx * cos_yaw;
+  const double weight = regularization_scale_factor_ * derivatives.num_pairs;
+
+  derivatives.score -= weight * longitudinal_distance * longitudinal_distance;
+  derivatives.gradient[0] += weight * 2.0 * cos_yaw * longitudinal_distance;
+  derivatives.gradient[1] += weight * 2.0 * sin_yaw * longitudinal_distance;
+  derivatives.hessian[0] -= weight * 2.0 * cos_yaw * cos_yaw;
+  derivatives.hessian[1] -= weight * 2.0 * cos_yaw * sin_yaw;
+  derivatives.hessian[2] -= weight * 2.0 * sin_yaw * sin_yaw;
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::unpack(
+  const Derivatives & derivatives, double & score, Vector6d & score_gradient, Matrix6d & hessian)
+{
+  score = derivatives.score;
+  for (int i = 0, n = 0; i < 6; ++i) {
+    score_gradient(i) = derivatives.gradient[i];
+    for (int j = 0; j <= i; ++j, ++n) {
+      hessian(i, j) = derivatives.hessian[n];
+      hessian(j, i) = derivatives.hessian[n];
+    }
+  }
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::computeStepLengthMT(
+  const Vector6d & x, Vector6d & step_dir, double step_init, double step_max, double step_min,
+  double & score, Vector6d & score_gradient, Matrix6d & hessian)
+{
+  // phi(0) and phi'(0) of eq 1.3 [More, Thuente 1994]
+  const double phi_0 = -score;
+  double d_phi_0 = -(score_gradient.dot(step_dir));
+
+  if (d_phi_0 >= 0) {
+    // not a descent direction
+    if (d_phi_0 == 0) {
+      return 0;
+    }
+    d_phi_0 *= -1;
+    step_dir *= -1;
+  }
+
+  constexpr int max_step_iterations = 10;
+  // sufficient decrease and curvature condition constants of eq 1.1 and 1.2
+  constexpr double mu = 1.e-4;
+  constexpr double nu = 0.9;
+
+  // end points of the interval I, on the auxiliary function psi while I is open (eq 2.1)
+  double a_l = 0;
+  double a_u = 0;
+  double f_l = auxiliaryFunctionPsiMT(a_l, phi_0, phi_0, d_phi_0, mu);
+  double g_l = auxiliaryFunctionDPsiMT(d_phi_0, d_phi_0, mu);
+  double f_u = auxiliaryFunctionPsiMT(a_u, phi_0, phi_0, d_phi_0, mu);
+  double g_u = auxiliaryFunctionDPsiMT(d_phi_0, d_phi_0, mu);
+
+  // same check as pclomp and PCL, with the same effect: step_min < step_max skips the iterations
+  // below, so that the step is the initial one clamped to [step_min, step_max]
+  bool interval_converged = (step_max - step_min) > 0;
+  bool open_interval = true;
+
+  double a_t = std::max(std::min(step_init, step_max), step_min);
+  const auto evaluate = [&](const double a) {
+    const Vector6d x_t = x + step_dir * a;
+    final_transformation_ = toMatrix(x_t).template cast<float>();
+    unpack(computeDerivatives(x_t), score, score_gradient, hessian);
+  };
+  evaluate(a_t);
+
+  double phi_t = -score;
+  double d_phi_t = -(score_gradient.dot(step_dir));
+  double psi_t = auxiliaryFunctionPsiMT(a_t, phi_t, phi_0, d_phi_0, mu);
+  double d_psi_t = auxiliaryFunctionDPsiMT(d_phi_t, d_phi_0, mu);
+
+  for (int step_iterations = 0;
+       !interval_converged && step_iterations < max_step_iterations &&
+       !(psi_t <= 0 /*sufficient decrease*/ && d_phi_t <= -nu * d_phi_0 /*curvature condition*/);
+       ++step_iterations) {
+    if (open_interval) {
+      a_t = trialValueSelectionMT(a_l, f_l, g_l, a_u, f_u, g_u, a_t, psi_t, d_psi_t);
+    } else {
+      a_t = trialValueSelectionMT(a_l, f_l, g_l, a_u, f_u, g_u, a_t, phi_t, d_phi_t);
+    }
+    a_t = std::max(std::min(a_t, step_max), step_min);
+    evaluate(a_t);
+
+    phi_t = -score;
+    d_phi_t = -(score_gradient.dot(step_dir));
+    psi_t = auxiliaryFunctionPsiMT(a_t, phi_t, phi_0, d_phi_0, mu);
+    d_psi_t = auxiliaryFunctionDPsiMT(d_phi_t, d_phi_0, mu);
+
+    // once I is closed, the end points are converted from psi to phi
+    if (open_interval && (psi_t <= 0 && d_psi_t >= 0)) {
+      open_interval = false;
+      f_l = f_l + phi_0 - mu * d_phi_0 * a_l;
+      g_l = g_l + mu * d_phi_0;
+      f_u = f_u + phi_0 - mu * d_phi_0 * a_u;
+      g_u = g_u + mu * d_phi_0;
+    }
+
+    if (open_interval) {
+      interval_converged = updateIntervalMT(a_l, f_l, g_l, a_u, f_u, g_u, a_t, psi_t, d_psi_t);
+    } else {
+      interval_converged = updateIntervalMT(a_l, f_l, g_l, a_u, f_u, g_u, a_t, phi_t, d_phi_t);
+    }
+  }
+  return a_t;
+}
+
+template <class PointSource, class PointTarget>
+bool NormalDistributionsTransformNative<PointSource, PointTarget>::updateIntervalMT(
+  double & a_l, double & f_l, double & g_l, double & a_u, double & f_u, double & g_u, double a_t,
+  double f_t, double g_t)
+{
+  // case U1 of the updating algorithm [More, Thuente 1994]
+  if (f_t > f_l) {
+    a_u = a_t;
+    f_u = f_t;
+    g_u = g_t;
+    return false;
+  }
+  // case U2
+  if (g_t * (a_l - a_t) > 0) {
+    a_l = a_t;
+    f_l = f_t;
+    g_l = g_t;
+    return false;
+  }
+  // case U3
+  if (g_t * (a_l - a_t) < 0) {
+    a_u = a_l;
+    f_u = f_l;
+    g_u = g_l;
+    a_l = a_t;
+    f_l = f_t;
+    g_l = g_t;
+    return false;
+  }
+  // the interval converged
+  return true;
+}
+
+template <class PointSource, class PointTarget>
+double NormalDistributionsTransformNative<PointSource, PointTarget>::trialValueSelectionMT(
+  double a_l, double f_l, double g_l, double a_u, double f_u, double g_u, double a_t, double f_t,
+  double g_t)
+{
+  if (a_t == a_l && a_t == a_u) {
+    return a_t;
+  }
+
+  // minimizer of the cubic interpolating f_l, f_t, g_l and g_t (eq 2.4.52, 2.4.56 [Sun, Yuan 2006])
+  const auto cubic_minimizer = [&]() {
+    const double z = 3 * (f_t - f_l) / (a_t - a_l) - g_t - g_l;
+    const double w = std::sqrt(z * z - g_t * g_l);
+    return a_l + (a_t - a_l) * (w - g_l - z) / (g_t - g_l + 2 * w);
+  };
+  // minimizer of the quadratic interpolating f_l, g_l and g_t (eq 2.4.5 [Sun, Yuan 2006])
+  const auto secant_minimizer = [&]() { return a_l - (a_l - a_t) / (g_l - g_t) * g_l; };
+
+  // case 1 of the trial value selection [More, Thuente 1994]
+  if (a_t != a_l && f_t > f_l) {
+    const double a_c = cubic_minimizer();
+    // minimizer of the quadratic interpolating f_l, f_t and g_l (eq 2.4.2 [Sun, Yuan 2006])
+    const double a_q = a_l - 0.5 * (a_l - a_t) * g_l / (g_l - (f_l - f_t) / (a_l - a_t));
+    return std::fabs(a_c - a_l) < std::fabs(a_q - a_l) ? a_c : 0.5 * (a_q + a_c);
+  }
+  // case 2
+  if (a_t != a_l && g_t * g_l < 0) {
+    const double a_c = cubic_minimizer();
+    const double a_s = secant_minimizer();
+    return std::fabs(a_c - a_t) >= std::fabs(a_s - a_t) ? a_c : a_s;
+  }
+  // case 3
+  if (a_t != a_l && std::fabs(g_t) <= std::fabs(g_l)) {
+    const double a_c = cubic_minimizer();
+    const double a_s = secant_minimizer();
+    const double a_t_next = std::fabs(a_c - a_t) < std::fabs(a_s - a_t) ? a_c : a_s;
+    return a_t > a_l ? std::min(a_t + 0.66 * (a_u - a_t), a_t_next)
+                     : std::max(a_t + 0.66 * (a_u - a_t), a_t_next);
+  }
+  // case 4, minimizer of the cubic interpolating f_u, f_t, g_u and g_t
+  const double z = 3 * (f_t - f_u) / (a_t - a_u) - g_t - g_u;
+  const double w = std::sqrt(z * z - g_t * g_u);
+  return a_u + (a_t - a_u) * (w - g_u - z) / (g_t - g_u + 2 * w);
+}
+
+template <class PointSource, class PointTarget>
+void NormalDistributionsTransformNative<PointSource, PointTarget>::updateGaussianParameters()
+{
+  // gaussian fitting parameters of eq 6.8 [Magnusson 2009]
+  const double gauss_c1 = 10.0 * (1.0 - outlier_ratio_);
+  const double gauss_c2 = outlier_ratio_ / std::pow(resolution_, 3);
+  const double gauss_d3 = -std::log(gauss_c2);
+  gauss_d1_ = -std::log(gauss_c1 + gauss_c2) - gauss_d3;
+  gauss_d2_ =
+    -2.0 * std::log((-std::log(gauss_c1 * std::exp(-0.5) + gauss_c2) - gauss_d3) / gauss_d1_);
+}
+
+#endif  // NDT__IMPL__NATIVE_HPP_
@@ -16,7 +16,9 @@
 #define NDT__IMPL__OMP_HPP_
 
 #include "ndt/omp.hpp"
+#include "ndt/registration_copy.hpp"
 
+#include <memory>
 #include <vector>
 
 template <class PointSource, class PointTarget>
@@ -226,4 +228,14 @@ NormalDistributionsTransformOMP<PointSource, PointTarget>::getNeighborhoodSearch
   return ndt_ptr_->getNeighborhoodSearchMethod();
 }
 
+template <class PointSource, class PointTarget>
+std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>>
+NormalDistributionsTransformOMP<PointSource, PointTarget>::clone() const
+{
+  using T = pclomp::NormalDistributionsTransform<PointSource, PointTarget>;
+  auto clone_ptr = std::make_shared<NormalDistributionsTransformOMP>();
+  clone_ptr->ndt_ptr_.reset(new RegistrationCopy<T>(*ndt_ptr_));
+  return clone_ptr;
+}
+
 #endif  // NDT__IMPL__OMP_HPP_
@@ -16,7 +16,9 @@
 #define NDT__IMPL__PCL_GENERIC_HPP_
 
 #include "ndt/pcl_generic.hpp"
+#include "ndt/registration_copy.hpp"
 
+#include <memory>
 #include <vector>
 
 template <class PointSource, class PointTarget>
@@ -187,4 +189,14 @@ double NormalDistributionsTransformPCLGeneric<PointSource, PointTarget>::
   return 0.0;
 }
 
+template <class PointSource, class PointTarget>
+std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>>
+NormalDistributionsTransformPCLGeneric<PointSource, PointTarget>::clone() const
+{
+  using T = pcl::NormalDistributionsTransform<PointSource, PointTarget>;
+  auto clone_ptr = std::make_shared<NormalDistributionsTransformPCLGeneric>();
+  clone_ptr->ndt_ptr_.reset(new RegistrationCopy<T>(*ndt_ptr_));
+  return clone_ptr;
+}
+
 #endif  // NDT__IMPL__PCL_GENERIC_HPP_
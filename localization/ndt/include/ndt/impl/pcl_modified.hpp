@@ -16,7 +16,9 @@
 #define NDT__IMPL__PCL_MODIFIED_HPP_
 
 #include "ndt/pcl_modified.hpp"
+#include "ndt/registration_copy.hpp"
 
+#include <memory>
 #include <vector>
 
 template <class PointSource, class PointTarget>
@@ -187,4 +189,14 @@ double NormalDistributionsTransformPCLModified<PointSource, PointTarget>::
   return 0.0;
 }
 
+template <class PointSource, class PointTarget>
+std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>>
+NormalDistributionsTransformPCLModified<PointSource, PointTarget>::clone() const
+{
+  using T = pcl::NormalDistributionsTransformModified<PointSource, PointTarget>;
+  auto clone_ptr = std::make_shared<NormalDistributionsTransformPCLModified>();
+  clone_ptr->ndt_ptr_.reset(new RegistrationCopy<T>(*ndt_ptr_));
+  return clone_ptr;
+}
+
 #endif  // NDT__IMPL__PCL_MODIFIED_HPP_
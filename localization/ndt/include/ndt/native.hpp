@@ -0,0 +1,216 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NDT__NATIVE_HPP_
+#define NDT__NATIVE_HPP_
+
+#include "ndt/base.hpp"
+#include "ndt/native_voxel_target.hpp"
+
+#include <pcl/common/io.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+#include <pclomp/ndt_omp.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// compares the derivatives with finite differences
+class NormalDistributionsTransformNativeTest;
+
+/**
+ * @brief NDT of [Magnusson 2009] with the same optimization as pclomp, whose target is a
+ * NativeVoxelTarget. The neighbor voxels of the points are found by hashing, and the score,
+ * gradient and Hessian are accumulated over structure of arrays in SIMD loops, reduced per thread.
+ */
+template <class PointSource, class PointTarget>
+class NormalDistributionsTransformNative
+: public NormalDistributionsTransformBase<PointSource, PointTarget>
+{
+public:
+  NormalDistributionsTransformNative();
+  ~NormalDistributionsTransformNative() = default;
+
+  std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> clone()
+    const override;
+
+  void align(pcl::PointCloud<PointSource> & output, const Eigen::Matrix4f & guess) override;
+  void setInputTarget(const pcl::shared_ptr<pcl::PointCloud<PointTarget>> & map_ptr) override;
+  void setInputSource(const pcl::shared_ptr<pcl::PointCloud<PointSource>> & scan_ptr) override;
+
+  void setMaximumIterations(int max_iter) override;
+  void setResolution(float res) override;
+  void setStepSize(double step_size) override;
+  void setTransformationEpsilon(double trans_eps) override;
+
+  int getMaximumIterations() override;
+  int getFinalNumIteration() const override;
+  float getResolution() const override;
+  double getStepSize() const override;
+  double getTransformationEpsilon() override;
+  double getTransformationProbability() const override;
+  double getNearestVoxelTransformationLikelihood() const override;
+  double getFitnessScore() override;
+  pcl::shared_ptr<const pcl::PointCloud<PointTarget>> getInputTarget() const override;
+  pcl::shared_ptr<const pcl::PointCloud<PointSource>> getInputSource() const override;
+  Eigen::Matrix4f getFinalTransformation() const override;
+  std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>>
+  getFinalTransformationArray() const override;
+
+  Eigen::Matrix<double, 6, 6> getHessian() const override;
+  void setRegularizationScaleFactor(const float regularization_scale_factor) override;
+  void setRegularizationPose(const Eigen::Matrix4f & regularization_pose) override;
+  void unsetRegularizationPose() override;
+
+  pcl::shared_ptr<pcl::search::KdTree<PointTarget>> getSearchMethodTarget() const override;
+
+  double calculateTransformationProbability(
+    const pcl::PointCloud<PointSource> & trans_cloud) const override;
+  double calculateNearestVoxelTransformationLikelihood(
+    const pcl::PointCloud<PointSource> & trans_cloud) const override;
+
+  // only Native Impl
+  void setNumThreads(int n);
+  // DIRECT1, DIRECT7 and DIRECT26 are hashed, and KDTREE is DIRECT26 within the resolution
+  void setNeighborhoodSearchMethod(pclomp::NeighborSearchMethod method);
+  // target built elsewhere, whose resolution replaces the one of this NDT
+  void setVoxelTarget(const std::shared_ptr<const NativeVoxelTarget> & target_ptr);
+
+  int getNumThreads() const;
+  pclomp::NeighborSearchMethod getNeighborhoodSearchMethod() const;
+  std::shared_ptr<const NativeVoxelTarget> getVoxelTarget() const;
+
+private:
+  friend class ::NormalDistributionsTransformNativeTest;
+
+  using Vector6d = Eigen::Matrix<double, 6, 1>;
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+  // (point, voxel) pairs found by a thread, as structure of arrays for the SIMD loop
+  struct PairBuffer
+  {
+    std::vector<int> point_indices;
+    // point before the transformation
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    // transformed point minus the voxel mean
+    std::vector<double> dx;
+    std::vector<double> dy;
+    std::vector<double> dz;
+    std::vector<double> icov_xx;
+    std::vector<double> icov_xy;
+    std::vector<double> icov_xz;
+    std::vector<double> icov_yy;
+    std::vector<double> icov_yz;
+    std::vector<double> icov_zz;
+    std::vector<double> scores;
+    // the arrays are kept allocated between the iterations, and only this number is reset
+    size_t num_pairs{0};
+
+    void reserve(size_t capacity);
+    size_t size() const { return num_pairs; }
+  };
+
+  struct Derivatives
+  {
+    double score{0.0};
+    std::array<double, 6> gradient{};
+    // lower triangle, row by row
+    std::array<double, 21> hessian{};
+    double nearest_voxel_score{0.0};
+    int num_points_with_voxels{0};
+    int num_pairs{0};
+  };
+
+  // derivatives of the rotation with respect to the euler angles (eq 6.19, 6.21 [Magnusson 2009])
+  struct AngleDerivatives
+  {
+    std::array<double, 24> jacobian;
+    std::array<double, 45> hessian;
+  };
+
+  static Eigen::Matrix4d toMatrix(const Vector6d & p);
+  static AngleDerivatives computeAngleDerivatives(const Vector6d & p);
+  static void unpack(
+    const Derivatives & derivatives, double & score, Vector6d & score_gradient,
+    Matrix6d & hessian);
+
+  void findPairs(
+    const pcl::PointCloud<PointSource> & cloud, const Eigen::Matrix4d & transform, size_t begin,
+    size_t end, PairBuffer & buffer) const;
+  void accumulate(
+    const AngleDerivatives & angle_derivatives, PairBuffer & buffer,
+    Derivatives & derivatives) const;
+  Derivatives accumulateInParallel(
+    const pcl::PointCloud<PointSource> & cloud, const Vector6d & p,
+    std::vector<PairBuffer> & pair_buffers) const;
+  Derivatives computeDerivatives(const Vector6d & p);
+  Derivatives computeScores(const pcl::PointCloud<PointSource> & trans_cloud) const;
+  void addRegularization(const Vector6d & p, Derivatives & derivatives) const;
+  void updateGaussianParameters();
+
+  // line search of [More, Thuente 1994], as in pcl::NormalDistributionsTransform
+  double computeStepLengthMT(
+    const Vector6d & x, Vector6d & step_dir, double step_init, double step_max,
+    double step_min, double & score, Vector6d & score_gradient, Matrix6d & hessian);
+  static bool updateIntervalMT(
+    double & a_l, double & f_l, double & g_l, double & a_u, double & f_u, double & g_u,
+    double a_t, double f_t, double g_t);
+  static double trialValueSelectionMT(
+    double a_l, double f_l, double g_l, double a_u, double f_u, double g_u, double a_t,
+    double f_t, double g_t);
+  static double auxiliaryFunctionPsiMT(
+    double a, double f_a, double f_0, double g_0, double mu = 1.e-4)
+  {
+    return f_a - f_0 - mu * g_0 * a;
+  }
+  static double auxiliaryFunctionDPsiMT(double g_a, double g_0, double mu = 1.e-4)
+  {
+    return g_a - mu * g_0;
+  }
+
+  pcl::shared_ptr<pcl::PointCloud<PointTarget>> target_cloud_ptr_;
+  pcl::shared_ptr<pcl::PointCloud<PointSource>> source_cloud_ptr_;
+  std::shared_ptr<const NativeVoxelTarget> target_ptr_;
+
+  int max_iterations_;
+  float resolution_;
+  double step_size_;
+  double transformation_epsilon_;
+  double outlier_ratio_;
+  double gauss_d1_;
+  double gauss_d2_;
+  int num_threads_;
+  pclomp::NeighborSearchMethod search_method_;
+  std::vector<std::array<int, 3>> neighbor_offsets_;
+
+  int nr_iterations_;
+  double transformation_probability_;
+  double nearest_voxel_transformation_likelihood_;
+  Eigen::Matrix4f final_transformation_;
+  std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> transformation_array_;
+  Matrix6d hessian_;
+
+  bool use_regularization_;
+  Eigen::Matrix4f regularization_pose_;
+  float regularization_scale_factor_;
+
+  std::vector<PairBuffer> pair_buffers_;
+};
+
+#include "ndt/impl/native.hpp"
+
+#endif  // NDT__NATIVE_HPP_
@@ -0,0 +1,62 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NDT__NATIVE_VOXEL_MAP_FILE_HPP_
+#define NDT__NATIVE_VOXEL_MAP_FILE_HPP_
+
+#include "ndt/native_voxel_target.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Binary file of the voxels of a NativeVoxelTarget, which is memory mapped as is by load().
+ *
+ * The file holds a header, the index of the tiles, the arrays of NativeVoxelTarget::Voxels and the
+ * hash table. The voxels are ordered by tile, so that only the pages of the tiles around the
+ * vehicle are read from the disk and resident. The byte order and the hash are the ones of the
+ * machine writing the file, and changing either needs a new version.
+ */
+class NativeVoxelMapFile
+{
+public:
+  static constexpr char magic[8] = {'N', 'D', 'T', 'V', 'O', 'X', 'E', 'L'};
+  static constexpr uint32_t version = 1;
+
+  /**
+   * @brief Voxels of the map in [ix * tile_size, (ix + 1) * tile_size) along x and likewise along
+   * y, which are the voxels [begin, end) of the file
+   */
+  struct Tile
+  {
+    int32_t ix;
+    int32_t iy;
+    uint64_t begin;
+    uint64_t end;
+  };
+
+  /**
+   * @throw std::runtime_error if tile_size is not positive or the file cannot be written
+   */
+  static void save(const std::string & path, const NativeVoxelTarget & target, float tile_size);
+  /**
+   * @brief Map the file read-only, and return a target whose arrays point into the mapping, which
+   * is unmapped with the last copy of the target
+   * @throw std::runtime_error if the file cannot be mapped or is not a valid voxel map
+   */
+  static std::shared_ptr<const NativeVoxelTarget> load(const std::string & path);
+};
+
+#endif  // NDT__NATIVE_VOXEL_MAP_FILE_HPP_
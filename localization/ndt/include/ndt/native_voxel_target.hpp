@@ -0,0 +1,195 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NDT__NATIVE_VOXEL_TARGET_HPP_
+#define NDT__NATIVE_VOXEL_TARGET_HPP_
+
+#include <pcl/point_cloud.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Normal distributions of the voxels of an NDT target, stored as structure of arrays and
+ * found by an open addressing hash table of the voxel keys. The arrays are read-only views of a
+ * storage shared by all the users of the target, so that it is never copied.
+ */
+class NativeVoxelTarget
+{
+public:
+  // same thresholds as pcl::VoxelGridCovariance
+  static constexpr int min_points_per_voxel = 6;
+  static constexpr double min_covariance_eigenvalue_ratio = 0.01;
+
+  /**
+   * @brief Arrays of the voxels with a normal distribution, whose i-th elements belong to the i-th
+   * voxel
+   */
+  struct Voxels
+  {
+    size_t size{0};
+    const uint64_t * keys{nullptr};
+    const int32_t * num_points{nullptr};
+    const double * mean_x{nullptr};
+    const double * mean_y{nullptr};
+    const double * mean_z{nullptr};
+    // upper triangle of the inverse covariance
+    const double * icov_xx{nullptr};
+    const double * icov_xy{nullptr};
+    const double * icov_xz{nullptr};
+    const double * icov_yy{nullptr};
+    const double * icov_yz{nullptr};
+    const double * icov_zz{nullptr};
+  };
+
+  /**
+   * @brief Sums of the points of the voxels, relative to the minimum corner of each voxel
+   */
+  struct PointSums
+  {
+    std::vector<uint64_t> keys;
+    std::vector<int32_t> num_points;
+    // x, y, z, xx, xy, xz, yy, yz, zz
+    std::vector<std::array<double, 9>> sums;
+    // position of each key in the arrays
+    std::unordered_map<uint64_t, size_t> indices;
+  };
+
+  /**
+   * @param table slots of the hash table, holding voxel indices or -1, whose size is a power of 2
+   * @param storage_ptr owner of the arrays of voxels and table
+   */
+  NativeVoxelTarget(
+    float resolution, const Voxels & voxels, const int32_t * table, size_t table_size,
+    std::shared_ptr<const void> storage_ptr);
+
+  template <class PointT>
+  static std::shared_ptr<const NativeVoxelTarget> build(
+    const pcl::PointCloud<PointT> & cloud, float resolution, int num_threads = 1);
+  static std::shared_ptr<const NativeVoxelTarget> build(
+    const PointSums & point_sums, float resolution, int num_threads = 1);
+  // for the clouds which are not built at once, like the files of a map
+  template <class PointT>
+  static void addPoints(
+    const pcl::PointCloud<PointT> & cloud, float resolution, PointSums & point_sums);
+
+  float getResolution() const { return resolution_; }
+  const Voxels & getVoxels() const { return voxels_; }
+
+  int32_t find(int32_t ix, int32_t iy, int32_t iz) const
+  {
+    const uint64_t key = makeKey(ix, iy, iz);
+    for (size_t slot = hash(key, table_mask_);; slot = (slot + 1) & table_mask_) {
+      const int32_t voxel_idx = table_[slot];
+      if (voxel_idx < 0 || voxels_.keys[voxel_idx] == key) {
+        return voxel_idx;
+      }
+    }
+  }
+
+  static uint64_t makeKey(int32_t ix, int32_t iy, int32_t iz)
+  {
+    // 21 bits for each axis, which covers +-1000 km with 1 m voxels
+    constexpr uint64_t mask = (1ULL << 21) - 1;
+    return ((static_cast<uint64_t>(ix) & mask) << 42) |
+           ((static_cast<uint64_t>(iy) & mask) << 21) | (static_cast<uint64_t>(iz) & mask);
+  }
+  static std::array<int32_t, 3> getIndices(uint64_t key)
+  {
+    return {decodeIndex(key >> 42), decodeIndex(key >> 21), decodeIndex(key)};
+  }
+  static int32_t getIndex(float coordinate, float inverse_resolution)
+  {
+    return static_cast<int32_t>(std::floor(coordinate * inverse_resolution));
+  }
+
+  // table of at most half load, which keeps the linear probing short
+  static size_t getTableSize(size_t num_voxels);
+  static void fillTable(
+    const uint64_t * keys, size_t num_voxels, int32_t * table, size_t table_size);
+
+private:
+  static int32_t decodeIndex(uint64_t bits)
+  {
+    // sign extension of the lower 21 bits
+    const int64_t index = static_cast<int64_t>(bits & ((1ULL << 21) - 1));
+    return static_cast<int32_t>(index >= (1LL << 20) ? index - (1LL << 21) : index);
+  }
+  static size_t hash(uint64_t key, size_t table_mask)
+  {
+    // murmur3 finalizer, since the keys of the neighbor voxels differ only in a few bits
+    key = (key ^ (key >> 33)) * 0xFF51AFD7ED558CCDULL;
+    key = (key ^ (key >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+    return static_cast<size_t>(key ^ (key >> 33)) & table_mask;
+  }
+
+  float resolution_;
+  Voxels voxels_;
+  const int32_t * table_;
+  size_t table_mask_;
+  std::shared_ptr<const void> storage_ptr_;
+};
+
+template <class PointT>
+std::shared_ptr<const NativeVoxelTarget> NativeVoxelTarget::build(
+  const pcl::PointCloud<PointT> & cloud, float resolution, int num_threads)
+{
+  PointSums point_sums;
+  addPoints(cloud, resolution, point_sums);
+  return build(point_sums, resolution, num_threads);
+}
+
+template <class PointT>
+void NativeVoxelTarget::addPoints(
+  const pcl::PointCloud<PointT> & cloud, float resolution, PointSums & point_sums)
+{
+  const float inverse_resolution = 1.0f / resolution;
+  for (const auto & point : cloud.points) {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+      continue;
+    }
+    const int32_t ix = getIndex(point.x, inverse_resolution);
+    const int32_t iy = getIndex(point.y, inverse_resolution);
+    const int32_t iz = getIndex(point.z, inverse_resolution);
+    const auto result = point_sums.indices.emplace(makeKey(ix, iy, iz), point_sums.keys.size());
+    if (result.second) {
+      point_sums.keys.push_back(result.first->first);
+      point_sums.num_points.push_back(0);
+      point_sums.sums.push_back({});
+    }
+
+    const size_t voxel_idx = result.first->second;
+    const double x = point.x - static_cast<double>(ix) * resolution;
+    const double y = point.y - static_cast<double>(iy) * resolution;
+    const double z = point.z - static_cast<double>(iz) * resolution;
+    auto & sums = point_sums.sums[voxel_idx];
+    sums[0] += x;
+    sums[1] += y;
+    sums[2] += z;
+    sums[3] += x * x;
+    sums[4] += x * y;
+    sums[5] += x * z;
+    sums[6] += y * y;
+    sums[7] += y * z;
+    sums[8] += z * z;
+    ++point_sums.num_points[voxel_idx];
+  }
+}
+
+#endif  // NDT__NATIVE_VOXEL_TARGET_HPP_
@@ -22,6 +22,7 @@
 #include <pcl/point_types.h>
 #include <pcl/registration/ndt.h>
 
+#include <memory>
 #include <vector>
 
 template <class PointSource, class PointTarget>
@@ -32,6 +33,9 @@ public:
   NormalDistributionsTransformPCLGeneric();
   ~NormalDistributionsTransformPCLGeneric() = default;
 
+  std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> clone()
+    const override;
+
   void align(pcl::PointCloud<PointSource> & output, const Eigen::Matrix4f & guess) override;
   void setInputTarget(const pcl::shared_ptr<pcl::PointCloud<PointTarget>> & map_ptr) override;
   void setInputSource(const pcl::shared_ptr<pcl::PointCloud<PointSource>> & scan_ptr) override;
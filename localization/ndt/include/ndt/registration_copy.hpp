@@ -0,0 +1,46 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NDT__REGISTRATION_COPY_HPP_
+#define NDT__REGISTRATION_COPY_HPP_
+
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief Copy of a pcl::Registration which aligns in another thread than the original.
+ *
+ * The copy constructor of pcl::Registration shares the objects held by pointers with the original.
+ * The alignment only reads the clouds and the search trees, but initCompute() writes the search
+ * methods into the correspondence estimation, and fills the indices of the source again when their
+ * size differs from the one of the source. The copy gets its own correspondence estimation and
+ * indices.
+ */
+template <class Registration>
+class RegistrationCopy : public Registration
+{
+public:
+  explicit RegistrationCopy(const Registration & original) : Registration(original)
+  {
+    if (this->correspondence_estimation_) {
+      this->correspondence_estimation_ = this->correspondence_estimation_->clone();
+    }
+    if (this->indices_) {
+      using Indices = std::remove_reference_t<decltype(*this->indices_)>;
+      this->indices_ = std::make_shared<Indices>(*this->indices_);
+    }
+  }
+};
+
+#endif  // NDT__REGISTRATION_COPY_HPP_
@@ -0,0 +1,289 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ndt/native_voxel_map_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+enum Section {
+  TILES = 0,
+  KEYS,
+  NUM_POINTS,
+  MEAN_X,
+  MEAN_Y,
+  MEAN_Z,
+  ICOV_XX,
+  ICOV_XY,
+  ICOV_XZ,
+  ICOV_YY,
+  ICOV_YZ,
+  ICOV_ZZ,
+  TABLE,
+  NUM_SECTIONS
+};
+
+constexpr uint32_t byte_order_mark = 0x01020304;
+// the sections start at cache line boundaries
+constexpr uint64_t section_alignment = 64;
+
+struct Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  float resolution;
+  float tile_size;
+  uint64_t num_voxels;
+  uint64_t num_tiles;
+  uint64_t table_size;
+  uint64_t file_size;
+  // from the beginning of the file
+  uint64_t section_offsets[NUM_SECTIONS];
+};
+
+uint64_t getSectionSize(const Header & header, const int section)
+{
+  switch (section) {
+    case TILES:
+      return header.num_tiles * sizeof(NativeVoxelMapFile::Tile);
+    case KEYS:
+      return header.num_voxels * sizeof(uint64_t);
+    case NUM_POINTS:
+      return header.num_voxels * sizeof(int32_t);
+    case TABLE:
+      return header.table_size * sizeof(int32_t);
+    default:
+      return header.num_voxels * sizeof(double);
+  }
+}
+
+void setSectionOffsets(Header & header)
+{
+  uint64_t offset = sizeof(Header);
+  for (int section = 0; section < NUM_SECTIONS; ++section) {
+    offset = (offset + section_alignment - 1) / section_alignment * section_alignment;
+    header.section_offsets[section] = offset;
+    offset += getSectionSize(header, section);
+  }
+  header.file_size = offset;
+}
+
+template <class T>
+std::vector<T> gather(const T * array, const std::vector<size_t> & order)
+{
+  std::vector<T> gathered(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    gathered[i] = array[order[i]];
+  }
+  return gathered;
+}
+
+std::runtime_error makeError(const std::string & path, const std::string & message)
+{
+  return std::runtime_error("Voxel map " + path + ": " + message);
+}
+}  // namespace
+
+void NativeVoxelMapFile::save(
+  const std::string & path, const NativeVoxelTarget & target, float tile_size)
+{
+  if (!(tile_size > 0.0f)) {
+    throw makeError(path, "tile size must be positive");
+  }
+  const auto & voxels = target.getVoxels();
+  const double resolution = target.getResolution();
+
+  // tile of the minimum corner of each voxel
+  std::vector<std::pair<int32_t, int32_t>> voxel_tiles(voxels.size);
+  for (size_t i = 0; i < voxels.size; ++i) {
+    const auto indices = NativeVoxelTarget::getIndices(voxels.keys[i]);
+    voxel_tiles[i].first = static_cast<int32_t>(std::floor(indices[0] * resolution / tile_size));
+    voxel_tiles[i].second = static_cast<int32_t>(std::floor(indices[1] * resolution / tile_size));
+  }
+  std::vector<size_t> order(voxels.size);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&voxel_tiles](const size_t a, const size_t b) {
+    return voxel_tiles[a] < voxel_tiles[b];
+  });
+
+  std::vector<Tile> tiles;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const auto & voxel_tile = voxel_tiles[order[i]];
+    if (
+      tiles.empty() || tiles.back().ix != voxel_tile.first ||
+      tiles.back().iy != voxel_tile.second) {
+      tiles.push_back(Tile{voxel_tile.first, voxel_tile.second, i, i});
+    }
+    tiles.back().end = i + 1;
+  }
+
+  const std::vector<uint64_t> keys = gather(voxels.keys, order);
+  std::vector<int32_t> table(NativeVoxelTarget::getTableSize(voxels.size));
+  NativeVoxelTarget::fillTable(keys.data(), keys.size(), table.data(), table.size());
+
+  Header header{};
+  std::copy(std::begin(magic), std::end(magic), header.magic);
+  header.version = version;
+  header.byte_order = byte_order_mark;
+  header.resolution = target.getResolution();
+  header.tile_size = tile_size;
+  header.num_voxels = voxels.size;
+  header.num_tiles = tiles.size();
+  header.table_size = table.size();
+  setSectionOffsets(header);
+
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  if (!ofs) {
+    throw makeError(path, "cannot be opened for writing");
+  }
+  ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  const auto write_section = [&ofs, &header](const int section, const void * data) {
+    const auto position = static_cast<uint64_t>(ofs.tellp());
+    const std::vector<char> padding(header.section_offsets[section] - position, 0);
+    ofs.write(padding.data(), padding.size());
+    ofs.write(static_cast<const char *>(data), getSectionSize(header, section));
+  };
+  write_section(TILES, tiles.data());
+  write_section(KEYS, keys.data());
+  write_section(NUM_POINTS, gather(voxels.num_points, order).data());
+  write_section(MEAN_X, gather(voxels.mean_x, order).data());
+  write_section(MEAN_Y, gather(voxels.mean_y, order).data());
+  write_section(MEAN_Z, gather(voxels.mean_z, order).data());
+  write_section(ICOV_XX, gather(voxels.icov_xx, order).data());
+  write_section(ICOV_XY, gather(voxels.icov_xy, order).data());
+  write_section(ICOV_XZ, gather(voxels.icov_xz, order).data());
+  write_section(ICOV_YY, gather(voxels.icov_yy, order).data());
+  write_section(ICOV_YZ, gather(voxels.icov_yz, order).data());
+  write_section(ICOV_ZZ, gather(voxels.icov_zz, order).data());
+  write_section(TABLE, table.data());
+  if (!ofs) {
+    throw makeError(path, "failed to write");
+  }
+}
+
+std::shared_ptr<const NativeVoxelTarget> NativeVoxelMapFile::load(const std::string & path)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw makeError(path, std::strerror(errno));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(Header)) {
+    close(fd);
+    throw makeError(path, "not a voxel map");
+  }
+  const size_t file_size = file_stat.st_size;
+  void * address = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping is kept after closing the file
+  close(fd);
+  if (address == MAP_FAILED) {
+    throw makeError(path, std::strerror(errno));
+  }
+  std::shared_ptr<const void> mapping_ptr(address, [file_size](const void * mapped_address) {
+    munmap(const_cast<void *>(mapped_address), file_size);
+  });
+
+  const char * data = static_cast<const char *>(address);
+  const Header & header = *reinterpret_cast<const Header *>(data);
+  if (!std::equal(std::begin(magic), std::end(magic), header.magic)) {
+    throw makeError(path, "not a voxel map");
+  }
+  if (header.version != version) {
+    throw makeError(
+      path, "version " + std::to_string(header.version) + " is not supported, expected " +
+              std::to_string(version));
+  }
+  if (header.byte_order != byte_order_mark) {
+    throw makeError(path, "written with a different byte order");
+  }
+  // the counts are bounded by the file size before the sizes of the sections are computed from
+  // them, so that the sizes do not overflow
+  const bool are_counts_valid = header.num_voxels <= file_size / sizeof(double) &&
+                                header.num_tiles <= file_size / sizeof(Tile) &&
+                                header.table_size <= file_size / sizeof(int32_t);
+  const bool is_table_size_valid = header.table_size >= NativeVoxelTarget::getTableSize(0) &&
+                                   (header.table_size & (header.table_size - 1)) == 0 &&
+                                   header.num_voxels < header.table_size &&
+                                   header.num_voxels <= std::numeric_limits<int32_t>::max();
+  if (
+    header.file_size != file_size || !(header.resolution > 0.0f) || !are_counts_valid ||
+    !is_table_size_valid) {
+    throw makeError(path, "corrupted header");
+  }
+  for (int section = 0; section < NUM_SECTIONS; ++section) {
+    const uint64_t offset = header.section_offsets[section];
+    if (
+      offset % section_alignment != 0 || offset > file_size ||
+      getSectionSize(header, section) > file_size - offset) {
+      throw makeError(path, "corrupted section offsets");
+    }
+  }
+
+  const auto get_section = [data, &header](const int section) {
+    return data + header.section_offsets[section];
+  };
+  const auto * tiles = reinterpret_cast<const Tile *>(get_section(TILES));
+  for (uint64_t i = 0; i < header.num_tiles; ++i) {
+    if (tiles[i].begin > tiles[i].end || tiles[i].end > header.num_voxels) {
+      throw makeError(path, "corrupted tile index");
+    }
+  }
+
+  NativeVoxelTarget::Voxels voxels;
+  voxels.size = header.num_voxels;
+  voxels.keys = reinterpret_cast<const uint64_t *>(get_section(KEYS));
+  voxels.num_points = reinterpret_cast<const int32_t *>(get_section(NUM_POINTS));
+  voxels.mean_x = reinterpret_cast<const double *>(get_section(MEAN_X));
+  voxels.mean_y = reinterpret_cast<const double *>(get_section(MEAN_Y));
+  voxels.mean_z = reinterpret_cast<const double *>(get_section(MEAN_Z));
+  voxels.icov_xx = reinterpret_cast<const double *>(get_section(ICOV_XX));
+  voxels.icov_xy = reinterpret_cast<const double *>(get_section(ICOV_XY));
+  voxels.icov_xz = reinterpret_cast<const double *>(get_section(ICOV_XZ));
+  voxels.icov_yy = reinterpret_cast<const double *>(get_section(ICOV_YY));
+  voxels.icov_yz = reinterpret_cast<const double *>(get_section(ICOV_YZ));
+  voxels.icov_zz = reinterpret_cast<const double *>(get_section(ICOV_ZZ));
+  const auto * table = reinterpret_cast<const int32_t *>(get_section(TABLE));
+  // find() dereferences the voxel of every probed slot until it reaches an empty one, so the
+  // slots must be voxel indices or -1, and at least one of them must be empty
+  bool has_empty_slot = false;
+  for (uint64_t i = 0; i < header.table_size; ++i) {
+    if (table[i] < -1 || table[i] >= static_cast<int64_t>(header.num_voxels)) {
+      throw makeError(path, "corrupted hash table");
+    }
+    has_empty_slot |= table[i] == -1;
+  }
+  if (!has_empty_slot) {
+    throw makeError(path, "corrupted hash table");
+  }
+  return std::make_shared<const NativeVoxelTarget>(
+    header.resolution, voxels, table, header.table_size, std::move(mapping_ptr));
+}
@@ -0,0 +1,180 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ndt/native_voxel_target.hpp"
+
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <Eigen/LU>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// arrays of the voxels and table built in memory
+struct Storage
+{
+  std::vector<uint64_t> keys;
+  std::vector<int32_t> num_points;
+  std::vector<double> mean_x;
+  std::vector<double> mean_y;
+  std::vector<double> mean_z;
+  std::vector<double> icov_xx;
+  std::vector<double> icov_xy;
+  std::vector<double> icov_xz;
+  std::vector<double> icov_yy;
+  std::vector<double> icov_yz;
+  std::vector<double> icov_zz;
+  std::vector<int32_t> table;
+};
+
+// normal distribution of the points, as computed by pcl::VoxelGridCovariance
+bool computeDistribution(
+  const int32_t num_points, const std::array<double, 9> & sums, Eigen::Vector3d & mean,
+  Eigen::Matrix3d & icov)
+{
+  if (num_points < NativeVoxelTarget::min_points_per_voxel) {
+    return false;
+  }
+
+  const double n = static_cast<double>(num_points);
+  mean << sums[0] / n, sums[1] / n, sums[2] / n;
+  Eigen::Matrix3d cov;
+  cov << sums[3], sums[4], sums[5], sums[4], sums[6], sums[7], sums[5], sums[7], sums[8];
+  cov = (cov / n - mean * mean.transpose()) * ((n - 1.0) / n);
+
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver(cov);
+  Eigen::Vector3d eigenvalues = eigensolver.eigenvalues();
+  if (eigenvalues(0) < 0 || eigenvalues(1) < 0 || eigenvalues(2) <= 0) {
+    return false;
+  }
+
+  // avoid the matrices near singularities (eq 6.11 [Magnusson 2009])
+  const double min_eigenvalue =
+    NativeVoxelTarget::min_covariance_eigenvalue_ratio * eigenvalues(2);
+  if (eigenvalues(0) < min_eigenvalue) {
+    eigenvalues(0) = min_eigenvalue;
+    eigenvalues(1) = std::max(eigenvalues(1), min_eigenvalue);
+    const Eigen::Matrix3d & eigenvectors = eigensolver.eigenvectors();
+    cov = eigenvectors * eigenvalues.asDiagonal() * eigenvectors.transpose();
+  }
+
+  icov = cov.inverse();
+  return icov.allFinite();
+}
+}  // namespace
+
+NativeVoxelTarget::NativeVoxelTarget(
+  float resolution, const Voxels & voxels, const int32_t * table, size_t table_size,
+  std::shared_ptr<const void> storage_ptr)
+: resolution_(resolution),
+  voxels_(voxels),
+  table_(table),
+  table_mask_(table_size - 1),
+  storage_ptr_(std::move(storage_ptr))
+{
+}
+
+std::shared_ptr<const NativeVoxelTarget> NativeVoxelTarget::build(
+  const PointSums & point_sums, float resolution, int num_threads)
+{
+  const size_t num_sums = point_sums.keys.size();
+  std::vector<Eigen::Vector3d> means(num_sums);
+  std::vector<Eigen::Matrix3d> icovs(num_sums);
+  std::vector<char> is_valid(num_sums);
+
+#pragma omp parallel for num_threads(std::max(num_threads, 1)) schedule(static)
+  for (int64_t i = 0; i < static_cast<int64_t>(num_sums); ++i) {
+    is_valid[i] =
+      computeDistribution(point_sums.num_points[i], point_sums.sums[i], means[i], icovs[i]);
+  }
+
+  auto storage_ptr = std::make_shared<Storage>();
+  auto & storage = *storage_ptr;
+  const size_t num_voxels = std::count(is_valid.begin(), is_valid.end(), 1);
+  for (auto * array : {&storage.mean_x, &storage.mean_y, &storage.mean_z, &storage.icov_xx,
+                       &storage.icov_xy, &storage.icov_xz, &storage.icov_yy, &storage.icov_yz,
+                       &storage.icov_zz}) {
+    array->reserve(num_voxels);
+  }
+  storage.keys.reserve(num_voxels);
+  storage.num_points.reserve(num_voxels);
+
+  for (size_t i = 0; i < num_sums; ++i) {
+    if (!is_valid[i]) {
+      continue;
+    }
+    const uint64_t key = point_sums.keys[i];
+    const auto indices = getIndices(key);
+    storage.keys.push_back(key);
+    storage.num_points.push_back(point_sums.num_points[i]);
+    storage.mean_x.push_back(means[i](0) + static_cast<double>(indices[0]) * resolution);
+    storage.mean_y.push_back(means[i](1) + static_cast<double>(indices[1]) * resolution);
+    storage.mean_z.push_back(means[i](2) + static_cast<double>(indices[2]) * resolution);
+    storage.icov_xx.push_back(icovs[i](0, 0));
+    storage.icov_xy.push_back(icovs[i](0, 1));
+    storage.icov_xz.push_back(icovs[i](0, 2));
+    storage.icov_yy.push_back(icovs[i](1, 1));
+    storage.icov_yz.push_back(icovs[i](1, 2));
+    storage.icov_zz.push_back(icovs[i](2, 2));
+  }
+
+  storage.table.resize(getTableSize(num_voxels));
+  fillTable(storage.keys.data(), num_voxels, storage.table.data(), storage.table.size());
+
+  Voxels voxels;
+  voxels.size = num_voxels;
+  voxels.keys = storage.keys.data();
+  voxels.num_points = storage.num_points.data();
+  voxels.mean_x = storage.mean_x.data();
+  voxels.mean_y = storage.mean_y.data();
+  voxels.mean_z = storage.mean_z.data();
+  voxels.icov_xx = storage.icov_xx.data();
+  voxels.icov_xy = storage.icov_xy.data();
+  voxels.icov_xz = storage.icov_xz.data();
+  voxels.icov_yy = storage.icov_yy.data();
+  voxels.icov_yz = storage.icov_yz.data();
+  voxels.icov_zz = storage.icov_zz.data();
+  const int32_t * table = storage.table.data();
+  const size_t table_size = storage.table.size();
+  return std::make_shared<const NativeVoxelTarget>(
+    resolution, voxels, table, table_size, std::move(storage_ptr));
+}
+
+size_t NativeVoxelTarget::getTableSize(size_t num_voxels)
+{
+  size_t table_size = 16;
+  while (table_size < 2 * num_voxels) {
+    table_size *= 2;
+  }
+  return table_size;
+}
+
+void NativeVoxelTarget::fillTable(
+  const uint64_t * keys, size_t num_voxels, int32_t * table, size_t table_size)
+{
+  std::fill(table, table + table_size, -1);
+  const size_t table_mask = table_size - 1;
+  for (size_t i = 0; i < num_voxels; ++i) {
+    size_t slot = hash(keys[i], table_mask);
+    while (table[slot] >= 0) {
+      slot = (slot + 1) & table_mask;
+    }
+    table[slot] = static_cast<int32_t>(i);
+  }
+}
@@ -0,0 +1,166 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ndt/native.hpp"
+
+#include <Eigen/Geometry>
+
+#include <gtest/gtest.h>
+#include <pcl/point_types.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using NDT = NormalDistributionsTransformNative<pcl::PointXYZ, pcl::PointXYZ>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+class NormalDistributionsTransformNativeTest : public ::testing::TestWithParam<int>
+{
+protected:
+  void SetUp() override
+  {
+    // a room with pillars, so that every axis is constrained
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<float> along_x(-10.0f, 12.0f);
+    std::uniform_real_distribution<float> along_y(-7.0f, 9.0f);
+    std::uniform_real_distribution<float> height(0.0f, 4.0f);
+    std::uniform_real_distribution<float> angle(-M_PI, M_PI);
+    std::normal_distribution<float> noise(0.0f, 0.03f);
+    const std::vector<Eigen::Vector2f> pillars = {{3.0f, 2.0f}, {-5.0f, 4.0f}, {8.0f, -3.0f}};
+    map_ptr_ = std::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    for (int i = 0; i < 80000; ++i) {
+      const float h = height(engine);
+      switch (i % 6) {
+        case 0:
+          map_ptr_->push_back(pcl::PointXYZ(along_x(engine), along_y(engine), noise(engine)));
+          break;
+        case 1:
+          map_ptr_->push_back(pcl::PointXYZ(-10.0f + noise(engine), along_y(engine), h));
+          break;
+        case 2:
+          map_ptr_->push_back(pcl::PointXYZ(12.0f + noise(engine), along_y(engine), h));
+          break;
+        case 3:
+          map_ptr_->push_back(pcl::PointXYZ(along_x(engine), -7.0f + noise(engine), h));
+          break;
+        case 4:
+          map_ptr_->push_back(pcl::PointXYZ(along_x(engine), 9.0f + noise(engine), h));
+          break;
+        default: {
+          const auto & pillar = pillars[i % pillars.size()];
+          const float a = angle(engine);
+          map_ptr_->push_back(
+            pcl::PointXYZ(pillar.x() + 0.5f * std::cos(a), pillar.y() + 0.5f * std::sin(a), h));
+        }
+      }
+    }
+
+    // the scan is every 20th point of the map seen from the pose true_pose_
+    const Eigen::AngleAxisf rotation(0.03f, Eigen::Vector3f(0.1f, 0.2f, 1.0f).normalized());
+    true_pose_ = Eigen::Matrix4f::Identity();
+    true_pose_.block<3, 3>(0, 0) = rotation.matrix();
+    true_pose_.block<3, 1>(0, 3) = Eigen::Vector3f(0.3f, -0.2f, 0.05f);
+    const Eigen::Matrix4f inverse = true_pose_.inverse();
+    scan_ptr_ = std::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    for (size_t i = 0; i < map_ptr_->size(); i += 20) {
+      pcl::PointXYZ point = map_ptr_->points[i];
+      point.getVector3fMap() = inverse.block<3, 3>(0, 0) * point.getVector3fMap() +
+                               inverse.block<3, 1>(0, 3);
+      scan_ptr_->push_back(point);
+    }
+
+    ndt_.setResolution(2.0f);
+    ndt_.setStepSize(0.1);
+    ndt_.setTransformationEpsilon(0.01);
+    ndt_.setMaximumIterations(30);
+    ndt_.setNumThreads(2);
+    ndt_.setNeighborhoodSearchMethod(static_cast<pclomp::NeighborSearchMethod>(GetParam()));
+    ndt_.setInputTarget(map_ptr_);
+    ndt_.setInputSource(scan_ptr_);
+  }
+
+  void computeDerivatives(
+    const Vector6d & p, double & score, Vector6d & gradient, Matrix6d & hessian)
+  {
+    NDT::unpack(ndt_.computeDerivatives(p), score, gradient, hessian);
+  }
+
+  NDT ndt_;
+  pcl::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> map_ptr_;
+  pcl::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> scan_ptr_;
+  Eigen::Matrix4f true_pose_;
+};
+
+TEST_P(NormalDistributionsTransformNativeTest, DerivativesMatchFiniteDifferences)
+{
+  Vector6d p;
+  p << 0.2, -0.1, 0.03, 0.01, -0.005, 0.02;
+  double score;
+  Vector6d gradient;
+  Matrix6d hessian;
+  computeDerivatives(p, score, gradient, hessian);
+
+  // central differences of the score and of the gradient, with a step small enough that no point
+  // moves to another voxel
+  constexpr double eps = 1e-7;
+  Vector6d numerical_gradient;
+  Matrix6d numerical_hessian;
+  for (int i = 0; i < 6; ++i) {
+    Vector6d p_plus = p;
+    Vector6d p_minus = p;
+    p_plus(i) += eps;
+    p_minus(i) -= eps;
+    double score_plus;
+    double score_minus;
+    Vector6d gradient_plus;
+    Vector6d gradient_minus;
+    Matrix6d hessian_plus;
+    Matrix6d hessian_minus;
+    computeDerivatives(p_plus, score_plus, gradient_plus, hessian_plus);
+    computeDerivatives(p_minus, score_minus, gradient_minus, hessian_minus);
+    numerical_gradient(i) = (score_plus - score_minus) / (2.0 * eps);
+    numerical_hessian.col(i) = (gradient_plus - gradient_minus) / (2.0 * eps);
+  }
+
+  ASSERT_GT(gradient.norm(), 0.0);
+  EXPECT_LT((gradient - numerical_gradient).norm() / gradient.norm(), 1e-4);
+  EXPECT_LT((hessian - numerical_hessian).norm() / hessian.norm(), 1e-4);
+  EXPECT_LT((hessian - hessian.transpose()).norm(), 1e-9 * hessian.norm());
+}
+
+TEST_P(NormalDistributionsTransformNativeTest, AlignToKnownTransform)
+{
+  // the guess is off by about as much as a predicted pose of ndt_scan_matcher
+  Eigen::Matrix4f guess = true_pose_;
+  guess.block<3, 3>(0, 0) =
+    guess.block<3, 3>(0, 0) * Eigen::AngleAxisf(0.01f, Eigen::Vector3f::UnitZ()).matrix();
+  guess.block<3, 1>(0, 3) += Eigen::Vector3f(0.1f, -0.08f, 0.03f);
+  pcl::PointCloud<pcl::PointXYZ> output;
+  ndt_.align(output, guess);
+
+  const Eigen::Matrix4f result = ndt_.getFinalTransformation();
+  EXPECT_LT((result.block<3, 1>(0, 3) - true_pose_.block<3, 1>(0, 3)).norm(), 0.05f);
+  const Eigen::AngleAxisf rotation_error(
+    Eigen::Matrix3f(result.block<3, 3>(0, 0).transpose() * true_pose_.block<3, 3>(0, 0)));
+  EXPECT_LT(std::abs(rotation_error.angle()), 0.005f);
+  EXPECT_LT(ndt_.getFinalNumIteration(), ndt_.getMaximumIterations());
+  EXPECT_GT(ndt_.getNearestVoxelTransformationLikelihood(), 2.0);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  SearchMethods, NormalDistributionsTransformNativeTest,
+  ::testing::Values(pclomp::DIRECT1, pclomp::DIRECT7, pclomp::DIRECT26));
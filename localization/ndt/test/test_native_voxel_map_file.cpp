@@ -0,0 +1,188 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ndt/native_voxel_map_file.hpp"
+#include "ndt/native_voxel_target.hpp"
+
+#include <gtest/gtest.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// offsets in the header of the file, see src/native_voxel_map_file.cpp
+constexpr size_t num_tiles_offset = 32;
+constexpr size_t table_size_offset = 40;
+constexpr size_t table_section_offset = 56 + 12 * sizeof(uint64_t);
+
+pcl::PointCloud<pcl::PointXYZ> makeCloud()
+{
+  // a floor and two walls, spread over several tiles
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> uniform(-60.0f, 60.0f);
+  std::uniform_real_distribution<float> height(0.0f, 4.0f);
+  std::normal_distribution<float> noise(0.0f, 0.03f);
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  for (int i = 0; i < 60000; ++i) {
+    pcl::PointXYZ point;
+    if (i % 3 == 0) {
+      point = pcl::PointXYZ(uniform(engine), uniform(engine), noise(engine));
+    } else if (i % 3 == 1) {
+      point = pcl::PointXYZ(12.0f + noise(engine), uniform(engine), height(engine));
+    } else {
+      point = pcl::PointXYZ(uniform(engine), -7.0f + noise(engine), height(engine));
+    }
+    cloud.push_back(point);
+  }
+  return cloud;
+}
+
+std::vector<char> readFile(const std::string & path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string & path, const std::vector<char> & bytes)
+{
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  ofs.write(bytes.data(), bytes.size());
+}
+
+template <class T>
+T & at(std::vector<char> & bytes, const size_t offset)
+{
+  return *reinterpret_cast<T *>(bytes.data() + offset);
+}
+
+class NativeVoxelMapFileTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    path_ = ::testing::TempDir() + "test_native_voxel_map_file.ndtvox";
+    target_ptr_ = NativeVoxelTarget::build(makeCloud(), 2.0f);
+    NativeVoxelMapFile::save(path_, *target_ptr_, 20.0f);
+  }
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  // rewrite the saved file with the given change and expect load() to reject it
+  template <class Corrupt>
+  void expectRejected(Corrupt corrupt)
+  {
+    auto bytes = readFile(path_);
+    corrupt(bytes);
+    writeFile(path_, bytes);
+    EXPECT_THROW(NativeVoxelMapFile::load(path_), std::runtime_error);
+  }
+
+  std::string path_;
+  std::shared_ptr<const NativeVoxelTarget> target_ptr_;
+};
+}  // namespace
+
+TEST_F(NativeVoxelMapFileTest, RoundTrip)
+{
+  const auto loaded_ptr = NativeVoxelMapFile::load(path_);
+  ASSERT_NE(loaded_ptr, nullptr);
+  EXPECT_EQ(loaded_ptr->getResolution(), target_ptr_->getResolution());
+
+  const auto & voxels = target_ptr_->getVoxels();
+  const auto & loaded_voxels = loaded_ptr->getVoxels();
+  ASSERT_GT(voxels.size, 0U);
+  ASSERT_EQ(loaded_voxels.size, voxels.size);
+  for (size_t i = 0; i < voxels.size; ++i) {
+    const auto indices = NativeVoxelTarget::getIndices(voxels.keys[i]);
+    const int32_t j = loaded_ptr->find(indices[0], indices[1], indices[2]);
+    ASSERT_GE(j, 0);
+    EXPECT_EQ(loaded_voxels.keys[j], voxels.keys[i]);
+    EXPECT_EQ(loaded_voxels.num_points[j], voxels.num_points[i]);
+    EXPECT_EQ(loaded_voxels.mean_x[j], voxels.mean_x[i]);
+    EXPECT_EQ(loaded_voxels.mean_y[j], voxels.mean_y[i]);
+    EXPECT_EQ(loaded_voxels.mean_z[j], voxels.mean_z[i]);
+    EXPECT_EQ(loaded_voxels.icov_xx[j], voxels.icov_xx[i]);
+    EXPECT_EQ(loaded_voxels.icov_xy[j], voxels.icov_xy[i]);
+    EXPECT_EQ(loaded_voxels.icov_xz[j], voxels.icov_xz[i]);
+    EXPECT_EQ(loaded_voxels.icov_yy[j], voxels.icov_yy[i]);
+    EXPECT_EQ(loaded_voxels.icov_yz[j], voxels.icov_yz[i]);
+    EXPECT_EQ(loaded_voxels.icov_zz[j], voxels.icov_zz[i]);
+  }
+  EXPECT_EQ(loaded_ptr->find(100000, 0, 0), -1);
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectMissingFile)
+{
+  EXPECT_THROW(NativeVoxelMapFile::load(path_ + ".missing"), std::runtime_error);
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectWrongMagic)
+{
+  expectRejected([](std::vector<char> & bytes) { bytes[0] = 'X'; });
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectTruncatedFile)
+{
+  expectRejected([](std::vector<char> & bytes) { bytes.resize(bytes.size() - 64); });
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectOverflowingCounts)
+{
+  expectRejected([](std::vector<char> & bytes) {
+    at<uint64_t>(bytes, num_tiles_offset) = UINT64_MAX / 24 + 1;
+  });
+  expectRejected([](std::vector<char> & bytes) {
+    at<uint64_t>(bytes, table_size_offset) = uint64_t{1} << 62;
+  });
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectTableOutOfVoxels)
+{
+  expectRejected([](std::vector<char> & bytes) {
+    const uint64_t table_offset = at<uint64_t>(bytes, table_section_offset);
+    const uint64_t table_size = at<uint64_t>(bytes, table_size_offset);
+    for (uint64_t i = 0; i < table_size; ++i) {
+      int32_t & slot = at<int32_t>(bytes, table_offset + i * sizeof(int32_t));
+      if (slot == -1) {
+        slot = 1000000000;
+      }
+    }
+  });
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectTableWithoutEmptySlot)
+{
+  expectRejected([](std::vector<char> & bytes) {
+    const uint64_t table_offset = at<uint64_t>(bytes, table_section_offset);
+    const uint64_t table_size = at<uint64_t>(bytes, table_size_offset);
+    for (uint64_t i = 0; i < table_size; ++i) {
+      at<int32_t>(bytes, table_offset + i * sizeof(int32_t)) = 0;
+    }
+  });
+}
+
+TEST_F(NativeVoxelMapFileTest, RejectNonPositiveTileSize)
+{
+  EXPECT_THROW(NativeVoxelMapFile::save(path_, *target_ptr_, 0.0f), std::runtime_error);
+  EXPECT_THROW(NativeVoxelMapFile::save(path_, *target_ptr_, -20.0f), std::runtime_error);
+  // the file of SetUp() is left as it was
+  EXPECT_NE(NativeVoxelMapFile::load(path_), nullptr);
+}
@@ -19,6 +19,8 @@
 
 #include "ndt_scan_matcher/particle.hpp"
 
+#include <map_loader/differential_map_client.hpp>
+#include <ndt/native.hpp>
 #include <ndt/omp.hpp>
 #include <ndt/pcl_generic.hpp>
 #include <ndt/pcl_modified.hpp>
@@ -54,15 +56,20 @@
 #endif
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <future>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 
-enum class NDTImplementType { PCL_GENERIC = 0, PCL_MODIFIED = 1, OMP = 2 };
+enum class NDTImplementType { PCL_GENERIC = 0, PCL_MODIFIED = 1, OMP = 2, NATIVE = 3 };
 enum class ConvergedParamType {
   TRANSFORM_PROBABILITY = 0,
   NEAREST_VOXEL_TRANSFORMATION_LIKELIHOOD = 1
@@ -85,6 +92,10 @@ std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> getN
     ndt_ptr.reset(new NormalDistributionsTransformOMP<PointSource, PointTarget>);
     return ndt_ptr;
   }
+  if (ndt_mode == NDTImplementType::NATIVE) {
+    ndt_ptr.reset(new NormalDistributionsTransformNative<PointSource, PointTarget>);
+    return ndt_ptr;
+  }
 
   const std::string s = fmt::format("Unknown NDT type {}", static_cast<int>(ndt_mode));
   throw std::runtime_error(s);
@@ -105,19 +116,41 @@ class NDTScanMatcher : public rclcpp::Node
 
 public:
   NDTScanMatcher();
+  ~NDTScanMatcher();
 
 private:
+  // copies of an instance of ndt_ptr_ for the other threads of the initial pose estimation
+  struct NDTCopies
+  {
+    std::weak_ptr<const NormalDistributionsTransformBase<PointSource, PointTarget>> original_ptr;
+    std::vector<std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>>> ptrs;
+  };
+
+  bool loadVoxelMap(const std::string & voxel_map_path);
+  void setOMPParams(
+    const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr)
+    const;
+
   void serviceNDTAlign(
     const tier4_localization_msgs::srv::PoseWithCovarianceStamped::Request::SharedPtr req,
     tier4_localization_msgs::srv::PoseWithCovarianceStamped::Response::SharedPtr res);
 
   void callbackMapPoints(sensor_msgs::msg::PointCloud2::ConstSharedPtr pointcloud2_msg_ptr);
+  void updateMapTarget(const pcl::shared_ptr<pcl::PointCloud<PointTarget>> & map_points_ptr);
+  bool waitForMapUpdate(const std::chrono::steady_clock::time_point & deadline);
+  void threadUpdateMap();
+  void timerUpdateMap();
+  std::optional<std::shared_future<bool>> requestMapUpdate(
+    const geometry_msgs::msg::Point & position);
   void callbackSensorPoints(sensor_msgs::msg::PointCloud2::ConstSharedPtr pointcloud2_msg_ptr);
   void callbackInitialPose(
     geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr pose_conv_msg_ptr);
   void callbackRegularizationPose(
     geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr pose_conv_msg_ptr);
 
+  std::shared_ptr<NDTCopies> makeNDTCopies(
+    const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr)
+    const;
   geometry_msgs::msg::PoseWithCovarianceStamped alignUsingMonteCarlo(
     const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr,
     const geometry_msgs::msg::PoseWithCovarianceStamped & initial_pose_with_cov);
@@ -141,6 +174,7 @@ private:
     const rclcpp::Time & sensor_ros_time);
 
   void timerDiagnostic();
+  void setKeyValue(const std::string & key, const std::string & value);
 
   rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr initial_pose_sub_;
   rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr map_points_sub_;
@@ -171,6 +205,7 @@ private:
   rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub_;
 
   rclcpp::Service<tier4_localization_msgs::srv::PoseWithCovarianceStamped>::SharedPtr service_;
+  rclcpp::TimerBase::SharedPtr map_update_timer_;
 
   tf2_ros::Buffer tf2_buffer_;
   tf2_ros::TransformListener tf2_listener_;
@@ -178,6 +213,8 @@ private:
 
   NDTImplementType ndt_implement_type_;
   std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> ndt_ptr_;
+  // made with each target, so that the requests do not copy the target
+  std::shared_ptr<NDTCopies> ndt_copies_ptr_;
 
   Eigen::Matrix4f base_to_sensor_matrix_;
   std::string base_frame_;
@@ -189,6 +226,9 @@ private:
   double converged_param_nearest_voxel_transformation_likelihood_;
 
   int initial_estimate_particles_num_;
+  int initial_estimate_num_threads_;
+  bool initial_estimate_early_termination_;
+  int initial_estimate_random_seed_;
   double initial_pose_timeout_sec_;
   double initial_pose_distance_tolerance_m_;
   float inversion_vector_threshold_;
@@ -199,12 +239,35 @@ private:
     initial_pose_msg_ptr_array_;
   std::mutex ndt_map_mtx_;
   std::mutex initial_pose_array_mtx_;
+  pcl::shared_ptr<pcl::PointCloud<PointSource>> latest_sensor_points_ptr_;
+
+  // the NDT target is built in this thread, and replaces ndt_ptr_ when it is ready
+  std::thread map_update_thread_;
+  std::mutex map_update_mtx_;
+  std::condition_variable map_update_cv_;
+  // at most one of them is set, with the latest map
+  pcl::shared_ptr<pcl::PointCloud<PointTarget>> pending_map_points_ptr_;
+  sensor_msgs::msg::PointCloud2::ConstSharedPtr pending_map_points_msg_ptr_;
+  std::atomic<bool> is_map_updating_;
+  bool is_map_update_thread_stopped_;
+  std::atomic<int> scans_during_map_update_;
 
   OMPParams omp_params_;
 
   std::thread diagnostic_thread_;
+  // values of the diagnostics, written by the callbacks and the map thread
+  std::mutex key_value_stdmap_mtx_;
   std::map<std::string, std::string> key_value_stdmap_;
 
+  // variables for dynamic map loading
+  bool use_dynamic_map_loading_;
+  double dynamic_map_loading_update_distance_;
+  double dynamic_map_loading_map_radius_;
+  double dynamic_map_loading_timeout_sec_;
+  std::unique_ptr<map_loader::DifferentialMapClient<PointTarget>> differential_map_client_;
+  std::optional<geometry_msgs::msg::Point> last_map_update_position_;
+  std::mutex map_request_mtx_;
+
   // variables for regularization
   const bool regularization_enabled_;
   const float regularization_scale_factor_;
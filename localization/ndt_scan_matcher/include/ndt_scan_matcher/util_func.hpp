@@ -71,7 +71,8 @@ void popOldPose(
 Eigen::Affine3d fromRosPoseToEigen(const geometry_msgs::msg::Pose & ros_pose);
 
 std::vector<geometry_msgs::msg::Pose> createRandomPoseArray(
-  const geometry_msgs::msg::PoseWithCovarianceStamped & base_pose_with_cov, const int particle_num);
+  const geometry_msgs::msg::PoseWithCovarianceStamped & base_pose_with_cov, const int particle_num,
+  const unsigned int seed);
 
 template <class T>
 T transform(const T & input, const geometry_msgs::msg::TransformStamped & transform)
@@ -19,6 +19,7 @@
 #include "ndt_scan_matcher/particle.hpp"
 #include "ndt_scan_matcher/util_func.hpp"
 
+#include <ndt/native_voxel_map_file.hpp>
 #include <tier4_autoware_utils/geometry/geometry.hpp>
 #include <tier4_autoware_utils/ros/marker_helper.hpp>
 
@@ -30,10 +31,16 @@
 #include <tf2_eigen/tf2_eigen.hpp>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <algorithm>
 #include <cmath>
 #include <functional>
 #include <iomanip>
+#include <optional>
+#include <random>
 #include <thread>
 
 tier4_debug_msgs::msg::Float32Stamped makeFloat32Stamped(
@@ -69,6 +76,17 @@ double norm(const geometry_msgs::msg::Point & p1, const geometry_msgs::msg::Poin
     std::pow(p1.x - p2.x, 2.0) + std::pow(p1.y - p2.y, 2.0) + std::pow(p1.z - p2.z, 2.0));
 }
 
+// a native NDT given a voxel map has no target points
+template <class PointSource, class PointTarget>
+bool hasInputTarget(
+  const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr)
+{
+  using T = NormalDistributionsTransformNative<PointSource, PointTarget>;
+  const auto ndt_native_ptr = std::dynamic_pointer_cast<T>(ndt_ptr);
+  return ndt_ptr->getInputTarget() != nullptr ||
+         (ndt_native_ptr != nullptr && ndt_native_ptr->getVoxelTarget() != nullptr);
+}
+
 bool isLocalOptimalSolutionOscillation(
   const std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> &
     result_pose_matrix_array,
@@ -109,14 +127,22 @@ NDTScanMatcher::NDTScanMatcher()
   converged_param_transform_probability_(4.5),
   converged_param_nearest_voxel_transformation_likelihood_(2.3),
   initial_estimate_particles_num_(100),
+  initial_estimate_num_threads_(1),
+  initial_estimate_early_termination_(false),
+  initial_estimate_random_seed_(-1),
   initial_pose_timeout_sec_(1.0),
   initial_pose_distance_tolerance_m_(10.0),
   inversion_vector_threshold_(-0.9),
   oscillation_threshold_(10),
+  is_map_updating_(false),
+  is_map_update_thread_stopped_(false),
+  scans_during_map_update_(0),
   regularization_enabled_(declare_parameter("regularization_enabled", false)),
   regularization_scale_factor_(declare_parameter("regularization_scale_factor", 0.01))
 {
   key_value_stdmap_["state"] = "Initializing";
+  key_value_stdmap_["map_update_time_ms"] = "0";
+  key_value_stdmap_["scans_during_map_update"] = "0";
 
   int ndt_implement_type_tmp = this->declare_parameter("ndt_implement_type", 0);
   ndt_implement_type_ = static_cast<NDTImplementType>(ndt_implement_type_tmp);
@@ -129,21 +155,17 @@ NDTScanMatcher::NDTScanMatcher()
     return;
   }
 
-  if (ndt_implement_type_ == NDTImplementType::OMP) {
-    using T = NormalDistributionsTransformOMP<PointSource, PointTarget>;
-
-    // FIXME(IshitaTakeshi) Not sure if this is safe
-    std::shared_ptr<T> ndt_omp_ptr = std::dynamic_pointer_cast<T>(ndt_ptr_);
+  if (
+    ndt_implement_type_ == NDTImplementType::OMP ||
+    ndt_implement_type_ == NDTImplementType::NATIVE) {
     int search_method = static_cast<int>(omp_params_.search_method);
     search_method = this->declare_parameter("omp_neighborhood_search_method", search_method);
     omp_params_.search_method = static_cast<pclomp::NeighborSearchMethod>(search_method);
     // TODO(Tier IV): check search_method is valid value.
-    ndt_omp_ptr->setNeighborhoodSearchMethod(omp_params_.search_method);
 
     omp_params_.num_threads = this->declare_parameter("omp_num_threads", omp_params_.num_threads);
     omp_params_.num_threads = std::max(omp_params_.num_threads, 1);
-    ndt_omp_ptr->setNumThreads(omp_params_.num_threads);
-    ndt_ptr_ = ndt_omp_ptr;
+    setOMPParams(ndt_ptr_);
   }
 
   int points_queue_size = this->declare_parameter("input_sensor_points_queue_size", 0);
@@ -174,15 +196,19 @@ NDTScanMatcher::NDTScanMatcher()
     get_logger(), "trans_epsilon: %lf, step_size: %lf, resolution: %lf, max_iterations: %d",
     trans_epsilon, step_size, resolution, max_iterations);
 
+  const std::string voxel_map_path = this->declare_parameter("ndt_voxel_map_path", std::string{});
+  const bool use_voxel_map = !voxel_map_path.empty() && loadVoxelMap(voxel_map_path);
+
   int converged_param_type_tmp = this->declare_parameter("converged_param_type", 0);
   converged_param_type_ = static_cast<ConvergedParamType>(converged_param_type_tmp);
   if (
     ndt_implement_type_ != NDTImplementType::OMP &&
+    ndt_implement_type_ != NDTImplementType::NATIVE &&
     converged_param_type_ == ConvergedParamType::NEAREST_VOXEL_TRANSFORMATION_LIKELIHOOD) {
     RCLCPP_ERROR(
       get_logger(),
       "ConvergedParamType::NEAREST_VOXEL_TRANSFORMATION_LIKELIHOOD is only available when "
-      "NDTImplementType::OMP is selected.");
+      "NDTImplementType::OMP or NDTImplementType::NATIVE is selected.");
     return;
   }
 
@@ -194,6 +220,13 @@ NDTScanMatcher::NDTScanMatcher()
 
   initial_estimate_particles_num_ =
     this->declare_parameter("initial_estimate_particles_num", initial_estimate_particles_num_);
+  initial_estimate_num_threads_ =
+    this->declare_parameter("initial_estimate_num_threads", initial_estimate_num_threads_);
+  initial_estimate_num_threads_ = std::max(initial_estimate_num_threads_, 1);
+  initial_estimate_early_termination_ = this->declare_parameter(
+    "initial_estimate_early_termination", initial_estimate_early_termination_);
+  initial_estimate_random_seed_ =
+    this->declare_parameter("initial_estimate_random_seed", initial_estimate_random_seed_);
 
   initial_pose_timeout_sec_ =
     this->declare_parameter("initial_pose_timeout_sec", initial_pose_timeout_sec_);
@@ -207,6 +240,18 @@ NDTScanMatcher::NDTScanMatcher()
     output_pose_covariance_[i] = output_pose_covariance[i];
   }
 
+  use_dynamic_map_loading_ = this->declare_parameter("use_dynamic_map_loading", false);
+  if (use_voxel_map && use_dynamic_map_loading_) {
+    RCLCPP_WARN(get_logger(), "The dynamic map loading is disabled since the voxel map is used.");
+    use_dynamic_map_loading_ = false;
+  }
+  dynamic_map_loading_update_distance_ =
+    this->declare_parameter("dynamic_map_loading_update_distance", 20.0);
+  dynamic_map_loading_map_radius_ =
+    this->declare_parameter("dynamic_map_loading_map_radius", 150.0);
+  dynamic_map_loading_timeout_sec_ =
+    this->declare_parameter("dynamic_map_loading_timeout_sec", 10.0);
+
   rclcpp::CallbackGroup::SharedPtr initial_pose_callback_group;
   initial_pose_callback_group =
     this->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
@@ -224,9 +269,21 @@ NDTScanMatcher::NDTScanMatcher()
     "ekf_pose_with_covariance", 100,
     std::bind(&NDTScanMatcher::callbackInitialPose, this, std::placeholders::_1),
     initial_pose_sub_opt);
-  map_points_sub_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
-    "pointcloud_map", rclcpp::QoS{1}.transient_local(),
-    std::bind(&NDTScanMatcher::callbackMapPoints, this, std::placeholders::_1), main_sub_opt);
+  if (use_dynamic_map_loading_) {
+    // the responses are received while the service of the initial pose waits for them in the main
+    // callback group
+    rclcpp::CallbackGroup::SharedPtr map_update_callback_group =
+      this->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    differential_map_client_ = std::make_unique<map_loader::DifferentialMapClient<PointTarget>>(
+      this, "pcd_loader_service", map_update_callback_group);
+    map_update_timer_ = rclcpp::create_timer(
+      this, this->get_clock(), rclcpp::Duration::from_seconds(1.0),
+      std::bind(&NDTScanMatcher::timerUpdateMap, this), map_update_callback_group);
+  } else if (!use_voxel_map) {
+    map_points_sub_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
+      "pointcloud_map", rclcpp::QoS{1}.transient_local(),
+      std::bind(&NDTScanMatcher::callbackMapPoints, this, std::placeholders::_1), main_sub_opt);
+  }
   sensor_points_sub_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
     "points_raw", rclcpp::SensorDataQoS().keep_last(points_queue_size),
     std::bind(&NDTScanMatcher::callbackSensorPoints, this, std::placeholders::_1), main_sub_opt);
@@ -275,6 +332,20 @@ NDTScanMatcher::NDTScanMatcher()
 
   diagnostic_thread_ = std::thread(&NDTScanMatcher::timerDiagnostic, this);
   diagnostic_thread_.detach();
+
+  map_update_thread_ = std::thread(&NDTScanMatcher::threadUpdateMap, this);
+}
+
+NDTScanMatcher::~NDTScanMatcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(map_update_mtx_);
+    is_map_update_thread_stopped_ = true;
+  }
+  map_update_cv_.notify_all();
+  if (map_update_thread_.joinable()) {
+    map_update_thread_.join();
+  }
 }
 
 void NDTScanMatcher::timerDiagnostic()
@@ -285,7 +356,14 @@ void NDTScanMatcher::timerDiagnostic()
     diag_status_msg.name = "ndt_scan_matcher";
     diag_status_msg.hardware_id = "";
 
-    for (const auto & key_value : key_value_stdmap_) {
+    // copied, as the callbacks and the map thread write it meanwhile
+    std::map<std::string, std::string> key_value_stdmap;
+    {
+      std::lock_guard<std::mutex> lock(key_value_stdmap_mtx_);
+      key_value_stdmap = key_value_stdmap_;
+    }
+
+    for (const auto & key_value : key_value_stdmap) {
       diagnostic_msgs::msg::KeyValue key_value_msg;
       key_value_msg.key = key_value.first;
       key_value_msg.value = key_value.second;
@@ -294,26 +372,26 @@ void NDTScanMatcher::timerDiagnostic()
 
     diag_status_msg.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
     diag_status_msg.message = "";
-    if (key_value_stdmap_.count("state") && key_value_stdmap_["state"] == "Initializing") {
+    if (key_value_stdmap.count("state") && key_value_stdmap.at("state") == "Initializing") {
       diag_status_msg.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
       diag_status_msg.message += "Initializing State. ";
     }
     if (
-      key_value_stdmap_.count("skipping_publish_num") &&
-      std::stoi(key_value_stdmap_["skipping_publish_num"]) > 1) {
+      key_value_stdmap.count("skipping_publish_num") &&
+      std::stoi(key_value_stdmap.at("skipping_publish_num")) > 1) {
       diag_status_msg.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
       diag_status_msg.message += "skipping_publish_num > 1. ";
     }
     if (
-      key_value_stdmap_.count("skipping_publish_num") &&
-      std::stoi(key_value_stdmap_["skipping_publish_num"]) >= 5) {
+      key_value_stdmap.count("skipping_publish_num") &&
+      std::stoi(key_value_stdmap.at("skipping_publish_num")) >= 5) {
       diag_status_msg.level = diagnostic_msgs::msg::DiagnosticStatus::ERROR;
       diag_status_msg.message += "skipping_publish_num exceed limit. ";
     }
     // Ignore local optimal solution
     if (
-      key_value_stdmap_.count("is_local_optimal_solution_oscillation") &&
-      std::stoi(key_value_stdmap_["is_local_optimal_solution_oscillation"])) {
+      key_value_stdmap.count("is_local_optimal_solution_oscillation") &&
+      std::stoi(key_value_stdmap.at("is_local_optimal_solution_oscillation"))) {
       diag_status_msg.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
       diag_status_msg.message = "local optimal solution oscillation occurred";
     }
@@ -328,6 +406,61 @@ void NDTScanMatcher::timerDiagnostic()
   }
 }
 
+void NDTScanMatcher::setKeyValue(const std::string & key, const std::string & value)
+{
+  std::lock_guard<std::mutex> lock(key_value_stdmap_mtx_);
+  key_value_stdmap_[key] = value;
+}
+
+bool NDTScanMatcher::loadVoxelMap(const std::string & voxel_map_path)
+{
+  if (ndt_implement_type_ != NDTImplementType::NATIVE) {
+    RCLCPP_ERROR(
+      get_logger(),
+      "ndt_voxel_map_path is only available when NDTImplementType::NATIVE is selected.");
+    return false;
+  }
+
+  std::shared_ptr<const NativeVoxelTarget> voxel_target_ptr;
+  try {
+    voxel_target_ptr = NativeVoxelMapFile::load(voxel_map_path);
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(get_logger(), "%s", e.what());
+    return false;
+  }
+  if (voxel_target_ptr->getResolution() != ndt_ptr_->getResolution()) {
+    RCLCPP_WARN(
+      get_logger(), "The resolution of the voxel map %f replaces the resolution parameter %f",
+      voxel_target_ptr->getResolution(), ndt_ptr_->getResolution());
+  }
+
+  using T = NormalDistributionsTransformNative<PointSource, PointTarget>;
+  std::dynamic_pointer_cast<T>(ndt_ptr_)->setVoxelTarget(voxel_target_ptr);
+  RCLCPP_INFO(
+    get_logger(), "Loaded %zu voxels from %s", voxel_target_ptr->getVoxels().size,
+    voxel_map_path.c_str());
+  return true;
+}
+
+void NDTScanMatcher::setOMPParams(
+  const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr) const
+{
+  if (ndt_implement_type_ == NDTImplementType::OMP) {
+    using T = NormalDistributionsTransformOMP<PointSource, PointTarget>;
+
+    // FIXME(IshitaTakeshi) Not sure if this is safe
+    std::shared_ptr<T> ndt_omp_ptr = std::dynamic_pointer_cast<T>(ndt_ptr);
+    ndt_omp_ptr->setNeighborhoodSearchMethod(omp_params_.search_method);
+    ndt_omp_ptr->setNumThreads(omp_params_.num_threads);
+  } else if (ndt_implement_type_ == NDTImplementType::NATIVE) {
+    using T = NormalDistributionsTransformNative<PointSource, PointTarget>;
+
+    std::shared_ptr<T> ndt_native_ptr = std::dynamic_pointer_cast<T>(ndt_ptr);
+    ndt_native_ptr->setNeighborhoodSearchMethod(omp_params_.search_method);
+    ndt_native_ptr->setNumThreads(omp_params_.num_threads);
+  }
+}
+
 void NDTScanMatcher::serviceNDTAlign(
   const tier4_localization_msgs::srv::PoseWithCovarianceStamped::Request::SharedPtr req,
   tier4_localization_msgs::srv::PoseWithCovarianceStamped::Response::SharedPtr res)
@@ -339,26 +472,50 @@ void NDTScanMatcher::serviceNDTAlign(
   // transform pose_frame to map_frame
   const auto mapTF_initial_pose_msg = transform(req->pose_with_covariance, *TF_pose_to_map_ptr);
 
-  if (ndt_ptr_->getInputTarget() == nullptr) {
+  if (use_dynamic_map_loading_) {
+    // wait for the request of the timer if any, and then for the map around the initial pose
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration<double>(dynamic_map_loading_timeout_sec_);
+    auto map_updated = requestMapUpdate(mapTF_initial_pose_msg.pose.pose.position);
+    while (!map_updated && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      map_updated = requestMapUpdate(mapTF_initial_pose_msg.pose.pose.position);
+    }
+    if (
+      !map_updated || map_updated->wait_until(deadline) != std::future_status::ready ||
+      !map_updated->get() || !waitForMapUpdate(deadline)) {
+      res->success = false;
+      res->seq = req->seq;
+      RCLCPP_WARN(get_logger(), "Failed to load the map around the initial pose");
+      return;
+    }
+  }
+
+  // mutex Map
+  std::lock_guard<std::mutex> lock(ndt_map_mtx_);
+  const auto ndt_ptr = std::atomic_load(&ndt_ptr_);
+
+  if (!hasInputTarget(ndt_ptr)) {
     res->success = false;
     res->seq = req->seq;
     RCLCPP_WARN(get_logger(), "No InputTarget");
     return;
   }
 
-  if (ndt_ptr_->getInputSource() == nullptr) {
+  // an instance built by the map thread gets the scan of the next sensor callback
+  if (ndt_ptr->getInputSource() == nullptr && latest_sensor_points_ptr_ != nullptr) {
+    ndt_ptr->setInputSource(latest_sensor_points_ptr_);
+  }
+  if (ndt_ptr->getInputSource() == nullptr) {
     res->success = false;
     res->seq = req->seq;
     RCLCPP_WARN(get_logger(), "No InputSource");
     return;
   }
 
-  // mutex Map
-  std::lock_guard<std::mutex> lock(ndt_map_mtx_);
-
-  key_value_stdmap_["state"] = "Aligning";
-  res->pose_with_covariance = alignUsingMonteCarlo(ndt_ptr_, mapTF_initial_pose_msg);
-  key_value_stdmap_["state"] = "Sleeping";
+  setKeyValue("state", "Aligning");
+  res->pose_with_covariance = alignUsingMonteCarlo(ndt_ptr, mapTF_initial_pose_msg);
+  setKeyValue("state", "Sleeping");
   res->success = true;
   res->seq = req->seq;
   res->pose_with_covariance.pose.covariance = req->pose_with_covariance.pose.covariance;
@@ -404,42 +561,148 @@ void NDTScanMatcher::callbackRegularizationPose(
 void NDTScanMatcher::callbackMapPoints(
   sensor_msgs::msg::PointCloud2::ConstSharedPtr map_points_msg_ptr)
 {
-  const auto trans_epsilon = ndt_ptr_->getTransformationEpsilon();
-  const auto step_size = ndt_ptr_->getStepSize();
-  const auto resolution = ndt_ptr_->getResolution();
-  const auto max_iterations = ndt_ptr_->getMaximumIterations();
+  // converted by the map thread, so that a large map does not block the callbacks
+  {
+    std::lock_guard<std::mutex> lock(map_update_mtx_);
+    pending_map_points_msg_ptr_ = map_points_msg_ptr;
+    pending_map_points_ptr_.reset();
+  }
+  map_update_cv_.notify_all();
+}
 
-  using NDTBase = NormalDistributionsTransformBase<PointSource, PointTarget>;
-  std::shared_ptr<NDTBase> new_ndt_ptr = getNDT<PointSource, PointTarget>(ndt_implement_type_);
+void NDTScanMatcher::updateMapTarget(
+  const pcl::shared_ptr<pcl::PointCloud<PointTarget>> & map_points_ptr)
+{
+  // only the latest map is built if the maps come faster than they are built
+  {
+    std::lock_guard<std::mutex> lock(map_update_mtx_);
+    pending_map_points_ptr_ = map_points_ptr;
+    pending_map_points_msg_ptr_.reset();
+  }
+  map_update_cv_.notify_all();
+}
 
-  if (ndt_implement_type_ == NDTImplementType::OMP) {
-    using T = NormalDistributionsTransformOMP<PointSource, PointTarget>;
+bool NDTScanMatcher::waitForMapUpdate(const std::chrono::steady_clock::time_point & deadline)
+{
+  std::unique_lock<std::mutex> lock(map_update_mtx_);
+  return map_update_cv_.wait_until(lock, deadline, [this]() {
+    return pending_map_points_ptr_ == nullptr && pending_map_points_msg_ptr_ == nullptr &&
+           !is_map_updating_;
+  });
+}
 
-    // FIXME(IshitaTakeshi) Not sure if this is safe
-    std::shared_ptr<T> ndt_omp_ptr = std::dynamic_pointer_cast<T>(ndt_ptr_);
-    ndt_omp_ptr->setNeighborhoodSearchMethod(omp_params_.search_method);
-    ndt_omp_ptr->setNumThreads(omp_params_.num_threads);
-    new_ndt_ptr = ndt_omp_ptr;
+void NDTScanMatcher::threadUpdateMap()
+{
+  while (true) {
+    pcl::shared_ptr<pcl::PointCloud<PointTarget>> map_points_ptr;
+    sensor_msgs::msg::PointCloud2::ConstSharedPtr map_points_msg_ptr;
+    {
+      std::unique_lock<std::mutex> lock(map_update_mtx_);
+      map_update_cv_.wait(lock, [this]() {
+        return pending_map_points_ptr_ != nullptr || pending_map_points_msg_ptr_ != nullptr ||
+               is_map_update_thread_stopped_;
+      });
+      if (is_map_update_thread_stopped_) {
+        return;
+      }
+      map_points_ptr = pending_map_points_ptr_;
+      map_points_msg_ptr = pending_map_points_msg_ptr_;
+      pending_map_points_ptr_.reset();
+      pending_map_points_msg_ptr_.reset();
+      is_map_updating_ = true;
+      scans_during_map_update_ = 0;
+    }
+    const auto update_start_time = std::chrono::steady_clock::now();
+    if (map_points_msg_ptr) {
+      map_points_ptr.reset(new pcl::PointCloud<PointTarget>);
+      pcl::fromROSMsg(*map_points_msg_ptr, *map_points_ptr);
+    }
+
+    // the parameters are not changed after the constructor
+    const auto ndt_ptr = std::atomic_load(&ndt_ptr_);
+    const auto trans_epsilon = ndt_ptr->getTransformationEpsilon();
+    const auto step_size = ndt_ptr->getStepSize();
+    const auto resolution = ndt_ptr->getResolution();
+    const auto max_iterations = ndt_ptr->getMaximumIterations();
+
+    using NDTBase = NormalDistributionsTransformBase<PointSource, PointTarget>;
+    std::shared_ptr<NDTBase> new_ndt_ptr = getNDT<PointSource, PointTarget>(ndt_implement_type_);
+
+    setOMPParams(new_ndt_ptr);
+
+    new_ndt_ptr->setTransformationEpsilon(trans_epsilon);
+    new_ndt_ptr->setStepSize(step_size);
+    new_ndt_ptr->setResolution(resolution);
+    new_ndt_ptr->setMaximumIterations(max_iterations);
+    new_ndt_ptr->setRegularizationScaleFactor(regularization_scale_factor_);
+
+    new_ndt_ptr->setInputTarget(map_points_ptr);
+    auto output_cloud = std::make_shared<pcl::PointCloud<PointSource>>();
+    new_ndt_ptr->align(*output_cloud, Eigen::Matrix4f::Identity());
+
+    // the copies for the initial pose estimation are made here rather than in the request
+    const auto new_ndt_copies_ptr = makeNDTCopies(new_ndt_ptr);
+
+    // swap, while the sensor callback keeps the previous instance until its scan is aligned
+    std::atomic_store(&ndt_ptr_, new_ndt_ptr);
+    std::atomic_store(&ndt_copies_ptr_, new_ndt_copies_ptr);
+
+    const auto update_end_time = std::chrono::steady_clock::now();
+    const double update_time_ms =
+      std::chrono::duration<double, std::milli>(update_end_time - update_start_time).count();
+    setKeyValue("map_update_time_ms", std::to_string(update_time_ms));
+    setKeyValue("scans_during_map_update", std::to_string(scans_during_map_update_));
+    {
+      std::lock_guard<std::mutex> lock(map_update_mtx_);
+      is_map_updating_ = false;
+    }
+    map_update_cv_.notify_all();
   }
+}
 
-  new_ndt_ptr->setTransformationEpsilon(trans_epsilon);
-  new_ndt_ptr->setStepSize(step_size);
-  new_ndt_ptr->setResolution(resolution);
-  new_ndt_ptr->setMaximumIterations(max_iterations);
-  new_ndt_ptr->setRegularizationScaleFactor(regularization_scale_factor_);
+void NDTScanMatcher::timerUpdateMap()
+{
+  geometry_msgs::msg::Point current_position;
+  {
+    std::lock_guard<std::mutex> initial_pose_array_lock(initial_pose_array_mtx_);
+    if (initial_pose_msg_ptr_array_.empty()) {
+      return;
+    }
+    current_position = initial_pose_msg_ptr_array_.back()->pose.pose.position;
+  }
 
-  pcl::shared_ptr<pcl::PointCloud<PointTarget>> map_points_ptr(new pcl::PointCloud<PointTarget>);
-  pcl::fromROSMsg(*map_points_msg_ptr, *map_points_ptr);
-  new_ndt_ptr->setInputTarget(map_points_ptr);
-  // create Thread
-  // detach
-  auto output_cloud = std::make_shared<pcl::PointCloud<PointSource>>();
-  new_ndt_ptr->align(*output_cloud, Eigen::Matrix4f::Identity());
+  {
+    std::lock_guard<std::mutex> lock(map_request_mtx_);
+    if (
+      last_map_update_position_ &&
+      norm(current_position, *last_map_update_position_) < dynamic_map_loading_update_distance_) {
+      return;
+    }
+  }
+  requestMapUpdate(current_position);
+}
 
-  // swap
-  ndt_map_mtx_.lock();
-  ndt_ptr_ = new_ndt_ptr;
-  ndt_map_mtx_.unlock();
+std::optional<std::shared_future<bool>> NDTScanMatcher::requestMapUpdate(
+  const geometry_msgs::msg::Point & position)
+{
+  // the tiles are kept by the client, and the target is rebuilt from the tiles around the vehicle
+  // the position is kept only once the tiles are updated, so that a failed request is sent again
+  return differential_map_client_->requestUpdate(
+    position, dynamic_map_loading_map_radius_,
+    [this, position](const map_loader::DifferentialMapClient<PointTarget>::MapUpdate & map_update) {
+      {
+        std::lock_guard<std::mutex> lock(map_request_mtx_);
+        last_map_update_position_ = position;
+      }
+      if (map_update.added_tiles.empty() && map_update.removed_ids.empty()) {
+        return;
+      }
+      RCLCPP_INFO(
+        get_logger(), "Update the map: %zu tiles added, %zu tiles removed, %zu tiles in total",
+        map_update.added_tiles.size(), map_update.removed_ids.size(),
+        differential_map_client_->getNumTiles());
+      updateMapTarget(differential_map_client_->getMap());
+    });
 }
 
 void NDTScanMatcher::callbackSensorPoints(
@@ -448,6 +711,11 @@ void NDTScanMatcher::callbackSensorPoints(
   const auto exe_start_time = std::chrono::system_clock::now();
   // mutex Map
   std::lock_guard<std::mutex> lock(ndt_map_mtx_);
+  // the map thread may replace ndt_ptr_ while this scan is aligned
+  const auto ndt_ptr = std::atomic_load(&ndt_ptr_);
+  if (is_map_updating_) {
+    ++scans_during_map_update_;
+  }
 
   const std::string & sensor_frame = sensor_points_sensorTF_msg_ptr->header.frame_id;
   const rclcpp::Time sensor_ros_time = sensor_points_sensorTF_msg_ptr->header.stamp;
@@ -464,7 +732,8 @@ void NDTScanMatcher::callbackSensorPoints(
     new pcl::PointCloud<PointSource>);
   pcl::transformPointCloud(
     *sensor_points_sensorTF_ptr, *sensor_points_baselinkTF_ptr, base_to_sensor_matrix);
-  ndt_ptr_->setInputSource(sensor_points_baselinkTF_ptr);
+  ndt_ptr->setInputSource(sensor_points_baselinkTF_ptr);
+  latest_sensor_points_ptr_ = sensor_points_baselinkTF_ptr;
 
   // start of critical section for initial_pose_msg_ptr_array_
   std::unique_lock<std::mutex> initial_pose_array_lock(initial_pose_array_mtx_);
@@ -499,11 +768,13 @@ void NDTScanMatcher::callbackSensorPoints(
   }
 
   // If regularization is enabled and available, set pose to NDT for regularization
-  if (regularization_enabled_ && (ndt_implement_type_ == NDTImplementType::OMP)) {
-    ndt_ptr_->unsetRegularizationPose();
+  if (
+    regularization_enabled_ && (ndt_implement_type_ == NDTImplementType::OMP ||
+                                ndt_implement_type_ == NDTImplementType::NATIVE)) {
+    ndt_ptr->unsetRegularizationPose();
     std::optional<Eigen::Matrix4f> pose_opt = interpolateRegularizationPose(sensor_ros_time);
     if (pose_opt.has_value()) {
-      ndt_ptr_->setRegularizationPose(pose_opt.value());
+      ndt_ptr->setRegularizationPose(pose_opt.value());
       RCLCPP_DEBUG_STREAM(get_logger(), "Regularization pose is set to NDT");
     }
   }
@@ -518,7 +789,7 @@ void NDTScanMatcher::callbackSensorPoints(
   initial_pose_cov_msg.header = initial_pose_msg.header;
   initial_pose_cov_msg.pose.pose = initial_pose_msg.pose;
 
-  if (ndt_ptr_->getInputTarget() == nullptr) {
+  if (!hasInputTarget(ndt_ptr)) {
     RCLCPP_WARN_STREAM_THROTTLE(this->get_logger(), *this->get_clock(), 1, "No MAP!");
     return;
   }
@@ -527,17 +798,17 @@ void NDTScanMatcher::callbackSensorPoints(
   const Eigen::Matrix4f initial_pose_matrix = initial_pose_affine.matrix().cast<float>();
 
   auto output_cloud = std::make_shared<pcl::PointCloud<PointSource>>();
-  key_value_stdmap_["state"] = "Aligning";
-  ndt_ptr_->align(*output_cloud, initial_pose_matrix);
-  key_value_stdmap_["state"] = "Sleeping";
+  setKeyValue("state", "Aligning");
+  ndt_ptr->align(*output_cloud, initial_pose_matrix);
+  setKeyValue("state", "Sleeping");
 
-  const Eigen::Matrix4f result_pose_matrix = ndt_ptr_->getFinalTransformation();
+  const Eigen::Matrix4f result_pose_matrix = ndt_ptr->getFinalTransformation();
   Eigen::Affine3d result_pose_affine;
   result_pose_affine.matrix() = result_pose_matrix.cast<double>();
   const geometry_msgs::msg::Pose result_pose_msg = tf2::toMsg(result_pose_affine);
 
   const std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>>
-    result_pose_matrix_array = ndt_ptr_->getFinalTransformationArray();
+    result_pose_matrix_array = ndt_ptr->getFinalTransformationArray();
   std::vector<geometry_msgs::msg::Pose> result_pose_msg_array;
   for (const auto & pose_matrix : result_pose_matrix_array) {
     Eigen::Affine3d pose_affine;
@@ -551,11 +822,11 @@ void NDTScanMatcher::callbackSensorPoints(
     std::chrono::duration_cast<std::chrono::microseconds>(exe_end_time - exe_start_time).count() /
     1000.0;
 
-  const float transform_probability = ndt_ptr_->getTransformationProbability();
+  const float transform_probability = ndt_ptr->getTransformationProbability();
   const float nearest_voxel_transformation_likelihood =
-    ndt_ptr_->getNearestVoxelTransformationLikelihood();
+    ndt_ptr->getNearestVoxelTransformationLikelihood();
 
-  const int iteration_num = ndt_ptr_->getFinalNumIteration();
+  const int iteration_num = ndt_ptr->getFinalNumIteration();
 
   /*****************************************************************************
   The reason the add 2 to the ndt_ptr_->getMaximumIterations() is that there are bugs in
@@ -569,13 +840,13 @@ void NDTScanMatcher::callbackSensorPoints(
   These bugs are now resolved in original pcl implementation.
   https://github.com/PointCloudLibrary/pcl/blob/424c1c6a0ca97d94ca63e5daff4b183a4db8aae4/registration/include/pcl/registration/impl/ndt.hpp#L73-L180
   *****************************************************************************/
-  bool is_ok_iteration_num = iteration_num < ndt_ptr_->getMaximumIterations() + 2;
+  bool is_ok_iteration_num = iteration_num < ndt_ptr->getMaximumIterations() + 2;
   if (!is_ok_iteration_num) {
     RCLCPP_WARN(
       get_logger(),
       "The number of iterations has reached its upper limit. The number of iterations: %d, Limit: "
       "%d",
-      iteration_num, ndt_ptr_->getMaximumIterations() + 2);
+      iteration_num, ndt_ptr->getMaximumIterations() + 2);
   }
 
   bool is_local_optimal_solution_oscillation = false;
@@ -666,7 +937,7 @@ void NDTScanMatcher::callbackSensorPoints(
     marker_array.markers.push_back(marker);
   }
   // TODO(Tier IV): delete old marker
-  for (; i < ndt_ptr_->getMaximumIterations() + 2;) {
+  for (; i < ndt_ptr->getMaximumIterations() + 2;) {
     marker.id = i++;
     marker.pose = geometry_msgs::msg::Pose();
     marker.color = ExchangeColorCrc(0);
@@ -697,70 +968,155 @@ void NDTScanMatcher::callbackSensorPoints(
   initial_to_result_distance_new_pub_->publish(
     makeFloat32Stamped(sensor_ros_time, initial_to_result_distance_new));
 
-  key_value_stdmap_["transform_probability"] = std::to_string(transform_probability);
-  key_value_stdmap_["nearest_voxel_transformation_likelihood"] =
-    std::to_string(nearest_voxel_transformation_likelihood);
-  key_value_stdmap_["iteration_num"] = std::to_string(iteration_num);
-  key_value_stdmap_["skipping_publish_num"] = std::to_string(skipping_publish_num);
-  if (is_local_optimal_solution_oscillation) {
-    key_value_stdmap_["is_local_optimal_solution_oscillation"] = "1";
-  } else {
-    key_value_stdmap_["is_local_optimal_solution_oscillation"] = "0";
+  {
+    std::lock_guard<std::mutex> key_value_lock(key_value_stdmap_mtx_);
+    key_value_stdmap_["transform_probability"] = std::to_string(transform_probability);
+    key_value_stdmap_["nearest_voxel_transformation_likelihood"] =
+      std::to_string(nearest_voxel_transformation_likelihood);
+    key_value_stdmap_["iteration_num"] = std::to_string(iteration_num);
+    key_value_stdmap_["skipping_publish_num"] = std::to_string(skipping_publish_num);
+    key_value_stdmap_["is_local_optimal_solution_oscillation"] =
+      is_local_optimal_solution_oscillation ? "1" : "0";
   }
 }
 
+std::shared_ptr<NDTScanMatcher::NDTCopies> NDTScanMatcher::makeNDTCopies(
+  const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr)
+  const
+{
+  auto ndt_copies_ptr = std::make_shared<NDTCopies>();
+  ndt_copies_ptr->original_ptr = ndt_ptr;
+  for (int thread = 1; thread < initial_estimate_num_threads_; ++thread) {
+    auto ndt_copy_ptr = ndt_ptr->clone();
+    ndt_copy_ptr->unsetRegularizationPose();
+    ndt_copies_ptr->ptrs.push_back(ndt_copy_ptr);
+  }
+  return ndt_copies_ptr;
+}
+
 geometry_msgs::msg::PoseWithCovarianceStamped NDTScanMatcher::alignUsingMonteCarlo(
   const std::shared_ptr<NormalDistributionsTransformBase<PointSource, PointTarget>> & ndt_ptr,
   const geometry_msgs::msg::PoseWithCovarianceStamped & initial_pose_with_cov)
 {
-  if (ndt_ptr->getInputTarget() == nullptr || ndt_ptr->getInputSource() == nullptr) {
+  if (!hasInputTarget(ndt_ptr) || ndt_ptr->getInputSource() == nullptr) {
     RCLCPP_WARN(get_logger(), "No Map or Sensor PointCloud");
     return geometry_msgs::msg::PoseWithCovarianceStamped();
   }
 
   // generateParticle
+  const unsigned int seed = initial_estimate_random_seed_ < 0
+                              ? std::random_device()()
+                              : static_cast<unsigned int>(initial_estimate_random_seed_);
   const auto initial_poses =
-    createRandomPoseArray(initial_pose_with_cov, initial_estimate_particles_num_);
+    createRandomPoseArray(initial_pose_with_cov, initial_estimate_particles_num_, seed);
+  const int particle_num = static_cast<int>(initial_poses.size());
 
-  std::vector<Particle> particle_array;
-  auto output_cloud = std::make_shared<pcl::PointCloud<PointSource>>();
+  // every thread aligns its particles with its own copy of ndt_ptr
+  using NDTBase = NormalDistributionsTransformBase<PointSource, PointTarget>;
+  const int num_threads = std::max(std::min(initial_estimate_num_threads_, particle_num), 1);
+  auto ndt_copies_ptr = std::atomic_load(&ndt_copies_ptr_);
+  if (num_threads > 1 && (!ndt_copies_ptr || ndt_copies_ptr->original_ptr.lock() != ndt_ptr)) {
+    // the target was not set by the map thread, as with ndt_voxel_map_path
+    ndt_copies_ptr = makeNDTCopies(ndt_ptr);
+    std::atomic_store(&ndt_copies_ptr_, ndt_copies_ptr);
+  }
+  // like the copies, ndt_ptr has no regularization pose during the search, so that every particle
+  // is aligned the same way whichever thread takes it. The next scan sets the pose again.
+  ndt_ptr->unsetRegularizationPose();
+  std::vector<std::shared_ptr<NDTBase>> ndt_ptrs{ndt_ptr};
+  for (int thread = 1; thread < num_threads; ++thread) {
+    // the copies have no regularization pose, which is set for each scan
+    const auto & ndt_copy_ptr = ndt_copies_ptr->ptrs.at(thread - 1);
+    ndt_copy_ptr->setInputSource(latest_sensor_points_ptr_);
+    ndt_ptrs.push_back(ndt_copy_ptr);
+  }
 
-  for (unsigned int i = 0; i < initial_poses.size(); i++) {
-    const auto & initial_pose = initial_poses[i];
+  const auto is_converged = [this](const NDTBase & particle_ndt) {
+    if (converged_param_type_ == ConvergedParamType::NEAREST_VOXEL_TRANSFORMATION_LIKELIHOOD) {
+      return particle_ndt.getNearestVoxelTransformationLikelihood() >
+             converged_param_nearest_voxel_transformation_likelihood_;
+    }
+    return particle_ndt.getTransformationProbability() > converged_param_transform_probability_;
+  };
+
+  // With the early termination, the particles after the first converged one are discarded even if
+  // they are already aligned, so that the result does not depend on the order of the threads.
+  std::vector<std::optional<Particle>> particle_array(particle_num);
+  std::atomic<int> last_particle_idx(particle_num - 1);
+
+  // a single thread keeps the threads of ndt_omp for each alignment
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+  for (int i = 0; i < particle_num; ++i) {
+    if (last_particle_idx < i) {
+      continue;
+    }
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    NDTBase & particle_ndt = *ndt_ptrs.at(thread);
+    const auto & initial_pose = initial_poses.at(i);
 
     const Eigen::Affine3d initial_pose_affine = fromRosPoseToEigen(initial_pose);
     const Eigen::Matrix4f initial_pose_matrix = initial_pose_affine.matrix().cast<float>();
 
-    ndt_ptr->align(*output_cloud, initial_pose_matrix);
+    pcl::PointCloud<PointSource> output_cloud;
+    particle_ndt.align(output_cloud, initial_pose_matrix);
 
-    const Eigen::Matrix4f result_pose_matrix = ndt_ptr->getFinalTransformation();
+    const Eigen::Matrix4f result_pose_matrix = particle_ndt.getFinalTransformation();
     Eigen::Affine3d result_pose_affine;
     result_pose_affine.matrix() = result_pose_matrix.cast<double>();
     const geometry_msgs::msg::Pose result_pose = tf2::toMsg(result_pose_affine);
 
-    const auto transform_probability = ndt_ptr->getTransformationProbability();
-    const auto num_iteration = ndt_ptr->getFinalNumIteration();
-
-    Particle particle(initial_pose, result_pose, transform_probability, num_iteration);
-    particle_array.push_back(particle);
-    const auto marker_array = makeDebugMarkers(
-      this->now(), map_frame_, tier4_autoware_utils::createMarkerScale(0.3, 0.1, 0.1), particle, i);
-    ndt_monte_carlo_initial_pose_marker_pub_->publish(marker_array);
-
-    auto sensor_points_mapTF_ptr = std::make_shared<pcl::PointCloud<PointSource>>();
-    const auto sensor_points_baselinkTF_ptr = ndt_ptr->getInputSource();
-    pcl::transformPointCloud(
-      *sensor_points_baselinkTF_ptr, *sensor_points_mapTF_ptr, result_pose_matrix);
-    sensor_msgs::msg::PointCloud2 sensor_points_mapTF_msg;
-    pcl::toROSMsg(*sensor_points_mapTF_ptr, sensor_points_mapTF_msg);
-    sensor_points_mapTF_msg.header.stamp = initial_pose_with_cov.header.stamp;
-    sensor_points_mapTF_msg.header.frame_id = map_frame_;
-    sensor_aligned_pose_pub_->publish(sensor_points_mapTF_msg);
-  }
-
-  auto best_particle_ptr = std::max_element(
-    std::begin(particle_array), std::end(particle_array),
-    [](const Particle & lhs, const Particle & rhs) { return lhs.score < rhs.score; });
+    const auto transform_probability = particle_ndt.getTransformationProbability();
+    const auto num_iteration = particle_ndt.getFinalNumIteration();
+
+    particle_array.at(i).emplace(initial_pose, result_pose, transform_probability, num_iteration);
+
+    if (initial_estimate_early_termination_ && is_converged(particle_ndt)) {
+      int current_last_particle_idx = last_particle_idx;
+      while (i < current_last_particle_idx &&
+             !last_particle_idx.compare_exchange_weak(current_last_particle_idx, i)) {
+      }
+    }
+  }
+  RCLCPP_DEBUG(
+    get_logger(), "Aligned %d of %d particles for the initial pose", last_particle_idx + 1,
+    particle_num);
+
+  // the debug messages are made after the alignments, only for the subscribed topics
+  const bool publish_marker =
+    ndt_monte_carlo_initial_pose_marker_pub_->get_subscription_count() > 0;
+  const bool publish_points = sensor_aligned_pose_pub_->get_subscription_count() > 0;
+  const auto sensor_points_baselinkTF_ptr = ndt_ptr->getInputSource();
+
+  const Particle * best_particle_ptr = nullptr;
+  for (int i = 0; i <= last_particle_idx; ++i) {
+    const Particle & particle = particle_array.at(i).value();
+    if (best_particle_ptr == nullptr || best_particle_ptr->score < particle.score) {
+      best_particle_ptr = &particle;
+    }
+
+    if (publish_marker) {
+      const auto marker_array = makeDebugMarkers(
+        this->now(), map_frame_, tier4_autoware_utils::createMarkerScale(0.3, 0.1, 0.1), particle,
+        i);
+      ndt_monte_carlo_initial_pose_marker_pub_->publish(marker_array);
+    }
+
+    if (publish_points) {
+      const Eigen::Matrix4f result_pose_matrix =
+        fromRosPoseToEigen(particle.result_pose).matrix().cast<float>();
+      auto sensor_points_mapTF_ptr = std::make_shared<pcl::PointCloud<PointSource>>();
+      pcl::transformPointCloud(
+        *sensor_points_baselinkTF_ptr, *sensor_points_mapTF_ptr, result_pose_matrix);
+      sensor_msgs::msg::PointCloud2 sensor_points_mapTF_msg;
+      pcl::toROSMsg(*sensor_points_mapTF_ptr, sensor_points_mapTF_msg);
+      sensor_points_mapTF_msg.header.stamp = initial_pose_with_cov.header.stamp;
+      sensor_points_mapTF_msg.header.frame_id = map_frame_;
+      sensor_aligned_pose_pub_->publish(sensor_points_mapTF_msg);
+    }
+  }
 
   geometry_msgs::msg::PoseWithCovarianceStamped result_pose_with_cov_msg;
   result_pose_with_cov_msg.header.stamp = initial_pose_with_cov.header.stamp;
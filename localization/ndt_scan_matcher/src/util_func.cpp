@@ -16,8 +16,6 @@
 
 #include "ndt_scan_matcher/matrix_type.hpp"
 
-static std::random_device seed_gen;
-
 // ref by http://takacity.blog.fc2.com/blog-entry-69.html
 std_msgs::msg::ColorRGBA ExchangeColorCrc(double x)
 {
@@ -213,9 +211,10 @@ Eigen::Affine3d fromRosPoseToEigen(const geometry_msgs::msg::Pose & ros_pose)
 }
 
 std::vector<geometry_msgs::msg::Pose> createRandomPoseArray(
-  const geometry_msgs::msg::PoseWithCovarianceStamped & base_pose_with_cov, const int particle_num)
+  const geometry_msgs::msg::PoseWithCovarianceStamped & base_pose_with_cov, const int particle_num,
+  const unsigned int seed)
 {
-  std::default_random_engine engine(seed_gen());
+  std::default_random_engine engine(seed);
   const Eigen::Map<const RowMatrixXd> covariance =
     makeEigenCovariance(base_pose_with_cov.pose.covariance);
 
@@ -0,0 +1,226 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAP_LOADER__DIFFERENTIAL_MAP_CLIENT_HPP_
+#define MAP_LOADER__DIFFERENTIAL_MAP_CLIENT_HPP_
+
+#include "map_loader/srv/get_differential_point_cloud_map.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <geometry_msgs/msg/point.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace map_loader
+{
+/**
+ * @brief Tiles of the pointcloud map around a position, kept up to date with the differential map
+ * service of pointcloud_map_loader. Only the tiles entering and leaving the area are transferred.
+ * @tparam PointT point type of the tiles
+ */
+template <class PointT>
+class DifferentialMapClient
+{
+public:
+  using GetDifferentialPointCloudMap = map_loader::srv::GetDifferentialPointCloudMap;
+  using PointCloudPtr = typename pcl::PointCloud<PointT>::Ptr;
+
+  /**
+   * @brief Tiles changed by an update
+   */
+  struct MapUpdate
+  {
+    std::vector<std::pair<std::string, PointCloudPtr>> added_tiles;
+    std::vector<std::string> removed_ids;
+  };
+
+  /**
+   * @param callback_group group of the responses, in which the updates are applied
+   * @param request_timeout time after which a request with no response is dropped
+   */
+  DifferentialMapClient(
+    rclcpp::Node * node, const std::string & service_name,
+    const rclcpp::CallbackGroup::SharedPtr & callback_group = nullptr,
+    const std::chrono::nanoseconds request_timeout = std::chrono::seconds(10))
+  : logger_(node->get_logger()),
+    client_(node->create_client<GetDifferentialPointCloudMap>(
+      service_name, rmw_qos_profile_services_default, callback_group)),
+    request_timeout_(request_timeout)
+  {
+  }
+
+  bool isServiceReady() const { return client_->service_is_ready(); }
+
+  /**
+   * @brief Request the tiles within the radius of the position, unless the response of the last
+   * request has not arrived yet. When it arrives, the tiles are updated and on_updated is called
+   * with the changes from the thread of the callback group. The last request is dropped if it is
+   * older than the timeout, or if the service was lost since it was sent, as its response may never
+   * arrive.
+   * @return future set to true once the tiles are updated, or to false if the request fails or is
+   * dropped, or nothing if no request is sent
+   */
+  std::optional<std::shared_future<bool>> requestUpdate(
+    const geometry_msgs::msg::Point & position, const float radius,
+    std::function<void(const MapUpdate &)> on_updated)
+  {
+    std::unique_lock<std::mutex> request_lock(request_mtx_);
+    if (!client_->service_is_ready()) {
+      is_service_lost_ = true;
+      return std::nullopt;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (is_requesting_) {
+      if (!is_service_lost_ && now - request_time_ < request_timeout_) {
+        return std::nullopt;
+      }
+      RCLCPP_WARN(logger_, "No response to the map request, which is dropped");
+    }
+    is_service_lost_ = false;
+    is_requesting_ = true;
+    request_time_ = now;
+    const uint64_t request_id = ++last_request_id_;
+    request_lock.unlock();
+
+    auto request = std::make_shared<GetDifferentialPointCloudMap::Request>();
+    request->position = position;
+    request->radius = radius;
+    {
+      std::lock_guard<std::mutex> lock(tiles_mtx_);
+      for (const auto & tile : tiles_) {
+        request->cached_ids.push_back(tile.first);
+      }
+    }
+
+    auto updated = std::make_shared<std::promise<bool>>();
+    client_->async_send_request(
+      request, [this, request_id, updated, on_updated = std::move(on_updated)](
+                 typename rclcpp::Client<GetDifferentialPointCloudMap>::SharedFuture future) {
+        if (!isLastRequest(request_id)) {
+          // the response of a dropped request is relative to tiles which may have changed since
+          updated->set_value(false);
+          return;
+        }
+        GetDifferentialPointCloudMap::Response::SharedPtr response;
+        try {
+          response = future.get();
+        } catch (const std::exception & e) {
+          RCLCPP_ERROR(logger_, "Map request failed: %s", e.what());
+        }
+        std::optional<MapUpdate> map_update;
+        if (response) {
+          map_update = applyResponse(*response);
+        }
+        {
+          std::lock_guard<std::mutex> lock(request_mtx_);
+          if (request_id == last_request_id_) {
+            is_requesting_ = false;
+          }
+        }
+        if (!map_update) {
+          updated->set_value(false);
+          return;
+        }
+        if (on_updated) {
+          on_updated(*map_update);
+        }
+        updated->set_value(true);
+      });
+    return updated->get_future().share();
+  }
+
+  /**
+   * @brief Concatenation of all the tiles
+   */
+  PointCloudPtr getMap() const
+  {
+    PointCloudPtr map_ptr(new pcl::PointCloud<PointT>);
+    std::lock_guard<std::mutex> lock(tiles_mtx_);
+    size_t num_points = 0;
+    for (const auto & tile : tiles_) {
+      num_points += tile.second->size();
+    }
+    map_ptr->reserve(num_points);
+    for (const auto & tile : tiles_) {
+      *map_ptr += *tile.second;
+    }
+    map_ptr->header.frame_id = "map";
+    return map_ptr;
+  }
+
+  size_t getNumTiles() const
+  {
+    std::lock_guard<std::mutex> lock(tiles_mtx_);
+    return tiles_.size();
+  }
+
+private:
+  bool isLastRequest(const uint64_t request_id) const
+  {
+    std::lock_guard<std::mutex> lock(request_mtx_);
+    return request_id == last_request_id_;
+  }
+
+  MapUpdate applyResponse(const GetDifferentialPointCloudMap::Response & response)
+  {
+    MapUpdate map_update;
+    for (const auto & cell : response.new_pointcloud_with_ids) {
+      PointCloudPtr tile_ptr(new pcl::PointCloud<PointT>);
+      pcl::fromROSMsg(cell.pointcloud, *tile_ptr);
+      map_update.added_tiles.emplace_back(cell.cell_id, tile_ptr);
+    }
+    map_update.removed_ids = response.ids_to_remove;
+
+    std::lock_guard<std::mutex> lock(tiles_mtx_);
+    for (const auto & id : map_update.removed_ids) {
+      tiles_.erase(id);
+    }
+    for (const auto & tile : map_update.added_tiles) {
+      tiles_[tile.first] = tile.second;
+    }
+    return map_update;
+  }
+
+  rclcpp::Logger logger_;
+  typename rclcpp::Client<GetDifferentialPointCloudMap>::SharedPtr client_;
+  const std::chrono::nanoseconds request_timeout_;
+
+  mutable std::mutex request_mtx_;
+  bool is_requesting_{false};
+  // whether the service was not ready since the last request was sent
+  bool is_service_lost_{false};
+  std::chrono::steady_clock::time_point request_time_;
+  uint64_t last_request_id_{0};
+
+  mutable std::mutex tiles_mtx_;
+  std::map<std::string, PointCloudPtr> tiles_;
+};
+}  // namespace map_loader
+
+#endif  // MAP_LOADER__DIFFERENTIAL_MAP_CLIENT_HPP_
@@ -0,0 +1,98 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAP_LOADER__DIFFERENTIAL_MAP_LOADER_MODULE_HPP_
+#define MAP_LOADER__DIFFERENTIAL_MAP_LOADER_MODULE_HPP_
+
+#include "map_loader/msg/point_cloud_map_cell.hpp"
+#include "map_loader/srv/get_differential_point_cloud_map.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Service giving the PCD files of the pointcloud map near a position as tiles, so that the
+ * clients keep only a part of the map. The bounding boxes of the files are read from a cache file
+ * and computed only for the files which are new or changed since it was written. The most recently
+ * served tiles are kept in memory, and the other files are loaded again when they are requested.
+ */
+class DifferentialMapLoaderModule
+{
+public:
+  using GetDifferentialPointCloudMap = map_loader::srv::GetDifferentialPointCloudMap;
+
+  /**
+   * @param bounds_cache_path file of the bounding boxes, which is written when some of them are
+   * computed, or empty to compute all of them
+   * @param tile_cache_size number of the recently served tiles kept in memory
+   */
+  DifferentialMapLoaderModule(
+    rclcpp::Node * node, const std::vector<std::string> & pcd_paths,
+    const std::string & bounds_cache_path, const size_t tile_cache_size);
+
+  /**
+   * @brief Answer a request of the service: the tiles whose bounding box is within the radius and
+   * which are not cached by the client, and the cached tiles out of the area
+   */
+  void getDifferentialPointCloudMap(
+    const GetDifferentialPointCloudMap::Request & req,
+    GetDifferentialPointCloudMap::Response & res) const;
+
+private:
+  struct PCDFileMetadata
+  {
+    std::string path;
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+    // identify the version of the file whose bounding box is cached
+    uint64_t file_size;
+    int64_t last_write_time;
+  };
+  using PointCloudMapCellConstPtr = std::shared_ptr<const map_loader::msg::PointCloudMapCell>;
+
+  rclcpp::Logger logger_;
+  std::vector<PCDFileMetadata> pcd_file_metadata_array_;
+  rclcpp::Service<GetDifferentialPointCloudMap>::SharedPtr get_differential_pcd_maps_service_;
+
+  // least recently served tile first
+  const size_t tile_cache_size_;
+  mutable std::mutex tile_cache_mtx_;
+  mutable std::list<std::pair<std::string, PointCloudMapCellConstPtr>> tile_cache_;
+  mutable std::unordered_map<
+    std::string, std::list<std::pair<std::string, PointCloudMapCellConstPtr>>::iterator>
+    tile_cache_index_;
+
+  void loadBounds(
+    const std::vector<std::string> & pcd_paths, const std::string & bounds_cache_path);
+  bool computeBounds(PCDFileMetadata & metadata) const;
+
+  bool onServiceGetDifferentialPointCloudMap(
+    GetDifferentialPointCloudMap::Request::SharedPtr req,
+    GetDifferentialPointCloudMap::Response::SharedPtr res) const;
+  PointCloudMapCellConstPtr getPointCloudMapCell(const PCDFileMetadata & metadata) const;
+  bool loadPointCloudMapCell(
+    const PCDFileMetadata & metadata, map_loader::msg::PointCloudMapCell & cell) const;
+};
+
+#endif  // MAP_LOADER__DIFFERENTIAL_MAP_LOADER_MODULE_HPP_
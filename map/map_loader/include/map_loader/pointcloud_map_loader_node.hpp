@@ -31,10 +31,13 @@
 #ifndef MAP_LOADER__POINTCLOUD_MAP_LOADER_NODE_HPP_
 #define MAP_LOADER__POINTCLOUD_MAP_LOADER_NODE_HPP_
 
+#include "map_loader/differential_map_loader_module.hpp"
+
 #include <rclcpp/rclcpp.hpp>
 
 #include <sensor_msgs/msg/point_cloud2.hpp>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -45,6 +48,7 @@ public:
 
 private:
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pub_pointcloud_map_;
+  std::unique_ptr<DifferentialMapLoaderModule> differential_map_loader_module_;
 
   sensor_msgs::msg::PointCloud2 loadPCDFiles(const std::vector<std::string> & pcd_paths);
 };
@@ -0,0 +1,238 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "map_loader/differential_map_loader_module.hpp"
+
+#include <pcl/common/common.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+bool isBoxWithinRadius(
+  const float min_x, const float min_y, const float max_x, const float max_y,
+  const geometry_msgs::msg::Point & position, const float radius)
+{
+  const double dx = std::max({min_x - position.x, 0.0, position.x - max_x});
+  const double dy = std::max({min_y - position.y, 0.0, position.y - max_y});
+  return dx * dx + dy * dy <= radius * radius;
+}
+}  // namespace
+
+DifferentialMapLoaderModule::DifferentialMapLoaderModule(
+  rclcpp::Node * node, const std::vector<std::string> & pcd_paths,
+  const std::string & bounds_cache_path, const size_t tile_cache_size)
+: logger_(node->get_logger()), tile_cache_size_(tile_cache_size)
+{
+  loadBounds(pcd_paths, bounds_cache_path);
+  RCLCPP_INFO(
+    logger_, "Indexed %zu PCD files for the differential map loading",
+    pcd_file_metadata_array_.size());
+
+  get_differential_pcd_maps_service_ = node->create_service<GetDifferentialPointCloudMap>(
+    "service/get_differential_pcd_map",
+    std::bind(
+      &DifferentialMapLoaderModule::onServiceGetDifferentialPointCloudMap, this,
+      std::placeholders::_1, std::placeholders::_2));
+}
+
+void DifferentialMapLoaderModule::loadBounds(
+  const std::vector<std::string> & pcd_paths, const std::string & bounds_cache_path)
+{
+  // each line of the cache is "file_size last_write_time min_x min_y max_x max_y path"
+  std::unordered_map<std::string, PCDFileMetadata> cached_metadata;
+  if (!bounds_cache_path.empty()) {
+    std::ifstream ifs(bounds_cache_path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+      std::istringstream iss(line);
+      PCDFileMetadata metadata;
+      iss >> metadata.file_size >> metadata.last_write_time >> metadata.min_x >> metadata.min_y >>
+        metadata.max_x >> metadata.max_y;
+      iss.ignore(1);
+      if (iss && std::getline(iss, metadata.path) && !metadata.path.empty()) {
+        cached_metadata[metadata.path] = metadata;
+      }
+    }
+  }
+
+  size_t num_computed = 0;
+  for (const auto & path : pcd_paths) {
+    std::error_code size_ec;
+    std::error_code time_ec;
+    PCDFileMetadata metadata;
+    metadata.path = path;
+    metadata.file_size = fs::file_size(path, size_ec);
+    metadata.last_write_time = fs::last_write_time(path, time_ec).time_since_epoch().count();
+    if (size_ec || time_ec) {
+      const auto & ec = size_ec ? size_ec : time_ec;
+      RCLCPP_ERROR_STREAM(logger_, "PCD load failed: " << path << ": " << ec.message());
+      continue;
+    }
+
+    const auto cached = cached_metadata.find(path);
+    if (
+      cached != cached_metadata.end() && cached->second.file_size == metadata.file_size &&
+      cached->second.last_write_time == metadata.last_write_time) {
+      pcd_file_metadata_array_.push_back(cached->second);
+      continue;
+    }
+    if (computeBounds(metadata)) {
+      pcd_file_metadata_array_.push_back(metadata);
+      ++num_computed;
+    }
+  }
+
+  if (bounds_cache_path.empty() || num_computed == 0) {
+    return;
+  }
+  std::ofstream ofs(bounds_cache_path, std::ios::trunc);
+  ofs.precision(std::numeric_limits<float>::max_digits10);
+  for (const auto & metadata : pcd_file_metadata_array_) {
+    ofs << metadata.file_size << ' ' << metadata.last_write_time << ' ' << metadata.min_x << ' '
+        << metadata.min_y << ' ' << metadata.max_x << ' ' << metadata.max_y << ' ' << metadata.path
+        << '\n';
+  }
+  if (!ofs) {
+    RCLCPP_WARN_STREAM(
+      logger_, "Failed to write the bounds of the PCD files: " << bounds_cache_path);
+  }
+}
+
+bool DifferentialMapLoaderModule::computeBounds(PCDFileMetadata & metadata) const
+{
+  pcl::PointCloud<pcl::PointXYZ> pcd;
+  if (pcl::io::loadPCDFile(metadata.path, pcd) == -1) {
+    RCLCPP_ERROR_STREAM(logger_, "PCD load failed: " << metadata.path);
+    return false;
+  }
+  if (pcd.empty()) {
+    return false;
+  }
+
+  pcl::PointXYZ min_point;
+  pcl::PointXYZ max_point;
+  pcl::getMinMax3D(pcd, min_point, max_point);
+  metadata.min_x = min_point.x;
+  metadata.min_y = min_point.y;
+  metadata.max_x = max_point.x;
+  metadata.max_y = max_point.y;
+  return true;
+}
+
+bool DifferentialMapLoaderModule::onServiceGetDifferentialPointCloudMap(
+  GetDifferentialPointCloudMap::Request::SharedPtr req,
+  GetDifferentialPointCloudMap::Response::SharedPtr res) const
+{
+  getDifferentialPointCloudMap(*req, *res);
+  return true;
+}
+
+void DifferentialMapLoaderModule::getDifferentialPointCloudMap(
+  const GetDifferentialPointCloudMap::Request & req,
+  GetDifferentialPointCloudMap::Response & res) const
+{
+  std::unordered_set<std::string> ids_in_area;
+  const std::unordered_set<std::string> cached_ids(req.cached_ids.begin(), req.cached_ids.end());
+  for (const auto & metadata : pcd_file_metadata_array_) {
+    if (!isBoxWithinRadius(
+          metadata.min_x, metadata.min_y, metadata.max_x, metadata.max_y, req.position,
+          req.radius)) {
+      continue;
+    }
+    ids_in_area.insert(metadata.path);
+    if (cached_ids.count(metadata.path) != 0) {
+      continue;
+    }
+
+    if (const auto cell_ptr = getPointCloudMapCell(metadata)) {
+      res.new_pointcloud_with_ids.push_back(*cell_ptr);
+    }
+  }
+
+  for (const auto & id : req.cached_ids) {
+    if (ids_in_area.count(id) == 0) {
+      res.ids_to_remove.push_back(id);
+    }
+  }
+
+  res.header.frame_id = "map";
+  RCLCPP_DEBUG(
+    logger_, "Sending %zu new PCD tiles and removing %zu", res.new_pointcloud_with_ids.size(),
+    res.ids_to_remove.size());
+}
+
+DifferentialMapLoaderModule::PointCloudMapCellConstPtr
+DifferentialMapLoaderModule::getPointCloudMapCell(const PCDFileMetadata & metadata) const
+{
+  {
+    std::lock_guard<std::mutex> lock(tile_cache_mtx_);
+    const auto cached = tile_cache_index_.find(metadata.path);
+    if (cached != tile_cache_index_.end()) {
+      tile_cache_.splice(tile_cache_.end(), tile_cache_, cached->second);
+      return cached->second->second;
+    }
+  }
+
+  // loaded without the lock, so that the other tiles are served meanwhile
+  auto cell_ptr = std::make_shared<map_loader::msg::PointCloudMapCell>();
+  if (!loadPointCloudMapCell(metadata, *cell_ptr)) {
+    return nullptr;
+  }
+  if (tile_cache_size_ == 0) {
+    return cell_ptr;
+  }
+
+  std::lock_guard<std::mutex> lock(tile_cache_mtx_);
+  if (tile_cache_index_.count(metadata.path) == 0) {
+    tile_cache_.emplace_back(metadata.path, cell_ptr);
+    tile_cache_index_[metadata.path] = std::prev(tile_cache_.end());
+    if (tile_cache_.size() > tile_cache_size_) {
+      tile_cache_index_.erase(tile_cache_.front().first);
+      tile_cache_.pop_front();
+    }
+  }
+  return cell_ptr;
+}
+
+bool DifferentialMapLoaderModule::loadPointCloudMapCell(
+  const PCDFileMetadata & metadata, map_loader::msg::PointCloudMapCell & cell) const
+{
+  if (pcl::io::loadPCDFile(metadata.path, cell.pointcloud) == -1) {
+    RCLCPP_ERROR_STREAM(logger_, "PCD load failed: " << metadata.path);
+    return false;
+  }
+  cell.pointcloud.header.frame_id = "map";
+  cell.cell_id = metadata.path;
+  cell.min_x = metadata.min_x;
+  cell.min_y = metadata.min_y;
+  cell.max_x = metadata.max_x;
+  cell.max_y = metadata.max_y;
+  return true;
+}
@@ -34,7 +34,9 @@
 #include <pcl/io/pcd_io.h>
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -61,13 +63,12 @@ bool isPcdFile(const std::string & p)
 PointCloudMapLoaderNode::PointCloudMapLoaderNode(const rclcpp::NodeOptions & options)
 : Node("pointcloud_map_loader", options)
 {
-  rclcpp::QoS durable_qos{1};
-  durable_qos.transient_local();
-  pub_pointcloud_map_ =
-    this->create_publisher<sensor_msgs::msg::PointCloud2>("output/pointcloud_map", durable_qos);
-
   const auto pcd_paths_or_directory =
     declare_parameter("pcd_paths_or_directory", std::vector<std::string>({}));
+  const bool enable_whole_load = declare_parameter("enable_whole_load", true);
+  const bool enable_differential_load = declare_parameter("enable_differential_load", false);
+  const auto pcd_bounds_cache_path = declare_parameter("pcd_bounds_cache_path", std::string(""));
+  const auto tile_cache_size = declare_parameter("tile_cache_size", 16);
 
   std::vector<std::string> pcd_paths{};
 
@@ -90,6 +91,20 @@ PointCloudMapLoaderNode::PointCloudMapLoaderNode(const rclcpp::NodeOptions & opt
     }
   }
 
+  if (enable_differential_load) {
+    differential_map_loader_module_ = std::make_unique<DifferentialMapLoaderModule>(
+      this, pcd_paths, pcd_bounds_cache_path, static_cast<size_t>(std::max(tile_cache_size, 0)));
+  }
+
+  if (!enable_whole_load) {
+    return;
+  }
+
+  rclcpp::QoS durable_qos{1};
+  durable_qos.transient_local();
+  pub_pointcloud_map_ =
+    this->create_publisher<sensor_msgs::msg::PointCloud2>("output/pointcloud_map", durable_qos);
+
   const auto pcd = loadPCDFiles(pcd_paths);
 
   if (pcd.width == 0) {
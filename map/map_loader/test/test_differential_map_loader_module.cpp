@@ -0,0 +1,285 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "map_loader/differential_map_client.hpp"
+#include "map_loader/differential_map_loader_module.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <gtest/gtest.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using GetDifferentialPointCloudMap = DifferentialMapLoaderModule::GetDifferentialPointCloudMap;
+
+namespace
+{
+// points at the corners and the center of the box
+void writeTile(
+  const std::string & path, const float min_x, const float min_y, const float max_x,
+  const float max_y, const bool with_extra_point = false)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  cloud.push_back(pcl::PointXYZ(min_x, min_y, 0.0f));
+  cloud.push_back(pcl::PointXYZ(max_x, max_y, 1.0f));
+  cloud.push_back(pcl::PointXYZ((min_x + max_x) / 2.0f, (min_y + max_y) / 2.0f, 0.5f));
+  if (with_extra_point) {
+    cloud.push_back(pcl::PointXYZ(min_x, max_y, 0.5f));
+  }
+  pcl::io::savePCDFileBinary(path, cloud);
+}
+
+std::vector<std::string> getNewIds(const GetDifferentialPointCloudMap::Response & res)
+{
+  std::vector<std::string> ids;
+  for (const auto & cell : res.new_pointcloud_with_ids) {
+    ids.push_back(cell.cell_id);
+  }
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+std::vector<std::string> getIdsToRemove(const GetDifferentialPointCloudMap::Response & res)
+{
+  std::vector<std::string> ids = res.ids_to_remove;
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+class DifferentialMapLoaderModuleTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    rclcpp::init(0, nullptr);
+    node_ = std::make_shared<rclcpp::Node>("test_differential_map_loader_module");
+
+    directory_ = fs::path(::testing::TempDir()) / "test_differential_map_loader_module";
+    fs::remove_all(directory_);
+    fs::create_directories(directory_);
+    // tiles of 10 m, 10 m apart along x
+    for (int i = 0; i < 3; ++i) {
+      paths_.push_back((directory_ / ("tile_" + std::to_string(i) + ".pcd")).string());
+      writeTile(paths_.back(), 20.0f * i, 0.0f, 20.0f * i + 10.0f, 10.0f);
+    }
+    bounds_cache_path_ = (directory_ / "bounds.txt").string();
+  }
+
+  void TearDown() override
+  {
+    module_.reset();
+    node_.reset();
+    fs::remove_all(directory_);
+    rclcpp::shutdown();
+  }
+
+  void makeModule(const std::string & bounds_cache_path, const size_t tile_cache_size)
+  {
+    // the service of the previous module is removed first
+    module_.reset();
+    module_ = std::make_unique<DifferentialMapLoaderModule>(
+      node_.get(), paths_, bounds_cache_path, tile_cache_size);
+  }
+
+  GetDifferentialPointCloudMap::Response request(
+    const double x, const double y, const float radius,
+    const std::vector<std::string> & cached_ids = {}) const
+  {
+    GetDifferentialPointCloudMap::Request req;
+    req.position.x = x;
+    req.position.y = y;
+    req.radius = radius;
+    req.cached_ids = cached_ids;
+    GetDifferentialPointCloudMap::Response res;
+    module_->getDifferentialPointCloudMap(req, res);
+    return res;
+  }
+
+  // lines of the bounds cache by path
+  std::map<std::string, std::string> readBoundsCache() const
+  {
+    std::map<std::string, std::string> lines;
+    std::ifstream ifs(bounds_cache_path_);
+    std::string line;
+    while (std::getline(ifs, line)) {
+      const auto path_begin = line.find(directory_.string());
+      if (path_begin != std::string::npos) {
+        lines[line.substr(path_begin)] = line;
+      }
+    }
+    return lines;
+  }
+
+  // replace the bounds of a file in the cache, keeping its size and its last write time
+  void setCachedBounds(const std::string & path, const float min_x, const float max_x) const
+  {
+    auto lines = readBoundsCache();
+    std::istringstream iss(lines.at(path));
+    uint64_t file_size;
+    int64_t last_write_time;
+    iss >> file_size >> last_write_time;
+    std::ostringstream oss;
+    oss << file_size << ' ' << last_write_time << ' ' << min_x << ' ' << 0.0f << ' ' << max_x << ' '
+        << 10.0f << ' ' << path;
+    lines[path] = oss.str();
+
+    std::ofstream ofs(bounds_cache_path_, std::ios::trunc);
+    for (const auto & line : lines) {
+      ofs << line.second << '\n';
+    }
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  fs::path directory_;
+  std::vector<std::string> paths_;
+  std::string bounds_cache_path_;
+  std::unique_ptr<DifferentialMapLoaderModule> module_;
+};
+}  // namespace
+
+TEST_F(DifferentialMapLoaderModuleTest, ServesTilesWithinRadius)
+{
+  makeModule("", 0);
+
+  auto res = request(5.0, 5.0, 1.0f);
+  ASSERT_EQ(getNewIds(res), std::vector<std::string>({paths_[0]}));
+  const auto & cell = res.new_pointcloud_with_ids.front();
+  EXPECT_EQ(cell.min_x, 0.0f);
+  EXPECT_EQ(cell.min_y, 0.0f);
+  EXPECT_EQ(cell.max_x, 10.0f);
+  EXPECT_EQ(cell.max_y, 10.0f);
+  EXPECT_EQ(cell.pointcloud.width * cell.pointcloud.height, 3U);
+  EXPECT_EQ(cell.pointcloud.header.frame_id, "map");
+  EXPECT_EQ(res.header.frame_id, "map");
+  EXPECT_TRUE(res.ids_to_remove.empty());
+
+  // the distance is measured to the bounding boxes
+  EXPECT_EQ(getNewIds(request(15.0, 5.0, 5.0f)), std::vector<std::string>({paths_[0], paths_[1]}));
+  EXPECT_TRUE(getNewIds(request(15.0, 5.0, 4.9f)).empty());
+  EXPECT_TRUE(getNewIds(request(15.0, 15.0, 5.0f)).empty());
+  EXPECT_EQ(getNewIds(request(25.0, 5.0, 100.0f)), paths_);
+}
+
+TEST_F(DifferentialMapLoaderModuleTest, SendsOnlyTheDifference)
+{
+  makeModule("", 0);
+
+  const std::string unknown_id = (directory_ / "unknown.pcd").string();
+  const auto res = request(45.0, 5.0, 16.0f, {paths_[0], paths_[1], unknown_id});
+  // tile_1 is cached and still in the area, tile_0 and the unknown tile are out of it
+  EXPECT_EQ(getNewIds(res), std::vector<std::string>({paths_[2]}));
+  std::vector<std::string> ids_to_remove = {paths_[0], unknown_id};
+  std::sort(ids_to_remove.begin(), ids_to_remove.end());
+  EXPECT_EQ(getIdsToRemove(res), ids_to_remove);
+
+  // nothing changes for a client which has the tiles of the area
+  const auto same_res = request(45.0, 5.0, 16.0f, {paths_[1], paths_[2]});
+  EXPECT_TRUE(same_res.new_pointcloud_with_ids.empty());
+  EXPECT_TRUE(same_res.ids_to_remove.empty());
+}
+
+TEST_F(DifferentialMapLoaderModuleTest, ReusesCachedBoundsOfUnchangedFiles)
+{
+  makeModule(bounds_cache_path_, 0);
+  ASSERT_EQ(readBoundsCache().size(), paths_.size());
+
+  // the cached bounds are used as long as the size and the last write time of a file are the same
+  for (const auto & path : paths_) {
+    setCachedBounds(path, 100.0f, 110.0f);
+  }
+  // tile_0 changes size, tile_1 only its last write time
+  writeTile(paths_[0], 0.0f, 0.0f, 10.0f, 10.0f, true);
+  fs::last_write_time(paths_[1], fs::last_write_time(paths_[1]) + std::chrono::hours(1));
+
+  makeModule(bounds_cache_path_, 0);
+  EXPECT_EQ(getNewIds(request(105.0, 5.0, 1.0f)), std::vector<std::string>({paths_[2]}));
+  EXPECT_EQ(getNewIds(request(5.0, 5.0, 1.0f)), std::vector<std::string>({paths_[0]}));
+  EXPECT_EQ(getNewIds(request(25.0, 5.0, 1.0f)), std::vector<std::string>({paths_[1]}));
+
+  // and the recomputed bounds are written back
+  makeModule(bounds_cache_path_, 0);
+  EXPECT_EQ(getNewIds(request(5.0, 5.0, 1.0f)), std::vector<std::string>({paths_[0]}));
+  EXPECT_EQ(getNewIds(request(25.0, 5.0, 1.0f)), std::vector<std::string>({paths_[1]}));
+  EXPECT_EQ(getNewIds(request(105.0, 5.0, 1.0f)), std::vector<std::string>({paths_[2]}));
+}
+
+TEST_F(DifferentialMapLoaderModuleTest, KeepsRecentlyServedTiles)
+{
+  makeModule("", 1);
+
+  ASSERT_EQ(getNewIds(request(5.0, 5.0, 1.0f)), std::vector<std::string>({paths_[0]}));
+  // served from the memory once the file is gone
+  fs::remove(paths_[0]);
+  EXPECT_EQ(getNewIds(request(5.0, 5.0, 1.0f)), std::vector<std::string>({paths_[0]}));
+
+  // until a more recent tile takes its place
+  ASSERT_EQ(getNewIds(request(25.0, 5.0, 1.0f)), std::vector<std::string>({paths_[1]}));
+  EXPECT_TRUE(getNewIds(request(5.0, 5.0, 1.0f)).empty());
+  fs::remove(paths_[1]);
+  EXPECT_EQ(getNewIds(request(25.0, 5.0, 1.0f)), std::vector<std::string>({paths_[1]}));
+}
+
+TEST_F(DifferentialMapLoaderModuleTest, ClientFollowsPosition)
+{
+  makeModule("", 0);
+  const auto client_node = std::make_shared<rclcpp::Node>("test_differential_map_client");
+  map_loader::DifferentialMapClient<pcl::PointXYZ> client(
+    client_node.get(), "service/get_differential_pcd_map");
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node_);
+  executor.add_node(client_node);
+  for (int i = 0; i < 100 && !client.isServiceReady(); ++i) {
+    executor.spin_some();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  ASSERT_TRUE(client.isServiceReady());
+
+  using MapUpdate = map_loader::DifferentialMapClient<pcl::PointXYZ>::MapUpdate;
+  MapUpdate last_update;
+  const auto update = [&](const double x) {
+    geometry_msgs::msg::Point position;
+    position.x = x;
+    position.y = 5.0;
+    const auto updated = client.requestUpdate(
+      position, 1.0f, [&last_update](const MapUpdate & map_update) { last_update = map_update; });
+    return updated && executor.spin_until_future_complete(*updated, std::chrono::seconds(5)) ==
+                        rclcpp::FutureReturnCode::SUCCESS &&
+           updated->get();
+  };
+
+  ASSERT_TRUE(update(5.0));
+  ASSERT_EQ(last_update.added_tiles.size(), 1U);
+  EXPECT_EQ(last_update.added_tiles.front().first, paths_[0]);
+  EXPECT_TRUE(last_update.removed_ids.empty());
+  EXPECT_EQ(client.getNumTiles(), 1U);
+  EXPECT_EQ(client.getMap()->size(), 3U);
+
+  ASSERT_TRUE(update(45.0));
+  ASSERT_EQ(last_update.added_tiles.size(), 1U);
+  EXPECT_EQ(last_update.added_tiles.front().first, paths_[2]);
+  EXPECT_EQ(last_update.removed_ids, std::vector<std::string>({paths_[0]}));
+  EXPECT_EQ(client.getNumTiles(), 1U);
+}
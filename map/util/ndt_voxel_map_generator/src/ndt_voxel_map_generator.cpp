@@ -0,0 +1,126 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <ndt/native_voxel_map_file.hpp>
+#include <ndt/native_voxel_target.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+bool isPcdFile(const std::string & p)
+{
+  if (fs::is_directory(p)) {
+    return false;
+  }
+
+  const std::string ext = fs::path(p).extension();
+  return ext == ".pcd" || ext == ".PCD";
+}
+
+std::vector<std::string> getPcdPaths(const std::vector<std::string> & pcd_paths_or_directory)
+{
+  std::vector<std::string> pcd_paths;
+  for (const auto & p : pcd_paths_or_directory) {
+    if (!fs::exists(p)) {
+      RCLCPP_ERROR_STREAM(rclcpp::get_logger("getPcdPaths"), "invalid path: " << p);
+      continue;
+    }
+    if (isPcdFile(p)) {
+      pcd_paths.push_back(p);
+    }
+    if (fs::is_directory(p)) {
+      for (const auto & file : fs::directory_iterator(p)) {
+        const auto filename = file.path().string();
+        if (isPcdFile(filename)) {
+          pcd_paths.push_back(filename);
+        }
+      }
+    }
+  }
+  // the voxels do not depend on the order of the files except for the rounding of the sums
+  std::sort(pcd_paths.begin(), pcd_paths.end());
+  return pcd_paths;
+}
+
+int generate(const rclcpp::Node::SharedPtr & node)
+{
+  const auto pcd_paths_or_directory =
+    node->declare_parameter<std::vector<std::string>>("pcd_paths_or_directory");
+  const auto output_path = node->declare_parameter<std::string>("output_path");
+  // has to be the resolution of ndt_scan_matcher
+  const auto resolution = node->declare_parameter<double>("resolution", 2.0);
+  const auto tile_size = node->declare_parameter<double>("tile_size", 50.0);
+  const auto num_threads = node->declare_parameter<int>("num_threads", 1);
+
+  // the voxel and tile indices are computed by dividing by them
+  if (!(resolution > 0.0) || !(tile_size > 0.0)) {
+    RCLCPP_ERROR(
+      node->get_logger(), "resolution (%f) and tile_size (%f) must be positive", resolution,
+      tile_size);
+    return EXIT_FAILURE;
+  }
+
+  const auto pcd_paths = getPcdPaths(pcd_paths_or_directory);
+  if (pcd_paths.empty()) {
+    RCLCPP_ERROR(node->get_logger(), "No PCD file was found");
+    return EXIT_FAILURE;
+  }
+
+  // the points are summed up per voxel file by file, so that the whole map is never in memory
+  NativeVoxelTarget::PointSums point_sums;
+  size_t num_points = 0;
+  for (const auto & path : pcd_paths) {
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    if (pcl::io::loadPCDFile(path, cloud) == -1) {
+      RCLCPP_ERROR_STREAM(node->get_logger(), "PCD load failed: " << path);
+      return EXIT_FAILURE;
+    }
+    NativeVoxelTarget::addPoints(cloud, resolution, point_sums);
+    num_points += cloud.size();
+    std::cout << "Loaded " << cloud.size() << " points from " << path << std::endl;
+  }
+
+  const auto target_ptr = NativeVoxelTarget::build(point_sums, resolution, num_threads);
+  try {
+    NativeVoxelMapFile::save(output_path, *target_ptr, tile_size);
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(node->get_logger(), "%s", e.what());
+    return EXIT_FAILURE;
+  }
+  std::cout << "Saved " << target_ptr->getVoxels().size << " voxels of " << num_points
+            << " points to " << output_path << std::endl;
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("ndt_voxel_map_generator");
+  const int result = generate(node);
+
+  rclcpp::shutdown();
+
+  return result;
+}
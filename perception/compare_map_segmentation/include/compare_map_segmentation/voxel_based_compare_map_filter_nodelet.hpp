@@ -17,9 +17,15 @@
 
 #include "pointcloud_preprocessor/filter.hpp"
 
+#include <map_loader/differential_map_client.hpp>
+
+#include <nav_msgs/msg/odometry.hpp>
+
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/search/pcl_search.h>
 
+#include <memory>
+#include <optional>
 #include <vector>
 
 namespace compare_map_segmentation
@@ -31,6 +37,9 @@ protected:
     const PointCloud2ConstPtr & input, const IndicesPtr & indices, PointCloud2 & output);
 
   void input_target_callback(const PointCloud2ConstPtr map);
+  void set_map(const pcl::PointCloud<pcl::PointXYZ>::Ptr & map_pcl_ptr);
+  void kinematic_state_callback(const nav_msgs::msg::Odometry::ConstSharedPtr msg);
+  void map_update_timer_callback();
   bool is_in_voxel(
     const pcl::PointXYZ & src_point, const pcl::PointXYZ & target_point,
     const double distance_threshold, const PointCloudPtr & map,
@@ -44,6 +53,16 @@ private:
   pcl::VoxelGrid<pcl::PointXYZ> voxel_grid_;
   bool set_map_in_voxel_grid_;
 
+  // dynamic map loading
+  bool use_dynamic_map_loading_;
+  double map_update_distance_threshold_;
+  double map_loader_radius_;
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr sub_kinematic_state_;
+  rclcpp::TimerBase::SharedPtr map_update_timer_;
+  std::unique_ptr<map_loader::DifferentialMapClient<pcl::PointXYZ>> differential_map_client_;
+  std::optional<geometry_msgs::msg::Point> current_position_;
+  std::optional<geometry_msgs::msg::Point> last_map_update_position_;
+
   /** \brief Parameter service callback result : needed to be hold */
   OnSetParametersCallbackHandle::SharedPtr set_param_res_;
 
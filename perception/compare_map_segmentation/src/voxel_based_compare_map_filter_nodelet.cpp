@@ -18,6 +18,8 @@
 #include <pcl/search/kdtree.h>
 #include <pcl/segmentation/segment_differences.h>
 
+#include <cmath>
+#include <memory>
 #include <vector>
 
 namespace compare_map_segmentation
@@ -40,12 +42,27 @@ VoxelBasedCompareMapFilterComponent::VoxelBasedCompareMapFilterComponent(
 
   distance_threshold_ = static_cast<double>(declare_parameter("distance_threshold", 0.3));
 
+  use_dynamic_map_loading_ = declare_parameter("use_dynamic_map_loading", false);
+  map_update_distance_threshold_ = declare_parameter("map_update_distance_threshold", 10.0);
+  map_loader_radius_ = declare_parameter("map_loader_radius", 150.0);
+
   set_map_in_voxel_grid_ = false;
 
   using std::placeholders::_1;
-  sub_map_ = this->create_subscription<PointCloud2>(
-    "map", rclcpp::QoS{1}.transient_local(),
-    std::bind(&VoxelBasedCompareMapFilterComponent::input_target_callback, this, _1));
+  if (use_dynamic_map_loading_) {
+    differential_map_client_ = std::make_unique<map_loader::DifferentialMapClient<pcl::PointXYZ>>(
+      this, "map_loader_service");
+    sub_kinematic_state_ = this->create_subscription<nav_msgs::msg::Odometry>(
+      "kinematic_state", rclcpp::QoS{1},
+      std::bind(&VoxelBasedCompareMapFilterComponent::kinematic_state_callback, this, _1));
+    map_update_timer_ = rclcpp::create_timer(
+      this, this->get_clock(), rclcpp::Duration::from_seconds(1.0),
+      std::bind(&VoxelBasedCompareMapFilterComponent::map_update_timer_callback, this));
+  } else {
+    sub_map_ = this->create_subscription<PointCloud2>(
+      "map", rclcpp::QoS{1}.transient_local(),
+      std::bind(&VoxelBasedCompareMapFilterComponent::input_target_callback, this, _1));
+  }
 
   set_param_res_ = this->add_on_set_parameters_callback(
     std::bind(&VoxelBasedCompareMapFilterComponent::paramCallback, this, _1));
@@ -251,7 +268,12 @@ void VoxelBasedCompareMapFilterComponent::input_target_callback(const PointCloud
   pcl::PointCloud<pcl::PointXYZ> map_pcl;
   pcl::fromROSMsg<pcl::PointXYZ>(*map, map_pcl);
   const auto map_pcl_ptr = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>(map_pcl);
+  set_map(map_pcl_ptr);
+}
 
+void VoxelBasedCompareMapFilterComponent::set_map(
+  const pcl::PointCloud<pcl::PointXYZ>::Ptr & map_pcl_ptr)
+{
   std::scoped_lock lock(mutex_);
   set_map_in_voxel_grid_ = true;
   tf_input_frame_ = map_pcl_ptr->header.frame_id;
@@ -272,6 +294,40 @@ void VoxelBasedCompareMapFilterComponent::input_target_callback(const PointCloud
   }
 }
 
+void VoxelBasedCompareMapFilterComponent::kinematic_state_callback(
+  const nav_msgs::msg::Odometry::ConstSharedPtr msg)
+{
+  current_position_ = msg->pose.pose.position;
+}
+
+void VoxelBasedCompareMapFilterComponent::map_update_timer_callback()
+{
+  if (!current_position_) {
+    return;
+  }
+  if (last_map_update_position_) {
+    const double dx = current_position_->x - last_map_update_position_->x;
+    const double dy = current_position_->y - last_map_update_position_->y;
+    if (std::hypot(dx, dy) < map_update_distance_threshold_) {
+      return;
+    }
+  }
+
+  // the voxel grid is built again from the tiles around the vehicle when some of them change
+  // the position is kept only once the tiles are updated, so that a failed request is sent again
+  differential_map_client_->requestUpdate(
+    *current_position_, map_loader_radius_,
+    [this, position = *current_position_](
+      const map_loader::DifferentialMapClient<pcl::PointXYZ>::MapUpdate & map_update) {
+      last_map_update_position_ = position;
+      if (map_update.added_tiles.empty() && map_update.removed_ids.empty()) {
+        return;
+      }
+      stop_watch_ptr_->toc("processing_time", true);
+      set_map(differential_map_client_->getMap());
+    });
+}
+
 rcl_interfaces::msg::SetParametersResult VoxelBasedCompareMapFilterComponent::paramCallback(
   const std::vector<rclcpp::Parameter> & p)
 {
@@ -23,6 +23,21 @@
 
 namespace euclidean_cluster
 {
+/// Clusters as spans of the indices of the points of the input, stored cluster after cluster
+struct ClusterIndexSpans
+{
+  /// indices of the points of the input
+  std::vector<int> indices;
+  /// index in indices of the first point of every cluster, followed by the size of indices
+  std::vector<size_t> begin{0};
+
+  size_t size() const { return begin.size() - 1; }
+  size_t clusterSize(const size_t cluster_idx) const
+  {
+    return begin[cluster_idx + 1] - begin[cluster_idx];
+  }
+};
+
 class EuclideanClusterInterface
 {
 public:
@@ -0,0 +1,104 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "euclidean_cluster/euclidean_cluster_interface.hpp"
+
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace euclidean_cluster
+{
+/**
+ * Same clustering as VoxelGridBasedEuclideanCluster, without kd-tree.
+ *
+ * The points are bucketed into the cells of the voxel grid, and the cells whose 2D centroids are
+ * within the tolerance are connected with a union-find over the neighbor cells. As with the
+ * pcl::VoxelGrid of VoxelGridBasedEuclideanCluster, whose leaf size along z is 100 km, a column of
+ * the grid has a cell below z = 0 and a cell above, which count their points separately against
+ * min_points_number_per_voxel. The grid is dense
+ * if its bounding box is small enough compared to the number of points, and a hash map otherwise.
+ * The rows of the grid are split into stripes which are connected in parallel.
+ */
+class GridBasedEuclideanCluster : public EuclideanClusterInterface
+{
+public:
+  GridBasedEuclideanCluster();
+  GridBasedEuclideanCluster(
+    bool use_height, int min_cluster_size, int max_cluster_size, float tolerance,
+    float voxel_leaf_size, int min_points_number_per_voxel);
+  bool cluster(
+    const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & pointcloud,
+    std::vector<pcl::PointCloud<pcl::PointXYZ>> & clusters) override;
+  /// Cluster without copying the points
+  bool cluster(const pcl::PointCloud<pcl::PointXYZ> & pointcloud, ClusterIndexSpans & clusters);
+  void setVoxelLeafSize(float voxel_leaf_size) { voxel_leaf_size_ = voxel_leaf_size; }
+  void setTolerance(float tolerance) { tolerance_ = tolerance; }
+  void setMinPointsNumberPerVoxel(int min_points_number_per_voxel)
+  {
+    min_points_number_per_voxel_ = min_points_number_per_voxel;
+  }
+  void setNumThreads(int num_threads) { num_threads_ = std::max(num_threads, 1); }
+
+private:
+  struct Voxel
+  {
+    uint64_t key;
+    int64_t row;
+    int64_t column;
+    int64_t layer;
+    size_t begin;  // index of the first point of the voxel in sorted_indices_
+    size_t end;
+    float x;  // centroid
+    float y;
+  };
+
+  /// Bucket the points by cell, and create the voxels with enough points
+  void createVoxels(const pcl::PointCloud<pcl::PointXYZ> & pointcloud);
+  /// Return the index of the voxel at row, column and layer, or -1
+  int findVoxel(int64_t row, int64_t column, int64_t layer) const;
+  int findRoot(int voxel_idx);
+  void unite(int voxel_idx1, int voxel_idx2);
+  /// Unite the voxels of rows in [first_row, last_row), and keep the pairs crossing last_row
+  void connectStripe(
+    int64_t first_row, int64_t last_row, std::vector<std::pair<int, int>> & crossing_pairs);
+
+  float tolerance_;
+  float voxel_leaf_size_;
+  int min_points_number_per_voxel_;
+  int num_threads_ = 1;
+
+  // buffers kept across the calls
+  int64_t min_column_;
+  int64_t min_row_;
+  int64_t min_layer_;
+  int64_t num_columns_;
+  int64_t num_rows_;
+  int64_t num_layers_;
+  bool use_dense_grid_;
+  std::vector<uint64_t> point_keys_;
+  std::vector<int> sorted_indices_;
+  std::vector<Voxel> voxels_;
+  std::vector<int> parents_;
+  std::vector<int> dense_grid_;
+  std::unordered_map<uint64_t, int> sparse_grid_;
+};
+
+}  // namespace euclidean_cluster
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include "euclidean_cluster/euclidean_cluster_interface.hpp"
+
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <tier4_perception_msgs/msg/detected_objects_with_feature.hpp>
@@ -31,6 +33,9 @@ void convertPointCloudClusters2Msg(
   const std_msgs::msg::Header & header,
   const std::vector<pcl::PointCloud<pcl::PointXYZ>> & clusters,
   tier4_perception_msgs::msg::DetectedObjectsWithFeature & msg);
+void convertPointCloudClusters2Msg(
+  const std_msgs::msg::Header & header, const pcl::PointCloud<pcl::PointXYZ> & pointcloud,
+  const ClusterIndexSpans & clusters, tier4_perception_msgs::msg::DetectedObjectsWithFeature & msg);
 void convertObjectMsg2SensorMsg(
   const tier4_perception_msgs::msg::DetectedObjectsWithFeature & input,
   sensor_msgs::msg::PointCloud2 & output);
@@ -0,0 +1,346 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "euclidean_cluster/grid_based_euclidean_cluster.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace euclidean_cluster
+{
+namespace
+{
+constexpr uint64_t invalid_key = std::numeric_limits<uint64_t>::max();
+// the grid is dense if it has at most this number of cells per point
+constexpr int64_t max_dense_cells_per_point = 4;
+constexpr int64_t min_dense_cells = 1 << 16;
+// leaf size of VoxelGridBasedEuclideanCluster along z, so that its voxels are split at z = 0
+constexpr float layer_height = 100000.0f;
+}  // namespace
+
+GridBasedEuclideanCluster::GridBasedEuclideanCluster() {}
+
+GridBasedEuclideanCluster::GridBasedEuclideanCluster(
+  bool use_height, int min_cluster_size, int max_cluster_size, float tolerance,
+  float voxel_leaf_size, int min_points_number_per_voxel)
+: EuclideanClusterInterface(use_height, min_cluster_size, max_cluster_size),
+  tolerance_(tolerance),
+  voxel_leaf_size_(voxel_leaf_size),
+  min_points_number_per_voxel_(min_points_number_per_voxel)
+{
+}
+
+bool GridBasedEuclideanCluster::cluster(
+  const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & pointcloud,
+  std::vector<pcl::PointCloud<pcl::PointXYZ>> & clusters)
+{
+  ClusterIndexSpans cluster_spans;
+  if (!cluster(*pointcloud, cluster_spans)) {
+    return false;
+  }
+
+  for (size_t cluster_idx = 0; cluster_idx < cluster_spans.size(); ++cluster_idx) {
+    pcl::PointCloud<pcl::PointXYZ> cluster;
+    cluster.points.reserve(cluster_spans.clusterSize(cluster_idx));
+    for (size_t i = cluster_spans.begin[cluster_idx]; i < cluster_spans.begin[cluster_idx + 1];
+         ++i) {
+      cluster.points.push_back(pointcloud->points[cluster_spans.indices[i]]);
+    }
+    cluster.width = cluster.points.size();
+    cluster.height = 1;
+    cluster.is_dense = false;
+    clusters.push_back(std::move(cluster));
+  }
+  return true;
+}
+
+bool GridBasedEuclideanCluster::cluster(
+  const pcl::PointCloud<pcl::PointXYZ> & pointcloud, ClusterIndexSpans & clusters)
+{
+  clusters.indices.clear();
+  clusters.begin.assign(1, 0);
+  createVoxels(pointcloud);
+  if (voxels_.empty()) {
+    return true;
+  }
+
+  // connect the voxels, the stripes of rows in parallel and then the pairs across the stripes
+  parents_.resize(voxels_.size());
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    parents_[i] = static_cast<int>(i);
+  }
+  const int num_stripes = static_cast<int>(std::min<int64_t>(num_threads_, num_rows_));
+  std::vector<std::vector<std::pair<int, int>>> crossing_pairs(num_stripes);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int stripe = 0; stripe < num_stripes; ++stripe) {
+    const int64_t first_row = num_rows_ * stripe / num_stripes;
+    const int64_t last_row = num_rows_ * (stripe + 1) / num_stripes;
+    connectStripe(first_row, last_row, crossing_pairs[stripe]);
+  }
+  for (const auto & stripe_pairs : crossing_pairs) {
+    for (const auto & pair : stripe_pairs) {
+      unite(pair.first, pair.second);
+    }
+  }
+
+  // count the voxels and points of the clusters, in the order of their first voxel
+  std::vector<int> cluster_of_root(voxels_.size(), -1);
+  std::vector<int> cluster_of_voxel(voxels_.size());
+  std::vector<size_t> num_cluster_voxels;
+  std::vector<size_t> num_cluster_points;
+  for (size_t voxel_idx = 0; voxel_idx < voxels_.size(); ++voxel_idx) {
+    const int root = findRoot(static_cast<int>(voxel_idx));
+    if (cluster_of_root[root] < 0) {
+      cluster_of_root[root] = static_cast<int>(num_cluster_voxels.size());
+      num_cluster_voxels.push_back(0);
+      num_cluster_points.push_back(0);
+    }
+    const int cluster_idx = cluster_of_root[root];
+    cluster_of_voxel[voxel_idx] = cluster_idx;
+    ++num_cluster_voxels[cluster_idx];
+    num_cluster_points[cluster_idx] += voxels_[voxel_idx].end - voxels_[voxel_idx].begin;
+  }
+
+  // check cluster size, the clusters of more than max_cluster_size voxels are dropped as by
+  // pcl::EuclideanClusterExtraction
+  std::vector<size_t> next_indices(num_cluster_voxels.size());
+  size_t num_indices = 0;
+  for (size_t cluster_idx = 0; cluster_idx < num_cluster_voxels.size(); ++cluster_idx) {
+    const auto num_points = static_cast<int64_t>(num_cluster_points[cluster_idx]);
+    if (
+      static_cast<int64_t>(num_cluster_voxels[cluster_idx]) > max_cluster_size_ ||
+      num_points < min_cluster_size_ || num_points > max_cluster_size_) {
+      next_indices[cluster_idx] = invalid_key;
+      continue;
+    }
+    next_indices[cluster_idx] = num_indices;
+    num_indices += num_points;
+    clusters.begin.push_back(num_indices);
+  }
+
+  clusters.indices.resize(num_indices);
+  for (size_t voxel_idx = 0; voxel_idx < voxels_.size(); ++voxel_idx) {
+    auto & next_index = next_indices[cluster_of_voxel[voxel_idx]];
+    if (next_index == invalid_key) {
+      continue;
+    }
+    const auto & voxel = voxels_[voxel_idx];
+    std::copy(
+      sorted_indices_.begin() + voxel.begin, sorted_indices_.begin() + voxel.end,
+      clusters.indices.begin() + next_index);
+    next_index += voxel.end - voxel.begin;
+  }
+  return true;
+}
+
+void GridBasedEuclideanCluster::createVoxels(const pcl::PointCloud<pcl::PointXYZ> & pointcloud)
+{
+  // same cells as the pcl::VoxelGrid of VoxelGridBasedEuclideanCluster, whose leaf size along z
+  // splits a column of the grid into a layer below z = 0 and a layer above
+  const float inverse_leaf_size = 1.0f / voxel_leaf_size_;
+  const float inverse_layer_height = 1.0f / layer_height;
+  const auto & points = pointcloud.points;
+  int64_t min_column = std::numeric_limits<int64_t>::max();
+  int64_t min_row = std::numeric_limits<int64_t>::max();
+  int64_t min_layer = std::numeric_limits<int64_t>::max();
+  int64_t max_column = std::numeric_limits<int64_t>::lowest();
+  int64_t max_row = std::numeric_limits<int64_t>::lowest();
+  int64_t max_layer = std::numeric_limits<int64_t>::lowest();
+  for (const auto & point : points) {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+      continue;
+    }
+    const auto column = static_cast<int64_t>(std::floor(point.x * inverse_leaf_size));
+    const auto row = static_cast<int64_t>(std::floor(point.y * inverse_leaf_size));
+    const auto layer = static_cast<int64_t>(std::floor(point.z * inverse_layer_height));
+    min_column = std::min(min_column, column);
+    min_row = std::min(min_row, row);
+    min_layer = std::min(min_layer, layer);
+    max_column = std::max(max_column, column);
+    max_row = std::max(max_row, row);
+    max_layer = std::max(max_layer, layer);
+  }
+  voxels_.clear();
+  if (min_column > max_column) {
+    sorted_indices_.clear();
+    num_rows_ = 0;
+    return;
+  }
+  min_column_ = min_column;
+  min_row_ = min_row;
+  min_layer_ = min_layer;
+  num_columns_ = max_column - min_column + 1;
+  num_rows_ = max_row - min_row + 1;
+  num_layers_ = max_layer - min_layer + 1;
+  const int64_t num_cells = num_columns_ * num_rows_ * num_layers_;
+  const auto num_points = static_cast<int64_t>(points.size());
+  use_dense_grid_ =
+    num_cells <= std::max(max_dense_cells_per_point * num_points, min_dense_cells);
+
+  point_keys_.resize(points.size());
+#pragma omp parallel for num_threads(num_threads_)
+  for (int64_t i = 0; i < num_points; ++i) {
+    const auto & point = points[i];
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+      point_keys_[i] = invalid_key;
+      continue;
+    }
+    const auto column = static_cast<int64_t>(std::floor(point.x * inverse_leaf_size));
+    const auto row = static_cast<int64_t>(std::floor(point.y * inverse_leaf_size));
+    const auto layer = static_cast<int64_t>(std::floor(point.z * inverse_layer_height));
+    point_keys_[i] = static_cast<uint64_t>(
+      ((row - min_row_) * num_columns_ + column - min_column_) * num_layers_ + layer - min_layer_);
+  }
+
+  // sort the points by cell, with a counting sort on the dense grid
+  sorted_indices_.clear();
+  if (use_dense_grid_) {
+    dense_grid_.assign(num_cells + 1, 0);
+    for (const auto key : point_keys_) {
+      if (key != invalid_key) {
+        ++dense_grid_[key + 1];
+      }
+    }
+    for (int64_t key = 0; key < num_cells; ++key) {
+      dense_grid_[key + 1] += dense_grid_[key];
+    }
+    sorted_indices_.resize(dense_grid_[num_cells]);
+    for (int64_t i = 0; i < num_points; ++i) {
+      if (point_keys_[i] != invalid_key) {
+        sorted_indices_[dense_grid_[point_keys_[i]]++] = static_cast<int>(i);
+      }
+    }
+    std::fill(dense_grid_.begin(), dense_grid_.end(), -1);
+  } else {
+    for (int64_t i = 0; i < num_points; ++i) {
+      if (point_keys_[i] != invalid_key) {
+        sorted_indices_.push_back(static_cast<int>(i));
+      }
+    }
+    std::sort(sorted_indices_.begin(), sorted_indices_.end(), [this](const int a, const int b) {
+      return point_keys_[a] < point_keys_[b] || (point_keys_[a] == point_keys_[b] && a < b);
+    });
+    sparse_grid_.clear();
+  }
+
+  // create the voxels of the runs of points in the same cell
+  for (size_t begin = 0; begin < sorted_indices_.size();) {
+    const uint64_t key = point_keys_[sorted_indices_[begin]];
+    size_t end = begin + 1;
+    float sum_x = points[sorted_indices_[begin]].x;
+    float sum_y = points[sorted_indices_[begin]].y;
+    for (; end < sorted_indices_.size() && point_keys_[sorted_indices_[end]] == key; ++end) {
+      sum_x += points[sorted_indices_[end]].x;
+      sum_y += points[sorted_indices_[end]].y;
+    }
+    const auto num_voxel_points = static_cast<int>(end - begin);
+    if (num_voxel_points >= min_points_number_per_voxel_) {
+      Voxel voxel;
+      voxel.key = key;
+      voxel.row = static_cast<int64_t>(key) / num_layers_ / num_columns_;
+      voxel.column = static_cast<int64_t>(key) / num_layers_ % num_columns_;
+      voxel.layer = static_cast<int64_t>(key) % num_layers_;
+      voxel.begin = begin;
+      voxel.end = end;
+      voxel.x = sum_x / static_cast<float>(num_voxel_points);
+      voxel.y = sum_y / static_cast<float>(num_voxel_points);
+      if (use_dense_grid_) {
+        dense_grid_[key] = static_cast<int>(voxels_.size());
+      } else {
+        sparse_grid_.emplace(key, static_cast<int>(voxels_.size()));
+      }
+      voxels_.push_back(voxel);
+    }
+    begin = end;
+  }
+}
+
+int GridBasedEuclideanCluster::findVoxel(
+  const int64_t row, const int64_t column, const int64_t layer) const
+{
+  if (row < 0 || column < 0 || row >= num_rows_ || column >= num_columns_) {
+    return -1;
+  }
+  const auto key = static_cast<uint64_t>((row * num_columns_ + column) * num_layers_ + layer);
+  if (use_dense_grid_) {
+    return dense_grid_[key];
+  }
+  const auto itr = sparse_grid_.find(key);
+  return itr == sparse_grid_.end() ? -1 : itr->second;
+}
+
+int GridBasedEuclideanCluster::findRoot(int voxel_idx)
+{
+  while (parents_[voxel_idx] != voxel_idx) {
+    parents_[voxel_idx] = parents_[parents_[voxel_idx]];
+    voxel_idx = parents_[voxel_idx];
+  }
+  return voxel_idx;
+}
+
+void GridBasedEuclideanCluster::unite(const int voxel_idx1, const int voxel_idx2)
+{
+  const int root1 = findRoot(voxel_idx1);
+  const int root2 = findRoot(voxel_idx2);
+  if (root1 != root2) {
+    parents_[std::max(root1, root2)] = std::min(root1, root2);
+  }
+}
+
+void GridBasedEuclideanCluster::connectStripe(
+  const int64_t first_row, const int64_t last_row,
+  std::vector<std::pair<int, int>> & crossing_pairs)
+{
+  // the centroids of voxels more than this number of cells apart are farther than the tolerance
+  const auto radius = static_cast<int64_t>(std::floor(tolerance_ / voxel_leaf_size_)) + 1;
+  const float squared_tolerance = tolerance_ * tolerance_;
+
+  // the voxels are sorted by row
+  const auto first_voxel = std::lower_bound(
+    voxels_.begin(), voxels_.end(), first_row,
+    [](const Voxel & voxel, const int64_t row) { return voxel.row < row; });
+  for (auto voxel = first_voxel; voxel != voxels_.end() && voxel->row < last_row; ++voxel) {
+    const int voxel_idx = static_cast<int>(voxel - voxels_.begin());
+    // look only forward, so that every pair is checked once. The layers of a cell are compared in
+    // 2D, as the voxels of VoxelGridBasedEuclideanCluster are pressed to z = 0.
+    for (int64_t row_offset = 0; row_offset <= radius; ++row_offset) {
+      const int64_t row = voxel->row + row_offset;
+      for (int64_t column_offset = row_offset == 0 ? 0 : -radius; column_offset <= radius;
+           ++column_offset) {
+        const bool is_same_cell = row_offset == 0 && column_offset == 0;
+        for (int64_t layer = is_same_cell ? voxel->layer + 1 : 0; layer < num_layers_; ++layer) {
+          const int neighbor_idx = findVoxel(row, voxel->column + column_offset, layer);
+          if (neighbor_idx < 0) {
+            continue;
+          }
+          const auto & neighbor = voxels_[neighbor_idx];
+          const float dx = neighbor.x - voxel->x;
+          const float dy = neighbor.y - voxel->y;
+          if (dx * dx + dy * dy > squared_tolerance) {
+            continue;
+          }
+          if (row < last_row) {
+            unite(voxel_idx, neighbor_idx);
+          } else {
+            crossing_pairs.emplace_back(voxel_idx, neighbor_idx);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace euclidean_cluster
@@ -19,6 +19,8 @@
 #include <tier4_perception_msgs/msg/detected_object_with_feature.hpp>
 #include <tier4_perception_msgs/msg/detected_objects_with_feature.hpp>
 
+#include <cstring>
+
 namespace euclidean_cluster
 {
 geometry_msgs::msg::Point getCentroid(const sensor_msgs::msg::PointCloud2 & pointcloud)
@@ -62,6 +64,50 @@ void convertPointCloudClusters2Msg(
     msg.feature_objects.push_back(feature_object);
   }
 }
+
+void convertPointCloudClusters2Msg(
+  const std_msgs::msg::Header & header, const pcl::PointCloud<pcl::PointXYZ> & pointcloud,
+  const ClusterIndexSpans & clusters, tier4_perception_msgs::msg::DetectedObjectsWithFeature & msg)
+{
+  msg.header = header;
+  msg.feature_objects.reserve(msg.feature_objects.size() + clusters.size());
+  for (size_t cluster_idx = 0; cluster_idx < clusters.size(); ++cluster_idx) {
+    tier4_perception_msgs::msg::DetectedObjectWithFeature feature_object;
+    // same layout as pcl::toROSMsg, written from the indices of the points
+    auto & ros_pointcloud = feature_object.feature.cluster;
+    ros_pointcloud.header = header;
+    sensor_msgs::PointCloud2Modifier modifier(ros_pointcloud);
+    using sensor_msgs::msg::PointField;
+    modifier.setPointCloud2Fields(
+      3, "x", 1, PointField::FLOAT32, "y", 1, PointField::FLOAT32, "z", 1, PointField::FLOAT32);
+    ros_pointcloud.point_step = sizeof(pcl::PointXYZ);
+    modifier.resize(clusters.clusterSize(cluster_idx));
+    ros_pointcloud.is_dense = false;
+
+    geometry_msgs::msg::Point centroid;
+    auto * data = ros_pointcloud.data.data();
+    for (size_t i = clusters.begin[cluster_idx]; i < clusters.begin[cluster_idx + 1]; ++i) {
+      const auto & point = pointcloud.points[clusters.indices[i]];
+      std::memcpy(data, &point, sizeof(pcl::PointXYZ));
+      data += sizeof(pcl::PointXYZ);
+      centroid.x += point.x;
+      centroid.y += point.y;
+      centroid.z += point.z;
+    }
+    const auto size = static_cast<double>(clusters.clusterSize(cluster_idx));
+    centroid.x /= size;
+    centroid.y /= size;
+    centroid.z /= size;
+    feature_object.object.kinematics.pose_with_covariance.pose.position = centroid;
+
+    autoware_auto_perception_msgs::msg::ObjectClassification classification;
+    classification.label = autoware_auto_perception_msgs::msg::ObjectClassification::UNKNOWN;
+    classification.probability = 1.0f;
+    feature_object.object.classification.emplace_back(classification);
+    msg.feature_objects.push_back(std::move(feature_object));
+  }
+}
+
 void convertObjectMsg2SensorMsg(
   const tier4_perception_msgs::msg::DetectedObjectsWithFeature & input,
   sensor_msgs::msg::PointCloud2 & output)
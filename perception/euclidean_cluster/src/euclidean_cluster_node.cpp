@@ -38,11 +38,14 @@ EuclideanClusterNode::EuclideanClusterNode(const rclcpp::NodeOptions & options)
   cluster_pub_ = this->create_publisher<tier4_perception_msgs::msg::DetectedObjectsWithFeature>(
     "output", rclcpp::QoS{1});
   debug_pub_ = this->create_publisher<sensor_msgs::msg::PointCloud2>("debug/clusters", 1);
+  latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
 }
 
 void EuclideanClusterNode::onPointCloud(
   const sensor_msgs::msg::PointCloud2::ConstSharedPtr input_msg)
 {
+  const auto span = latency_tracer_->startSpan(input_msg->header.stamp);
+
   // convert ros to pcl
   pcl::PointCloud<pcl::PointXYZ>::Ptr raw_pointcloud_ptr(new pcl::PointCloud<pcl::PointXYZ>);
   pcl::fromROSMsg(*input_msg, *raw_pointcloud_ptr);
@@ -55,6 +58,7 @@ void EuclideanClusterNode::onPointCloud(
   tier4_perception_msgs::msg::DetectedObjectsWithFeature output;
   convertPointCloudClusters2Msg(input_msg->header, clusters, output);
   cluster_pub_->publish(output);
+  latency_tracer_->publishLatency(input_msg->header.stamp);
 
   // build debug msg
   if (debug_pub_->get_subscription_count() < 1) {
@@ -30,9 +30,19 @@ VoxelGridBasedEuclideanClusterNode::VoxelGridBasedEuclideanClusterNode(
   const float tolerance = this->declare_parameter("tolerance", 1.0);
   const float voxel_leaf_size = this->declare_parameter("voxel_leaf_size", 0.5);
   const int min_points_number_per_voxel = this->declare_parameter("min_points_number_per_voxel", 3);
-  cluster_ = std::make_shared<VoxelGridBasedEuclideanCluster>(
-    use_height, min_cluster_size, max_cluster_size, tolerance, voxel_leaf_size,
-    min_points_number_per_voxel);
+  const bool use_grid_connected_components =
+    this->declare_parameter("use_grid_connected_components", false);
+  const int num_threads = this->declare_parameter("num_threads", 1);
+  if (use_grid_connected_components) {
+    grid_cluster_ = std::make_shared<GridBasedEuclideanCluster>(
+      use_height, min_cluster_size, max_cluster_size, tolerance, voxel_leaf_size,
+      min_points_number_per_voxel);
+    grid_cluster_->setNumThreads(num_threads);
+  } else {
+    cluster_ = std::make_shared<VoxelGridBasedEuclideanCluster>(
+      use_height, min_cluster_size, max_cluster_size, tolerance, voxel_leaf_size,
+      min_points_number_per_voxel);
+  }
 
   using std::placeholders::_1;
   pointcloud_sub_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
@@ -42,23 +52,30 @@ VoxelGridBasedEuclideanClusterNode::VoxelGridBasedEuclideanClusterNode(
   cluster_pub_ = this->create_publisher<tier4_perception_msgs::msg::DetectedObjectsWithFeature>(
     "output", rclcpp::QoS{1});
   debug_pub_ = this->create_publisher<sensor_msgs::msg::PointCloud2>("debug/clusters", 1);
+  latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
 }
 
 void VoxelGridBasedEuclideanClusterNode::onPointCloud(
   const sensor_msgs::msg::PointCloud2::ConstSharedPtr input_msg)
 {
+  const auto span = latency_tracer_->startSpan(input_msg->header.stamp);
+
   // convert ros to pcl
   pcl::PointCloud<pcl::PointXYZ>::Ptr raw_pointcloud_ptr(new pcl::PointCloud<pcl::PointXYZ>);
   pcl::fromROSMsg(*input_msg, *raw_pointcloud_ptr);
 
-  // clustering
-  std::vector<pcl::PointCloud<pcl::PointXYZ>> clusters;
-  cluster_->cluster(raw_pointcloud_ptr, clusters);
-
-  // build output msg
+  // clustering and build output msg
   tier4_perception_msgs::msg::DetectedObjectsWithFeature output;
-  convertPointCloudClusters2Msg(input_msg->header, clusters, output);
+  if (grid_cluster_) {
+    grid_cluster_->cluster(*raw_pointcloud_ptr, cluster_spans_);
+    convertPointCloudClusters2Msg(input_msg->header, *raw_pointcloud_ptr, cluster_spans_, output);
+  } else {
+    std::vector<pcl::PointCloud<pcl::PointXYZ>> clusters;
+    cluster_->cluster(raw_pointcloud_ptr, clusters);
+    convertPointCloudClusters2Msg(input_msg->header, clusters, output);
+  }
   cluster_pub_->publish(output);
+  latency_tracer_->publishLatency(input_msg->header.stamp);
 
   // build debug msg
   if (debug_pub_->get_subscription_count() < 1) {
@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include "euclidean_cluster/grid_based_euclidean_cluster.hpp"
 #include "euclidean_cluster/voxel_grid_based_euclidean_cluster.hpp"
 
 #include <rclcpp/rclcpp.hpp>
+#include <tier4_autoware_utils/ros/latency_tracer.hpp>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
@@ -37,8 +39,11 @@ private:
   rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr pointcloud_sub_;
   rclcpp::Publisher<tier4_perception_msgs::msg::DetectedObjectsWithFeature>::SharedPtr cluster_pub_;
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr debug_pub_;
+  std::unique_ptr<tier4_autoware_utils::LatencyTracer> latency_tracer_;
 
   std::shared_ptr<VoxelGridBasedEuclideanCluster> cluster_;
+  std::shared_ptr<GridBasedEuclideanCluster> grid_cluster_;
+  ClusterIndexSpans cluster_spans_;
 };
 
 }  // namespace euclidean_cluster
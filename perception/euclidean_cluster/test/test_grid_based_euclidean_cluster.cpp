@@ -0,0 +1,194 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "euclidean_cluster/grid_based_euclidean_cluster.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using euclidean_cluster::ClusterIndexSpans;
+using euclidean_cluster::GridBasedEuclideanCluster;
+using Partition = std::set<std::set<int>>;
+
+namespace
+{
+struct Params
+{
+  float voxel_leaf_size;
+  float tolerance;
+  int min_points_number_per_voxel;
+  int min_cluster_size;
+  int max_cluster_size;
+};
+
+// Same voxels as the pcl::VoxelGrid of VoxelGridBasedEuclideanCluster, i.e. split at z = 0, and a
+// breadth-first search over all the pairs of 2D centroids
+Partition clusterByBruteForce(const pcl::PointCloud<pcl::PointXYZ> & cloud, const Params & params)
+{
+  std::map<std::tuple<int64_t, int64_t, int64_t>, std::vector<int>> cells;
+  const float inverse_leaf_size = 1.0f / params.voxel_leaf_size;
+  for (size_t i = 0; i < cloud.points.size(); ++i) {
+    const auto & point = cloud.points[i];
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+      continue;
+    }
+    cells[std::make_tuple(
+            static_cast<int64_t>(std::floor(point.x * inverse_leaf_size)),
+            static_cast<int64_t>(std::floor(point.y * inverse_leaf_size)),
+            static_cast<int64_t>(std::floor(point.z * (1.0f / 100000.0f))))]
+      .push_back(static_cast<int>(i));
+  }
+
+  std::vector<std::vector<int>> voxels;
+  std::vector<std::pair<float, float>> centroids;
+  for (const auto & cell : cells) {
+    if (static_cast<int>(cell.second.size()) < params.min_points_number_per_voxel) {
+      continue;
+    }
+    float sum_x = 0.0f;
+    float sum_y = 0.0f;
+    for (const int i : cell.second) {
+      sum_x += cloud.points[i].x;
+      sum_y += cloud.points[i].y;
+    }
+    const auto num_points = static_cast<float>(cell.second.size());
+    voxels.push_back(cell.second);
+    centroids.emplace_back(sum_x / num_points, sum_y / num_points);
+  }
+
+  Partition partition;
+  std::vector<bool> visited(voxels.size(), false);
+  for (size_t seed = 0; seed < voxels.size(); ++seed) {
+    if (visited[seed]) {
+      continue;
+    }
+    visited[seed] = true;
+    std::vector<size_t> queue = {seed};
+    for (size_t head = 0; head < queue.size(); ++head) {
+      const auto & centroid = centroids[queue[head]];
+      for (size_t other = 0; other < voxels.size(); ++other) {
+        const float dx = centroids[other].first - centroid.first;
+        const float dy = centroids[other].second - centroid.second;
+        if (!visited[other] && dx * dx + dy * dy <= params.tolerance * params.tolerance) {
+          visited[other] = true;
+          queue.push_back(other);
+        }
+      }
+    }
+    std::set<int> cluster;
+    for (const auto voxel_idx : queue) {
+      cluster.insert(voxels[voxel_idx].begin(), voxels[voxel_idx].end());
+    }
+    const auto num_voxels = static_cast<int>(queue.size());
+    const auto num_points = static_cast<int>(cluster.size());
+    if (
+      num_voxels <= params.max_cluster_size && params.min_cluster_size <= num_points &&
+      num_points <= params.max_cluster_size) {
+      partition.insert(cluster);
+    }
+  }
+  return partition;
+}
+
+Partition toPartition(const ClusterIndexSpans & spans)
+{
+  Partition partition;
+  for (size_t cluster_idx = 0; cluster_idx < spans.size(); ++cluster_idx) {
+    partition.emplace(
+      spans.indices.begin() + spans.begin[cluster_idx],
+      spans.indices.begin() + spans.begin[cluster_idx + 1]);
+  }
+  return partition;
+}
+
+// Blobs of points scattered over an area, around z = 0 so that the cells are split
+pcl::PointCloud<pcl::PointXYZ>::Ptr createCloud(std::mt19937 & engine, const float area_size)
+{
+  auto cloud = std::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  std::uniform_real_distribution<float> center(-area_size / 2.0f, area_size / 2.0f);
+  std::uniform_real_distribution<float> blob_size(0.2f, 3.5f);
+  std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+  std::uniform_int_distribution<int> num_blobs(5, 64);
+  std::uniform_int_distribution<int> num_blob_points(1, 300);
+  for (int blob = num_blobs(engine); blob > 0; --blob) {
+    const float center_x = center(engine);
+    const float center_y = center(engine);
+    const float size = blob_size(engine);
+    for (int i = num_blob_points(engine); i > 0; --i) {
+      cloud->points.emplace_back(
+        center_x + size * offset(engine), center_y + size * offset(engine), offset(engine));
+    }
+  }
+  return cloud;
+}
+}  // namespace
+
+TEST(GridBasedEuclideanCluster, MatchesBruteForce)
+{
+  std::mt19937 engine(5);
+  for (int trial = 0; trial < 40; ++trial) {
+    SCOPED_TRACE(trial);
+    // the odd trials are spread enough for the sparse grid
+    const auto cloud = createCloud(engine, trial % 2 ? 60.0f : 3000.0f);
+    if (trial % 4 == 3) {
+      cloud->points.emplace_back(std::numeric_limits<float>::quiet_NaN(), 1.0f, 1.0f);
+    }
+    const Params params{0.3f, trial % 3 ? 0.7f : 1.3f, 1 + trial % 3, 10, 3000 - trial * 70};
+    GridBasedEuclideanCluster cluster(
+      false, params.min_cluster_size, params.max_cluster_size, params.tolerance,
+      params.voxel_leaf_size, params.min_points_number_per_voxel);
+    cluster.setNumThreads(1 + trial % 4);
+
+    ClusterIndexSpans spans;
+    ASSERT_TRUE(cluster.cluster(*cloud, spans));
+    EXPECT_EQ(toPartition(spans), clusterByBruteForce(*cloud, params));
+
+    std::vector<pcl::PointCloud<pcl::PointXYZ>> clouds;
+    ASSERT_TRUE(cluster.cluster(pcl::PointCloud<pcl::PointXYZ>::ConstPtr(cloud), clouds));
+    ASSERT_EQ(clouds.size(), spans.size());
+    for (size_t cluster_idx = 0; cluster_idx < spans.size(); ++cluster_idx) {
+      EXPECT_EQ(clouds[cluster_idx].points.size(), spans.clusterSize(cluster_idx));
+    }
+  }
+}
+
+TEST(GridBasedEuclideanCluster, SplitsCellsAtZeroHeight)
+{
+  // 3 points of a cell below z = 0 and 3 above, which are a voxel of 6 points in 2D but two voxels
+  // of 3 points for pcl::VoxelGrid
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  for (int i = 0; i < 3; ++i) {
+    cloud.points.emplace_back(0.1f * i, 0.1f, -0.5f);
+    cloud.points.emplace_back(0.1f * i, 0.2f, 0.5f);
+  }
+  ClusterIndexSpans spans;
+
+  GridBasedEuclideanCluster cluster(false, 1, 100, 0.5f, 1.0f, 4);
+  ASSERT_TRUE(cluster.cluster(cloud, spans));
+  EXPECT_EQ(spans.size(), 0U);
+
+  // both halves are kept and joined as their centroids are within the tolerance
+  cluster.setMinPointsNumberPerVoxel(3);
+  ASSERT_TRUE(cluster.cluster(cloud, spans));
+  ASSERT_EQ(spans.size(), 1U);
+  EXPECT_EQ(spans.clusterSize(0), 6U);
+}
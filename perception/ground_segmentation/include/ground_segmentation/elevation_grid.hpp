@@ -0,0 +1,165 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GROUND_SEGMENTATION__ELEVATION_GRID_HPP_
+#define GROUND_SEGMENTATION__ELEVATION_GRID_HPP_
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ground_segmentation
+{
+/*!
+ * Rolling elevation grid of the ground height around the vehicle, in a fixed frame.
+ *
+ * The cells are stored in a ring buffer indexed by the cell coordinates modulo the grid size, and
+ * every cell is tagged with its coordinates. Moving the window thus only moves its bounds: the
+ * cells which stay in the window keep their ground height, and the ones which leave it are
+ * invalidated by their tag when their slot is reused.
+ */
+class ElevationGrid
+{
+public:
+  struct Parameters
+  {
+    double cell_size;                   // [m]
+    double grid_length;                 // length of a side of the window [m]
+    double height_threshold;            // height above the ground of the non ground points [m]
+    double max_height_change;           // height change of a cell accepted as a ground change [m]
+    double global_slope_max_angle_rad;  // max slope of the ground from the vehicle
+    double smoothing;                   // weight of the new observations of the ground height
+    double cell_lifetime;               // time after which an unobserved cell is forgotten [s]
+  };
+
+  struct Statistics
+  {
+    size_t num_cells;
+    size_t num_known_cells;
+    size_t num_updated_cells;
+    size_t memory_bytes;
+  };
+
+  explicit ElevationGrid(const Parameters & parameters);
+
+  void setNumThreads(const int num_threads) { num_threads_ = std::max(num_threads, 1); }
+
+  /*!
+   * Center the window on the ground point of the vehicle
+   * @param ground_origin Ground point below the vehicle in the fixed frame
+   */
+  void moveTo(const Eigen::Vector3d & ground_origin);
+
+  /*!
+   * Update the ground height of the cells with the lowest point observed in every cell
+   * @param points Points in the fixed frame, the non finite ones are ignored
+   * @param stamp Time of the points [s]
+   */
+  void update(const std::vector<Eigen::Vector3f> & points, const double stamp);
+
+  /*!
+   * Classify a point in the fixed frame, with the ground height of its cell if it is known, or
+   * with the global slope from the vehicle otherwise. A non finite point is not ground.
+   */
+  bool isGround(const Eigen::Vector3f & point) const
+  {
+    if (!point.allFinite()) {
+      return false;
+    }
+    const int64_t cell_x = toCellCoordinate(point.x());
+    const int64_t cell_y = toCellCoordinate(point.y());
+    if (isInWindow(cell_x, cell_y)) {
+      const auto & cell = cells_[toIndex(cell_x, cell_y)];
+      if (isKnown(cell, cell_x, cell_y)) {
+        const double ground_margin = parameters_.height_threshold + cell.slope * half_diagonal_;
+        return point.z() <= cell.height + ground_margin;
+      }
+    }
+    return point.z() <= globalGroundLimit(point.x(), point.y());
+  }
+
+  Statistics getStatistics() const;
+
+private:
+  struct Cell
+  {
+    int32_t x = 0;
+    int32_t y = 0;
+    bool valid = false;
+    float height = 0.0f;
+    float slope = 0.0f;
+    double stamp = 0.0;
+  };
+
+  /// The position must be finite
+  int64_t toCellCoordinate(const double position) const
+  {
+    return static_cast<int64_t>(std::floor(position * inverse_cell_size_));
+  }
+
+  bool isInWindow(const int64_t cell_x, const int64_t cell_y) const
+  {
+    return cell_x >= min_cell_x_ && cell_y >= min_cell_y_ && cell_x < min_cell_x_ + grid_cells_ &&
+           cell_y < min_cell_y_ + grid_cells_;
+  }
+
+  size_t toIndex(const int64_t cell_x, const int64_t cell_y) const
+  {
+    const int64_t index_x = ((cell_x % grid_cells_) + grid_cells_) % grid_cells_;
+    const int64_t index_y = ((cell_y % grid_cells_) + grid_cells_) % grid_cells_;
+    return static_cast<size_t>(index_y * grid_cells_ + index_x);
+  }
+
+  bool isKnown(const Cell & cell, const int64_t cell_x, const int64_t cell_y) const
+  {
+    return cell.valid && cell.x == cell_x && cell.y == cell_y &&
+           stamp_ - cell.stamp <= parameters_.cell_lifetime;
+  }
+
+  /// Highest ground allowed by the global slope from the vehicle
+  double globalGroundLimit(const double x, const double y) const
+  {
+    const double distance = std::hypot(x - ground_origin_.x(), y - ground_origin_.y());
+    return ground_origin_.z() + tan_global_slope_ * distance + parameters_.height_threshold;
+  }
+
+  /// Order preserving conversion of a float into an unsigned integer, for atomic min
+  static uint32_t toOrderedKey(const float value);
+  static float fromOrderedKey(const uint32_t key);
+
+  const Parameters parameters_;
+  const double inverse_cell_size_;
+  const double half_diagonal_;
+  const double tan_global_slope_;
+  const int64_t grid_cells_;
+  int num_threads_ = 1;
+
+  std::vector<Cell> cells_;
+  // lowest point of every cell in the current frame
+  std::unique_ptr<std::atomic<uint32_t>[]> lowest_keys_;
+
+  Eigen::Vector3d ground_origin_ = Eigen::Vector3d::Zero();
+  int64_t min_cell_x_ = 0;
+  int64_t min_cell_y_ = 0;
+  double stamp_ = 0.0;
+  size_t num_updated_cells_ = 0;
+};
+}  // namespace ground_segmentation
+
+#endif  // GROUND_SEGMENTATION__ELEVATION_GRID_HPP_
@@ -0,0 +1,70 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GROUND_SEGMENTATION__ELEVATION_GRID_GROUND_FILTER_NODELET_HPP_
+#define GROUND_SEGMENTATION__ELEVATION_GRID_GROUND_FILTER_NODELET_HPP_
+
+#include "ground_segmentation/elevation_grid.hpp"
+#include "pointcloud_preprocessor/filter.hpp"
+
+#include <Eigen/Geometry>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ground_segmentation
+{
+class ElevationGridGroundFilterComponent : public pointcloud_preprocessor::Filter
+{
+private:
+  void filter(
+    const PointCloud2ConstPtr & input, const IndicesPtr & indices, PointCloud2 & output) override;
+
+  /*!
+   * Look up the transform of a frame to the fixed frame
+   * @param[in] frame_id Source frame
+   * @param[in] stamp Time of the transform
+   * @param[out] transform Transform from frame_id to the fixed frame
+   * @retval true lookup succeeded
+   * @retval false lookup failed
+   */
+  bool lookupTransform(
+    const std::string & frame_id, const rclcpp::Time & stamp, Eigen::Affine3f & transform);
+
+  std::string base_frame_;
+  std::string fixed_frame_;
+  int num_threads_;
+  std::unique_ptr<ElevationGrid> elevation_grid_;
+
+  // buffers kept across the frames
+  std::vector<Eigen::Vector3f> points_;
+  std::vector<uint8_t> is_ground_;
+  std::vector<size_t> chunk_begin_;
+
+  /** \brief Parameter service callback result : needed to be hold */
+  OnSetParametersCallbackHandle::SharedPtr set_param_res_;
+
+  /** \brief Parameter service callback */
+  rcl_interfaces::msg::SetParametersResult onParameter(const std::vector<rclcpp::Parameter> & p);
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  explicit ElevationGridGroundFilterComponent(const rclcpp::NodeOptions & options);
+};
+}  // namespace ground_segmentation
+
+#endif  // GROUND_SEGMENTATION__ELEVATION_GRID_GROUND_FILTER_NODELET_HPP_
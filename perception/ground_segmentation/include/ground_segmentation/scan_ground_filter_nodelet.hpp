@@ -55,17 +55,23 @@ private:
     UNKNOWN,
     VIRTUAL_GROUND,
   };
-  struct PointRef
+  /*!
+   * Points in structure-of-arrays layout, grouped by radial division and sorted by radius in
+   * every division. The buffers are kept across the frames to avoid reallocations.
+   */
+  struct RadialOrderedPoints
   {
-    float radius;       // cylindrical coords on XY Plane
-    float theta;        // angle deg on XY plane
-    size_t radial_div;  // index of the radial division to which this point belongs to
-    PointLabel point_state{PointLabel::INIT};
-
-    size_t orig_index;  // index of this point in the source pointcloud
-    pcl::PointXYZ * orig_point;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;  // cylindrical coords on XY Plane
+    std::vector<PointLabel> point_state;
+    // index of the first point of every radial division, followed by the number of points
+    std::vector<size_t> division_begin;
+    // index in the output of the first non ground point of every radial division, followed by
+    // the number of non ground points
+    std::vector<size_t> no_ground_begin;
   };
-  using PointCloudRefVector = std::vector<PointRef>;
 
   struct PointsCentroid
   {
@@ -121,8 +127,16 @@ private:
     split_height_distance_;                 // useful for close points
   bool use_virtual_ground_point_;
   size_t radial_dividers_num_;
+  int num_threads_;
   VehicleInfo vehicle_info_;
 
+  // buffers kept across the frames
+  RadialOrderedPoints radial_ordered_points_;
+  std::vector<float> radius_;
+  std::vector<size_t> radial_div_;
+  std::vector<size_t> sorted_indices_;
+  std::vector<size_t> division_counts_;
+
   /*!
    * Output transformed PointCloud from in_cloud_ptr->header.frame_id to in_target_frame
    * @param[in] in_target_frame Coordinate system to perform transform
@@ -136,14 +150,14 @@ private:
     const PointCloud2::SharedPtr & out_cloud_ptr);
 
   /*!
-   * Convert pcl::PointCloud to sorted PointCloudRefVector
-   * @param[in] in_cloud Input Point Cloud to be organized in radial segments
-   * @param[out] out_radial_ordered_points_manager Vector of Points Clouds,
-   *     each element will contain the points ordered
+   * Organize the points of a PointCloud in radial divisions sorted by radius
+   * @param[in] in_cloud Input PointCloud with float x, y and z fields
+   * @param[out] out_radial_ordered_points Points ordered by radial division and radius
+   * @retval true conversion succeeded
+   * @retval false the input has no float x, y and z fields
    */
-  void convertPointcloud(
-    const pcl::PointCloud<pcl::PointXYZ>::Ptr in_cloud,
-    std::vector<PointCloudRefVector> & out_radial_ordered_points_manager);
+  bool convertPointcloud(
+    const PointCloud2 & in_cloud, RadialOrderedPoints & out_radial_ordered_points);
 
   /*!
    * Output ground center of front wheels as the virtual ground point
@@ -152,26 +166,30 @@ private:
   void calcVirtualGroundOrigin(pcl::PointXYZ & point);
 
   /*!
-   * Classifies Points in the PointCloud as Ground and Not Ground
-   * @param in_radial_ordered_clouds Vector of an Ordered PointsCloud
-   *     ordered by radial distance from the origin
-   * @param out_no_ground_indices Returns the indices of the points
-   *     classified as not ground in the original PointCloud
+   * Classifies Points in the PointCloud as Ground and Not Ground, the radial divisions are
+   * classified in parallel
+   * @param in_radial_ordered_points Points ordered by radial division and radius, whose
+   *     point_state and no_ground_begin are set
+   */
+  void classifyPointCloud(RadialOrderedPoints & in_radial_ordered_points);
+
+  /*!
+   * Classifies the Points of one radial division as Ground and Not Ground
+   * @param in_radial_ordered_points Points ordered by radial division and radius, whose
+   *     point_state is set for the division
+   * @param division Index of the radial division
+   * @return Number of the points classified as not ground
    */
-  void classifyPointCloud(
-    std::vector<PointCloudRefVector> & in_radial_ordered_clouds,
-    pcl::PointIndices & out_no_ground_indices);
+  size_t classifyRadialDivision(
+    RadialOrderedPoints & in_radial_ordered_points, const size_t division);
 
   /*!
-   * Returns the resulting complementary PointCloud, one with the points kept
-   * and the other removed as indicated in the indices
-   * @param in_cloud_ptr Input PointCloud to which the extraction will be performed
-   * @param in_indices Indices of the points to be both removed and kept
-   * @param out_object_cloud_ptr Resulting PointCloud with the indices kept
+   * Write the points classified as not ground into a PointCloud of pcl::PointXYZ layout
+   * @param in_radial_ordered_points Classified points
+   * @param out_object_cloud Resulting PointCloud
    */
   void extractObjectPoints(
-    const pcl::PointCloud<pcl::PointXYZ>::Ptr in_cloud_ptr, const pcl::PointIndices & in_indices,
-    pcl::PointCloud<pcl::PointXYZ>::Ptr out_object_cloud_ptr);
+    const RadialOrderedPoints & in_radial_ordered_points, PointCloud2 & out_object_cloud);
 
   /** \brief Parameter service callback result : needed to be hold */
   OnSetParametersCallbackHandle::SharedPtr set_param_res_;
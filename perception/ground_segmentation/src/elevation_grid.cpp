@@ -0,0 +1,189 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_segmentation/elevation_grid.hpp"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace ground_segmentation
+{
+namespace
+{
+constexpr uint32_t empty_key = std::numeric_limits<uint32_t>::max();
+}  // namespace
+
+ElevationGrid::ElevationGrid(const Parameters & parameters)
+: parameters_(parameters),
+  inverse_cell_size_(1.0 / parameters.cell_size),
+  half_diagonal_(parameters.cell_size * std::sqrt(0.5)),
+  tan_global_slope_(std::tan(parameters.global_slope_max_angle_rad)),
+  grid_cells_(std::max<int64_t>(
+    static_cast<int64_t>(std::ceil(parameters.grid_length / parameters.cell_size)), 1)),
+  cells_(grid_cells_ * grid_cells_),
+  lowest_keys_(new std::atomic<uint32_t>[grid_cells_ * grid_cells_])
+{
+}
+
+uint32_t ElevationGrid::toOrderedKey(const float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  // flip all the bits of the negative values, and the sign bit of the positive ones
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+float ElevationGrid::fromOrderedKey(const uint32_t key)
+{
+  const uint32_t bits = (key & 0x80000000u) ? key & 0x7fffffffu : ~key;
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void ElevationGrid::moveTo(const Eigen::Vector3d & ground_origin)
+{
+  ground_origin_ = ground_origin;
+  min_cell_x_ = toCellCoordinate(ground_origin.x()) - grid_cells_ / 2;
+  min_cell_y_ = toCellCoordinate(ground_origin.y()) - grid_cells_ / 2;
+}
+
+void ElevationGrid::update(const std::vector<Eigen::Vector3f> & points, const double stamp)
+{
+  stamp_ = stamp;
+  const int num_cells = static_cast<int>(cells_.size());
+#pragma omp parallel for num_threads(num_threads_)
+  for (int i = 0; i < num_cells; ++i) {
+    lowest_keys_[i].store(empty_key, std::memory_order_relaxed);
+  }
+
+  // lowest point of every cell
+  const int num_points = static_cast<int>(points.size());
+#pragma omp parallel for num_threads(num_threads_)
+  for (int i = 0; i < num_points; ++i) {
+    const auto & point = points[i];
+    if (!point.allFinite()) {
+      continue;
+    }
+    const int64_t cell_x = toCellCoordinate(point.x());
+    const int64_t cell_y = toCellCoordinate(point.y());
+    if (!isInWindow(cell_x, cell_y)) {
+      continue;
+    }
+    auto & lowest_key = lowest_keys_[toIndex(cell_x, cell_y)];
+    const uint32_t key = toOrderedKey(point.z());
+    uint32_t current_key = lowest_key.load(std::memory_order_relaxed);
+    while (key < current_key &&
+           !lowest_key.compare_exchange_weak(current_key, key, std::memory_order_relaxed)) {
+    }
+  }
+
+  // update the ground height of the observed cells
+  size_t num_updated_cells = 0;
+#pragma omp parallel for num_threads(num_threads_) reduction(+ : num_updated_cells)
+  for (int64_t index_y = 0; index_y < grid_cells_; ++index_y) {
+    // coordinates of the cells of this row in the window
+    const int64_t cell_y =
+      min_cell_y_ + ((index_y - min_cell_y_) % grid_cells_ + grid_cells_) % grid_cells_;
+    for (int64_t index_x = 0; index_x < grid_cells_; ++index_x) {
+      const size_t index = index_y * grid_cells_ + index_x;
+      const uint32_t key = lowest_keys_[index].load(std::memory_order_relaxed);
+      if (key == empty_key) {
+        continue;
+      }
+      const int64_t cell_x =
+        min_cell_x_ + ((index_x - min_cell_x_) % grid_cells_ + grid_cells_) % grid_cells_;
+      const double lowest_height = fromOrderedKey(key);
+      auto & cell = cells_[index];
+
+      if (isKnown(cell, cell_x, cell_y)) {
+        const double height_change = lowest_height - cell.height;
+        if (height_change < -parameters_.max_height_change) {
+          // the ground was hidden, or the cell was initialized on an object
+          cell.height = lowest_height;
+        } else if (height_change <= parameters_.max_height_change) {
+          cell.height += parameters_.smoothing * height_change;
+        }
+        // otherwise, the ground is covered by an object
+        cell.stamp = stamp;
+        ++num_updated_cells;
+        continue;
+      }
+
+      // the center of the cell is used, so that the limit does not depend on the point
+      const double center_x = (static_cast<double>(cell_x) + 0.5) * parameters_.cell_size;
+      const double center_y = (static_cast<double>(cell_y) + 0.5) * parameters_.cell_size;
+      if (lowest_height > globalGroundLimit(center_x, center_y)) {
+        continue;
+      }
+      cell.x = static_cast<int32_t>(cell_x);
+      cell.y = static_cast<int32_t>(cell_y);
+      cell.valid = true;
+      cell.height = lowest_height;
+      cell.slope = 0.0f;
+      cell.stamp = stamp;
+      ++num_updated_cells;
+    }
+  }
+  num_updated_cells_ = num_updated_cells;
+
+  // slope to the neighbor cells, once all the heights are updated
+#pragma omp parallel for num_threads(num_threads_)
+  for (int64_t cell_y = min_cell_y_; cell_y < min_cell_y_ + grid_cells_; ++cell_y) {
+    for (int64_t cell_x = min_cell_x_; cell_x < min_cell_x_ + grid_cells_; ++cell_x) {
+      const size_t index = toIndex(cell_x, cell_y);
+      auto & cell = cells_[index];
+      if (lowest_keys_[index].load(std::memory_order_relaxed) == empty_key) {
+        continue;
+      }
+      if (!isKnown(cell, cell_x, cell_y)) {
+        continue;
+      }
+      float max_height_difference = 0.0f;
+      const int64_t neighbors[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+      for (const auto & neighbor : neighbors) {
+        const int64_t neighbor_x = cell_x + neighbor[0];
+        const int64_t neighbor_y = cell_y + neighbor[1];
+        if (!isInWindow(neighbor_x, neighbor_y)) {
+          continue;
+        }
+        const auto & neighbor_cell = cells_[toIndex(neighbor_x, neighbor_y)];
+        if (isKnown(neighbor_cell, neighbor_x, neighbor_y)) {
+          max_height_difference =
+            std::max(max_height_difference, std::abs(cell.height - neighbor_cell.height));
+        }
+      }
+      cell.slope = static_cast<float>(max_height_difference * inverse_cell_size_);
+    }
+  }
+}
+
+ElevationGrid::Statistics ElevationGrid::getStatistics() const
+{
+  Statistics statistics{};
+  statistics.num_cells = cells_.size();
+  for (int64_t cell_y = min_cell_y_; cell_y < min_cell_y_ + grid_cells_; ++cell_y) {
+    for (int64_t cell_x = min_cell_x_; cell_x < min_cell_x_ + grid_cells_; ++cell_x) {
+      if (isKnown(cells_[toIndex(cell_x, cell_y)], cell_x, cell_y)) {
+        ++statistics.num_known_cells;
+      }
+    }
+  }
+  statistics.num_updated_cells = num_updated_cells_;
+  statistics.memory_bytes =
+    cells_.capacity() * sizeof(Cell) + cells_.size() * sizeof(std::atomic<uint32_t>);
+  return statistics;
+}
+}  // namespace ground_segmentation
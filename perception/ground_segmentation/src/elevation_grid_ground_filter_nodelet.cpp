@@ -0,0 +1,234 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_segmentation/elevation_grid_ground_filter_nodelet.hpp"
+
+#include <tier4_autoware_utils/math/unit_conversion.hpp>
+
+#ifdef ROS_DISTRO_GALACTIC
+#include <tf2_eigen/tf2_eigen.h>
+#else
+#include <tf2_eigen/tf2_eigen.hpp>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ground_segmentation
+{
+using pointcloud_preprocessor::get_param;
+using tier4_autoware_utils::deg2rad;
+
+ElevationGridGroundFilterComponent::ElevationGridGroundFilterComponent(
+  const rclcpp::NodeOptions & options)
+: Filter("ElevationGridGroundFilter", options)
+{
+  // initialize debug tool
+  {
+    using tier4_autoware_utils::DebugPublisher;
+    using tier4_autoware_utils::StopWatch;
+    stop_watch_ptr_ = std::make_unique<StopWatch<std::chrono::milliseconds>>();
+    debug_publisher_ = std::make_unique<DebugPublisher>(this, "elevation_grid_ground_filter");
+    stop_watch_ptr_->tic("cyclic_time");
+    stop_watch_ptr_->tic("processing_time");
+  }
+
+  // set initial parameters
+  {
+    base_frame_ = static_cast<std::string>(declare_parameter("base_frame", "base_link"));
+    fixed_frame_ = static_cast<std::string>(declare_parameter("fixed_frame", "map"));
+    num_threads_ = std::max(static_cast<int>(declare_parameter("num_threads", 1)), 1);
+
+    ElevationGrid::Parameters grid_parameters;
+    grid_parameters.cell_size = static_cast<double>(declare_parameter("cell_size", 0.5));
+    grid_parameters.grid_length = static_cast<double>(declare_parameter("grid_length", 200.0));
+    grid_parameters.height_threshold =
+      static_cast<double>(declare_parameter("height_threshold", 0.2));
+    grid_parameters.max_height_change =
+      static_cast<double>(declare_parameter("max_height_change", 0.3));
+    grid_parameters.global_slope_max_angle_rad =
+      deg2rad(static_cast<double>(declare_parameter("global_slope_max_angle_deg", 8.0)));
+    grid_parameters.smoothing = static_cast<double>(declare_parameter("smoothing", 0.2));
+    grid_parameters.cell_lifetime = static_cast<double>(declare_parameter("cell_lifetime", 10.0));
+    elevation_grid_ = std::make_unique<ElevationGrid>(grid_parameters);
+    elevation_grid_->setNumThreads(num_threads_);
+  }
+
+  using std::placeholders::_1;
+  set_param_res_ = this->add_on_set_parameters_callback(
+    std::bind(&ElevationGridGroundFilterComponent::onParameter, this, _1));
+}
+
+bool ElevationGridGroundFilterComponent::lookupTransform(
+  const std::string & frame_id, const rclcpp::Time & stamp, Eigen::Affine3f & transform)
+{
+  try {
+    const auto transform_stamped = tf_buffer_->lookupTransform(
+      fixed_frame_, frame_id, stamp, rclcpp::Duration::from_seconds(0.1));
+    transform = tf2::transformToEigen(transform_stamped.transform).cast<float>();
+  } catch (tf2::TransformException & ex) {
+    RCLCPP_WARN_STREAM_THROTTLE(get_logger(), *get_clock(), 10000, ex.what());
+    return false;
+  }
+  return true;
+}
+
+void ElevationGridGroundFilterComponent::filter(
+  const PointCloud2ConstPtr & input, [[maybe_unused]] const IndicesPtr & indices,
+  PointCloud2 & output)
+{
+  std::scoped_lock lock(mutex_);
+  stop_watch_ptr_->toc("processing_time", true);
+
+  // find the float x, y and z fields
+  const std::array<std::string, 3> field_names{"x", "y", "z"};
+  std::array<int, 3> field_offsets{-1, -1, -1};
+  for (const auto & field : input->fields) {
+    for (size_t i = 0; i < field_names.size(); ++i) {
+      if (
+        field.name == field_names[i] &&
+        field.datatype == sensor_msgs::msg::PointField::FLOAT32) {
+        field_offsets[i] = static_cast<int>(field.offset);
+      }
+    }
+  }
+  if (std::any_of(field_offsets.begin(), field_offsets.end(), [](int o) { return o < 0; })) {
+    RCLCPP_ERROR_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 10000, "Input pointcloud has no float x, y and z fields");
+    return;
+  }
+
+  const rclcpp::Time stamp = input->header.stamp;
+  Eigen::Affine3f sensor_to_fixed;
+  Eigen::Affine3f base_to_fixed;
+  if (
+    !lookupTransform(input->header.frame_id, stamp, sensor_to_fixed) ||
+    !lookupTransform(base_frame_, stamp, base_to_fixed)) {
+    return;
+  }
+
+  // transform the points into the fixed frame
+  const size_t num_points = input->width * input->height;
+  const auto point_data = [&input](const size_t i) {
+    return input->data.data() + (i / input->width) * input->row_step +
+           (i % input->width) * input->point_step;
+  };
+  points_.resize(num_points);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int i = 0; i < static_cast<int>(num_points); ++i) {
+    const uint8_t * data = point_data(i);
+    Eigen::Vector3f point;
+    std::memcpy(&point.x(), data + field_offsets[0], sizeof(float));
+    std::memcpy(&point.y(), data + field_offsets[1], sizeof(float));
+    std::memcpy(&point.z(), data + field_offsets[2], sizeof(float));
+    points_[i] = sensor_to_fixed * point;
+  }
+
+  // the origin of base_link is on the ground
+  elevation_grid_->moveTo(base_to_fixed.translation().cast<double>());
+  elevation_grid_->update(points_, stamp.seconds());
+
+  // classify the points, and count the non ground points of every chunk to copy them in parallel
+  is_ground_.resize(num_points);
+  const int num_chunks = num_threads_;
+  const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  chunk_begin_.assign(num_chunks + 1, 0);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    const size_t chunk_end = std::min(num_points, (chunk + 1) * chunk_size);
+    size_t num_no_ground = 0;
+    for (size_t i = chunk * chunk_size; i < chunk_end; ++i) {
+      is_ground_[i] = elevation_grid_->isGround(points_[i]);
+      num_no_ground += is_ground_[i] ? 0 : 1;
+    }
+    chunk_begin_[chunk] = num_no_ground;
+  }
+  size_t offset = 0;
+  for (auto & begin : chunk_begin_) {
+    offset += std::exchange(begin, offset);
+  }
+
+  // copy the non ground points with all their fields
+  output.header = input->header;
+  output.fields = input->fields;
+  output.is_bigendian = input->is_bigendian;
+  output.point_step = input->point_step;
+  output.height = 1;
+  output.width = static_cast<uint32_t>(offset);
+  output.row_step = output.point_step * output.width;
+  output.is_dense = input->is_dense;
+  output.data.resize(output.row_step);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    const size_t chunk_end = std::min(num_points, (chunk + 1) * chunk_size);
+    uint8_t * out_data = output.data.data() + chunk_begin_[chunk] * output.point_step;
+    for (size_t i = chunk * chunk_size; i < chunk_end; ++i) {
+      if (!is_ground_[i]) {
+        std::memcpy(out_data, point_data(i), output.point_step);
+        out_data += output.point_step;
+      }
+    }
+  }
+
+  // add processing time and grid statistics for debug
+  if (debug_publisher_) {
+    const double cyclic_time_ms = stop_watch_ptr_->toc("cyclic_time", true);
+    const double processing_time_ms = stop_watch_ptr_->toc("processing_time", true);
+    const auto statistics = elevation_grid_->getStatistics();
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/cyclic_time_ms", cyclic_time_ms);
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/processing_time_ms", processing_time_ms);
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/known_cell_ratio",
+      static_cast<double>(statistics.num_known_cells) / static_cast<double>(statistics.num_cells));
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/updated_cell_ratio", static_cast<double>(statistics.num_updated_cells) /
+                                    static_cast<double>(statistics.num_cells));
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/memory_usage_mb", static_cast<double>(statistics.memory_bytes) / (1024.0 * 1024.0));
+  }
+}
+
+rcl_interfaces::msg::SetParametersResult ElevationGridGroundFilterComponent::onParameter(
+  const std::vector<rclcpp::Parameter> & p)
+{
+  std::scoped_lock lock(mutex_);
+
+  if (get_param(p, "base_frame", base_frame_)) {
+    RCLCPP_DEBUG_STREAM(get_logger(), "Setting base_frame to: " << base_frame_);
+  }
+  int num_threads{num_threads_};
+  if (get_param(p, "num_threads", num_threads)) {
+    num_threads_ = std::max(num_threads, 1);
+    elevation_grid_->setNumThreads(num_threads_);
+    RCLCPP_DEBUG(get_logger(), "Setting num_threads to: %d.", num_threads_);
+  }
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  result.reason = "success";
+
+  return result;
+}
+
+}  // namespace ground_segmentation
+
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(ground_segmentation::ElevationGridGroundFilterComponent)
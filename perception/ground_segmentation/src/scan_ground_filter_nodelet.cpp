@@ -20,8 +20,12 @@
 #include <tier4_autoware_utils/math/unit_conversion.hpp>
 #include <vehicle_info_util/vehicle_info_util.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace ground_segmentation
@@ -45,6 +49,7 @@ ScanGroundFilterComponent::ScanGroundFilterComponent(const rclcpp::NodeOptions &
     split_points_distance_tolerance_ = declare_parameter("split_points_distance_tolerance", 0.2);
     split_height_distance_ = declare_parameter("split_height_distance", 0.2);
     use_virtual_ground_point_ = declare_parameter("use_virtual_ground_point", true);
+    num_threads_ = std::max(static_cast<int>(declare_parameter("num_threads", 1)), 1);
     radial_dividers_num_ = std::ceil(2.0 * M_PI / radial_divider_angle_rad_);
     vehicle_info_ = VehicleInfoUtil(*this).getVehicleInfo();
   }
@@ -78,36 +83,111 @@ bool ScanGroundFilterComponent::transformPointCloud(
   return true;
 }
 
-void ScanGroundFilterComponent::convertPointcloud(
-  const pcl::PointCloud<pcl::PointXYZ>::Ptr in_cloud,
-  std::vector<PointCloudRefVector> & out_radial_ordered_points)
+bool ScanGroundFilterComponent::convertPointcloud(
+  const PointCloud2 & in_cloud, RadialOrderedPoints & out_radial_ordered_points)
 {
-  out_radial_ordered_points.resize(radial_dividers_num_);
-  PointRef current_point;
-
-  for (size_t i = 0; i < in_cloud->points.size(); ++i) {
-    auto radius{static_cast<float>(std::hypot(in_cloud->points[i].x, in_cloud->points[i].y))};
-    auto theta{normalizeRadian(std::atan2(in_cloud->points[i].x, in_cloud->points[i].y), 0.0)};
-    auto radial_div{
-      static_cast<size_t>(std::floor(normalizeDegree(theta / radial_divider_angle_rad_, 0.0)))};
-
-    current_point.radius = radius;
-    current_point.theta = theta;
-    current_point.radial_div = radial_div;
-    current_point.point_state = PointLabel::INIT;
-    current_point.orig_index = i;
-    current_point.orig_point = &in_cloud->points[i];
-
-    // radial divisions
-    out_radial_ordered_points[radial_div].emplace_back(current_point);
+  // find the float x, y and z fields
+  const std::array<std::string, 3> field_names{"x", "y", "z"};
+  std::array<int, 3> field_offsets{-1, -1, -1};
+  for (const auto & field : in_cloud.fields) {
+    for (size_t i = 0; i < field_names.size(); ++i) {
+      if (
+        field.name == field_names[i] &&
+        field.datatype == sensor_msgs::msg::PointField::FLOAT32) {
+        field_offsets[i] = static_cast<int>(field.offset);
+      }
+    }
+  }
+  if (std::any_of(field_offsets.begin(), field_offsets.end(), [](int o) { return o < 0; })) {
+    return false;
+  }
+  const auto get_point = [&in_cloud, &field_offsets](const size_t i) {
+    const uint8_t * data = in_cloud.data.data() + (i / in_cloud.width) * in_cloud.row_step +
+                           (i % in_cloud.width) * in_cloud.point_step;
+    pcl::PointXYZ point;
+    std::memcpy(&point.x, data + field_offsets[0], sizeof(float));
+    std::memcpy(&point.y, data + field_offsets[1], sizeof(float));
+    std::memcpy(&point.z, data + field_offsets[2], sizeof(float));
+    return point;
+  };
+
+  const size_t num_points = in_cloud.width * in_cloud.height;
+  const size_t num_divisions = radial_dividers_num_;
+  radius_.resize(num_points);
+  radial_div_.resize(num_points);
+
+  // the points are binned in one chunk per thread, and the chunks are concatenated in order, so
+  // that every radial division keeps the order of the input points
+  const int num_chunks = num_threads_;
+  const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  division_counts_.assign(num_chunks * num_divisions, 0);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    size_t * counts = division_counts_.data() + chunk * num_divisions;
+    const size_t chunk_end = std::min(num_points, (chunk + 1) * chunk_size);
+    for (size_t i = chunk * chunk_size; i < chunk_end; ++i) {
+      const auto point = get_point(i);
+      radius_[i] = static_cast<float>(std::hypot(point.x, point.y));
+      const auto theta{normalizeRadian(std::atan2(point.x, point.y), 0.0)};
+      const auto radial_div{std::floor(normalizeDegree(theta / radial_divider_angle_rad_, 0.0))};
+      // points with a non finite position are dropped
+      if (radial_div >= 0.0 && radial_div < static_cast<double>(num_divisions)) {
+        radial_div_[i] = static_cast<size_t>(radial_div);
+        ++counts[radial_div_[i]];
+      } else {
+        radial_div_[i] = num_divisions;
+      }
+    }
   }
 
-  // sort by distance
-  for (size_t i = 0; i < radial_dividers_num_; ++i) {
+  // turn the counts into the index of the first point of every division and chunk
+  auto & division_begin = out_radial_ordered_points.division_begin;
+  division_begin.resize(num_divisions + 1);
+  size_t offset = 0;
+  for (size_t division = 0; division < num_divisions; ++division) {
+    division_begin[division] = offset;
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      auto & count = division_counts_[chunk * num_divisions + division];
+      offset += std::exchange(count, offset);
+    }
+  }
+  division_begin[num_divisions] = offset;
+
+  sorted_indices_.resize(offset);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    size_t * next_indices = division_counts_.data() + chunk * num_divisions;
+    const size_t chunk_end = std::min(num_points, (chunk + 1) * chunk_size);
+    for (size_t i = chunk * chunk_size; i < chunk_end; ++i) {
+      if (radial_div_[i] < num_divisions) {
+        sorted_indices_[next_indices[radial_div_[i]]++] = i;
+      }
+    }
+  }
+
+  // sort by distance, and gather the points in the sorted order
+  out_radial_ordered_points.x.resize(offset);
+  out_radial_ordered_points.y.resize(offset);
+  out_radial_ordered_points.z.resize(offset);
+  out_radial_ordered_points.radius.resize(offset);
+  out_radial_ordered_points.point_state.assign(offset, PointLabel::INIT);
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (int division = 0; division < static_cast<int>(num_divisions); ++division) {
+    const size_t begin = division_begin[division];
+    const size_t end = division_begin[division + 1];
     std::sort(
-      out_radial_ordered_points[i].begin(), out_radial_ordered_points[i].end(),
-      [](const PointRef & a, const PointRef & b) { return a.radius < b.radius; });
+      sorted_indices_.begin() + begin, sorted_indices_.begin() + end,
+      [this](const size_t a, const size_t b) { return radius_[a] < radius_[b]; });
+    for (size_t j = begin; j < end; ++j) {
+      const size_t i = sorted_indices_[j];
+      const auto point = get_point(i);
+      out_radial_ordered_points.x[j] = point.x;
+      out_radial_ordered_points.y[j] = point.y;
+      out_radial_ordered_points.z[j] = point.z;
+      out_radial_ordered_points.radius[j] = radius_[i];
+    }
   }
+  return true;
 }
 
 void ScanGroundFilterComponent::calcVirtualGroundOrigin(pcl::PointXYZ & point)
@@ -117,127 +197,174 @@ void ScanGroundFilterComponent::calcVirtualGroundOrigin(pcl::PointXYZ & point)
   point.z = 0;
 }
 
-void ScanGroundFilterComponent::classifyPointCloud(
-  std::vector<PointCloudRefVector> & in_radial_ordered_clouds,
-  pcl::PointIndices & out_no_ground_indices)
+void ScanGroundFilterComponent::classifyPointCloud(RadialOrderedPoints & in_radial_ordered_points)
 {
-  out_no_ground_indices.indices.clear();
+  // the radial divisions are independent
+  const size_t num_divisions = in_radial_ordered_points.division_begin.size() - 1;
+  auto & no_ground_begin = in_radial_ordered_points.no_ground_begin;
+  no_ground_begin.assign(num_divisions + 1, 0);
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (int division = 0; division < static_cast<int>(num_divisions); ++division) {
+    no_ground_begin[division] = classifyRadialDivision(in_radial_ordered_points, division);
+  }
 
+  size_t offset = 0;
+  for (auto & begin : no_ground_begin) {
+    offset += std::exchange(begin, offset);
+  }
+}
+
+size_t ScanGroundFilterComponent::classifyRadialDivision(
+  RadialOrderedPoints & in_radial_ordered_points, const size_t division)
+{
   const pcl::PointXYZ init_ground_point(0, 0, 0);
   pcl::PointXYZ virtual_ground_point(0, 0, 0);
   calcVirtualGroundOrigin(virtual_ground_point);
 
   // point classification algorithm
-  // sweep through each radial division
-  for (size_t i = 0; i < in_radial_ordered_clouds.size(); i++) {
-    float prev_gnd_radius = 0.0f;
-    float prev_gnd_slope = 0.0f;
-    float points_distance = 0.0f;
-    PointsCentroid ground_cluster, non_ground_cluster;
-    float local_slope = 0.0f;
-    PointLabel prev_point_label = PointLabel::INIT;
-    pcl::PointXYZ prev_gnd_point(0, 0, 0);
-    // loop through each point in the radial div
-    for (size_t j = 0; j < in_radial_ordered_clouds[i].size(); j++) {
-      const float global_slope_max_angle = global_slope_max_angle_rad_;
-      const float local_slope_max_angle = local_slope_max_angle_rad_;
-      auto * p = &in_radial_ordered_clouds[i][j];
-      auto * p_prev = &in_radial_ordered_clouds[i][j - 1];
-
-      if (j == 0) {
-        bool is_front_side = (p->orig_point->x > virtual_ground_point.x);
-        if (use_virtual_ground_point_ && is_front_side) {
-          prev_gnd_point = virtual_ground_point;
-        } else {
-          prev_gnd_point = init_ground_point;
-        }
-        prev_gnd_radius = std::hypot(prev_gnd_point.x, prev_gnd_point.y);
-        prev_gnd_slope = 0.0f;
-        ground_cluster.initialize();
-        non_ground_cluster.initialize();
-        points_distance = calcDistance3d(*p->orig_point, prev_gnd_point);
+  size_t no_ground_num = 0;
+  float prev_gnd_radius = 0.0f;
+  float prev_gnd_slope = 0.0f;
+  float points_distance = 0.0f;
+  PointsCentroid ground_cluster, non_ground_cluster;
+  float local_slope = 0.0f;
+  PointLabel prev_point_label = PointLabel::INIT;
+  pcl::PointXYZ prev_gnd_point(0, 0, 0);
+  // loop through each point in the radial div
+  const size_t begin = in_radial_ordered_points.division_begin[division];
+  const size_t end = in_radial_ordered_points.division_begin[division + 1];
+  for (size_t j = begin; j < end; j++) {
+    const float global_slope_max_angle = global_slope_max_angle_rad_;
+    const float local_slope_max_angle = local_slope_max_angle_rad_;
+    const pcl::PointXYZ p(
+      in_radial_ordered_points.x[j], in_radial_ordered_points.y[j], in_radial_ordered_points.z[j]);
+    const float p_radius = in_radial_ordered_points.radius[j];
+    auto & p_state = in_radial_ordered_points.point_state[j];
+
+    if (j == begin) {
+      bool is_front_side = (p.x > virtual_ground_point.x);
+      if (use_virtual_ground_point_ && is_front_side) {
+        prev_gnd_point = virtual_ground_point;
       } else {
-        points_distance = calcDistance3d(*p->orig_point, *p_prev->orig_point);
+        prev_gnd_point = init_ground_point;
       }
+      prev_gnd_radius = std::hypot(prev_gnd_point.x, prev_gnd_point.y);
+      prev_gnd_slope = 0.0f;
+      ground_cluster.initialize();
+      non_ground_cluster.initialize();
+      points_distance = calcDistance3d(p, prev_gnd_point);
+    } else {
+      const pcl::PointXYZ p_prev(
+        in_radial_ordered_points.x[j - 1], in_radial_ordered_points.y[j - 1],
+        in_radial_ordered_points.z[j - 1]);
+      points_distance = calcDistance3d(p, p_prev);
+    }
 
-      float radius_distance_from_gnd = p->radius - prev_gnd_radius;
-      float height_from_gnd = p->orig_point->z - prev_gnd_point.z;
-      float height_from_obj = p->orig_point->z - non_ground_cluster.getAverageHeight();
-      bool calculate_slope = false;
-      bool is_point_close_to_prev =
-        (points_distance <
-         (p->radius * radial_divider_angle_rad_ + split_points_distance_tolerance_));
-
-      float global_slope = std::atan2(p->orig_point->z, p->radius);
-      // check points which is far enough from previous point
-      if (global_slope > global_slope_max_angle) {
-        p->point_state = PointLabel::NON_GROUND;
-        calculate_slope = false;
-      } else if (
-        (prev_point_label == PointLabel::NON_GROUND) &&
-        (std::abs(height_from_obj) >= split_height_distance_)) {
-        calculate_slope = true;
-      } else if (is_point_close_to_prev && std::abs(height_from_gnd) < split_height_distance_) {
-        // close to the previous point, set point follow label
-        p->point_state = PointLabel::POINT_FOLLOW;
-        calculate_slope = false;
+    float radius_distance_from_gnd = p_radius - prev_gnd_radius;
+    float height_from_gnd = p.z - prev_gnd_point.z;
+    float height_from_obj = p.z - non_ground_cluster.getAverageHeight();
+    bool calculate_slope = false;
+    bool is_point_close_to_prev =
+      (points_distance < (p_radius * radial_divider_angle_rad_ + split_points_distance_tolerance_));
+
+    float global_slope = std::atan2(p.z, p_radius);
+    // check points which is far enough from previous point
+    if (global_slope > global_slope_max_angle) {
+      p_state = PointLabel::NON_GROUND;
+      calculate_slope = false;
+    } else if (
+      (prev_point_label == PointLabel::NON_GROUND) &&
+      (std::abs(height_from_obj) >= split_height_distance_)) {
+      calculate_slope = true;
+    } else if (is_point_close_to_prev && std::abs(height_from_gnd) < split_height_distance_) {
+      // close to the previous point, set point follow label
+      p_state = PointLabel::POINT_FOLLOW;
+      calculate_slope = false;
+    } else {
+      calculate_slope = true;
+    }
+    if (is_point_close_to_prev) {
+      height_from_gnd = p.z - ground_cluster.getAverageHeight();
+      radius_distance_from_gnd = p_radius - ground_cluster.getAverageRadius();
+    }
+    if (calculate_slope) {
+      // far from the previous point
+      local_slope = std::atan2(height_from_gnd, radius_distance_from_gnd);
+      if (local_slope - prev_gnd_slope > local_slope_max_angle) {
+        // the point is outside of the local slope threshold
+        p_state = PointLabel::NON_GROUND;
       } else {
-        calculate_slope = true;
-      }
-      if (is_point_close_to_prev) {
-        height_from_gnd = p->orig_point->z - ground_cluster.getAverageHeight();
-        radius_distance_from_gnd = p->radius - ground_cluster.getAverageRadius();
-      }
-      if (calculate_slope) {
-        // far from the previous point
-        local_slope = std::atan2(height_from_gnd, radius_distance_from_gnd);
-        if (local_slope - prev_gnd_slope > local_slope_max_angle) {
-          // the point is outside of the local slope threshold
-          p->point_state = PointLabel::NON_GROUND;
-        } else {
-          p->point_state = PointLabel::GROUND;
-        }
+        p_state = PointLabel::GROUND;
       }
+    }
 
-      if (p->point_state == PointLabel::GROUND) {
-        ground_cluster.initialize();
-        non_ground_cluster.initialize();
-      }
-      if (p->point_state == PointLabel::NON_GROUND) {
-        out_no_ground_indices.indices.push_back(p->orig_index);
-      } else if (  // NOLINT
-        (prev_point_label == PointLabel::NON_GROUND) &&
-        (p->point_state == PointLabel::POINT_FOLLOW)) {
-        p->point_state = PointLabel::NON_GROUND;
-        out_no_ground_indices.indices.push_back(p->orig_index);
-      } else if (  // NOLINT
-        (prev_point_label == PointLabel::GROUND) && (p->point_state == PointLabel::POINT_FOLLOW)) {
-        p->point_state = PointLabel::GROUND;
-      } else {
-      }
+    if (p_state == PointLabel::GROUND) {
+      ground_cluster.initialize();
+      non_ground_cluster.initialize();
+    }
+    if (p_state == PointLabel::NON_GROUND) {
+      ++no_ground_num;
+    } else if (  // NOLINT
+      (prev_point_label == PointLabel::NON_GROUND) && (p_state == PointLabel::POINT_FOLLOW)) {
+      p_state = PointLabel::NON_GROUND;
+      ++no_ground_num;
+    } else if (  // NOLINT
+      (prev_point_label == PointLabel::GROUND) && (p_state == PointLabel::POINT_FOLLOW)) {
+      p_state = PointLabel::GROUND;
+    } else {
+    }
 
-      // update the ground state
-      prev_point_label = p->point_state;
-      if (p->point_state == PointLabel::GROUND) {
-        prev_gnd_radius = p->radius;
-        prev_gnd_point = pcl::PointXYZ(p->orig_point->x, p->orig_point->y, p->orig_point->z);
-        ground_cluster.addPoint(p->radius, p->orig_point->z);
-        prev_gnd_slope = ground_cluster.getAverageSlope();
-      }
-      // update the non ground state
-      if (p->point_state == PointLabel::NON_GROUND) {
-        non_ground_cluster.addPoint(p->radius, p->orig_point->z);
-      }
+    // update the ground state
+    prev_point_label = p_state;
+    if (p_state == PointLabel::GROUND) {
+      prev_gnd_radius = p_radius;
+      prev_gnd_point = p;
+      ground_cluster.addPoint(p_radius, p.z);
+      prev_gnd_slope = ground_cluster.getAverageSlope();
+    }
+    // update the non ground state
+    if (p_state == PointLabel::NON_GROUND) {
+      non_ground_cluster.addPoint(p_radius, p.z);
     }
   }
+  return no_ground_num;
 }
 
 void ScanGroundFilterComponent::extractObjectPoints(
-  const pcl::PointCloud<pcl::PointXYZ>::Ptr in_cloud_ptr, const pcl::PointIndices & in_indices,
-  pcl::PointCloud<pcl::PointXYZ>::Ptr out_object_cloud_ptr)
+  const RadialOrderedPoints & in_radial_ordered_points, PointCloud2 & out_object_cloud)
 {
-  for (const auto & i : in_indices.indices) {
-    out_object_cloud_ptr->points.emplace_back(in_cloud_ptr->points[i]);
+  // same layout as pcl::toROSMsg of pcl::PointCloud<pcl::PointXYZ>
+  const std::array<std::string, 3> field_names{"x", "y", "z"};
+  out_object_cloud.fields.resize(field_names.size());
+  for (size_t i = 0; i < field_names.size(); ++i) {
+    out_object_cloud.fields[i].name = field_names[i];
+    out_object_cloud.fields[i].offset = static_cast<uint32_t>(i * sizeof(float));
+    out_object_cloud.fields[i].datatype = sensor_msgs::msg::PointField::FLOAT32;
+    out_object_cloud.fields[i].count = 1;
+  }
+  out_object_cloud.height = 1;
+  out_object_cloud.width = in_radial_ordered_points.no_ground_begin.back();
+  out_object_cloud.is_bigendian = false;
+  out_object_cloud.point_step = sizeof(pcl::PointXYZ);
+  out_object_cloud.row_step = out_object_cloud.point_step * out_object_cloud.width;
+  out_object_cloud.is_dense = true;
+  out_object_cloud.data.resize(out_object_cloud.row_step);
+
+  const auto & division_begin = in_radial_ordered_points.division_begin;
+  const int num_divisions = static_cast<int>(division_begin.size()) - 1;
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (int division = 0; division < num_divisions; ++division) {
+    uint8_t * out_data = out_object_cloud.data.data() +
+                         in_radial_ordered_points.no_ground_begin[division] * sizeof(pcl::PointXYZ);
+    for (size_t j = division_begin[division]; j < division_begin[division + 1]; ++j) {
+      if (in_radial_ordered_points.point_state[j] == PointLabel::NON_GROUND) {
+        const pcl::PointXYZ point(
+          in_radial_ordered_points.x[j], in_radial_ordered_points.y[j],
+          in_radial_ordered_points.z[j]);
+        std::memcpy(out_data, &point, sizeof(pcl::PointXYZ));
+        out_data += sizeof(pcl::PointXYZ);
+      }
+    }
   }
 }
 
@@ -255,27 +382,18 @@ void ScanGroundFilterComponent::filter(
     return;
   }
 
-  pcl::PointCloud<pcl::PointXYZ>::Ptr current_sensor_cloud_ptr(new pcl::PointCloud<pcl::PointXYZ>);
-  pcl::fromROSMsg(*input_transformed_ptr, *current_sensor_cloud_ptr);
-
-  std::vector<PointCloudRefVector> radial_ordered_points;
-
-  convertPointcloud(current_sensor_cloud_ptr, radial_ordered_points);
-
-  pcl::PointIndices no_ground_indices;
-  pcl::PointCloud<pcl::PointXYZ>::Ptr no_ground_cloud_ptr(new pcl::PointCloud<pcl::PointXYZ>);
-  no_ground_cloud_ptr->points.reserve(current_sensor_cloud_ptr->points.size());
-
-  classifyPointCloud(radial_ordered_points, no_ground_indices);
+  if (!convertPointcloud(*input_transformed_ptr, radial_ordered_points_)) {
+    RCLCPP_ERROR_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 10000, "Input pointcloud has no float x, y and z fields");
+    return;
+  }
 
-  extractObjectPoints(current_sensor_cloud_ptr, no_ground_indices, no_ground_cloud_ptr);
+  classifyPointCloud(radial_ordered_points_);
 
-  auto no_ground_cloud_msg_ptr = std::make_shared<PointCloud2>();
-  pcl::toROSMsg(*no_ground_cloud_ptr, *no_ground_cloud_msg_ptr);
+  extractObjectPoints(radial_ordered_points_, output);
 
-  no_ground_cloud_msg_ptr->header.stamp = input->header.stamp;
-  no_ground_cloud_msg_ptr->header.frame_id = base_frame_;
-  output = *no_ground_cloud_msg_ptr;
+  output.header.stamp = input->header.stamp;
+  output.header.frame_id = base_frame_;
 }
 
 rcl_interfaces::msg::SetParametersResult ScanGroundFilterComponent::onParameter(
@@ -317,6 +435,11 @@ rcl_interfaces::msg::SetParametersResult ScanGroundFilterComponent::onParameter(
       get_logger(),
       "Setting use_virtual_ground_point to: " << std::boolalpha << use_virtual_ground_point_);
   }
+  int num_threads{num_threads_};
+  if (get_param(p, "num_threads", num_threads)) {
+    num_threads_ = std::max(num_threads, 1);
+    RCLCPP_DEBUG(get_logger(), "Setting num_threads to: %d.", num_threads_);
+  }
 
   rcl_interfaces::msg::SetParametersResult result;
   result.successful = true;
@@ -0,0 +1,139 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_segmentation/elevation_grid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using ground_segmentation::ElevationGrid;
+
+namespace
+{
+// 20 x 20 cells of 1 m
+ElevationGrid::Parameters makeParameters()
+{
+  ElevationGrid::Parameters parameters;
+  parameters.cell_size = 1.0;
+  parameters.grid_length = 20.0;
+  parameters.height_threshold = 0.2;
+  parameters.max_height_change = 0.3;
+  parameters.global_slope_max_angle_rad = 10.0 * M_PI / 180.0;
+  parameters.smoothing = 0.5;
+  parameters.cell_lifetime = 10.0;
+  return parameters;
+}
+
+// an object above the ground of the cell (5, 5), which is ground with the global slope alone as it
+// is 7.8 m from the vehicle
+const Eigen::Vector3f object_point(5.5f, 5.5f, 1.0f);
+}  // namespace
+
+TEST(ElevationGrid, KeepsGroundAcrossFrames)
+{
+  ElevationGrid grid(makeParameters());
+  grid.moveTo(Eigen::Vector3d::Zero());
+  EXPECT_TRUE(grid.isGround(object_point));
+
+  // the ground of the cell is observed
+  grid.update({{5.2f, 5.3f, 0.05f}, {5.7f, 5.6f, 0.0f}, {5.5f, 5.8f, 0.1f}}, 0.0);
+  EXPECT_EQ(grid.getStatistics().num_updated_cells, 1U);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 1U);
+  EXPECT_TRUE(grid.isGround({5.5f, 5.5f, 0.15f}));
+  EXPECT_FALSE(grid.isGround(object_point));
+
+  // then hidden by an object, whose points do not move the ground height
+  grid.update({{5.5f, 5.5f, 1.0f}, {5.5f, 5.5f, 1.5f}}, 1.0);
+  EXPECT_TRUE(grid.isGround({5.5f, 5.5f, 0.15f}));
+  EXPECT_FALSE(grid.isGround(object_point));
+
+  // and not observed anymore, until it is forgotten
+  grid.update({}, 5.0);
+  EXPECT_FALSE(grid.isGround(object_point));
+  grid.update({}, 12.0);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 0U);
+  EXPECT_TRUE(grid.isGround(object_point));
+}
+
+TEST(ElevationGrid, FollowsGroundHeightChanges)
+{
+  ElevationGrid grid(makeParameters());
+  grid.moveTo(Eigen::Vector3d::Zero());
+  grid.update({{5.5f, 5.5f, 0.5f}}, 0.0);
+
+  // a small change is smoothed, a lower ground replaces the height at once
+  grid.update({{5.5f, 5.5f, 0.7f}}, 1.0);
+  EXPECT_TRUE(grid.isGround({5.5f, 5.5f, 0.75f}));
+  EXPECT_FALSE(grid.isGround({5.5f, 5.5f, 0.85f}));
+  grid.update({{5.5f, 5.5f, -0.5f}}, 2.0);
+  EXPECT_TRUE(grid.isGround({5.5f, 5.5f, -0.35f}));
+  EXPECT_FALSE(grid.isGround({5.5f, 5.5f, -0.25f}));
+}
+
+TEST(ElevationGrid, ShiftsWindow)
+{
+  ElevationGrid grid(makeParameters());
+  grid.moveTo(Eigen::Vector3d::Zero());
+  grid.update({{5.5f, 5.5f, 0.0f}}, 0.0);
+
+  // the cell stays in the window, and keeps its ground height
+  grid.moveTo(Eigen::Vector3d(3.0, -2.0, 0.0));
+  grid.update({}, 1.0);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 1U);
+  EXPECT_FALSE(grid.isGround(object_point));
+
+  // the cell leaves the window, and the point is classified with the global slope
+  grid.moveTo(Eigen::Vector3d(30.0, 0.0, 0.0));
+  grid.update({}, 2.0);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 0U);
+  EXPECT_TRUE(grid.isGround(object_point));
+
+  // the slot of the cell (5, 5) is reused by the cell (25, 5), which invalidates it
+  grid.update({{25.5f, 5.5f, 0.5f}}, 3.0);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 1U);
+  EXPECT_FALSE(grid.isGround({25.5f, 5.5f, 1.0f}));
+  grid.moveTo(Eigen::Vector3d::Zero());
+  grid.update({}, 4.0);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 0U);
+  EXPECT_TRUE(grid.isGround(object_point));
+}
+
+TEST(ElevationGrid, IgnoresNonFinitePoints)
+{
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  const std::vector<Eigen::Vector3f> non_finite_points = {
+    {nan, 5.5f, 0.0f}, {5.5f, nan, 0.0f}, {5.5f, 5.5f, nan},
+    {inf, 5.5f, 0.0f}, {5.5f, -inf, 0.0f}, {5.5f, 5.5f, -inf}};
+
+  ElevationGrid grid(makeParameters());
+  grid.setNumThreads(2);
+  grid.moveTo(Eigen::Vector3d::Zero());
+  grid.update(non_finite_points, 0.0);
+  EXPECT_EQ(grid.getStatistics().num_updated_cells, 0U);
+  EXPECT_EQ(grid.getStatistics().num_known_cells, 0U);
+  for (const auto & point : non_finite_points) {
+    EXPECT_FALSE(grid.isGround(point));
+  }
+
+  // nor do they hide the finite points
+  std::vector<Eigen::Vector3f> points = non_finite_points;
+  points.emplace_back(5.5f, 5.5f, 0.0f);
+  grid.update(points, 1.0);
+  EXPECT_EQ(grid.getStatistics().num_updated_cells, 1U);
+  EXPECT_FALSE(grid.isGround(object_point));
+}
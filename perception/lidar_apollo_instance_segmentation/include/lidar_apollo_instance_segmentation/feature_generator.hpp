@@ -21,20 +21,45 @@
 #include <pcl/point_types.h>
 
 #include <memory>
+#include <vector>
 
 class FeatureGenerator
 {
 private:
+  // features of a cell accumulated from the points, stored together for the cache locality
+  struct CellFeature
+  {
+    float max_height;
+    float top_intensity;
+    float sum_height;
+    float sum_intensity;
+    float count;
+  };
+
+  // features of the points of a part of the pointcloud, with the cells having some points
+  struct PartialGrid
+  {
+    std::vector<CellFeature> cells;
+    std::vector<int> nonempty_cells;
+  };
+
   float min_height_;
   float max_height_;
   bool use_intensity_feature_;
   bool use_constant_feature_;
+  int num_threads_;
   std::shared_ptr<FeatureMapInterface> map_ptr_;
+  std::vector<PartialGrid> partial_grids_;  // one for each thread
+  std::vector<int> nonempty_cells_;         // cells written to the feature map by the last call
+
+  void accumulate(
+    const pcl::PointCloud<pcl::PointXYZI> & pointcloud, const size_t begin, const size_t end,
+    PartialGrid & grid) const;
 
 public:
   FeatureGenerator(
     const int width, const int height, const int range, const bool use_intensity_feature,
-    const bool use_constant_feature);
+    const bool use_constant_feature, const int num_threads = 1);
   ~FeatureGenerator() {}
 
   std::shared_ptr<FeatureMapInterface> generate(
@@ -32,7 +32,8 @@ public:
   float * nonempty_data;        // channel 7
   std::vector<float> map_data;
   virtual void initializeMap(std::vector<float> & map) = 0;
-  virtual void resetMap(std::vector<float> & map) = 0;
+  // set the features of the cells, except for the constant ones, to the values of an empty cell
+  void resetCells(const std::vector<int> & cells);
   FeatureMapInterface(const int _channels, const int _width, const int _height, const int _range);
 };
 
@@ -40,26 +41,22 @@ struct FeatureMap : public FeatureMapInterface
 {
   FeatureMap(const int width, const int height, const int range);
   void initializeMap(std::vector<float> & map) override;
-  void resetMap(std::vector<float> & map) override;
 };
 
 struct FeatureMapWithIntensity : public FeatureMapInterface
 {
   FeatureMapWithIntensity(const int width, const int height, const int range);
   void initializeMap(std::vector<float> & map) override;
-  void resetMap(std::vector<float> & map) override;
 };
 
 struct FeatureMapWithConstant : public FeatureMapInterface
 {
   FeatureMapWithConstant(const int width, const int height, const int range);
   void initializeMap(std::vector<float> & map) override;
-  void resetMap(std::vector<float> & map) override;
 };
 
 struct FeatureMapWithConstantAndIntensity : public FeatureMapInterface
 {
   FeatureMapWithConstantAndIntensity(const int width, const int height, const int range);
   void initializeMap(std::vector<float> & map) override;
-  void resetMap(std::vector<float> & map) override;
 };
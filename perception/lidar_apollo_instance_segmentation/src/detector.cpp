@@ -23,7 +23,7 @@
 LidarApolloInstanceSegmentation::LidarApolloInstanceSegmentation(rclcpp::Node * node)
 : node_(node), tf_buffer_(node_->get_clock()), tf_listener_(tf_buffer_)
 {
-  int range, width, height;
+  int range, width, height, num_threads;
   bool use_intensity_feature, use_constant_feature;
   std::string engine_file;
   std::string prototxt_file;
@@ -39,6 +39,7 @@ LidarApolloInstanceSegmentation::LidarApolloInstanceSegmentation(rclcpp::Node *
   use_constant_feature = node_->declare_parameter("use_constant_feature", true);
   target_frame_ = node_->declare_parameter("target_frame", "base_link");
   z_offset_ = node_->declare_parameter<float>("z_offset", -2.0);
+  num_threads = node_->declare_parameter("num_threads", 1);
 
   // load weight file
   std::ifstream fs(engine_file);
@@ -89,7 +90,7 @@ LidarApolloInstanceSegmentation::LidarApolloInstanceSegmentation(rclcpp::Node *
 
   // feature map generator: pre process
   feature_generator_ = std::make_shared<FeatureGenerator>(
-    width, height, range, use_intensity_feature, use_constant_feature);
+    width, height, range, use_intensity_feature, use_constant_feature, num_threads);
 
   // cluster: post process
   cluster2d_ = std::make_shared<Cluster2D>(width, height, range);
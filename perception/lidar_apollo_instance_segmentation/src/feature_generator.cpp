@@ -16,6 +16,8 @@
 
 #include "lidar_apollo_instance_segmentation/log_table.hpp"
 
+#include <algorithm>
+
 namespace
 {
 inline float normalizeIntensity(float intensity) { return intensity / 255.0f; }
@@ -23,11 +25,12 @@ inline float normalizeIntensity(float intensity) { return intensity / 255.0f; }
 
 FeatureGenerator::FeatureGenerator(
   const int width, const int height, const int range, const bool use_intensity_feature,
-  const bool use_constant_feature)
+  const bool use_constant_feature, const int num_threads)
 : min_height_(-5.0),
   max_height_(5.0),
   use_intensity_feature_(use_intensity_feature),
-  use_constant_feature_(use_constant_feature)
+  use_constant_feature_(use_constant_feature),
+  num_threads_(std::max(num_threads, 1))
 {
   // select feature map type
   if (use_constant_feature && use_intensity_feature) {
@@ -40,56 +43,104 @@ FeatureGenerator::FeatureGenerator(
     map_ptr_ = std::make_shared<FeatureMap>(width, height, range);
   }
   map_ptr_->initializeMap(map_ptr_->map_data);
+
+  const CellFeature empty_cell{min_height_, 0.0f, 0.0f, 0.0f, 0.0f};
+  partial_grids_.resize(num_threads_);
+  for (auto & grid : partial_grids_) {
+    grid.cells.assign(width * height, empty_cell);
+  }
 }
 
-std::shared_ptr<FeatureMapInterface> FeatureGenerator::generate(
-  const pcl::PointCloud<pcl::PointXYZI>::Ptr & pc_ptr)
+void FeatureGenerator::accumulate(
+  const pcl::PointCloud<pcl::PointXYZI> & pointcloud, const size_t begin, const size_t end,
+  PartialGrid & grid) const
 {
-  const double epsilon = 1e-6;
-  map_ptr_->resetMap(map_ptr_->map_data);
-
-  int size = map_ptr_->height * map_ptr_->width;
-
   const float inv_res_x = 0.5 * map_ptr_->width / map_ptr_->range;
   const float inv_res_y = 0.5 * map_ptr_->height / map_ptr_->range;
 
-  for (size_t i = 0; i < pc_ptr->points.size(); ++i) {
-    if (pc_ptr->points[i].z <= min_height_ || max_height_ <= pc_ptr->points[i].z) {
+  for (size_t i = begin; i < end; ++i) {
+    const auto & point = pointcloud.points[i];
+    if (point.z <= min_height_ || max_height_ <= point.z) {
       continue;
     }
 
-    const int pos_x = std::floor((map_ptr_->range - pc_ptr->points[i].y) * inv_res_x);  // x on grid
-    const int pos_y = std::floor((map_ptr_->range - pc_ptr->points[i].x) * inv_res_y);  // y on grid
+    const int pos_x = std::floor((map_ptr_->range - point.y) * inv_res_x);  // x on grid
+    const int pos_y = std::floor((map_ptr_->range - point.x) * inv_res_y);  // y on grid
     if (pos_x < 0 || map_ptr_->width <= pos_x || pos_y < 0 || map_ptr_->height <= pos_y) {
       continue;
     }
 
     const int idx = pos_y * map_ptr_->width + pos_x;
-
-    if (map_ptr_->max_height_data[idx] < pc_ptr->points[i].z) {
-      map_ptr_->max_height_data[idx] = pc_ptr->points[i].z;
-      if (map_ptr_->top_intensity_data != nullptr) {
-        map_ptr_->top_intensity_data[idx] = normalizeIntensity(pc_ptr->points[i].intensity);
-      }
+    auto & cell = grid.cells[idx];
+    if (cell.count == 0.0f) {
+      grid.nonempty_cells.push_back(idx);
     }
-    map_ptr_->mean_height_data[idx] += static_cast<float>(pc_ptr->points[i].z);
-    if (map_ptr_->mean_intensity_data != nullptr) {
-      map_ptr_->mean_intensity_data[idx] += normalizeIntensity(pc_ptr->points[i].intensity);
+
+    if (cell.max_height < point.z) {
+      cell.max_height = point.z;
+      cell.top_intensity = normalizeIntensity(point.intensity);
     }
-    map_ptr_->count_data[idx] += 1.0f;
+    cell.sum_height += static_cast<float>(point.z);
+    cell.sum_intensity += normalizeIntensity(point.intensity);
+    cell.count += 1.0f;
   }
+}
 
-  for (int i = 0; i < size; ++i) {
-    if (map_ptr_->count_data[i] < epsilon) {
-      map_ptr_->max_height_data[i] = 0.0f;
-    } else {
-      map_ptr_->mean_height_data[i] /= map_ptr_->count_data[i];
-      if (map_ptr_->mean_intensity_data != nullptr) {
-        map_ptr_->mean_intensity_data[i] /= map_ptr_->count_data[i];
+std::shared_ptr<FeatureMapInterface> FeatureGenerator::generate(
+  const pcl::PointCloud<pcl::PointXYZI>::Ptr & pc_ptr)
+{
+  // the other cells are still empty since the last call
+  map_ptr_->resetCells(nonempty_cells_);
+
+  // accumulate the features of contiguous parts of the pointcloud in parallel
+  const size_t num_points = pc_ptr->points.size();
+#pragma omp parallel for num_threads(num_threads_)
+  for (int thread_idx = 0; thread_idx < num_threads_; ++thread_idx) {
+    accumulate(
+      *pc_ptr, num_points * thread_idx / num_threads_, num_points * (thread_idx + 1) / num_threads_,
+      partial_grids_[thread_idx]);
+  }
+
+  // merge the parts in the order of the points, so that the first point of the max height is kept
+  const CellFeature empty_cell{min_height_, 0.0f, 0.0f, 0.0f, 0.0f};
+  auto & grid = partial_grids_.front();
+  for (size_t grid_idx = 1; grid_idx < partial_grids_.size(); ++grid_idx) {
+    auto & partial_grid = partial_grids_[grid_idx];
+    for (const int idx : partial_grid.nonempty_cells) {
+      auto & cell = grid.cells[idx];
+      auto & partial_cell = partial_grid.cells[idx];
+      if (cell.count == 0.0f) {
+        grid.nonempty_cells.push_back(idx);
+      }
+      if (cell.max_height < partial_cell.max_height) {
+        cell.max_height = partial_cell.max_height;
+        cell.top_intensity = partial_cell.top_intensity;
       }
-      map_ptr_->nonempty_data[i] = 1.0f;
+      cell.sum_height += partial_cell.sum_height;
+      cell.sum_intensity += partial_cell.sum_intensity;
+      cell.count += partial_cell.count;
+      partial_cell = empty_cell;
     }
-    map_ptr_->count_data[i] = calcApproximateLog(map_ptr_->count_data[i]);
+    partial_grid.nonempty_cells.clear();
   }
+
+  // write the features of the nonempty cells, the empty ones being all 0
+  for (const int idx : grid.nonempty_cells) {
+    auto & cell = grid.cells[idx];
+    map_ptr_->max_height_data[idx] = cell.max_height;
+    map_ptr_->mean_height_data[idx] = cell.sum_height / cell.count;
+    map_ptr_->count_data[idx] = calcApproximateLog(cell.count);
+    if (map_ptr_->top_intensity_data != nullptr) {
+      map_ptr_->top_intensity_data[idx] = cell.top_intensity;
+    }
+    if (map_ptr_->mean_intensity_data != nullptr) {
+      map_ptr_->mean_intensity_data[idx] = cell.sum_intensity / cell.count;
+    }
+    map_ptr_->nonempty_data[idx] = 1.0f;
+    cell = empty_cell;
+  }
+  nonempty_cells_.swap(grid.nonempty_cells);
+  grid.nonempty_cells.clear();
+
   return map_ptr_;
 }
@@ -36,6 +36,22 @@ FeatureMapInterface::FeatureMapInterface(
   map_data.resize(width * height * channels);
 }
 
+void FeatureMapInterface::resetCells(const std::vector<int> & cells)
+{
+  for (const int idx : cells) {
+    max_height_data[idx] = 0.0f;
+    mean_height_data[idx] = 0.0f;
+    count_data[idx] = 0.0f;
+    if (top_intensity_data != nullptr) {
+      top_intensity_data[idx] = 0.0f;
+    }
+    if (mean_intensity_data != nullptr) {
+      mean_intensity_data[idx] = 0.0f;
+    }
+    nonempty_data[idx] = 0.0f;
+  }
+}
+
 FeatureMap::FeatureMap(const int width, const int height, const int range)
 : FeatureMapInterface(4, width, height, range)
 {
@@ -45,16 +61,6 @@ FeatureMap::FeatureMap(const int width, const int height, const int range)
   nonempty_data = &(map_data[0]) + width * height * 3;
 }
 void FeatureMap::initializeMap([[maybe_unused]] std::vector<float> & map) {}
-void FeatureMap::resetMap([[maybe_unused]] std::vector<float> & map)
-{
-  const int size = width * height;
-  for (int i = 0; i < size; ++i) {
-    max_height_data[i] = -5.0f;
-    mean_height_data[i] = 0.0f;
-    count_data[i] = 0.0f;
-    nonempty_data[i] = 0.0f;
-  }
-}
 
 FeatureMapWithIntensity::FeatureMapWithIntensity(const int width, const int height, const int range)
 : FeatureMapInterface(6, width, height, range)
@@ -67,18 +73,6 @@ FeatureMapWithIntensity::FeatureMapWithIntensity(const int width, const int heig
   nonempty_data = &(map_data[0]) + width * height * 5;
 }
 void FeatureMapWithIntensity::initializeMap([[maybe_unused]] std::vector<float> & map) {}
-void FeatureMapWithIntensity::resetMap([[maybe_unused]] std::vector<float> & map)
-{
-  const int size = width * height;
-  for (int i = 0; i < size; ++i) {
-    max_height_data[i] = -5.0f;
-    mean_height_data[i] = 0.0f;
-    count_data[i] = 0.0f;
-    top_intensity_data[i] = 0.0f;
-    mean_intensity_data[i] = 0.0f;
-    nonempty_data[i] = 0.0f;
-  }
-}
 
 FeatureMapWithConstant::FeatureMapWithConstant(const int width, const int height, const int range)
 : FeatureMapInterface(6, width, height, range)
@@ -108,17 +102,6 @@ void FeatureMapWithConstant::initializeMap([[maybe_unused]] std::vector<float> &
   }
 }
 
-void FeatureMapWithConstant::resetMap([[maybe_unused]] std::vector<float> & map)
-{
-  const int size = width * height;
-  for (int i = 0; i < size; ++i) {
-    max_height_data[i] = -5.0f;
-    mean_height_data[i] = 0.0f;
-    count_data[i] = 0.0f;
-    nonempty_data[i] = 0.0f;
-  }
-}
-
 FeatureMapWithConstantAndIntensity::FeatureMapWithConstantAndIntensity(
   const int width, const int height, const int range)
 : FeatureMapInterface(8, width, height, range)
@@ -149,16 +132,3 @@ void FeatureMapWithConstantAndIntensity::initializeMap([[maybe_unused]] std::vec
     }
   }
 }
-
-void FeatureMapWithConstantAndIntensity::resetMap([[maybe_unused]] std::vector<float> & map)
-{
-  const int size = width * height;
-  for (int i = 0; i < size; ++i) {
-    max_height_data[i] = -5.0f;
-    mean_height_data[i] = 0.0f;
-    count_data[i] = 0.0f;
-    top_intensity_data[i] = 0.0f;
-    mean_intensity_data[i] = 0.0f;
-    nonempty_data[i] = 0.0f;
-  }
-}
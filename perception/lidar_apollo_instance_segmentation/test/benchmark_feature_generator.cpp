@@ -0,0 +1,180 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lidar_apollo_instance_segmentation/feature_generator.hpp"
+#include "lidar_apollo_instance_segmentation/log_table.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Lidar
+{
+  std::string name;
+  int num_beams;
+  float min_elevation;  // [deg]
+  float max_elevation;  // [deg]
+  int num_azimuths;
+  // feature map of config/<name>.param.yaml
+  int range;
+  int size;
+  bool use_intensity_feature;
+};
+
+// scan of a lidar 2m above the ground, surrounded by walls at random distances
+pcl::PointCloud<pcl::PointXYZI>::Ptr createPointCloud(const Lidar & lidar)
+{
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> wall_distance(5.0f, 100.0f);
+  std::uniform_real_distribution<float> intensity(0.0f, 255.0f);
+  std::vector<float> wall_distances(36);
+  for (auto & distance : wall_distances) {
+    distance = wall_distance(engine);
+  }
+
+  constexpr float lidar_height = 2.0f;
+  constexpr float deg2rad = M_PI / 180.0;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr pointcloud(new pcl::PointCloud<pcl::PointXYZI>);
+  for (int azimuth_idx = 0; azimuth_idx < lidar.num_azimuths; ++azimuth_idx) {
+    const float azimuth = 2.0f * M_PI * azimuth_idx / lidar.num_azimuths;
+    const float wall = wall_distances[azimuth_idx * wall_distances.size() / lidar.num_azimuths];
+    for (int beam_idx = 0; beam_idx < lidar.num_beams; ++beam_idx) {
+      const float elevation =
+        deg2rad * (lidar.min_elevation + (lidar.max_elevation - lidar.min_elevation) * beam_idx /
+                                           (lidar.num_beams - 1));
+      float distance = wall;
+      if (elevation < 0.0f) {
+        distance = std::min(distance, lidar_height / std::tan(-elevation));
+      }
+      pcl::PointXYZI point;
+      point.x = distance * std::cos(azimuth);
+      point.y = distance * std::sin(azimuth);
+      point.z = std::max(distance * std::tan(elevation), -lidar_height);
+      point.intensity = intensity(engine);
+      pointcloud->points.push_back(point);
+    }
+  }
+  pointcloud->width = pointcloud->points.size();
+  pointcloud->height = 1;
+  return pointcloud;
+}
+
+// previous implementation, which writes and resets all the cells of the feature map
+void generateDense(
+  const pcl::PointCloud<pcl::PointXYZI> & pointcloud, const Lidar & lidar,
+  std::vector<float> & map_data)
+{
+  const int size = lidar.size * lidar.size;
+  map_data.assign(size * (lidar.use_intensity_feature ? 6 : 4), 0.0f);
+  float * max_height_data = map_data.data();
+  float * mean_height_data = max_height_data + size;
+  float * count_data = mean_height_data + size;
+  float * top_intensity_data = lidar.use_intensity_feature ? count_data + size : nullptr;
+  float * mean_intensity_data = lidar.use_intensity_feature ? count_data + size * 2 : nullptr;
+  float * nonempty_data = map_data.data() + map_data.size() - size;
+  std::fill(max_height_data, max_height_data + size, -5.0f);
+
+  const float inv_res = 0.5 * lidar.size / lidar.range;
+  for (const auto & point : pointcloud.points) {
+    if (point.z <= -5.0f || 5.0f <= point.z) {
+      continue;
+    }
+    const int pos_x = std::floor((lidar.range - point.y) * inv_res);
+    const int pos_y = std::floor((lidar.range - point.x) * inv_res);
+    if (pos_x < 0 || lidar.size <= pos_x || pos_y < 0 || lidar.size <= pos_y) {
+      continue;
+    }
+    const int idx = pos_y * lidar.size + pos_x;
+    if (max_height_data[idx] < point.z) {
+      max_height_data[idx] = point.z;
+      if (top_intensity_data != nullptr) {
+        top_intensity_data[idx] = point.intensity / 255.0f;
+      }
+    }
+    mean_height_data[idx] += static_cast<float>(point.z);
+    if (mean_intensity_data != nullptr) {
+      mean_intensity_data[idx] += point.intensity / 255.0f;
+    }
+    count_data[idx] += 1.0f;
+  }
+
+  for (int i = 0; i < size; ++i) {
+    if (count_data[i] < 1e-6) {
+      max_height_data[i] = 0.0f;
+    } else {
+      mean_height_data[i] /= count_data[i];
+      if (mean_intensity_data != nullptr) {
+        mean_intensity_data[i] /= count_data[i];
+      }
+      nonempty_data[i] = 1.0f;
+    }
+    count_data[i] = calcApproximateLog(count_data[i]);
+  }
+}
+
+template <class Func>
+double measureMilliseconds(const int num_repetitions, Func && func)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (int repetition = 0; repetition < num_repetitions; ++repetition) {
+    func();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() / num_repetitions;
+}
+}  // namespace
+
+int main()
+{
+  constexpr int num_repetitions = 50;
+  const std::vector<Lidar> lidars = {
+    {"hdl-64", 64, -24.9f, 2.0f, 2000, 70, 672, true},
+    {"vls-128", 128, -25.0f, 15.0f, 1800, 90, 864, false},
+  };
+  const int max_num_threads = 4;
+
+  for (const auto & lidar : lidars) {
+    const auto pointcloud = createPointCloud(lidar);
+    std::cout << lidar.name << ": " << pointcloud->points.size() << " points, " << lidar.size
+              << "x" << lidar.size << " cells" << std::endl;
+
+    std::vector<float> dense_map_data;
+    const double dense_time_ms = measureMilliseconds(
+      num_repetitions, [&]() { generateDense(*pointcloud, lidar, dense_map_data); });
+    std::cout << "  dense:             " << dense_time_ms << " ms" << std::endl;
+
+    for (int num_threads = 1; num_threads <= max_num_threads; num_threads *= 2) {
+      FeatureGenerator generator(
+        lidar.size, lidar.size, lidar.range, lidar.use_intensity_feature, false, num_threads);
+      std::shared_ptr<FeatureMapInterface> map_ptr;
+      const double time_ms =
+        measureMilliseconds(num_repetitions, [&]() { map_ptr = generator.generate(pointcloud); });
+
+      float max_difference = 0.0f;
+      for (size_t i = 0; i < dense_map_data.size(); ++i) {
+        max_difference =
+          std::max(max_difference, std::abs(dense_map_data[i] - map_ptr->map_data[i]));
+      }
+      std::cout << "  sparse, " << num_threads << " thread(s): " << time_ms
+                << " ms, max difference " << max_difference << std::endl;
+    }
+  }
+  return 0;
+}
@@ -27,7 +27,8 @@ public:
     const std::size_t class_size, const float point_feature_size, const std::size_t max_voxel_size,
     const std::vector<double> & point_cloud_range, const std::vector<double> & voxel_size,
     const std::size_t downsample_factor, const std::size_t encoder_in_feature_size,
-    const float score_threshold, const float circle_nms_dist_threshold)
+    const float score_threshold, const float circle_nms_dist_threshold,
+    const std::size_t num_threads)
   {
     class_size_ = class_size;
     point_feature_size_ = point_feature_size;
@@ -56,6 +57,10 @@ public:
       circle_nms_dist_threshold_ = circle_nms_dist_threshold;
     }
 
+    if (num_threads > 0) {
+      num_threads_ = num_threads;
+    }
+
     grid_size_x_ = static_cast<std::size_t>((range_max_x_ - range_min_x_) / voxel_size_x_);
     grid_size_y_ = static_cast<std::size_t>((range_max_y_ - range_min_y_) / voxel_size_y_);
     grid_size_z_ = static_cast<std::size_t>((range_max_z_ - range_min_z_) / voxel_size_z_);
@@ -82,6 +87,9 @@ public:
   float voxel_size_y_{0.32f};
   float voxel_size_z_{8.0f};
 
+  // pre-process params
+  std::size_t num_threads_{1};
+
   // network params
   const std::size_t batch_size_{1};
   std::size_t downsample_factor_{2};
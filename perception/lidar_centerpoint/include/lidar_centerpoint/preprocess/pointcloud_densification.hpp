@@ -26,6 +26,7 @@
 #include <list>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace centerpoint
 {
@@ -48,7 +49,11 @@ private:
 
 struct PointCloudWithTransform
 {
-  sensor_msgs::msg::PointCloud2 pointcloud_msg;
+  double timestamp;
+  // points in the frame of the pointcloud, which are transformed with affine_past2world
+  std::vector<float> points_x;
+  std::vector<float> points_y;
+  std::vector<float> points_z;
   Eigen::Affine3f affine_past2world;
 };
 
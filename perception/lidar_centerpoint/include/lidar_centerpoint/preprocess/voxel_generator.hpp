@@ -55,6 +55,15 @@ public:
   std::size_t pointsToVoxels(
     std::vector<float> & voxels, std::vector<int> & coordinates,
     std::vector<float> & num_points_per_voxel) override;
+
+private:
+  // buffers kept across the calls
+  std::vector<int> coord_to_voxel_idx_;  // -1 except for the cells of the voxels being generated
+  std::vector<int> voxel_to_coord_idx_;
+  std::vector<float> points_x_;  // points of a pointcloud transformed to the current frame
+  std::vector<float> points_y_;
+  std::vector<float> points_z_;
+  std::vector<int> point_coord_indices_;  // -1 if the point is out of range
 };
 
 }  // namespace centerpoint
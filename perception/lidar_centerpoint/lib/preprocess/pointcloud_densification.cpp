@@ -15,6 +15,7 @@
 #include "lidar_centerpoint/preprocess/pointcloud_densification.hpp"
 
 #include <pcl_ros/transforms.hpp>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
 
 #include <boost/optional.hpp>
 
@@ -25,6 +26,7 @@
 #include <tf2_eigen/tf2_eigen.hpp>
 #endif
 
+#include <iterator>
 #include <string>
 #include <utility>
 
@@ -83,8 +85,32 @@ void PointCloudDensification::enqueue(
 {
   affine_world2current_ = affine_world2current;
   current_timestamp_ = rclcpp::Time(msg.header.stamp).seconds();
-  PointCloudWithTransform pointcloud = {msg, affine_world2current.inverse()};
-  pointcloud_cache_.push_front(pointcloud);
+
+  // reuse the buffers of the oldest pointcloud, which is dequeued
+  if (pointcloud_cache_.size() >= param_.pointcloud_cache_size()) {
+    pointcloud_cache_.splice(
+      pointcloud_cache_.begin(), pointcloud_cache_, std::prev(pointcloud_cache_.end()));
+  } else {
+    pointcloud_cache_.emplace_front();
+  }
+
+  auto & pointcloud = pointcloud_cache_.front();
+  pointcloud.timestamp = current_timestamp_;
+  pointcloud.affine_past2world = affine_world2current.inverse();
+  pointcloud.points_x.clear();
+  pointcloud.points_y.clear();
+  pointcloud.points_z.clear();
+  const std::size_t num_points = msg.width * msg.height;
+  pointcloud.points_x.reserve(num_points);
+  pointcloud.points_y.reserve(num_points);
+  pointcloud.points_z.reserve(num_points);
+  for (sensor_msgs::PointCloud2ConstIterator<float> x_iter(msg, "x"), y_iter(msg, "y"),
+       z_iter(msg, "z");
+       x_iter != x_iter.end(); ++x_iter, ++y_iter, ++z_iter) {
+    pointcloud.points_x.push_back(*x_iter);
+    pointcloud.points_y.push_back(*y_iter);
+    pointcloud.points_z.push_back(*z_iter);
+  }
 }
 
 void PointCloudDensification::dequeue()
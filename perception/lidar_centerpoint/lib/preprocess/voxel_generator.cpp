@@ -14,7 +14,8 @@
 
 #include "lidar_centerpoint/preprocess/voxel_generator.hpp"
 
-#include <sensor_msgs/point_cloud2_iterator.hpp>
+#include <algorithm>
+#include <array>
 
 namespace centerpoint
 {
@@ -52,78 +53,95 @@ std::size_t VoxelGenerator::pointsToVoxels(
   // num_points_per_voxel (float): (max_voxel_size)
 
   const std::size_t grid_size = config_.grid_size_z_ * config_.grid_size_y_ * config_.grid_size_x_;
-  std::vector<int> coord_to_voxel_idx(grid_size, -1);
+  if (coord_to_voxel_idx_.size() != grid_size) {
+    coord_to_voxel_idx_.assign(grid_size, -1);
+  }
+  voxel_to_coord_idx_.clear();
 
+  const int num_threads = static_cast<int>(config_.num_threads_);
+  const int grid_size_xy = grid_size_[1] * grid_size_[0];
   std::size_t voxel_cnt = 0;  // @return
-  std::vector<float> point;
-  point.resize(config_.point_feature_size_);
-  std::vector<float> coord_zyx;
-  coord_zyx.resize(config_.point_dim_size_);
-  bool out_of_range;
-  std::size_t point_cnt;
-  int c, coord_idx, voxel_idx;
-  Eigen::Vector3f point_current, point_past;
 
   for (auto pc_cache_iter = pd_ptr_->getPointCloudCacheIter(); !pd_ptr_->isCacheEnd(pc_cache_iter);
        pc_cache_iter++) {
-    auto pc_msg = pc_cache_iter->pointcloud_msg;
-    auto affine_past2current =
+    const auto affine_past2current =
       pd_ptr_->getAffineWorldToCurrent() * pc_cache_iter->affine_past2world;
-    float timelag = static_cast<float>(
-      pd_ptr_->getCurrentTimestamp() - rclcpp::Time(pc_msg.header.stamp).seconds());
-
-    for (sensor_msgs::PointCloud2ConstIterator<float> x_iter(pc_msg, "x"), y_iter(pc_msg, "y"),
-         z_iter(pc_msg, "z");
-         x_iter != x_iter.end(); ++x_iter, ++y_iter, ++z_iter) {
-      point_past << *x_iter, *y_iter, *z_iter;
-      point_current = affine_past2current * point_past;
-
-      point[0] = point_current.x();
-      point[1] = point_current.y();
-      point[2] = point_current.z();
-      point[3] = timelag;
-
-      out_of_range = false;
+    const float timelag =
+      static_cast<float>(pd_ptr_->getCurrentTimestamp() - pc_cache_iter->timestamp);
+
+    // transform the points and find their cells in parallel
+    const auto num_points = static_cast<int>(pc_cache_iter->points_x.size());
+    points_x_.resize(num_points);
+    points_y_.resize(num_points);
+    points_z_.resize(num_points);
+    point_coord_indices_.resize(num_points);
+#pragma omp parallel for num_threads(num_threads)
+    for (int i = 0; i < num_points; i++) {
+      const Eigen::Vector3f point_past(
+        pc_cache_iter->points_x[i], pc_cache_iter->points_y[i], pc_cache_iter->points_z[i]);
+      const Eigen::Vector3f point_current = affine_past2current * point_past;
+      points_x_[i] = point_current.x();
+      points_y_[i] = point_current.y();
+      points_z_[i] = point_current.z();
+
+      std::array<int, 3> coord_xyz;
+      point_coord_indices_[i] = -1;
+      bool out_of_range = false;
       for (std::size_t di = 0; di < config_.point_dim_size_; di++) {
-        c = static_cast<int>((point[di] - range_[di]) * recip_voxel_size_[di]);
-        if (c < 0 || c >= grid_size_[di]) {
+        coord_xyz[di] = static_cast<int>((point_current[di] - range_[di]) * recip_voxel_size_[di]);
+        if (coord_xyz[di] < 0 || coord_xyz[di] >= grid_size_[di]) {
           out_of_range = true;
           break;
         }
-        coord_zyx[config_.point_dim_size_ - di - 1] = c;
       }
-      if (out_of_range) {
+      if (!out_of_range) {
+        point_coord_indices_[i] =
+          coord_xyz[2] * grid_size_xy + coord_xyz[1] * grid_size_[0] + coord_xyz[0];
+      }
+    }
+
+    // fill the voxels in the order of the points
+    for (int i = 0; i < num_points; i++) {
+      const int coord_idx = point_coord_indices_[i];
+      if (coord_idx == -1) {
         continue;
       }
 
-      coord_idx = coord_zyx[0] * config_.grid_size_y_ * config_.grid_size_x_ +
-                  coord_zyx[1] * config_.grid_size_x_ + coord_zyx[2];
-      voxel_idx = coord_to_voxel_idx[coord_idx];
+      int voxel_idx = coord_to_voxel_idx_[coord_idx];
       if (voxel_idx == -1) {
-        voxel_idx = voxel_cnt;
         if (voxel_cnt >= config_.max_voxel_size_) {
           continue;
         }
 
+        voxel_idx = voxel_cnt;
         voxel_cnt++;
-        coord_to_voxel_idx[coord_idx] = voxel_idx;
-        for (std::size_t di = 0; di < config_.point_dim_size_; di++) {
-          coordinates[voxel_idx * config_.point_dim_size_ + di] = coord_zyx[di];
-        }
+        coord_to_voxel_idx_[coord_idx] = voxel_idx;
+        voxel_to_coord_idx_.push_back(coord_idx);
+        coordinates[voxel_idx * config_.point_dim_size_ + 0] = coord_idx / grid_size_xy;
+        coordinates[voxel_idx * config_.point_dim_size_ + 1] =
+          (coord_idx / grid_size_[0]) % grid_size_[1];
+        coordinates[voxel_idx * config_.point_dim_size_ + 2] = coord_idx % grid_size_[0];
       }
 
-      point_cnt = num_points_per_voxel[voxel_idx];
+      const std::size_t point_cnt = num_points_per_voxel[voxel_idx];
       if (point_cnt < config_.max_point_in_voxel_size_) {
-        for (std::size_t fi = 0; fi < config_.point_feature_size_; fi++) {
-          voxels
-            [voxel_idx * config_.max_point_in_voxel_size_ * config_.point_feature_size_ +
-             point_cnt * config_.point_feature_size_ + fi] = point[fi];
+        const std::size_t offset =
+          voxel_idx * config_.max_point_in_voxel_size_ * config_.point_feature_size_ +
+          point_cnt * config_.point_feature_size_;
+        const std::array<float, 4> point{points_x_[i], points_y_[i], points_z_[i], timelag};
+        for (std::size_t fi = 0; fi < std::min(config_.point_feature_size_, point.size()); fi++) {
+          voxels[offset + fi] = point[fi];
         }
         num_points_per_voxel[voxel_idx]++;
       }
     }
   }
 
+  // reset only the cells of the generated voxels for the next call
+  for (const auto coord_idx : voxel_to_coord_idx_) {
+    coord_to_voxel_idx_[coord_idx] = -1;
+  }
+
   return voxel_cnt;
 }
 
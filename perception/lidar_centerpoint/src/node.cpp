@@ -26,6 +26,7 @@
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #endif
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -43,6 +44,7 @@ LidarCenterPointNode::LidarCenterPointNode(const rclcpp::NodeOptions & node_opti
     this->declare_parameter("densification_world_frame_id", "map");
   const int densification_num_past_frames =
     this->declare_parameter("densification_num_past_frames", 1);
+  const int num_threads = this->declare_parameter("num_threads", 1);
   const std::string trt_precision = this->declare_parameter("trt_precision", "fp16");
   const std::string encoder_onnx_path = this->declare_parameter<std::string>("encoder_onnx_path");
   const std::string encoder_engine_path =
@@ -80,7 +82,8 @@ LidarCenterPointNode::LidarCenterPointNode(const rclcpp::NodeOptions & node_opti
   }
   CenterPointConfig config(
     class_names_.size(), point_feature_size, max_voxel_size, point_cloud_range, voxel_size,
-    downsample_factor, encoder_in_feature_size, score_threshold, circle_nms_dist_threshold);
+    downsample_factor, encoder_in_feature_size, score_threshold, circle_nms_dist_threshold,
+    static_cast<std::size_t>(std::max(num_threads, 1)));
   detector_ptr_ =
     std::make_unique<CenterPointTRT>(encoder_param, head_param, densification_param, config);
 
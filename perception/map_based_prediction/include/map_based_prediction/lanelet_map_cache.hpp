@@ -0,0 +1,137 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAP_BASED_PREDICTION__LANELET_MAP_CACHE_HPP_
+#define MAP_BASED_PREDICTION__LANELET_MAP_CACHE_HPP_
+
+#include "map_based_prediction/path_generator.hpp"
+
+#include <geometry_msgs/msg/point.hpp>
+
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <boost/optional.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace map_based_prediction
+{
+/**
+ * @brief Middle points of the front and the back edges of the crosswalk
+ */
+EntryPoint getCrosswalkEntryPoint(const lanelet::ConstLanelet & crosswalk);
+
+/**
+ * @brief Geometry of the lanelet map which is queried for every object, computed once when the
+ * map is received. The lanelets and the crosswalks are indexed by their bounding boxes, and the
+ * centerlines are stored as 2d points with the yaw of each segment.
+ */
+class LaneletMapCache
+{
+public:
+  using Point = boost::geometry::model::d2::point_xy<double>;
+  using Box = boost::geometry::model::box<Point>;
+
+  LaneletMapCache() = default;
+  /**
+   * @param lanelet_map_ptr map to cache
+   * @param crosswalks lanelets used by the crosswalk users, in the order they are searched
+   */
+  LaneletMapCache(
+    const lanelet::LaneletMapPtr & lanelet_map_ptr, const lanelet::ConstLanelets & crosswalks);
+
+  /**
+   * @brief Lanelets whose bounding box contains the point, in the order of the lanelet layer
+   */
+  std::vector<lanelet::Lanelet> getLaneletsCovering(const lanelet::BasicPoint2d & point) const;
+
+  /**
+   * @brief Same as getLaneletsCovering, without the crosswalks and the walkways
+   */
+  std::vector<lanelet::Lanelet> getRoadLaneletsCovering(const lanelet::BasicPoint2d & point) const;
+
+  /**
+   * @brief Lanelet of the map with the same id, which can be modified, or nothing if the lanelet
+   * is not in the map
+   */
+  boost::optional<lanelet::Lanelet> getLanelet(const lanelet::ConstLanelet & lanelet) const;
+
+  /**
+   * @brief Same as lanelet::utils::getLaneletAngle, with the cached centerline
+   */
+  double getLaneletAngle(
+    const lanelet::ConstLanelet & lanelet, const geometry_msgs::msg::Point & search_point) const;
+
+  /**
+   * @brief Lane yaw at each point of the centerline, which is the same as getLaneletAngle at the
+   * point
+   */
+  std::vector<double> getCenterlineYaws(const lanelet::ConstLanelet & lanelet) const;
+
+  const lanelet::ConstLanelets & getCrosswalks() const { return crosswalks_; }
+
+  /**
+   * @brief Indices of the crosswalks whose bounding box contains the point, in increasing order
+   */
+  std::vector<size_t> getCrosswalksCovering(const lanelet::BasicPoint2d & point) const;
+
+  /**
+   * @brief Indices of the crosswalks with an entry point within the distance of the point on each
+   * axis, in increasing order
+   */
+  std::vector<size_t> getCrosswalksWithEntryPointNear(
+    const lanelet::BasicPoint2d & point, const double distance) const;
+
+  /**
+   * @brief Crosswalks which can be the closest to the point, in the order of getCrosswalks. The
+   * other crosswalks are farther than all of them, so that lanelet::utils::query::getClosestLanelet
+   * gives the same result with these candidates.
+   */
+  lanelet::ConstLanelets getClosestCrosswalkCandidates(const lanelet::BasicPoint2d & point) const;
+
+private:
+  struct Centerline
+  {
+    std::vector<Eigen::Vector2d> points;
+    std::vector<double> segment_yaws;
+    std::vector<double> point_yaws;
+  };
+
+  using BoxIndex = std::pair<Box, size_t>;
+  using PointIndex = std::pair<Point, size_t>;
+  using BoxRTree = boost::geometry::index::rtree<BoxIndex, boost::geometry::index::rstar<16>>;
+  using PointRTree = boost::geometry::index::rtree<PointIndex, boost::geometry::index::rstar<16>>;
+
+  /// Indices of the lanelets whose bounding box contains the point, in increasing order
+  std::vector<size_t> queryLanelets(const lanelet::BasicPoint2d & point) const;
+  const Centerline * findCenterline(const lanelet::ConstLanelet & lanelet) const;
+
+  std::vector<lanelet::Lanelet> lanelets_;
+  std::vector<bool> is_road_lanelet_;
+  std::vector<Centerline> centerlines_;
+  std::unordered_map<lanelet::Id, size_t> lanelet_indices_;
+  BoxRTree lanelet_rtree_;
+
+  lanelet::ConstLanelets crosswalks_;
+  BoxRTree crosswalk_rtree_;
+  PointRTree entry_point_rtree_;
+};
+}  // namespace map_based_prediction
+
+#endif  // MAP_BASED_PREDICTION__LANELET_MAP_CACHE_HPP_
@@ -15,6 +15,7 @@
 #ifndef MAP_BASED_PREDICTION__MAP_BASED_PREDICTION_NODE_HPP_
 #define MAP_BASED_PREDICTION__MAP_BASED_PREDICTION_NODE_HPP_
 
+#include "map_based_prediction/lanelet_map_cache.hpp"
 #include "map_based_prediction/path_generator.hpp"
 
 #include <lanelet2_extension/utility/message_conversion.hpp>
@@ -22,6 +23,7 @@
 #include <lanelet2_extension/utility/utilities.hpp>
 #include <motion_utils/motion_utils.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <tier4_autoware_utils/ros/latency_tracer.hpp>
 #include <tier4_autoware_utils/ros/transform_listener.hpp>
 #include <tier4_autoware_utils/tier4_autoware_utils.hpp>
 
@@ -102,6 +104,7 @@ private:
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr pub_debug_markers_;
   rclcpp::Subscription<TrackedObjects>::SharedPtr sub_objects_;
   rclcpp::Subscription<HADMapBin>::SharedPtr sub_map_;
+  std::unique_ptr<tier4_autoware_utils::LatencyTracer> latency_tracer_;
 
   // Object History
   std::unordered_map<std::string, std::deque<ObjectData>> objects_history_;
@@ -117,8 +120,8 @@ private:
   // Path Generator
   std::shared_ptr<PathGenerator> path_generator_;
 
-  // Crosswalk Entry Points
-  lanelet::ConstLanelets crosswalks_;
+  // Lanelet Map Cache, which also holds the crosswalks
+  LaneletMapCache lanelet_map_cache_;
 
   // Parameters
   bool enable_delay_compensation_;
@@ -137,6 +140,7 @@ private:
   double diff_dist_threshold_to_left_bound_;
   double diff_dist_threshold_to_right_bound_;
   double reference_path_resolution_;
+  int num_threads_;
 
   // Stop watch
   StopWatch<std::chrono::milliseconds> stop_watch_;
@@ -150,6 +154,10 @@ private:
 
   PredictedObject convertToPredictedObject(const TrackedObject & tracked_object);
 
+  bool isRoadUser(const TrackedObject & object) const;
+  boost::optional<PredictedObject> getPredictedObjectAsRoadUser(
+    const TrackedObject & object, const LaneletsData & current_lanelets,
+    const double objects_detected_time, boost::optional<Maneuver> & debug_maneuver);
   PredictedObject getPredictedObjectAsCrosswalkUser(const TrackedObject & object);
 
   void removeOldObjectsHistory(const double current_time);
@@ -0,0 +1,298 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "map_based_prediction/lanelet_map_cache.hpp"
+
+#include <lanelet2_extension/utility/utilities.hpp>
+#include <tier4_autoware_utils/tier4_autoware_utils.hpp>
+
+#include <boost/geometry.hpp>
+
+#include <lanelet2_core/geometry/BoundingBox.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+namespace map_based_prediction
+{
+namespace bgi = boost::geometry::index;
+
+namespace
+{
+LaneletMapCache::Box toBox(const lanelet::ConstLanelet & lanelet)
+{
+  const auto bbox = lanelet::geometry::boundingBox2d(lanelet);
+  return LaneletMapCache::Box(
+    LaneletMapCache::Point(bbox.min().x(), bbox.min().y()),
+    LaneletMapCache::Point(bbox.max().x(), bbox.max().y()));
+}
+
+bool isRoadLanelet(const lanelet::ConstLanelet & lanelet)
+{
+  if (!lanelet.hasAttribute(lanelet::AttributeName::Subtype)) {
+    return true;
+  }
+  const lanelet::Attribute attr = lanelet.attribute(lanelet::AttributeName::Subtype);
+  return attr.value() != lanelet::AttributeValueString::Crosswalk &&
+         attr.value() != lanelet::AttributeValueString::Walkway;
+}
+
+// same as the distance of boost::geometry between a point and a segment
+double calcSquaredDistanceToSegment(
+  const Eigen::Vector2d & point, const Eigen::Vector2d & p1, const Eigen::Vector2d & p2)
+{
+  const Eigen::Vector2d v = p2 - p1;
+  const Eigen::Vector2d w = point - p1;
+  const double c1 = w.dot(v);
+  if (c1 <= 0.0) {
+    return w.squaredNorm();
+  }
+  const double c2 = v.dot(v);
+  if (c2 <= c1) {
+    return (point - p2).squaredNorm();
+  }
+  return (point - (p1 + v * (c1 / c2))).squaredNorm();
+}
+}  // namespace
+
+EntryPoint getCrosswalkEntryPoint(const lanelet::ConstLanelet & crosswalk)
+{
+  const auto & r_p_front = crosswalk.rightBound().front();
+  const auto & l_p_front = crosswalk.leftBound().front();
+  const Eigen::Vector2d front_entry_point(
+    (r_p_front.x() + l_p_front.x()) / 2.0, (r_p_front.y() + l_p_front.y()) / 2.0);
+
+  const auto & r_p_back = crosswalk.rightBound().back();
+  const auto & l_p_back = crosswalk.leftBound().back();
+  const Eigen::Vector2d back_entry_point(
+    (r_p_back.x() + l_p_back.x()) / 2.0, (r_p_back.y() + l_p_back.y()) / 2.0);
+
+  return std::make_pair(front_entry_point, back_entry_point);
+}
+
+LaneletMapCache::LaneletMapCache(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const lanelet::ConstLanelets & crosswalks)
+{
+  std::vector<BoxIndex> lanelet_boxes;
+  for (const auto & lanelet : lanelet_map_ptr->laneletLayer) {
+    const size_t lanelet_idx = lanelets_.size();
+    lanelets_.push_back(lanelet);
+    is_road_lanelet_.push_back(isRoadLanelet(lanelet));
+    lanelet_indices_.emplace(lanelet.id(), lanelet_idx);
+    lanelet_boxes.emplace_back(toBox(lanelet), lanelet_idx);
+
+    // lanelet::utils::getLaneletAngle takes the yaw of the first segment closest to the point,
+    // which is the segment ending at the point for the points of the centerline. The lanelet
+    // computes its centerline lazily, so it is also computed here before the objects are predicted
+    // in parallel.
+    Centerline centerline;
+    const auto centerline3d = lanelet.centerline();
+    for (const auto & p : centerline3d) {
+      centerline.points.emplace_back(p.x(), p.y());
+    }
+    for (size_t i = 1; i < centerline3d.size(); ++i) {
+      centerline.segment_yaws.push_back(std::atan2(
+        centerline3d[i].y() - centerline3d[i - 1].y(),
+        centerline3d[i].x() - centerline3d[i - 1].x()));
+    }
+    for (size_t i = 0; i < centerline.points.size(); ++i) {
+      if (centerline.segment_yaws.empty()) {
+        centerline.point_yaws.push_back(0.0);
+        continue;
+      }
+      size_t first_same_point_idx = i;
+      while (0 < first_same_point_idx &&
+             centerline.points.at(first_same_point_idx - 1) == centerline.points.at(i)) {
+        --first_same_point_idx;
+      }
+      const size_t segment_idx = std::max(first_same_point_idx, size_t{1}) - 1;
+      centerline.point_yaws.push_back(centerline.segment_yaws.at(segment_idx));
+    }
+    centerlines_.push_back(std::move(centerline));
+  }
+  lanelet_rtree_ = BoxRTree(lanelet_boxes.begin(), lanelet_boxes.end());
+
+  std::vector<BoxIndex> crosswalk_boxes;
+  std::vector<PointIndex> entry_points;
+  for (const auto & crosswalk : crosswalks) {
+    const size_t crosswalk_idx = crosswalks_.size();
+    crosswalks_.push_back(crosswalk);
+    crosswalk_boxes.emplace_back(toBox(crosswalk), crosswalk_idx);
+    const auto entry_point = getCrosswalkEntryPoint(crosswalk);
+    for (const auto & p : {entry_point.first, entry_point.second}) {
+      entry_points.emplace_back(Point(p.x(), p.y()), crosswalk_idx);
+    }
+  }
+  crosswalk_rtree_ = BoxRTree(crosswalk_boxes.begin(), crosswalk_boxes.end());
+  entry_point_rtree_ = PointRTree(entry_points.begin(), entry_points.end());
+}
+
+std::vector<lanelet::Lanelet> LaneletMapCache::getLaneletsCovering(
+  const lanelet::BasicPoint2d & point) const
+{
+  std::vector<lanelet::Lanelet> lanelets;
+  for (const auto lanelet_idx : queryLanelets(point)) {
+    lanelets.push_back(lanelets_.at(lanelet_idx));
+  }
+  return lanelets;
+}
+
+std::vector<lanelet::Lanelet> LaneletMapCache::getRoadLaneletsCovering(
+  const lanelet::BasicPoint2d & point) const
+{
+  std::vector<lanelet::Lanelet> lanelets;
+  for (const auto lanelet_idx : queryLanelets(point)) {
+    if (is_road_lanelet_.at(lanelet_idx)) {
+      lanelets.push_back(lanelets_.at(lanelet_idx));
+    }
+  }
+  return lanelets;
+}
+
+boost::optional<lanelet::Lanelet> LaneletMapCache::getLanelet(
+  const lanelet::ConstLanelet & lanelet) const
+{
+  const auto itr = lanelet_indices_.find(lanelet.id());
+  if (itr == lanelet_indices_.end()) {
+    return {};
+  }
+  return lanelets_.at(itr->second);
+}
+
+double LaneletMapCache::getLaneletAngle(
+  const lanelet::ConstLanelet & lanelet, const geometry_msgs::msg::Point & search_point) const
+{
+  const auto * centerline = findCenterline(lanelet);
+  if (!centerline) {
+    return lanelet::utils::getLaneletAngle(lanelet, search_point);
+  }
+  if (centerline->segment_yaws.empty()) {
+    return 0.0;
+  }
+
+  const Eigen::Vector2d point(search_point.x, search_point.y);
+  size_t closest_segment_idx = 0;
+  double min_squared_dist = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < centerline->segment_yaws.size(); ++i) {
+    const double squared_dist = calcSquaredDistanceToSegment(
+      point, centerline->points.at(i), centerline->points.at(i + 1));
+    if (squared_dist < min_squared_dist) {
+      min_squared_dist = squared_dist;
+      closest_segment_idx = i;
+    }
+  }
+  return centerline->segment_yaws.at(closest_segment_idx);
+}
+
+std::vector<double> LaneletMapCache::getCenterlineYaws(const lanelet::ConstLanelet & lanelet) const
+{
+  const auto * centerline = findCenterline(lanelet);
+  if (centerline) {
+    return centerline->point_yaws;
+  }
+
+  std::vector<double> yaws;
+  for (const auto & p : lanelet.centerline()) {
+    const auto position = tier4_autoware_utils::createPoint(p.x(), p.y(), p.z());
+    yaws.push_back(lanelet::utils::getLaneletAngle(lanelet, position));
+  }
+  return yaws;
+}
+
+std::vector<size_t> LaneletMapCache::getCrosswalksCovering(
+  const lanelet::BasicPoint2d & point) const
+{
+  std::vector<BoxIndex> results;
+  crosswalk_rtree_.query(bgi::intersects(Point(point.x(), point.y())), std::back_inserter(results));
+
+  std::vector<size_t> crosswalk_indices;
+  for (const auto & result : results) {
+    crosswalk_indices.push_back(result.second);
+  }
+  std::sort(crosswalk_indices.begin(), crosswalk_indices.end());
+  return crosswalk_indices;
+}
+
+std::vector<size_t> LaneletMapCache::getCrosswalksWithEntryPointNear(
+  const lanelet::BasicPoint2d & point, const double distance) const
+{
+  const Box search_box(
+    Point(point.x() - distance, point.y() - distance),
+    Point(point.x() + distance, point.y() + distance));
+  std::vector<PointIndex> results;
+  entry_point_rtree_.query(bgi::intersects(search_box), std::back_inserter(results));
+
+  std::vector<size_t> crosswalk_indices;
+  for (const auto & result : results) {
+    crosswalk_indices.push_back(result.second);
+  }
+  std::sort(crosswalk_indices.begin(), crosswalk_indices.end());
+  crosswalk_indices.erase(
+    std::unique(crosswalk_indices.begin(), crosswalk_indices.end()), crosswalk_indices.end());
+  return crosswalk_indices;
+}
+
+lanelet::ConstLanelets LaneletMapCache::getClosestCrosswalkCandidates(
+  const lanelet::BasicPoint2d & point) const
+{
+  // the crosswalks are visited in increasing distance to their bounding box, which is not larger
+  // than the distance to the crosswalk
+  const Point search_point(point.x(), point.y());
+  double min_dist = std::numeric_limits<double>::max();
+  std::vector<size_t> crosswalk_indices;
+  for (auto itr = crosswalk_rtree_.qbegin(bgi::nearest(search_point, crosswalk_rtree_.size()));
+       itr != crosswalk_rtree_.qend(); ++itr) {
+    if (min_dist < boost::geometry::distance(search_point, itr->first)) {
+      break;
+    }
+    const auto & crosswalk = crosswalks_.at(itr->second);
+    const double dist = boost::geometry::distance(crosswalk.polygon2d().basicPolygon(), point);
+    min_dist = std::min(min_dist, dist);
+    crosswalk_indices.push_back(itr->second);
+  }
+  std::sort(crosswalk_indices.begin(), crosswalk_indices.end());
+
+  lanelet::ConstLanelets candidates;
+  for (const auto crosswalk_idx : crosswalk_indices) {
+    candidates.push_back(crosswalks_.at(crosswalk_idx));
+  }
+  return candidates;
+}
+
+std::vector<size_t> LaneletMapCache::queryLanelets(const lanelet::BasicPoint2d & point) const
+{
+  std::vector<BoxIndex> results;
+  lanelet_rtree_.query(bgi::intersects(Point(point.x(), point.y())), std::back_inserter(results));
+
+  std::vector<size_t> lanelet_indices;
+  for (const auto & result : results) {
+    lanelet_indices.push_back(result.second);
+  }
+  std::sort(lanelet_indices.begin(), lanelet_indices.end());
+  return lanelet_indices;
+}
+
+const LaneletMapCache::Centerline * LaneletMapCache::findCenterline(
+  const lanelet::ConstLanelet & lanelet) const
+{
+  const auto itr = lanelet_indices_.find(lanelet.id());
+  if (itr == lanelet_indices_.end()) {
+    return nullptr;
+  }
+  return &centerlines_.at(itr->second);
+}
+}  // namespace map_based_prediction
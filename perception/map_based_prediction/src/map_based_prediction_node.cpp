@@ -58,21 +58,6 @@ lanelet::ConstLanelets getLanelets(const map_based_prediction::LaneletsData & da
   return lanelets;
 }
 
-EntryPoint getCrosswalkEntryPoint(const lanelet::ConstLanelet & crosswalk)
-{
-  const auto & r_p_front = crosswalk.rightBound().front();
-  const auto & l_p_front = crosswalk.leftBound().front();
-  const Eigen::Vector2d front_entry_point(
-    (r_p_front.x() + l_p_front.x()) / 2.0, (r_p_front.y() + l_p_front.y()) / 2.0);
-
-  const auto & r_p_back = crosswalk.rightBound().back();
-  const auto & l_p_back = crosswalk.leftBound().back();
-  const Eigen::Vector2d back_entry_point(
-    (r_p_back.x() + l_p_back.x()) / 2.0, (r_p_back.y() + l_p_back.y()) / 2.0);
-
-  return std::make_pair(front_entry_point, back_entry_point);
-}
-
 bool withinLanelet(const TrackedObject & object, const lanelet::ConstLanelet & lanelet)
 {
   using Point = boost::geometry::model::d2::point_xy<double>;
@@ -86,30 +71,14 @@ bool withinLanelet(const TrackedObject & object, const lanelet::ConstLanelet & l
   return boost::geometry::within(p_object, polygon);
 }
 
-bool withinRoadLanelet(const TrackedObject & object, const lanelet::LaneletMapPtr & lanelet_map_ptr)
+bool withinRoadLanelet(const TrackedObject & object, const LaneletMapCache & lanelet_map_cache)
 {
-  using Point = boost::geometry::model::d2::point_xy<double>;
-
   const auto & obj_pos = object.kinematics.pose_with_covariance.pose.position;
-  const Point p_object{obj_pos.x, obj_pos.y};
-
-  lanelet::BasicPoint2d search_point(obj_pos.x, obj_pos.y);
-  // nearest lanelet
-  constexpr double search_radius = 10.0;  // [m]
-  const auto surrounding_lanelets =
-    lanelet::geometry::findNearest(lanelet_map_ptr->laneletLayer, search_point, search_radius);
-
-  for (const auto & lanelet : surrounding_lanelets) {
-    if (lanelet.second.hasAttribute(lanelet::AttributeName::Subtype)) {
-      lanelet::Attribute attr = lanelet.second.attribute(lanelet::AttributeName::Subtype);
-      if (
-        attr.value() == lanelet::AttributeValueString::Crosswalk ||
-        attr.value() == lanelet::AttributeValueString::Walkway) {
-        continue;
-      }
-    }
+  const lanelet::BasicPoint2d search_point(obj_pos.x, obj_pos.y);
 
-    if (withinLanelet(object, lanelet.second)) {
+  // the object is inside of the lanelet only if the lanelet's bounding box contains it
+  for (const auto & lanelet : lanelet_map_cache.getRoadLaneletsCovering(search_point)) {
+    if (withinLanelet(object, lanelet)) {
       return true;
     }
   }
@@ -272,6 +241,7 @@ MapBasedPredictionNode::MapBasedPredictionNode(const rclcpp::NodeOptions & node_
   diff_dist_threshold_to_right_bound_ =
     declare_parameter("diff_dist_threshold_to_right_bound", -0.29);
   reference_path_resolution_ = declare_parameter("reference_path_resolution", 0.5);
+  num_threads_ = std::max(static_cast<int>(declare_parameter("num_threads", 1)), 1);
 
   path_generator_ = std::make_shared<PathGenerator>(
     prediction_time_horizon_, prediction_sampling_time_interval_,
@@ -287,6 +257,7 @@ MapBasedPredictionNode::MapBasedPredictionNode(const rclcpp::NodeOptions & node_
   pub_objects_ = this->create_publisher<PredictedObjects>("objects", rclcpp::QoS{1});
   pub_debug_markers_ =
     this->create_publisher<visualization_msgs::msg::MarkerArray>("maneuver", rclcpp::QoS{1});
+  latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
 }
 
 PredictedObjectKinematics MapBasedPredictionNode::convertToPredictedKinematics(
@@ -321,14 +292,17 @@ void MapBasedPredictionNode::mapCallback(const HADMapBin::ConstSharedPtr msg)
   RCLCPP_INFO(get_logger(), "[Map Based Prediction]: Map is loaded");
 
   const auto all_lanelets = lanelet::utils::query::laneletLayer(lanelet_map_ptr_);
-  const auto crosswalks = lanelet::utils::query::crosswalkLanelets(all_lanelets);
+  auto crosswalks = lanelet::utils::query::crosswalkLanelets(all_lanelets);
   const auto walkways = lanelet::utils::query::walkwayLanelets(all_lanelets);
-  crosswalks_.insert(crosswalks_.end(), crosswalks.begin(), crosswalks.end());
-  crosswalks_.insert(crosswalks_.end(), walkways.begin(), walkways.end());
+  crosswalks.insert(crosswalks.end(), walkways.begin(), walkways.end());
+  lanelet_map_cache_ = LaneletMapCache(lanelet_map_ptr_, crosswalks);
+  RCLCPP_INFO(get_logger(), "[Map Based Prediction]: Map cache is built");
 }
 
 void MapBasedPredictionNode::objectsCallback(const TrackedObjects::ConstSharedPtr in_objects)
 {
+  const auto span = latency_tracer_->startSpan(in_objects->header.stamp);
+
   // Guard for map pointer and frame transformation
   if (!lanelet_map_ptr_) {
     return;
@@ -363,130 +337,57 @@ void MapBasedPredictionNode::objectsCallback(const TrackedObjects::ConstSharedPt
   // result debug
   visualization_msgs::msg::MarkerArray debug_markers;
 
-  for (const auto & object : in_objects->objects) {
-    std::string object_id = toHexString(object.object_id);
-    TrackedObject transformed_object = object;
-
-    // transform object frame if it's based on map frame
-    if (in_objects->header.frame_id != "map") {
+  // transform object frame if it's based on map frame
+  const size_t num_objects = in_objects->objects.size();
+  std::vector<TrackedObject> transformed_objects(in_objects->objects);
+  if (in_objects->header.frame_id != "map") {
+    for (auto & transformed_object : transformed_objects) {
       geometry_msgs::msg::PoseStamped pose_in_map;
       geometry_msgs::msg::PoseStamped pose_orig;
-      pose_orig.pose = object.kinematics.pose_with_covariance.pose;
+      pose_orig.pose = transformed_object.kinematics.pose_with_covariance.pose;
       tf2::doTransform(pose_orig, pose_in_map, *world2map_transform);
       transformed_object.kinematics.pose_with_covariance.pose = pose_in_map.pose;
     }
+  }
 
-    const auto & label = transformed_object.classification.front().label;
-
-    // For crosswalk user
-    if (label == ObjectClassification::PEDESTRIAN || label == ObjectClassification::BICYCLE) {
-      const auto predicted_object = getPredictedObjectAsCrosswalkUser(transformed_object);
-      output.objects.push_back(predicted_object);
-      // For road user
-    } else if (
-      label == ObjectClassification::CAR || label == ObjectClassification::BUS ||
-      label == ObjectClassification::TRAILER || label == ObjectClassification::MOTORCYCLE ||
-      label == ObjectClassification::TRUCK) {
+  // The objects are predicted in parallel. Only the history of the road users is shared between
+  // them, so it is updated serially after their current lanelets are searched, and the prediction
+  // of each object only modifies its own history.
+  std::vector<LaneletsData> current_lanelets_array(num_objects);
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (size_t i = 0; i < num_objects; ++i) {
+    auto & transformed_object = transformed_objects.at(i);
+    if (isRoadUser(transformed_object)) {
       // Update object yaw and velocity
       updateObjectData(transformed_object);
 
       // Get Closest Lanelet
-      const auto current_lanelets = getCurrentLanelets(transformed_object);
-
-      // Update Objects History
-      updateObjectsHistory(output.header, transformed_object, current_lanelets);
-
-      // For off lane obstacles
-      if (current_lanelets.empty()) {
-        PredictedPath predicted_path =
-          path_generator_->generatePathForOffLaneVehicle(transformed_object);
-        predicted_path.confidence = 1.0;
-        if (predicted_path.path.empty()) {
-          continue;
-        }
-
-        auto predicted_object = convertToPredictedObject(transformed_object);
-        predicted_object.kinematics.predicted_paths.push_back(predicted_path);
-        output.objects.push_back(predicted_object);
-        continue;
-      }
-
-      // For too-slow vehicle
-      if (
-        std::fabs(transformed_object.kinematics.twist_with_covariance.twist.linear.x) <
-        min_velocity_for_map_based_prediction_) {
-        PredictedPath predicted_path =
-          path_generator_->generatePathForLowSpeedVehicle(transformed_object);
-        predicted_path.confidence = 1.0;
-        if (predicted_path.path.empty()) {
-          continue;
-        }
-
-        auto predicted_object = convertToPredictedObject(transformed_object);
-        predicted_object.kinematics.predicted_paths.push_back(predicted_path);
-        output.objects.push_back(predicted_object);
-        continue;
-      }
-
-      // Get Predicted Reference Path for Each Maneuver and current lanelets
-      // return: <probability, paths>
-      const auto ref_paths =
-        getPredictedReferencePath(transformed_object, current_lanelets, objects_detected_time);
-
-      // If predicted reference path is empty, assume this object is out of the lane
-      if (ref_paths.empty()) {
-        PredictedPath predicted_path =
-          path_generator_->generatePathForLowSpeedVehicle(transformed_object);
-        predicted_path.confidence = 1.0;
-        if (predicted_path.path.empty()) {
-          continue;
-        }
-
-        auto predicted_object = convertToPredictedObject(transformed_object);
-        predicted_object.kinematics.predicted_paths.push_back(predicted_path);
-        output.objects.push_back(predicted_object);
-        continue;
-      }
-
-      // Get Debug Marker for On Lane Vehicles
-      const auto max_prob_path = std::max_element(
-        ref_paths.begin(), ref_paths.end(),
-        [](const PredictedRefPath & a, const PredictedRefPath & b) {
-          return a.probability < b.probability;
-        });
-      const auto debug_marker =
-        getDebugMarker(object, max_prob_path->maneuver, debug_markers.markers.size());
-      debug_markers.markers.push_back(debug_marker);
-
-      // Generate Predicted Path
-      std::vector<PredictedPath> predicted_paths;
-      for (const auto & ref_path : ref_paths) {
-        PredictedPath predicted_path =
-          path_generator_->generatePathForOnLaneVehicle(transformed_object, ref_path.path);
-        predicted_path.confidence = ref_path.probability;
-
-        predicted_paths.push_back(predicted_path);
-      }
+      current_lanelets_array.at(i) = getCurrentLanelets(transformed_object);
+    }
+  }
 
-      // Normalize Path Confidence and output the predicted object
-      {
-        float sum_confidence = 0.0;
-        for (const auto & predicted_path : predicted_paths) {
-          sum_confidence += predicted_path.confidence;
-        }
-        const float min_sum_confidence_value = 1e-3;
-        sum_confidence = std::max(sum_confidence, min_sum_confidence_value);
+  // Update Objects History
+  for (size_t i = 0; i < num_objects; ++i) {
+    if (isRoadUser(transformed_objects.at(i))) {
+      updateObjectsHistory(output.header, transformed_objects.at(i), current_lanelets_array.at(i));
+    }
+  }
 
-        for (auto & predicted_path : predicted_paths) {
-          predicted_path.confidence = predicted_path.confidence / sum_confidence;
-        }
+  std::vector<boost::optional<PredictedObject>> predicted_objects(num_objects);
+  std::vector<boost::optional<Maneuver>> debug_maneuvers(num_objects);
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (size_t i = 0; i < num_objects; ++i) {
+    const auto & transformed_object = transformed_objects.at(i);
+    const auto & label = transformed_object.classification.front().label;
 
-        auto predicted_object = convertToPredictedObject(transformed_object);
-        for (const auto & predicted_path : predicted_paths) {
-          predicted_object.kinematics.predicted_paths.push_back(predicted_path);
-        }
-        output.objects.push_back(predicted_object);
-      }
+    // For crosswalk user
+    if (label == ObjectClassification::PEDESTRIAN || label == ObjectClassification::BICYCLE) {
+      predicted_objects.at(i) = getPredictedObjectAsCrosswalkUser(transformed_object);
+      // For road user
+    } else if (isRoadUser(transformed_object)) {
+      predicted_objects.at(i) = getPredictedObjectAsRoadUser(
+        transformed_object, current_lanelets_array.at(i), objects_detected_time,
+        debug_maneuvers.at(i));
       // For unknown object
     } else {
       auto predicted_object = convertToPredictedObject(transformed_object);
@@ -495,13 +396,121 @@ void MapBasedPredictionNode::objectsCallback(const TrackedObjects::ConstSharedPt
       predicted_path.confidence = 1.0;
 
       predicted_object.kinematics.predicted_paths.push_back(predicted_path);
-      output.objects.push_back(predicted_object);
+      predicted_objects.at(i) = predicted_object;
+    }
+  }
+
+  // Output the objects in the input order
+  for (size_t i = 0; i < num_objects; ++i) {
+    // Get Debug Marker for On Lane Vehicles
+    if (debug_maneuvers.at(i)) {
+      const auto debug_marker = getDebugMarker(
+        in_objects->objects.at(i), debug_maneuvers.at(i).get(), debug_markers.markers.size());
+      debug_markers.markers.push_back(debug_marker);
+    }
+    if (predicted_objects.at(i)) {
+      output.objects.push_back(std::move(predicted_objects.at(i).get()));
     }
   }
 
   // Publish Results
   pub_objects_->publish(output);
   pub_debug_markers_->publish(debug_markers);
+  latency_tracer_->publishLatency(in_objects->header.stamp);
+}
+
+bool MapBasedPredictionNode::isRoadUser(const TrackedObject & object) const
+{
+  const auto & label = object.classification.front().label;
+  return label == ObjectClassification::CAR || label == ObjectClassification::BUS ||
+         label == ObjectClassification::TRAILER || label == ObjectClassification::MOTORCYCLE ||
+         label == ObjectClassification::TRUCK;
+}
+
+boost::optional<PredictedObject> MapBasedPredictionNode::getPredictedObjectAsRoadUser(
+  const TrackedObject & object, const LaneletsData & current_lanelets,
+  const double objects_detected_time, boost::optional<Maneuver> & debug_maneuver)
+{
+  // For off lane obstacles
+  if (current_lanelets.empty()) {
+    PredictedPath predicted_path = path_generator_->generatePathForOffLaneVehicle(object);
+    predicted_path.confidence = 1.0;
+    if (predicted_path.path.empty()) {
+      return {};
+    }
+
+    auto predicted_object = convertToPredictedObject(object);
+    predicted_object.kinematics.predicted_paths.push_back(predicted_path);
+    return predicted_object;
+  }
+
+  // For too-slow vehicle
+  if (
+    std::fabs(object.kinematics.twist_with_covariance.twist.linear.x) <
+    min_velocity_for_map_based_prediction_) {
+    PredictedPath predicted_path = path_generator_->generatePathForLowSpeedVehicle(object);
+    predicted_path.confidence = 1.0;
+    if (predicted_path.path.empty()) {
+      return {};
+    }
+
+    auto predicted_object = convertToPredictedObject(object);
+    predicted_object.kinematics.predicted_paths.push_back(predicted_path);
+    return predicted_object;
+  }
+
+  // Get Predicted Reference Path for Each Maneuver and current lanelets
+  // return: <probability, paths>
+  const auto ref_paths = getPredictedReferencePath(object, current_lanelets, objects_detected_time);
+
+  // If predicted reference path is empty, assume this object is out of the lane
+  if (ref_paths.empty()) {
+    PredictedPath predicted_path = path_generator_->generatePathForLowSpeedVehicle(object);
+    predicted_path.confidence = 1.0;
+    if (predicted_path.path.empty()) {
+      return {};
+    }
+
+    auto predicted_object = convertToPredictedObject(object);
+    predicted_object.kinematics.predicted_paths.push_back(predicted_path);
+    return predicted_object;
+  }
+
+  // Maneuver of the debug marker for on lane vehicles
+  const auto max_prob_path = std::max_element(
+    ref_paths.begin(), ref_paths.end(),
+    [](const PredictedRefPath & a, const PredictedRefPath & b) {
+      return a.probability < b.probability;
+    });
+  debug_maneuver = max_prob_path->maneuver;
+
+  // Generate Predicted Path
+  std::vector<PredictedPath> predicted_paths;
+  for (const auto & ref_path : ref_paths) {
+    PredictedPath predicted_path =
+      path_generator_->generatePathForOnLaneVehicle(object, ref_path.path);
+    predicted_path.confidence = ref_path.probability;
+
+    predicted_paths.push_back(predicted_path);
+  }
+
+  // Normalize Path Confidence and output the predicted object
+  float sum_confidence = 0.0;
+  for (const auto & predicted_path : predicted_paths) {
+    sum_confidence += predicted_path.confidence;
+  }
+  const float min_sum_confidence_value = 1e-3;
+  sum_confidence = std::max(sum_confidence, min_sum_confidence_value);
+
+  for (auto & predicted_path : predicted_paths) {
+    predicted_path.confidence = predicted_path.confidence / sum_confidence;
+  }
+
+  auto predicted_object = convertToPredictedObject(object);
+  for (const auto & predicted_path : predicted_paths) {
+    predicted_object.kinematics.predicted_paths.push_back(predicted_path);
+  }
+  return predicted_object;
 }
 
 PredictedObject MapBasedPredictionNode::getPredictedObjectAsCrosswalkUser(
@@ -515,10 +524,14 @@ PredictedObject MapBasedPredictionNode::getPredictedObjectAsCrosswalkUser(
     predicted_object.kinematics.predicted_paths.push_back(predicted_path);
   }
 
+  const auto & obj_pos = object.kinematics.pose_with_covariance.pose.position;
+  const lanelet::BasicPoint2d obj_point(obj_pos.x, obj_pos.y);
+  const auto & crosswalks = lanelet_map_cache_.getCrosswalks();
+
   boost::optional<lanelet::ConstLanelet> crossing_crosswalk{boost::none};
-  for (const auto & crosswalk : crosswalks_) {
-    if (withinLanelet(object, crosswalk)) {
-      crossing_crosswalk = crosswalk;
+  for (const auto crosswalk_idx : lanelet_map_cache_.getCrosswalksCovering(obj_point)) {
+    if (withinLanelet(object, crosswalks.at(crosswalk_idx))) {
+      crossing_crosswalk = crosswalks.at(crosswalk_idx);
       break;
     }
   }
@@ -544,11 +557,11 @@ PredictedObject MapBasedPredictionNode::getPredictedObjectAsCrosswalkUser(
       predicted_object.kinematics.predicted_paths.push_back(predicted_path);
     }
 
-  } else if (withinRoadLanelet(object, lanelet_map_ptr_)) {
+  } else if (withinRoadLanelet(object, lanelet_map_cache_)) {
     lanelet::ConstLanelet closest_crosswalk{};
     const auto & obj_pose = object.kinematics.pose_with_covariance.pose;
-    const auto found_closest_crosswalk =
-      lanelet::utils::query::getClosestLanelet(crosswalks_, obj_pose, &closest_crosswalk);
+    const auto found_closest_crosswalk = lanelet::utils::query::getClosestLanelet(
+      lanelet_map_cache_.getClosestCrosswalkCandidates(obj_point), obj_pose, &closest_crosswalk);
 
     if (found_closest_crosswalk) {
       const auto entry_point = getCrosswalkEntryPoint(closest_crosswalk);
@@ -573,8 +586,14 @@ PredictedObject MapBasedPredictionNode::getPredictedObjectAsCrosswalkUser(
     }
 
   } else {
-    for (const auto & crosswalk : crosswalks_) {
-      const auto entry_point = getCrosswalkEntryPoint(crosswalk);
+    // only the crosswalks with an entry point within the reachable distance are checked
+    const auto & obj_vel = object.kinematics.twist_with_covariance.twist.linear;
+    const double reachable_dist =
+      prediction_time_horizon_ *
+      std::max(min_velocity_for_map_based_prediction_, std::hypot(obj_vel.x, obj_vel.y));
+    for (const auto crosswalk_idx :
+         lanelet_map_cache_.getCrosswalksWithEntryPointNear(obj_point, reachable_dist)) {
+      const auto entry_point = getCrosswalkEntryPoint(crosswalks.at(crosswalk_idx));
 
       const auto reachable_first = hasPotentialToReach(
         object, entry_point.first, prediction_time_horizon_,
@@ -702,9 +721,22 @@ LaneletsData MapBasedPredictionNode::getCurrentLanelets(const TrackedObject & ob
     object.kinematics.pose_with_covariance.pose.position.x,
     object.kinematics.pose_with_covariance.pose.position.y);
 
-  // nearest lanelet
-  std::vector<std::pair<double, lanelet::Lanelet>> surrounding_lanelets =
-    lanelet::geometry::findNearest(lanelet_map_ptr_->laneletLayer, search_point, 10);
+  // The current lanelets have to be in the future possible lanelets of the object if it has them,
+  // so only they are checked. Otherwise, the lanelets whose bounding box contains the object are.
+  std::vector<lanelet::Lanelet> surrounding_lanelets;
+  const std::string object_id = toHexString(object.object_id);
+  if (
+    objects_history_.count(object_id) != 0 &&
+    !objects_history_.at(object_id).back().future_possible_lanelets.empty()) {
+    for (const auto & possible_lanelet :
+         objects_history_.at(object_id).back().future_possible_lanelets) {
+      if (const auto lanelet = lanelet_map_cache_.getLanelet(possible_lanelet)) {
+        surrounding_lanelets.push_back(lanelet.get());
+      }
+    }
+  } else {
+    surrounding_lanelets = lanelet_map_cache_.getLaneletsCovering(search_point);
+  }
 
   // No Closest Lanelets
   if (surrounding_lanelets.empty()) {
@@ -712,7 +744,10 @@ LaneletsData MapBasedPredictionNode::getCurrentLanelets(const TrackedObject & ob
   }
 
   LaneletsData closest_lanelets;
-  for (const auto & lanelet : surrounding_lanelets) {
+  for (const auto & surrounding_lanelet : surrounding_lanelets) {
+    // The distance to the lanelet is zero if the object is inside of it
+    const auto lanelet = std::make_pair(0.0, surrounding_lanelet);
+
     // Check if the close lanelets meet the necessary condition for start lanelets and
     // Check if similar lanelet is inside the closest lanelet
     if (
@@ -761,7 +796,7 @@ bool MapBasedPredictionNode::checkCloseLaneletCondition(
 
   // Step3. Calculate the angle difference between the lane angle and obstacle angle
   const double object_yaw = tf2::getYaw(object.kinematics.pose_with_covariance.pose.orientation);
-  const double lane_yaw = lanelet::utils::getLaneletAngle(
+  const double lane_yaw = lanelet_map_cache_.getLaneletAngle(
     lanelet.second, object.kinematics.pose_with_covariance.pose.position);
   const double delta_yaw = object_yaw - lane_yaw;
   const double normalized_delta_yaw = tier4_autoware_utils::normalizeRadian(delta_yaw);
@@ -788,7 +823,7 @@ float MapBasedPredictionNode::calculateLocalLikelihood(
 
   // compute yaw difference between the object and lane
   const double obj_yaw = tf2::getYaw(object.kinematics.pose_with_covariance.pose.orientation);
-  const double lane_yaw = lanelet::utils::getLaneletAngle(current_lanelet, obj_point);
+  const double lane_yaw = lanelet_map_cache_.getLaneletAngle(current_lanelet, obj_point);
   const double delta_yaw = obj_yaw - lane_yaw;
   const double abs_norm_delta_yaw = std::fabs(tier4_autoware_utils::normalizeRadian(delta_yaw));
 
@@ -973,7 +1008,7 @@ Maneuver MapBasedPredictionNode::predictObjectManeuver(
   lanelet::ConstLanelet prev_lanelet = prev_lanelets.front();
   double closest_prev_yaw = std::numeric_limits<double>::max();
   for (const auto & lanelet : prev_lanelets) {
-    const double lane_yaw = lanelet::utils::getLaneletAngle(lanelet, prev_pose.position);
+    const double lane_yaw = lanelet_map_cache_.getLaneletAngle(lanelet, prev_pose.position);
     const double delta_yaw = tf2::getYaw(prev_pose.orientation) - lane_yaw;
     const double normalized_delta_yaw = tier4_autoware_utils::normalizeRadian(delta_yaw);
     if (normalized_delta_yaw < closest_prev_yaw) {
@@ -1214,24 +1249,28 @@ std::vector<PosePath> MapBasedPredictionNode::convertPathType(
       lanelet::ConstLanelets prev_lanelets = routing_graph_ptr_->previous(path.front());
       if (!prev_lanelets.empty()) {
         lanelet::ConstLanelet prev_lanelet = prev_lanelets.front();
-        for (const auto & lanelet_p : prev_lanelet.centerline()) {
+        const auto centerline = prev_lanelet.centerline();
+        const auto lane_yaws = lanelet_map_cache_.getCenterlineYaws(prev_lanelet);
+        for (size_t i = 0; i < centerline.size(); ++i) {
+          const auto & lanelet_p = centerline[i];
           geometry_msgs::msg::Pose current_p;
           current_p.position =
             tier4_autoware_utils::createPoint(lanelet_p.x(), lanelet_p.y(), lanelet_p.z());
-          const double lane_yaw = lanelet::utils::getLaneletAngle(prev_lanelet, current_p.position);
-          current_p.orientation = tier4_autoware_utils::createQuaternionFromYaw(lane_yaw);
+          current_p.orientation = tier4_autoware_utils::createQuaternionFromYaw(lane_yaws.at(i));
           converted_path.push_back(current_p);
         }
       }
     }
 
     for (const auto & lanelet : path) {
-      for (const auto & lanelet_p : lanelet.centerline()) {
+      const auto centerline = lanelet.centerline();
+      const auto lane_yaws = lanelet_map_cache_.getCenterlineYaws(lanelet);
+      for (size_t i = 0; i < centerline.size(); ++i) {
+        const auto & lanelet_p = centerline[i];
         geometry_msgs::msg::Pose current_p;
         current_p.position =
           tier4_autoware_utils::createPoint(lanelet_p.x(), lanelet_p.y(), lanelet_p.z());
-        const double lane_yaw = lanelet::utils::getLaneletAngle(lanelet, current_p.position);
-        current_p.orientation = tier4_autoware_utils::createQuaternionFromYaw(lane_yaw);
+        current_p.orientation = tier4_autoware_utils::createQuaternionFromYaw(lane_yaws.at(i));
 
         // Prevent from inserting same points
         if (!converted_path.empty()) {
@@ -1264,7 +1303,12 @@ PosePath MapBasedPredictionNode::resamplePath(const PosePath & base_path) const
     base_x.at(i) = base_path.at(i).position.x;
     base_y.at(i) = base_path.at(i).position.y;
     base_z.at(i) = base_path.at(i).position.z;
-    base_s.at(i) = motion_utils::calcSignedArcLength(base_path, 0, i);
+    // accumulated in the same order as motion_utils::calcSignedArcLength(base_path, 0, i)
+    if (0 < i) {
+      const double segment_length =
+        tier4_autoware_utils::calcDistance2d(base_path.at(i - 1), base_path.at(i));
+      base_s.at(i) = base_s.at(i - 1) + segment_length;
+    }
   }
   const double base_path_len = base_s.back();
 
@@ -24,11 +24,15 @@
 #include <autoware_auto_perception_msgs/msg/detected_object.hpp>
 #include <autoware_auto_perception_msgs/msg/shape.hpp>
 #include <autoware_auto_perception_msgs/msg/tracked_object.hpp>
+#include <geometry_msgs/msg/point.hpp>
 #include <geometry_msgs/msg/polygon.hpp>
 #include <geometry_msgs/msg/vector3.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 namespace utils
@@ -71,6 +75,70 @@ enum MSG_COV_IDX {
   YAW_PITCH = 34,
   YAW_YAW = 35
 };
+
+/**
+ * @brief Indices of 2d points sorted by square cells, to find the points near a position
+ * without comparing all the pairs
+ */
+class PointGrid
+{
+public:
+  explicit PointGrid(const double cell_size) : cell_size_(cell_size) {}
+
+  /**
+   * @brief Add a point. The points which are not finite are ignored.
+   * @param point Position of the point
+   * @param index Index given back by forEachNeighbor
+   */
+  void add(const geometry_msgs::msg::Point & point, const size_t index)
+  {
+    if (std::isfinite(point.x) && std::isfinite(point.y)) {
+      cells_.emplace_back(toKey(toCell(point.x), toCell(point.y)), index);
+    }
+  }
+
+  /**
+   * @brief Sort the points by cell, once all the points are added
+   */
+  void build() { std::sort(cells_.begin(), cells_.end()); }
+
+  /**
+   * @brief Call func(index) for the points in the 3x3 cells around a position, which include all
+   * the points within cell_size of it. The indices of a cell are given in increasing order.
+   */
+  template <class Func>
+  void forEachNeighbor(const geometry_msgs::msg::Point & point, Func && func) const
+  {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y)) {
+      return;
+    }
+    const int64_t cell_x = toCell(point.x);
+    const int64_t cell_y = toCell(point.y);
+    for (int64_t neighbor_x = cell_x - 1; neighbor_x <= cell_x + 1; ++neighbor_x) {
+      for (int64_t neighbor_y = cell_y - 1; neighbor_y <= cell_y + 1; ++neighbor_y) {
+        const uint64_t key = toKey(neighbor_x, neighbor_y);
+        const auto first = std::make_pair(key, size_t{0});
+        for (auto itr = std::lower_bound(cells_.begin(), cells_.end(), first);
+             itr != cells_.end() && itr->first == key; ++itr) {
+          func(itr->second);
+        }
+      }
+    }
+  }
+
+private:
+  int64_t toCell(const double value) const
+  {
+    return static_cast<int64_t>(std::floor(value / cell_size_));
+  }
+  static uint64_t toKey(const int64_t cell_x, const int64_t cell_y)
+  {
+    return (static_cast<uint64_t>(cell_x) << 32) | static_cast<uint32_t>(cell_y);
+  }
+
+  double cell_size_;
+  std::vector<std::pair<uint64_t /*cell key*/, size_t /*index*/>> cells_;
+};
 }  // namespace utils
 
 #endif  // MULTI_OBJECT_TRACKER__UTILS__UTILS_HPP_
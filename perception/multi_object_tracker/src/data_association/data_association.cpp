@@ -19,9 +19,10 @@
 #include "perception_utils/perception_utils.hpp"
 
 #include <algorithm>
-#include <list>
 #include <memory>
+#include <numeric>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace
@@ -115,21 +116,77 @@ DataAssociation::DataAssociation(
 }
 
 void DataAssociation::assign(
-  const Eigen::MatrixXd & src, std::unordered_map<int, int> & direct_assignment,
+  const Eigen::SparseMatrix<double> & src, std::unordered_map<int, int> & direct_assignment,
   std::unordered_map<int, int> & reverse_assignment)
 {
-  std::vector<std::vector<double>> score(src.rows());
-  for (int row = 0; row < src.rows(); ++row) {
-    score.at(row).resize(src.cols());
-    for (int col = 0; col < src.cols(); ++col) {
-      score.at(row).at(col) = src(row, col);
+  // The trackers and measurements linked by a score are split into connected components, and the
+  // assignment is solved on each of them, since the matching does not cross the components.
+  // The nodes are the trackers [0, rows) and the measurements [rows, rows + cols).
+  const int num_trackers = static_cast<int>(src.rows());
+  const int num_nodes = num_trackers + static_cast<int>(src.cols());
+  std::vector<int> parents(num_nodes);
+  std::iota(parents.begin(), parents.end(), 0);
+  const auto find_root = [&parents](int node) {
+    while (parents[node] != node) {
+      parents[node] = parents[parents[node]];
+      node = parents[node];
+    }
+    return node;
+  };
+  std::vector<bool> has_score(num_nodes, false);
+  for (int col = 0; col < src.outerSize(); ++col) {
+    for (Eigen::SparseMatrix<double>::InnerIterator it(src, col); it; ++it) {
+      const int tracker_node = static_cast<int>(it.row());
+      const int measurement_node = num_trackers + col;
+      has_score[tracker_node] = has_score[measurement_node] = true;
+      parents[find_root(tracker_node)] = find_root(measurement_node);
+    }
+  }
+
+  // trackers and measurements of every component, and their indices in the component
+  std::vector<int> component_of_root(num_nodes, -1);
+  std::vector<std::pair<std::vector<int>, std::vector<int>>> components;
+  std::vector<int> local_indices(num_nodes);
+  for (int node = 0; node < num_nodes; ++node) {
+    if (!has_score[node]) {
+      continue;
+    }
+    int & component_idx = component_of_root[find_root(node)];
+    if (component_idx < 0) {
+      component_idx = static_cast<int>(components.size());
+      components.emplace_back();
+    }
+    auto & nodes = node < num_trackers ? components[component_idx].first
+                                       : components[component_idx].second;
+    local_indices[node] = static_cast<int>(nodes.size());
+    nodes.push_back(node < num_trackers ? node : node - num_trackers);
+  }
+
+  std::vector<std::vector<double>> score;
+  for (int component_idx = 0; component_idx < static_cast<int>(components.size());
+       ++component_idx) {
+    const auto & trackers = components[component_idx].first;
+    const auto & measurements = components[component_idx].second;
+    score.assign(trackers.size(), std::vector<double>(measurements.size(), 0.0));
+    for (const int col : measurements) {
+      for (Eigen::SparseMatrix<double>::InnerIterator it(src, col); it; ++it) {
+        score.at(local_indices[it.row()]).at(local_indices[num_trackers + col]) = it.value();
+      }
+    }
+    // Solve
+    std::unordered_map<int, int> local_direct_assignment, local_reverse_assignment;
+    gnn_solver_ptr_->maximizeLinearAssignment(
+      score, &local_direct_assignment, &local_reverse_assignment);
+    for (const auto & [tracker_idx, measurement_idx] : local_direct_assignment) {
+      direct_assignment.emplace(trackers.at(tracker_idx), measurements.at(measurement_idx));
+    }
+    for (const auto & [measurement_idx, tracker_idx] : local_reverse_assignment) {
+      reverse_assignment.emplace(measurements.at(measurement_idx), trackers.at(tracker_idx));
     }
   }
-  // Solve
-  gnn_solver_ptr_->maximizeLinearAssignment(score, &direct_assignment, &reverse_assignment);
 
   for (auto itr = direct_assignment.begin(); itr != direct_assignment.end();) {
-    if (src(itr->first, itr->second) < score_threshold_) {
+    if (src.coeff(itr->first, itr->second) < score_threshold_) {
       itr = direct_assignment.erase(itr);
       continue;
     } else {
@@ -137,7 +194,7 @@ void DataAssociation::assign(
     }
   }
   for (auto itr = reverse_assignment.begin(); itr != reverse_assignment.end();) {
-    if (src(itr->second, itr->first) < score_threshold_) {
+    if (src.coeff(itr->second, itr->first) < score_threshold_) {
       itr = reverse_assignment.erase(itr);
       continue;
     } else {
@@ -146,79 +203,112 @@ void DataAssociation::assign(
   }
 }
 
-Eigen::MatrixXd DataAssociation::calcScoreMatrix(
+Eigen::SparseMatrix<double> DataAssociation::calcScoreMatrix(
   const autoware_auto_perception_msgs::msg::DetectedObjects & measurements,
-  const std::list<std::shared_ptr<Tracker>> & trackers)
+  const std::vector<std::shared_ptr<Tracker>> & trackers)
 {
-  Eigen::MatrixXd score_matrix =
-    Eigen::MatrixXd::Zero(trackers.size(), measurements.objects.size());
-  size_t tracker_idx = 0;
-  for (auto tracker_itr = trackers.begin(); tracker_itr != trackers.end();
-       ++tracker_itr, ++tracker_idx) {
-    const std::uint8_t tracker_label = (*tracker_itr)->getHighestProbLabel();
-
-    for (size_t measurement_idx = 0; measurement_idx < measurements.objects.size();
-         ++measurement_idx) {
-      const autoware_auto_perception_msgs::msg::DetectedObject & measurement_object =
-        measurements.objects.at(measurement_idx);
-      const std::uint8_t measurement_label =
-        perception_utils::getHighestProbLabel(measurement_object.classification);
-
-      double score = 0.0;
-      if (can_assign_matrix_(tracker_label, measurement_label)) {
-        autoware_auto_perception_msgs::msg::TrackedObject tracked_object;
-        (*tracker_itr)->getTrackedObject(measurements.header.stamp, tracked_object);
-
-        const double max_dist = max_dist_matrix_(tracker_label, measurement_label);
-        const double dist = tier4_autoware_utils::calcDistance2d(
-          measurement_object.kinematics.pose_with_covariance.pose.position,
-          tracked_object.kinematics.pose_with_covariance.pose.position);
-
-        bool passed_gate = true;
-        // dist gate
-        if (passed_gate) {
-          if (max_dist < dist) passed_gate = false;
-        }
-        // area gate
-        if (passed_gate) {
-          const double max_area = max_area_matrix_(tracker_label, measurement_label);
-          const double min_area = min_area_matrix_(tracker_label, measurement_label);
-          const double area = tier4_autoware_utils::getArea(measurement_object.shape);
-          if (area < min_area || max_area < area) passed_gate = false;
-        }
-        // angle gate
-        if (passed_gate) {
-          const double max_rad = max_rad_matrix_(tracker_label, measurement_label);
-          const double angle = getFormedYawAngle(
-            measurement_object.kinematics.pose_with_covariance.pose.orientation,
-            tracked_object.kinematics.pose_with_covariance.pose.orientation, false);
-          if (std::fabs(max_rad) < M_PI && std::fabs(max_rad) < std::fabs(angle))
-            passed_gate = false;
-        }
-        // mahalanobis dist gate
-        if (passed_gate) {
-          const double mahalanobis_dist = getMahalanobisDistance(
-            measurement_object.kinematics.pose_with_covariance.pose.position,
-            tracked_object.kinematics.pose_with_covariance.pose.position,
-            getXYCovariance(tracked_object.kinematics.pose_with_covariance));
-          if (2.448 /*95%*/ <= mahalanobis_dist) passed_gate = false;
+  Eigen::SparseMatrix<double> score_matrix(trackers.size(), measurements.objects.size());
+  const double cell_size = max_dist_matrix_.maxCoeff();
+  if (trackers.empty() || measurements.objects.empty() || cell_size <= 0.0) {
+    return score_matrix;
+  }
+
+  // The measurements are bucketed by cells as large as the largest distance gate, so that only
+  // the measurements in the 3x3 cells around a tracker can pass its distance gate.
+  utils::PointGrid measurement_grid(cell_size);
+  std::vector<std::uint8_t> measurement_labels(measurements.objects.size());
+  for (size_t measurement_idx = 0; measurement_idx < measurements.objects.size();
+       ++measurement_idx) {
+    const auto & measurement_object = measurements.objects.at(measurement_idx);
+    measurement_labels.at(measurement_idx) =
+      perception_utils::getHighestProbLabel(measurement_object.classification);
+    measurement_grid.add(
+      measurement_object.kinematics.pose_with_covariance.pose.position, measurement_idx);
+  }
+  measurement_grid.build();
+
+  std::vector<Eigen::Triplet<double>> scores;
+  for (size_t tracker_idx = 0; tracker_idx < trackers.size(); ++tracker_idx) {
+    const auto & tracker = trackers.at(tracker_idx);
+    const std::uint8_t tracker_label = tracker->getHighestProbLabel();
+
+    // predicted once for all the measurements
+    autoware_auto_perception_msgs::msg::TrackedObject tracked_object;
+    tracker->getTrackedObject(measurements.header.stamp, tracked_object);
+    measurement_grid.forEachNeighbor(
+      tracked_object.kinematics.pose_with_covariance.pose.position,
+      [&](const size_t measurement_idx) {
+        const std::uint8_t measurement_label = measurement_labels.at(measurement_idx);
+        if (!can_assign_matrix_(tracker_label, measurement_label)) {
+          return;
         }
-        // 2d iou gate
-        if (passed_gate) {
-          const double min_iou = min_iou_matrix_(tracker_label, measurement_label);
-          const double iou = perception_utils::get2dIoU(measurement_object, tracked_object);
-          if (iou < min_iou) passed_gate = false;
+        const double score = calcScore(
+          tracker_label, tracked_object, measurement_label,
+          measurements.objects.at(measurement_idx));
+        if (0.0 < score) {
+          scores.emplace_back(tracker_idx, measurement_idx, score);
         }
+      });
+  }
+  score_matrix.setFromTriplets(scores.begin(), scores.end());
 
-        // all gate is passed
-        if (passed_gate) {
-          score = (max_dist - std::min(dist, max_dist)) / max_dist;
-          if (score < score_threshold_) score = 0.0;
-        }
-      }
-      score_matrix(tracker_idx, measurement_idx) = score;
+  return score_matrix;
+}
+
+double DataAssociation::calcScore(
+  const std::uint8_t tracker_label,
+  const autoware_auto_perception_msgs::msg::TrackedObject & tracked_object,
+  const std::uint8_t measurement_label,
+  const autoware_auto_perception_msgs::msg::DetectedObject & measurement_object) const
+{
+  const double max_dist = max_dist_matrix_(tracker_label, measurement_label);
+  const double dist = tier4_autoware_utils::calcDistance2d(
+    measurement_object.kinematics.pose_with_covariance.pose.position,
+    tracked_object.kinematics.pose_with_covariance.pose.position);
+
+  // dist gate
+  if (max_dist < dist) {
+    return 0.0;
+  }
+  // area gate
+  {
+    const double max_area = max_area_matrix_(tracker_label, measurement_label);
+    const double min_area = min_area_matrix_(tracker_label, measurement_label);
+    const double area = tier4_autoware_utils::getArea(measurement_object.shape);
+    if (area < min_area || max_area < area) {
+      return 0.0;
+    }
+  }
+  // angle gate
+  {
+    const double max_rad = max_rad_matrix_(tracker_label, measurement_label);
+    const double angle = getFormedYawAngle(
+      measurement_object.kinematics.pose_with_covariance.pose.orientation,
+      tracked_object.kinematics.pose_with_covariance.pose.orientation, false);
+    if (std::fabs(max_rad) < M_PI && std::fabs(max_rad) < std::fabs(angle)) {
+      return 0.0;
+    }
+  }
+  // mahalanobis dist gate
+  {
+    const double mahalanobis_dist = getMahalanobisDistance(
+      measurement_object.kinematics.pose_with_covariance.pose.position,
+      tracked_object.kinematics.pose_with_covariance.pose.position,
+      getXYCovariance(tracked_object.kinematics.pose_with_covariance));
+    if (2.448 /*95%*/ <= mahalanobis_dist) {
+      return 0.0;
+    }
+  }
+  // 2d iou gate
+  {
+    const double min_iou = min_iou_matrix_(tracker_label, measurement_label);
+    const double iou = perception_utils::get2dIoU(measurement_object, tracked_object);
+    if (iou < min_iou) {
+      return 0.0;
     }
   }
 
-  return score_matrix;
+  // all gate is passed
+  const double score = (max_dist - std::min(dist, max_dist)) / max_dist;
+  return score < score_threshold_ ? 0.0 : score;
 }
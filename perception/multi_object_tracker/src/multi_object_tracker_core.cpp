@@ -19,8 +19,7 @@
 #include <tf2_ros/create_timer_interface.h>
 #include <tf2_ros/create_timer_ros.h>
 
-#include <iterator>
-#include <list>
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -182,11 +181,13 @@ MultiObjectTracker::MultiObjectTracker(const rclcpp::NodeOptions & node_options)
   data_association_ = std::make_unique<DataAssociation>(
     can_assign_matrix, max_dist_matrix, max_area_matrix, min_area_matrix, max_rad_matrix,
     min_iou_matrix);
+  latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
 }
 
 void MultiObjectTracker::onMeasurement(
   const autoware_auto_perception_msgs::msg::DetectedObjects::ConstSharedPtr input_objects_msg)
 {
+  const auto span = latency_tracer_->startSpan(input_objects_msg->header.stamp);
   const auto self_transform = getTransformAnonymous(
     tf_buffer_, "base_link", world_frame_id_, input_objects_msg->header.stamp);
   if (!self_transform) {
@@ -201,27 +202,25 @@ void MultiObjectTracker::onMeasurement(
   }
   /* tracker prediction */
   rclcpp::Time measurement_time = input_objects_msg->header.stamp;
-  for (auto itr = list_tracker_.begin(); itr != list_tracker_.end(); ++itr) {
-    (*itr)->predict(measurement_time);
+  for (const auto & tracker : list_tracker_) {
+    tracker->predict(measurement_time);
   }
 
   /* global nearest neighbor */
   std::unordered_map<int, int> direct_assignment, reverse_assignment;
-  Eigen::MatrixXd score_matrix = data_association_->calcScoreMatrix(
+  const auto score_matrix = data_association_->calcScoreMatrix(
     transformed_objects, list_tracker_);  // row : tracker, col : measurement
   data_association_->assign(score_matrix, direct_assignment, reverse_assignment);
 
   /* tracker measurement update */
-  int tracker_idx = 0;
-  for (auto tracker_itr = list_tracker_.begin(); tracker_itr != list_tracker_.end();
-       ++tracker_itr, ++tracker_idx) {
-    if (direct_assignment.find(tracker_idx) != direct_assignment.end()) {  // found
-      (*(tracker_itr))
-        ->updateWithMeasurement(
-          transformed_objects.objects.at(direct_assignment.find(tracker_idx)->second),
-          measurement_time);
+  for (size_t tracker_idx = 0; tracker_idx < list_tracker_.size(); ++tracker_idx) {
+    const auto & tracker = list_tracker_.at(tracker_idx);
+    const auto assignment = direct_assignment.find(tracker_idx);
+    if (assignment != direct_assignment.end()) {  // found
+      tracker->updateWithMeasurement(
+        transformed_objects.objects.at(assignment->second), measurement_time);
     } else {  // not found
-      (*(tracker_itr))->updateWithoutMeasurement();
+      tracker->updateWithoutMeasurement();
     }
   }
 
@@ -243,6 +242,7 @@ void MultiObjectTracker::onMeasurement(
   if (publish_timer_ == nullptr) {
     publish(measurement_time);
   }
+  latency_tracer_->publishLatency(measurement_time);
 }
 
 std::shared_ptr<Tracker> MultiObjectTracker::createNewTracker(
@@ -291,37 +291,61 @@ void MultiObjectTracker::onTimer()
 }
 
 void MultiObjectTracker::checkTrackerLifeCycle(
-  std::list<std::shared_ptr<Tracker>> & list_tracker, const rclcpp::Time & time,
+  std::vector<std::shared_ptr<Tracker>> & list_tracker, const rclcpp::Time & time,
   const geometry_msgs::msg::Transform & self_transform)
 {
   /* params */
   constexpr float max_elapsed_time = 1.0;
 
   /* delete tracker */
-  for (auto itr = list_tracker.begin(); itr != list_tracker.end(); ++itr) {
-    const bool is_old = max_elapsed_time < (*itr)->getElapsedTimeFromLastUpdate(time);
-    const bool is_specific_alive_pattern = isSpecificAlivePattern(*itr, time, self_transform);
-    if (is_old && !is_specific_alive_pattern) {
-      auto erase_itr = itr;
-      --itr;
-      list_tracker.erase(erase_itr);
-    }
-  }
+  const auto is_dead = [&](const std::shared_ptr<Tracker> & tracker) {
+    const bool is_old = max_elapsed_time < tracker->getElapsedTimeFromLastUpdate(time);
+    return is_old && !isSpecificAlivePattern(tracker, time, self_transform);
+  };
+  list_tracker.erase(
+    std::remove_if(list_tracker.begin(), list_tracker.end(), is_dead), list_tracker.end());
 }
 
 void MultiObjectTracker::sanitizeTracker(
-  std::list<std::shared_ptr<Tracker>> & list_tracker, const rclcpp::Time & time)
+  std::vector<std::shared_ptr<Tracker>> & list_tracker, const rclcpp::Time & time)
 {
   constexpr float min_iou = 0.1;
   constexpr float min_iou_for_unknown_object = 0.001;
   constexpr double distance_threshold = 5.0;
+
+  // The trackers are predicted once, and only the pairs in neighbor grid cells as large as
+  // distance_threshold are compared, instead of all the pairs.
+  std::vector<autoware_auto_perception_msgs::msg::TrackedObject> objects(list_tracker.size());
+  utils::PointGrid grid(distance_threshold);
+  for (size_t i = 0; i < list_tracker.size(); ++i) {
+    list_tracker.at(i)->getTrackedObject(time, objects.at(i));
+    grid.add(objects.at(i).kinematics.pose_with_covariance.pose.position, i);
+  }
+  grid.build();
+
   /* delete collision tracker */
-  for (auto itr1 = list_tracker.begin(); itr1 != list_tracker.end(); ++itr1) {
-    autoware_auto_perception_msgs::msg::TrackedObject object1;
-    (*itr1)->getTrackedObject(time, object1);
-    for (auto itr2 = std::next(itr1); itr2 != list_tracker.end(); ++itr2) {
-      autoware_auto_perception_msgs::msg::TrackedObject object2;
-      (*itr2)->getTrackedObject(time, object2);
+  // The pairs are visited in the same order as comparing every tracker with the following ones,
+  // so that the same trackers are deleted.
+  std::vector<bool> is_deleted(list_tracker.size(), false);
+  std::vector<size_t> neighbors;
+  for (size_t i = 0; i < list_tracker.size(); ++i) {
+    if (is_deleted.at(i)) {
+      continue;
+    }
+    const auto & object1 = objects.at(i);
+    neighbors.clear();
+    grid.forEachNeighbor(object1.kinematics.pose_with_covariance.pose.position, [&](size_t j) {
+      if (i < j) {
+        neighbors.push_back(j);
+      }
+    });
+    std::sort(neighbors.begin(), neighbors.end());
+
+    for (const size_t j : neighbors) {
+      if (is_deleted.at(j)) {
+        continue;
+      }
+      const auto & object2 = objects.at(j);
       const double distance = std::hypot(
         object1.kinematics.pose_with_covariance.pose.position.x -
           object2.kinematics.pose_with_covariance.pose.position.x,
@@ -331,9 +355,11 @@ void MultiObjectTracker::sanitizeTracker(
         continue;
       }
 
+      const auto & tracker1 = list_tracker.at(i);
+      const auto & tracker2 = list_tracker.at(j);
       const auto iou = perception_utils::get2dIoU(object1, object2);
-      const auto & label1 = (*itr1)->getHighestProbLabel();
-      const auto & label2 = (*itr2)->getHighestProbLabel();
+      const auto & label1 = tracker1->getHighestProbLabel();
+      const auto & label2 = tracker2->getHighestProbLabel();
       bool should_delete_tracker1 = false;
       bool should_delete_tracker2 = false;
 
@@ -342,7 +368,7 @@ void MultiObjectTracker::sanitizeTracker(
       if (label1 == Label::UNKNOWN || label2 == Label::UNKNOWN) {
         if (min_iou_for_unknown_object < iou) {
           if (label1 == Label::UNKNOWN && label2 == Label::UNKNOWN) {
-            if ((*itr1)->getTotalMeasurementCount() < (*itr2)->getTotalMeasurementCount()) {
+            if (tracker1->getTotalMeasurementCount() < tracker2->getTotalMeasurementCount()) {
               should_delete_tracker1 = true;
             } else {
               should_delete_tracker2 = true;
@@ -355,7 +381,7 @@ void MultiObjectTracker::sanitizeTracker(
         }
       } else {  // If neither is UNKNOWN, delete the one with lower IOU.
         if (min_iou < iou) {
-          if ((*itr1)->getTotalMeasurementCount() < (*itr2)->getTotalMeasurementCount()) {
+          if (tracker1->getTotalMeasurementCount() < tracker2->getTotalMeasurementCount()) {
             should_delete_tracker1 = true;
           } else {
             should_delete_tracker2 = true;
@@ -364,15 +390,21 @@ void MultiObjectTracker::sanitizeTracker(
       }
 
       if (should_delete_tracker1) {
-        itr1 = list_tracker.erase(itr1);
-        --itr1;
+        is_deleted.at(i) = true;
         break;
       } else if (should_delete_tracker2) {
-        itr2 = list_tracker.erase(itr2);
-        --itr2;
+        is_deleted.at(j) = true;
       }
     }
   }
+
+  size_t num_trackers = 0;
+  for (size_t i = 0; i < list_tracker.size(); ++i) {
+    if (!is_deleted.at(i)) {
+      list_tracker.at(num_trackers++) = std::move(list_tracker.at(i));
+    }
+  }
+  list_tracker.resize(num_trackers);
 }
 
 inline bool MultiObjectTracker::shouldTrackerPublish(
@@ -396,12 +428,13 @@ void MultiObjectTracker::publish(const rclcpp::Time & time) const
   autoware_auto_perception_msgs::msg::TrackedObjects output_msg;
   output_msg.header.frame_id = world_frame_id_;
   output_msg.header.stamp = time;
-  for (auto itr = list_tracker_.begin(); itr != list_tracker_.end(); ++itr) {
-    if (!shouldTrackerPublish(*itr)) {
+  output_msg.objects.reserve(list_tracker_.size());
+  for (const auto & tracker : list_tracker_) {
+    if (!shouldTrackerPublish(tracker)) {
       continue;
     }
     autoware_auto_perception_msgs::msg::TrackedObject object;
-    (*itr)->getTrackedObject(time, object);
+    tracker->getTrackedObject(time, object);
     output_msg.objects.push_back(object);
   }
 
@@ -18,7 +18,9 @@
 #include "shape_estimation/model/model_interface.hpp"
 #include "shape_estimation/shape_estimator.hpp"
 
-#include <vector>
+#define EIGEN_MPL2_ONLY
+
+#include <Eigen/Core>
 
 class BoundingBoxShapeModel : public ShapeEstimationModelInterface
 {
@@ -27,11 +29,19 @@ private:
     const pcl::PointCloud<pcl::PointXYZ> & cluster, const float min_angle, const float max_angle,
     autoware_auto_perception_msgs::msg::Shape & shape_output,
     geometry_msgs::msg::Pose & pose_output);
-  float calcClosenessCriterion(const std::vector<float> & C_1, const std::vector<float> & C_2);
-  float optimize(
-    const pcl::PointCloud<pcl::PointXYZ> & cluster, const float min_angle, const float max_angle);
-  float boostOptimize(
-    const pcl::PointCloud<pcl::PointXYZ> & cluster, const float min_angle, const float max_angle);
+  void project(
+    const float cos_theta, const float sin_theta, Eigen::ArrayXf & C_1,
+    Eigen::ArrayXf & C_2) const;
+  float calcClosenessCriterion(const float theta);
+  float optimize(const float min_angle, const float max_angle);
+  float boostOptimize(const float min_angle, const float max_angle);
+
+  // x and y of the points of the cluster, and buffers of the criterion
+  Eigen::ArrayXf x_;
+  Eigen::ArrayXf y_;
+  Eigen::ArrayXf C_1_;
+  Eigen::ArrayXf C_2_;
+  Eigen::ArrayXf D_;
 
 public:
   BoundingBoxShapeModel();
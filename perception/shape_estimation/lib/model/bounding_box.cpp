@@ -87,33 +87,34 @@ bool BoundingBoxShapeModel::fitLShape(
    * Authors : Xio Zhang, Wenda Xu, Chiyu Dong and John M. Dolan
    */
 
+  // the points are projected as arrays, so that the projections and reductions are vectorized
+  x_.resize(cluster.size());
+  y_.resize(cluster.size());
+  for (size_t i = 0; i < cluster.size(); ++i) {
+    x_[i] = cluster[i].x;
+    y_[i] = cluster[i].y;
+  }
+
   // Paper : Algo.2 Search-Based Rectangle Fitting
   double theta_star;
   if (use_boost_bbox_optimizer_) {
-    theta_star = boostOptimize(cluster, min_angle, max_angle);
+    theta_star = boostOptimize(min_angle, max_angle);
   } else {
-    theta_star = optimize(cluster, min_angle, max_angle);
+    theta_star = optimize(min_angle, max_angle);
   }
 
   const float sin_theta_star = std::sin(theta_star);
   const float cos_theta_star = std::cos(theta_star);
 
   Eigen::Vector2f e_1_star;  // col.11, Algo.2
-  Eigen::Vector2f e_2_star;
   e_1_star << cos_theta_star, sin_theta_star;
-  e_2_star << -sin_theta_star, cos_theta_star;
-  std::vector<float> C_1_star;  // col.11, Algo.2
-  std::vector<float> C_2_star;  // col.11, Algo.2
-  for (const auto & point : cluster) {
-    C_1_star.push_back(point.x * e_1_star.x() + point.y * e_1_star.y());
-    C_2_star.push_back(point.x * e_2_star.x() + point.y * e_2_star.y());
-  }
+  project(cos_theta_star, sin_theta_star, C_1_, C_2_);  // col.11, Algo.2
 
   // col.12, Algo.2
-  const float min_C_1_star = *std::min_element(C_1_star.begin(), C_1_star.end());
-  const float max_C_1_star = *std::max_element(C_1_star.begin(), C_1_star.end());
-  const float min_C_2_star = *std::min_element(C_2_star.begin(), C_2_star.end());
-  const float max_C_2_star = *std::max_element(C_2_star.begin(), C_2_star.end());
+  const float min_C_1_star = C_1_.minCoeff();
+  const float max_C_1_star = C_1_.maxCoeff();
+  const float min_C_2_star = C_2_.minCoeff();
+  const float max_C_2_star = C_2_.maxCoeff();
 
   const float a_1 = cos_theta_star;
   const float b_1 = sin_theta_star;
@@ -162,88 +163,55 @@ bool BoundingBoxShapeModel::fitLShape(
   return true;
 }
 
-float BoundingBoxShapeModel::calcClosenessCriterion(
-  const std::vector<float> & C_1, const std::vector<float> & C_2)
+void BoundingBoxShapeModel::project(
+  const float cos_theta, const float sin_theta, Eigen::ArrayXf & C_1, Eigen::ArrayXf & C_2) const
+{
+  // projections to e_1 = (cos, sin) and e_2 = (-sin, cos)
+  C_1 = x_ * cos_theta + y_ * sin_theta;
+  C_2 = y_ * cos_theta - x_ * sin_theta;
+}
+
+float BoundingBoxShapeModel::calcClosenessCriterion(const float theta)
 {
+  project(std::cos(theta), std::sin(theta), C_1_, C_2_);  // col.3 - col.6, Algo.2
+
   // Paper : Algo.4 Closeness Criterion
-  const float min_c_1 = *std::min_element(C_1.begin(), C_1.end());  // col.2, Algo.4
-  const float max_c_1 = *std::max_element(C_1.begin(), C_1.end());  // col.2, Algo.4
-  const float min_c_2 = *std::min_element(C_2.begin(), C_2.end());  // col.3, Algo.4
-  const float max_c_2 = *std::max_element(C_2.begin(), C_2.end());  // col.3, Algo.4
-
-  std::vector<float> D_1;  // col.4, Algo.4
-  for (const auto & c_1_element : C_1) {
-    const float v = std::min(max_c_1 - c_1_element, c_1_element - min_c_1);
-    D_1.push_back(v * v);
-  }
+  const float min_c_1 = C_1_.minCoeff();  // col.2, Algo.4
+  const float max_c_1 = C_1_.maxCoeff();  // col.2, Algo.4
+  const float min_c_2 = C_2_.minCoeff();  // col.3, Algo.4
+  const float max_c_2 = C_2_.maxCoeff();  // col.3, Algo.4
+
+  // min of D_1 (col.4, Algo.4) and D_2 (col.5, Algo.4)
+  D_ = (max_c_1 - C_1_).min(C_1_ - min_c_1).square().min(
+    (max_c_2 - C_2_).min(C_2_ - min_c_2).square());
 
-  std::vector<float> D_2;  // col.5, Algo.4
-  for (const auto & c_2_element : C_2) {
-    const float v = std::min(max_c_2 - c_2_element, c_2_element - min_c_2);
-    D_2.push_back(v * v);
-  }
   constexpr float d_min = 0.1 * 0.1;
   constexpr float d_max = 0.4 * 0.4;
-  float beta = 0;  // col.6, Algo.4
-  for (size_t i = 0; i < D_1.size(); ++i) {
-    if (d_max < std::min(D_1.at(i), D_2.at(i))) {
-      continue;
-    }
-    const float d = std::max(std::min(D_1.at(i), D_2.at(i)), d_min);
-    beta += 1.0 / d;
-  }
-  return beta;
+  // col.6, Algo.4
+  return (D_ <= d_max).select(D_.max(d_min).inverse(), 0.0f).sum();
 }
 
-float BoundingBoxShapeModel::optimize(
-  const pcl::PointCloud<pcl::PointXYZ> & cluster, const float min_angle, const float max_angle)
+float BoundingBoxShapeModel::optimize(const float min_angle, const float max_angle)
 {
-  std::vector<std::pair<float /*theta*/, float /*q*/>> Q;
   constexpr float angle_resolution = M_PI / 180.0;
-  for (float theta = min_angle; theta <= max_angle + epsilon; theta += angle_resolution) {
-    Eigen::Vector2f e_1;
-    e_1 << std::cos(theta), std::sin(theta);  // col.3, Algo.2
-    Eigen::Vector2f e_2;
-    e_2 << -std::sin(theta), std::cos(theta);  // col.4, Algo.2
-    std::vector<float> C_1;                    // col.5, Algo.2
-    std::vector<float> C_2;                    // col.6, Algo.2
-    for (const auto & point : cluster) {
-      C_1.push_back(point.x * e_1.x() + point.y * e_1.y());
-      C_2.push_back(point.x * e_2.x() + point.y * e_2.y());
-    }
-    float q = calcClosenessCriterion(C_1, C_2);  // col.7, Algo.2
-    Q.push_back(std::make_pair(theta, q));       // col.8, Algo.2
-  }
-
   float theta_star{0.0};  // col.10, Algo.2
   float max_q = 0.0;
-  for (size_t i = 0; i < Q.size(); ++i) {
-    if (max_q < Q.at(i).second || i == 0) {
-      max_q = Q.at(i).second;
-      theta_star = Q.at(i).first;
+  bool is_first = true;
+  for (float theta = min_angle; theta <= max_angle + epsilon; theta += angle_resolution) {
+    const float q = calcClosenessCriterion(theta);  // col.7, Algo.2
+    if (max_q < q || is_first) {
+      max_q = q;
+      theta_star = theta;
+      is_first = false;
     }
   }
 
   return theta_star;
 }
 
-float BoundingBoxShapeModel::boostOptimize(
-  const pcl::PointCloud<pcl::PointXYZ> & cluster, const float min_angle, const float max_angle)
+float BoundingBoxShapeModel::boostOptimize(const float min_angle, const float max_angle)
 {
-  auto closeness_func = [&](float theta) {
-    Eigen::Vector2f e_1;
-    e_1 << std::cos(theta), std::sin(theta);  // col.3, Algo.2
-    Eigen::Vector2f e_2;
-    e_2 << -std::sin(theta), std::cos(theta);  // col.4, Algo.2
-    std::vector<float> C_1;                    // col.5, Algo.2
-    std::vector<float> C_2;                    // col.6, Algo.2
-    for (const auto & point : cluster) {
-      C_1.push_back(point.x * e_1.x() + point.y * e_1.y());
-      C_2.push_back(point.x * e_2.x() + point.y * e_2.y());
-    }
-    float q = calcClosenessCriterion(C_1, C_2);
-    return -q;
-  };
+  auto closeness_func = [&](float theta) { return -calcClosenessCriterion(theta); };
 
   int bits = 6;
   boost::uintmax_t max_iter = 20;
@@ -29,8 +29,10 @@
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #endif
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 using Label = autoware_auto_perception_msgs::msg::ObjectClassification;
 
@@ -47,6 +49,7 @@ ShapeEstimationNode::ShapeEstimationNode(const rclcpp::NodeOptions & node_option
   use_vehicle_reference_yaw_ = declare_parameter("use_vehicle_reference_yaw", true);
   bool use_boost_bbox_optimizer = declare_parameter("use_boost_bbox_optimizer", false);
   RCLCPP_INFO(this->get_logger(), "using boost shape estimation : %d", use_boost_bbox_optimizer);
+  num_threads_ = std::max(static_cast<int>(declare_parameter("num_threads", 1)), 1);
   estimator_ =
     std::make_unique<ShapeEstimator>(use_corrector, use_filter, use_boost_bbox_optimizer);
 }
@@ -62,48 +65,59 @@ void ShapeEstimationNode::callback(const DetectedObjectsWithFeature::ConstShared
   DetectedObjectsWithFeature output_msg;
   output_msg.header = input_msg->header;
 
-  // Estimate shape for each object and pack msg
-  for (const auto & feature_object : input_msg->feature_objects) {
-    const auto & object = feature_object.object;
-    const auto & label = object.classification.front().label;
-    const auto & feature = feature_object.feature;
-    const bool is_vehicle = Label::CAR == label || Label::TRUCK == label || Label::BUS == label ||
-                            Label::TRAILER == label;
-
-    // convert ros to pcl
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cluster(new pcl::PointCloud<pcl::PointXYZ>);
-    pcl::fromROSMsg(feature.cluster, *cluster);
-
-    // check cluster data
-    if (cluster->empty()) {
-      continue;
-    }
-
-    // estimate shape and pose
-    autoware_auto_perception_msgs::msg::Shape shape;
-    geometry_msgs::msg::Pose pose;
-    boost::optional<ReferenceYawInfo> ref_yaw_info = boost::none;
-    if (use_vehicle_reference_yaw_ && is_vehicle) {
-      ref_yaw_info = ReferenceYawInfo{
-        static_cast<float>(tf2::getYaw(object.kinematics.pose_with_covariance.pose.orientation)),
-        tier4_autoware_utils::deg2rad(10)};
-    }
-    const bool estimated_success =
-      estimator_->estimateShapeAndPose(label, *cluster, ref_yaw_info, shape, pose);
+  // Estimate shape for each object, in parallel since the clusters are independent
+  const auto & feature_objects = input_msg->feature_objects;
+  const int num_objects = static_cast<int>(feature_objects.size());
+  std::vector<uint8_t> estimated_success(num_objects);
+  std::vector<autoware_auto_perception_msgs::msg::Shape> shapes(num_objects);
+  std::vector<geometry_msgs::msg::Pose> poses(num_objects);
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (int i = 0; i < num_objects; ++i) {
+    estimated_success[i] = estimateObjectShape(feature_objects[i], shapes[i], poses[i]);
+  }
 
-    // If the shape estimation fails, ignore it.
-    if (!estimated_success) {
+  // Pack msg in the input order. If the shape estimation fails, ignore it.
+  for (int i = 0; i < num_objects; ++i) {
+    if (!estimated_success[i]) {
       continue;
     }
-
-    output_msg.feature_objects.push_back(feature_object);
-    output_msg.feature_objects.back().object.shape = shape;
-    output_msg.feature_objects.back().object.kinematics.pose_with_covariance.pose = pose;
+    output_msg.feature_objects.push_back(feature_objects[i]);
+    output_msg.feature_objects.back().object.shape = shapes[i];
+    output_msg.feature_objects.back().object.kinematics.pose_with_covariance.pose = poses[i];
   }
 
   // Publish
   pub_->publish(output_msg);
 }
 
+bool ShapeEstimationNode::estimateObjectShape(
+  const tier4_perception_msgs::msg::DetectedObjectWithFeature & feature_object,
+  autoware_auto_perception_msgs::msg::Shape & shape, geometry_msgs::msg::Pose & pose)
+{
+  const auto & object = feature_object.object;
+  const auto & label = object.classification.front().label;
+  const auto & feature = feature_object.feature;
+  const bool is_vehicle = Label::CAR == label || Label::TRUCK == label || Label::BUS == label ||
+                          Label::TRAILER == label;
+
+  // convert ros to pcl
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cluster(new pcl::PointCloud<pcl::PointXYZ>);
+  pcl::fromROSMsg(feature.cluster, *cluster);
+
+  // check cluster data
+  if (cluster->empty()) {
+    return false;
+  }
+
+  // estimate shape and pose
+  boost::optional<ReferenceYawInfo> ref_yaw_info = boost::none;
+  if (use_vehicle_reference_yaw_ && is_vehicle) {
+    ref_yaw_info = ReferenceYawInfo{
+      static_cast<float>(tf2::getYaw(object.kinematics.pose_with_covariance.pose.orientation)),
+      tier4_autoware_utils::deg2rad(10)};
+  }
+  return estimator_->estimateShapeAndPose(label, *cluster, ref_yaw_info, shape, pose);
+}
+
 #include <rclcpp_components/register_node_macro.hpp>
 RCLCPP_COMPONENTS_REGISTER_NODE(ShapeEstimationNode)
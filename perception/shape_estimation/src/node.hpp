@@ -23,6 +23,7 @@
 #include <tier4_perception_msgs/msg/detected_objects_with_feature.hpp>
 
 #include <memory>
+#include <vector>
 
 using autoware_auto_perception_msgs::msg::DetectedObjects;
 using tier4_perception_msgs::msg::DetectedObjectsWithFeature;
@@ -34,9 +35,13 @@ private:
   rclcpp::Subscription<DetectedObjectsWithFeature>::SharedPtr sub_;
 
   void callback(const DetectedObjectsWithFeature::ConstSharedPtr input_msg);
+  bool estimateObjectShape(
+    const tier4_perception_msgs::msg::DetectedObjectWithFeature & feature_object,
+    autoware_auto_perception_msgs::msg::Shape & shape, geometry_msgs::msg::Pose & pose);
 
   std::unique_ptr<ShapeEstimator> estimator_;
   bool use_vehicle_reference_yaw_;
+  int num_threads_;
 
 public:
   explicit ShapeEstimationNode(const rclcpp::NodeOptions & node_options);
@@ -19,6 +19,7 @@
 #include "behavior_velocity_planner/planner_manager.hpp"
 
 #include <rclcpp/rclcpp.hpp>
+#include <tier4_autoware_utils/ros/latency_tracer.hpp>
 
 #include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
 #include <autoware_auto_perception_msgs/msg/predicted_objects.hpp>
@@ -96,6 +97,8 @@ private:
   rclcpp::Publisher<autoware_auto_planning_msgs::msg::Path>::SharedPtr path_pub_;
   rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticStatus>::SharedPtr stop_reason_diag_pub_;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr debug_viz_pub_;
+  // keyed by the sensor stamp of the predicted objects used for the path
+  std::unique_ptr<tier4_autoware_utils::LatencyTracer> latency_tracer_;
 
   void publishDebugMarker(const autoware_auto_planning_msgs::msg::Path & path);
 
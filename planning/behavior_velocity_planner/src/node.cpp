@@ -155,6 +155,7 @@ BehaviorVelocityPlannerNode::BehaviorVelocityPlannerNode(const rclcpp::NodeOptio
   stop_reason_diag_pub_ =
     this->create_publisher<diagnostic_msgs::msg::DiagnosticStatus>("~/output/stop_reason", 1);
   debug_viz_pub_ = this->create_publisher<visualization_msgs::msg::MarkerArray>("~/debug/path", 1);
+  latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
 
   // Parameters
   forward_path_length_ = this->declare_parameter("forward_path_length", 1000.0);
@@ -416,11 +417,14 @@ void BehaviorVelocityPlannerNode::onTrigger(
     return;
   }
 
+  const rclcpp::Time sensor_stamp = planner_data.predicted_objects->header.stamp;
+  const auto span = latency_tracer_->startSpan(sensor_stamp);
   const autoware_auto_planning_msgs::msg::Path output_path_msg =
     generatePath(input_path_msg, planner_data);
 
   path_pub_->publish(output_path_msg);
   stop_reason_diag_pub_->publish(planner_manager_.getStopReasonDiag());
+  latency_tracer_->publishLatency(sensor_stamp);
 
   if (debug_viz_pub_->get_subscription_count() > 0) {
     publishDebugMarker(output_path_msg);
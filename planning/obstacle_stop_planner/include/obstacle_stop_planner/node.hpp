@@ -27,6 +27,7 @@
 #include <rclcpp/rclcpp.hpp>
 #include <signal_processing/lowpass_filter_1d.hpp>
 #include <tier4_autoware_utils/math/unit_conversion.hpp>
+#include <tier4_autoware_utils/ros/latency_tracer.hpp>
 #include <tier4_autoware_utils/tier4_autoware_utils.hpp>
 #include <vehicle_info_util/vehicle_info_util.hpp>
 
@@ -184,6 +185,8 @@ private:
 
   std::unique_ptr<motion_planning::AdaptiveCruiseController> acc_controller_;
   std::shared_ptr<ObstacleStopPlannerDebugNode> debug_ptr_;
+  // keyed by the sensor stamp of the obstacle pointcloud used for the trajectory
+  std::unique_ptr<tier4_autoware_utils::LatencyTracer> latency_tracer_;
   std::shared_ptr<LowpassFilter1d> lpf_acc_{nullptr};
   boost::optional<StopPoint> latest_stop_point_{boost::none};
   boost::optional<SlowDownSection> latest_slow_down_section_{boost::none};
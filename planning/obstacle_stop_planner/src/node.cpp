@@ -520,6 +520,7 @@ ObstacleStopPlannerNode::ObstacleStopPlannerNode(const rclcpp::NodeOptions & nod
 
   // Publishers
   path_pub_ = this->create_publisher<Trajectory>("~/output/trajectory", 1);
+  latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
   stop_reason_diag_pub_ =
     this->create_publisher<diagnostic_msgs::msg::DiagnosticStatus>("~/output/stop_reason", 1);
   pub_clear_velocity_limit_ = this->create_publisher<VelocityLimitClearCommand>(
@@ -627,6 +628,8 @@ void ObstacleStopPlannerNode::pathCallback(const Trajectory::ConstSharedPtr inpu
     return;
   }
 
+  const rclcpp::Time sensor_stamp = obstacle_ros_pointcloud_ptr->header.stamp;
+  const auto span = latency_tracer_->startSpan(sensor_stamp);
   PlannerData planner_data{};
 
   getSelfPose(input_msg->header, tf_buffer_, planner_data.current_pose);
@@ -667,6 +670,7 @@ void ObstacleStopPlannerNode::pathCallback(const Trajectory::ConstSharedPtr inpu
 
   trajectory.header = input_msg->header;
   path_pub_->publish(trajectory);
+  latency_tracer_->publishLatency(sensor_stamp);
 }
 
 void ObstacleStopPlannerNode::searchObstacle(
@@ -0,0 +1,124 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__CONCATENATE_DATA__CLOUD_SYNCHRONIZER_HPP_
+#define POINTCLOUD_PREPROCESSOR__CONCATENATE_DATA__CLOUD_SYNCHRONIZER_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+/** \brief @b CloudSynchronizer gathers one point cloud per sensor into frames. Every sensor has
+ * a slot in the current frame, which is closed as soon as all the slots are filled, or when the
+ * learned deadline of the missing sensors passes. A sensor delivering again in the same frame
+ * closes it, and its new cloud opens the next frame.
+ *
+ * The deadline is learned from the observed arrival offset of each sensor relative to the first
+ * arrival of the frame, plus a margin. It is never later than one learned period of the missing
+ * sensors, whose next cloud belongs to the next frame, nor than the timeout.
+ *
+ * The synchronizer has no thread of its own: the owner takes the closed frames after every push()
+ * and at the deadline given by getTimeToDeadline(), e.g. from a timer of its executor. The frames
+ * are guarded by a single mutex, held only to store a cloud or to take the frames, so that the
+ * conversions of the sensor callbacks run without it. push() may be called concurrently for
+ * different sensors, but not for the same sensor.
+ */
+class CloudSynchronizer
+{
+public:
+  using PointCloud2ConstPtr = sensor_msgs::msg::PointCloud2::ConstSharedPtr;
+  /** \brief One cloud per sensor, nullptr if the sensor missed the frame. */
+  using Frame = std::vector<PointCloud2ConstPtr>;
+
+  /** \brief Arrival statistics of a sensor, for diagnostics. */
+  struct SensorStatistics
+  {
+    double period_sec;
+    double expected_offset_sec;
+    double arrival_skew_sec;
+    uint64_t received;
+    uint64_t repeated;
+    uint64_t missed;
+  };
+
+  CloudSynchronizer(
+    const size_t num_sensors, const double timeout_sec, const double deadline_margin_sec);
+
+  CloudSynchronizer(const CloudSynchronizer &) = delete;
+  CloudSynchronizer & operator=(const CloudSynchronizer &) = delete;
+
+  /** \brief Store the cloud of a sensor in the current frame. If the sensor already delivered in
+   * this frame, the frame is closed first and the cloud opens the next one. */
+  void push(const size_t sensor_idx, const PointCloud2ConstPtr & cloud);
+
+  /** \brief Take the closed frames, oldest first. The current frame is closed first if its
+   * deadline has passed. */
+  std::vector<Frame> takeFrames();
+
+  /** \brief Time left until the deadline of the current frame, nullopt if no frame is open. */
+  std::optional<std::chrono::nanoseconds> getTimeToDeadline();
+
+  std::vector<SensorStatistics> getStatistics() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /** \brief Arrival model of a sensor. It is written under the mutex, and the counters
+   * are read by getStatistics() without it, hence the atomics. */
+  struct ArrivalModel
+  {
+    int64_t last_arrival_ns{0};
+    std::atomic<int64_t> period_ns{0};
+    std::atomic<int64_t> expected_offset_ns{0};
+    std::atomic<int64_t> arrival_skew_ns{0};
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> repeated{0};
+    std::atomic<uint64_t> missed{0};
+  };
+
+  /** \brief Number of arrivals before the learned offset is trusted for the deadline. */
+  static constexpr uint64_t min_samples_ = 10;
+
+  /** \brief Weight of the newest sample in the exponential moving averages. */
+  static constexpr double smoothing_ = 0.1;
+
+  const int64_t timeout_ns_;
+  const int64_t deadline_margin_ns_;
+  /** \brief Guards the slots, the state of the current frame and the closed frames. */
+  std::mutex mutex_;
+
+  Frame slots_;
+  std::vector<Frame> closed_frames_;
+  std::vector<ArrivalModel> models_;
+
+  /** \brief Arrival time of the first cloud of the current frame, 0 if no frame is open. */
+  int64_t frame_start_ns_{0};
+
+  static int64_t nowNs();
+  static int64_t smooth(const int64_t average, const int64_t sample);
+  bool isFrameComplete() const;
+  int64_t computeDeadlineNs() const;
+  void closeFrame();
+};
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__CONCATENATE_DATA__CLOUD_SYNCHRONIZER_HPP_
@@ -62,6 +62,8 @@
 
 // ROS includes
 #include "autoware_point_types/types.hpp"
+#include "pointcloud_preprocessor/concatenate_data/cloud_synchronizer.hpp"
+#include "pointcloud_preprocessor/concatenate_data/zero_copy_concatenator.hpp"
 
 #include <diagnostic_updater/diagnostic_updater.hpp>
 #include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
@@ -121,12 +123,15 @@ private:
   double timeout_sec_ = 0.1;
 
   std::set<std::string> not_subscribed_topic_names_;
+  std::mutex diagnostics_mutex_;
 
   /** \brief A vector of subscriber. */
   std::vector<rclcpp::Subscription<PointCloud2>::SharedPtr> filters_;
+  std::vector<rclcpp::CallbackGroup::SharedPtr> filter_callback_groups_;
 
   rclcpp::Subscription<autoware_auto_vehicle_msgs::msg::VelocityReport>::SharedPtr sub_twist_;
 
+  /** \brief Publishes at the timeout, or at the deadline of the frame of the synchronizer. */
   rclcpp::TimerBase::SharedPtr timer_;
   diagnostic_updater::Updater updater_{this};
 
@@ -150,11 +155,29 @@ private:
   std::vector<double> input_offset_;
   std::map<std::string, double> offset_map_;
 
+  /** \brief If true, the received clouds are kept as they are and concatenated in a single pass
+   * into one pre-sized output buffer instead of being copied and combined pairwise. */
+  bool use_zero_copy_concatenation_ = false;
+
+  /** \brief If true, the clouds are gathered by a CloudSynchronizer, which publishes a frame as
+   * soon as it is complete or when the learned deadline of the missing sensors passes, instead of
+   * by the timer. */
+  bool use_deadline_synchronizer_ = false;
+  double deadline_margin_sec_ = 0.01;
+
   void transformPointCloud(const PointCloud2::ConstSharedPtr & in, PointCloud2::SharedPtr & out);
+  bool lookupTransformMatrix(
+    const std::string & source_frame, const rclcpp::Time & stamp, Eigen::Matrix4f & matrix);
+  Eigen::Matrix4f computeMotionCompensation(
+    const rclcpp::Time & old_stamp, const rclcpp::Time & new_stamp);
   void combineClouds(
     const PointCloud2::ConstSharedPtr & in1, const PointCloud2::ConstSharedPtr & in2,
     PointCloud2::SharedPtr & out);
+  std::unique_ptr<PointCloud2> concatenateClouds();
+  std::unique_ptr<PointCloud2> concatenateCloudsZeroCopy();
   void publish();
+  sensor_msgs::msg::PointCloud2::ConstSharedPtr toConcatenationInput(
+    const sensor_msgs::msg::PointCloud2::ConstSharedPtr & input_ptr);
 
   void convertToXYZICloud(
     const sensor_msgs::msg::PointCloud2::SharedPtr & input_ptr,
@@ -163,14 +186,20 @@ private:
   void cloud_callback(
     const sensor_msgs::msg::PointCloud2::ConstSharedPtr & input_ptr,
     const std::string & topic_name);
+  void synchronized_cloud_callback(
+    const sensor_msgs::msg::PointCloud2::ConstSharedPtr & input_ptr, const size_t sensor_idx);
+  void publishFrames();
   void twist_callback(const autoware_auto_vehicle_msgs::msg::VelocityReport::ConstSharedPtr input);
   void timer_callback();
+  void deadline_timer_callback();
 
   void checkConcatStatus(diagnostic_updater::DiagnosticStatusWrapper & stat);
 
   /** \brief processing time publisher. **/
   std::unique_ptr<tier4_autoware_utils::StopWatch<std::chrono::milliseconds>> stop_watch_ptr_;
   std::unique_ptr<tier4_autoware_utils::DebugPublisher> debug_publisher_;
+
+  std::unique_ptr<CloudSynchronizer> synchronizer_;
 };
 
 }  // namespace pointcloud_preprocessor
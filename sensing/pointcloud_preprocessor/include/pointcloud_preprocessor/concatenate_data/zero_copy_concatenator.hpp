@@ -0,0 +1,53 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__CONCATENATE_DATA__ZERO_COPY_CONCATENATOR_HPP_
+#define POINTCLOUD_PREPROCESSOR__CONCATENATE_DATA__ZERO_COPY_CONCATENATOR_HPP_
+
+#include <Eigen/Core>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+/** \brief One input of the zero-copy concatenation. */
+struct ConcatenateSource
+{
+  /** \brief The received cloud. It is only read, never copied. */
+  sensor_msgs::msg::PointCloud2::ConstSharedPtr cloud;
+
+  /** \brief Transform from the cloud frame into the output frame, motion compensation included. */
+  Eigen::Matrix4f transform = Eigen::Matrix4f::Identity();
+};
+
+/** \brief Return true if the cloud has float32 x, y and z fields and a consistent data size. */
+bool isConcatenatable(const sensor_msgs::msg::PointCloud2 & cloud);
+
+/** \brief Concatenate all sources into a single XYZI cloud in one pass.
+ * The output buffer is sized once from the input widths, and every source is transformed straight
+ * into its own slice of that buffer (in parallel over the sources when OpenMP is available).
+ * Sources which do not satisfy isConcatenatable() are skipped.
+ * \param sources the clouds to concatenate together with their transforms
+ * \param frame_id the frame id of the output cloud
+ * \return the concatenated cloud, its stamp is left to the caller
+ */
+std::unique_ptr<sensor_msgs::msg::PointCloud2> concatenateXYZI(
+  const std::vector<ConcatenateSource> & sources, const std::string & frame_id);
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__CONCATENATE_DATA__ZERO_COPY_CONCATENATOR_HPP_
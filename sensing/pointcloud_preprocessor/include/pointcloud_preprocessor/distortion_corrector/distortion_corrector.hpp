@@ -39,9 +39,11 @@
 #include <tier4_autoware_utils/ros/debug_publisher.hpp>
 #include <tier4_autoware_utils/system/stop_watch.hpp>
 
+#include <array>
 #include <deque>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace pointcloud_preprocessor
 {
@@ -63,6 +65,8 @@ private:
     tf2::Transform * tf2_transform_ptr);
 
   bool undistortPointCloud(const tf2::Transform & tf2_base_link_to_sensor, PointCloud2 & points);
+  bool undistortPointCloudFastPath(
+    const tf2::Transform & tf2_base_link_to_sensor, PointCloud2 & points);
 
   rclcpp::Subscription<PointCloud2>::SharedPtr input_points_sub_;
   rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr imu_sub_;
@@ -81,6 +85,17 @@ private:
   std::string base_link_frame_ = "base_link";
   std::string time_stamp_field_name_;
   bool use_imu_;
+  bool use_fast_path_;
+  double time_slice_sec_;
+
+  /** \brief Consecutive points sharing one motion correction, stored as a row-major 3x4 matrix. */
+  struct TimeSlice
+  {
+    size_t begin;
+    size_t end;
+    std::array<float, 12> correction;
+  };
+  std::vector<TimeSlice> time_slices_;
 };
 
 }  // namespace pointcloud_preprocessor
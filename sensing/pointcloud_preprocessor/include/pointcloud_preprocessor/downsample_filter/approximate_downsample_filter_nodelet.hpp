@@ -51,6 +51,7 @@
 #ifndef POINTCLOUD_PREPROCESSOR__DOWNSAMPLE_FILTER__APPROXIMATE_DOWNSAMPLE_FILTER_NODELET_HPP_
 #define POINTCLOUD_PREPROCESSOR__DOWNSAMPLE_FILTER__APPROXIMATE_DOWNSAMPLE_FILTER_NODELET_HPP_
 
+#include "pointcloud_preprocessor/downsample_filter/radix_voxel_grid.hpp"
 #include "pointcloud_preprocessor/filter.hpp"
 
 #include <tier4_pcl_extensions/voxel_grid_nearest_centroid.hpp>
@@ -76,6 +77,11 @@ private:
   double voxel_size_y_;
   double voxel_size_z_;
 
+  /** \brief If true, the cloud is downsampled by RadixVoxelGrid instead of PCL. */
+  bool use_radix_voxel_grid_;
+  VoxelRepresentative voxel_representative_;
+  RadixVoxelGrid radix_voxel_grid_;
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
   explicit ApproximateDownsampleFilterComponent(const rclcpp::NodeOptions & options);
@@ -0,0 +1,84 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__DOWNSAMPLE_FILTER__RADIX_VOXEL_GRID_HPP_
+#define POINTCLOUD_PREPROCESSOR__DOWNSAMPLE_FILTER__RADIX_VOXEL_GRID_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+/** \brief The point a voxel is reduced to. */
+enum class VoxelRepresentative {
+  /** \brief The centroid of the voxel, output as x, y, z and the mean intensity. */
+  Centroid,
+  /** \brief The first point of the voxel in the input order, output with all its fields. */
+  FirstPoint,
+  /** \brief The point of the voxel nearest to its centroid, output with all its fields. */
+  NearestCentroid,
+};
+
+/** \brief Parse "centroid", "first_point" or "nearest_centroid". Return false for other names. */
+bool toVoxelRepresentative(const std::string & name, VoxelRepresentative & representative);
+
+/** \brief @b RadixVoxelGrid downsamples a PointCloud2 with a voxel grid, reading the points
+ * straight from the message bytes.
+ *
+ * The voxel key of every point is computed relative to the bounding box of the cloud, so it does
+ * not overflow as long as the number of voxels in the box fits in 62 bits. The (key, index) pairs
+ * are then ordered with a parallel LSD radix sort, each pass building per-thread histograms over
+ * contiguous chunks before a stable scatter, and the voxels are reduced in parallel. The sort is
+ * stable, so the points of a voxel stay in input order.
+ *
+ * The buffers are kept between calls, so that a filter running every cycle does not allocate once
+ * it has seen its largest cloud.
+ */
+class RadixVoxelGrid
+{
+public:
+  void setLeafSize(const float leaf_size_x, const float leaf_size_y, const float leaf_size_z);
+  void setRepresentative(const VoxelRepresentative representative);
+
+  /** \brief Downsample input into output, the header of the output is left to the caller.
+   * \return false if the input has no float32 x, y and z fields or if the voxel grid spanned by it
+   * is too large for the keys, output is then unchanged
+   */
+  bool filter(const sensor_msgs::msg::PointCloud2 & input, sensor_msgs::msg::PointCloud2 & output);
+
+private:
+  struct KeyIndex
+  {
+    uint64_t key;
+    uint32_t index;
+  };
+
+  float leaf_size_x_ = 0.3f;
+  float leaf_size_y_ = 0.3f;
+  float leaf_size_z_ = 0.1f;
+  VoxelRepresentative representative_ = VoxelRepresentative::Centroid;
+
+  std::vector<KeyIndex> entries_;
+  std::vector<KeyIndex> sort_buffer_;
+  std::vector<size_t> histograms_;
+  std::vector<size_t> voxel_begins_;
+
+  void radixSort(const int num_bits);
+};
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__DOWNSAMPLE_FILTER__RADIX_VOXEL_GRID_HPP_
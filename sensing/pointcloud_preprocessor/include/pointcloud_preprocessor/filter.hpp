@@ -79,6 +79,7 @@
 
 // Include tier4 autoware utils
 #include <tier4_autoware_utils/ros/debug_publisher.hpp>
+#include <tier4_autoware_utils/ros/latency_tracer.hpp>
 #include <tier4_autoware_utils/system/stop_watch.hpp>
 
 namespace pointcloud_preprocessor
@@ -177,6 +178,9 @@ protected:
   std::unique_ptr<tier4_autoware_utils::StopWatch<std::chrono::milliseconds>> stop_watch_ptr_;
   std::unique_ptr<tier4_autoware_utils::DebugPublisher> debug_publisher_;
 
+  /** \brief latency tracer of the input clouds. **/
+  std::unique_ptr<tier4_autoware_utils::LatencyTracer> latency_tracer_;
+
   /** \brief Virtual abstract filter method. To be implemented by every child.
    * \param input the input point cloud dataset.
    * \param indices a pointer to the vector of point indices to use.
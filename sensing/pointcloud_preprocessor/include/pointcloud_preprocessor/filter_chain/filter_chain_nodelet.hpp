@@ -0,0 +1,51 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__FILTER_CHAIN__FILTER_CHAIN_NODELET_HPP_
+#define POINTCLOUD_PREPROCESSOR__FILTER_CHAIN__FILTER_CHAIN_NODELET_HPP_
+
+#include "pointcloud_preprocessor/filter.hpp"
+#include "pointcloud_preprocessor/filter_chain/filter_stage.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+/** \brief @b FilterChainComponent runs an ordered list of filter stages in a single node.
+ * The stages share the input buffer and hand over the indices of the kept points, so the cloud is
+ * received, transformed and copied only once for the whole chain.
+ */
+class FilterChainComponent : public pointcloud_preprocessor::Filter
+{
+protected:
+  virtual void filter(
+    const PointCloud2ConstPtr & input, const IndicesPtr & indices, PointCloud2 & output);
+
+private:
+  /** \brief The stages with their names, in execution order. */
+  std::vector<std::pair<std::string, std::unique_ptr<FilterStage>>> stages_;
+
+  /** \brief The indices of the points kept so far, reused between frames. */
+  std::vector<uint32_t> kept_indices_;
+
+public:
+  PCL_MAKE_ALIGNED_OPERATOR_NEW
+  explicit FilterChainComponent(const rclcpp::NodeOptions & options);
+};
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__FILTER_CHAIN__FILTER_CHAIN_NODELET_HPP_
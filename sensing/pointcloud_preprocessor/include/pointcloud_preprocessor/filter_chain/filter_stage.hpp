@@ -0,0 +1,99 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__FILTER_CHAIN__FILTER_STAGE_HPP_
+#define POINTCLOUD_PREPROCESSOR__FILTER_CHAIN__FILTER_STAGE_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+/** \brief @b FilterStage is one step of a FilterChainComponent. Instead of producing a new cloud,
+ * a stage narrows down the indices of the points which are still kept, so that all the stages of
+ * a chain work on the same input buffer.
+ */
+class FilterStage
+{
+public:
+  virtual ~FilterStage() = default;
+
+  /** \brief Remove from indices the points rejected by this stage.
+   * \param cloud the input cloud shared by all the stages
+   * \param indices the sorted indices of the points kept by the previous stages
+   * \return false if the cloud does not have the fields required by the stage
+   */
+  virtual bool filter(
+    const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const = 0;
+};
+
+/** \brief Same as CropBoxFilterComponent. */
+class CropBoxStage : public FilterStage
+{
+public:
+  CropBoxStage(rclcpp::Node & node, const std::string & ns);
+  bool filter(
+    const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const override;
+
+private:
+  float min_x_;
+  float min_y_;
+  float min_z_;
+  float max_x_;
+  float max_y_;
+  float max_z_;
+  bool negative_;
+};
+
+/** \brief Same as RingOutlierFilterComponent, except that the kept points keep all their fields. */
+class RingOutlierStage : public FilterStage
+{
+public:
+  RingOutlierStage(rclcpp::Node & node, const std::string & ns);
+  bool filter(
+    const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const override;
+
+private:
+  double distance_ratio_;
+  double object_length_threshold_;
+  int num_points_threshold_;
+};
+
+/** \brief Keep the first point of every voxel, i.e. a voxel grid downsample without centroids.
+ * The points with a non-finite coordinate are removed. */
+class VoxelGridStage : public FilterStage
+{
+public:
+  VoxelGridStage(rclcpp::Node & node, const std::string & ns);
+  bool filter(
+    const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const override;
+
+private:
+  float voxel_size_x_;
+  float voxel_size_y_;
+  float voxel_size_z_;
+};
+
+/** \brief Create the stage of the given type, its parameters are declared under ns. Return nullptr
+ * for an unknown type. */
+std::unique_ptr<FilterStage> createFilterStage(
+  const std::string & type, rclcpp::Node & node, const std::string & ns);
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__FILTER_CHAIN__FILTER_STAGE_HPP_
@@ -0,0 +1,98 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__OUTLIER_FILTER__RING_OUTLIER_CLUSTERS_HPP_
+#define POINTCLOUD_PREPROCESSOR__OUTLIER_FILTER__RING_OUTLIER_CLUSTERS_HPP_
+
+#include <algorithm>
+#include <iterator>
+
+namespace pointcloud_preprocessor
+{
+/** \brief Fields of a point read by the ring outlier filter. */
+struct RingOutlierPoint
+{
+  float x;
+  float y;
+  float z;
+  float azimuth;
+  float distance;
+};
+
+/** \brief Parameters of the ring outlier filter. */
+struct RingOutlierParams
+{
+  double distance_ratio;
+  double object_length_threshold;
+  int num_points_threshold;
+};
+
+/** \brief Split the points of one ring, in scan order, into clusters of neighbouring points, and
+ * call keep(cluster_begin, cluster_end) for every cluster which is not an outlier. This is the
+ * logic shared by RingOutlierFilterComponent and RingOutlierStage.
+ * \param ring_begin the first index of the ring
+ * \param ring_end the end of the indices of the ring
+ * \param params the thresholds of the filter
+ * \param point_at returns the RingOutlierPoint of an index
+ * \param keep is called with the range of indices of every kept cluster
+ */
+template <class IndexIterator, class PointAt, class Keep>
+void forEachRingCluster(
+  const IndexIterator ring_begin, const IndexIterator ring_end, const RingOutlierParams & params,
+  const PointAt & point_at, const Keep & keep)
+{
+  if (std::distance(ring_begin, ring_end) < 2) {
+    return;
+  }
+
+  const auto is_cluster = [&](const IndexIterator cluster_begin, const IndexIterator cluster_end) {
+    const RingOutlierPoint front_pt = point_at(*cluster_begin);
+    const RingOutlierPoint back_pt = point_at(*std::prev(cluster_end));
+    const auto x_diff = front_pt.x - back_pt.x;
+    const auto y_diff = front_pt.y - back_pt.y;
+    const auto z_diff = front_pt.z - back_pt.z;
+    return static_cast<int>(std::distance(cluster_begin, cluster_end)) >
+             params.num_points_threshold ||
+           (x_diff * x_diff) + (y_diff * y_diff) + (z_diff * z_diff) >=
+             params.object_length_threshold * params.object_length_threshold;
+  };
+
+  const IndexIterator last = std::prev(ring_end);
+  IndexIterator cluster_begin = ring_begin;
+  for (IndexIterator it = ring_begin; it != last; ++it) {
+    const RingOutlierPoint current_pt = point_at(*it);
+    const RingOutlierPoint next_pt = point_at(*std::next(it));
+
+    float azimuth_diff = next_pt.azimuth - current_pt.azimuth;
+    azimuth_diff = azimuth_diff < 0.f ? azimuth_diff + 36000.f : azimuth_diff;
+
+    if (
+      std::max(current_pt.distance, next_pt.distance) <
+        std::min(current_pt.distance, next_pt.distance) * params.distance_ratio &&
+      azimuth_diff < 100.f) {
+      continue;
+    }
+    if (is_cluster(cluster_begin, std::next(it))) {
+      keep(cluster_begin, std::next(it));
+    }
+    cluster_begin = std::next(it);
+  }
+  // the last point of the ring is never part of a cluster
+  if (cluster_begin != last && is_cluster(cluster_begin, last)) {
+    keep(cluster_begin, last);
+  }
+}
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__OUTLIER_FILTER__RING_OUTLIER_CLUSTERS_HPP_
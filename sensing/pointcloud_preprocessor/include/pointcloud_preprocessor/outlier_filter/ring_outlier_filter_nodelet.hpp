@@ -17,6 +17,7 @@
 
 #include "autoware_point_types/types.hpp"
 #include "pointcloud_preprocessor/filter.hpp"
+#include "pointcloud_preprocessor/outlier_filter/ring_outlier_clusters.hpp"
 
 #include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
 
@@ -39,25 +40,28 @@ private:
   double object_length_threshold_;
   int num_points_threshold_;
 
+  /** \brief If true, the points are bucketed by ring into contiguous spans of a reused index
+   * arena, and the rings are processed in parallel. */
+  bool use_ring_spans_;
+
+  /** \brief Buffers reused between frames by filterRingSpans(). */
+  std::vector<std::size_t> ring_offsets_;
+  std::vector<std::size_t> ring_write_positions_;
+  std::vector<std::size_t> ring_arena_;
+  std::vector<uint8_t> keep_mask_;
+
   /** \brief Parameter service callback result : needed to be hold */
   OnSetParametersCallbackHandle::SharedPtr set_param_res_;
 
   /** \brief Parameter service callback */
   rcl_interfaces::msg::SetParametersResult paramCallback(const std::vector<rclcpp::Parameter> & p);
 
-  bool isCluster(
-    sensor_msgs::msg::PointCloud2::SharedPtr & input_ptr,
-    const std::vector<std::size_t> & tmp_indices)
-  {
-    PointXYZI * front_pt = reinterpret_cast<PointXYZI *>(&input_ptr->data[tmp_indices.front()]);
-    PointXYZI * back_pt = reinterpret_cast<PointXYZI *>(&input_ptr->data[tmp_indices.back()]);
+  void filterRingSpans(const PointCloud2ConstPtr & input, PointCloud2 & output);
+  void publishProcessingTime();
 
-    const auto x_diff = front_pt->x - back_pt->x;
-    const auto y_diff = front_pt->y - back_pt->y;
-    const auto z_diff = front_pt->z - back_pt->z;
-    return static_cast<int>(tmp_indices.size()) > num_points_threshold_ ||
-           (x_diff * x_diff) + (y_diff * y_diff) + (z_diff * z_diff) >=
-             object_length_threshold_ * object_length_threshold_;
+  RingOutlierParams getRingOutlierParams() const
+  {
+    return {distance_ratio_, object_length_threshold_, num_points_threshold_};
   }
 
 public:
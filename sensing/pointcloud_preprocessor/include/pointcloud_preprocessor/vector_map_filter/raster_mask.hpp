@@ -0,0 +1,125 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINTCLOUD_PREPROCESSOR__VECTOR_MAP_FILTER__RASTER_MASK_HPP_
+#define POINTCLOUD_PREPROCESSOR__VECTOR_MAP_FILTER__RASTER_MASK_HPP_
+
+#include <Eigen/Core>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+/** \brief @b TiledRasterMask is a bitmap of the area covered by a set of 2D polygons, e.g. the
+ * road lanelets, so that testing whether a point is inside the polygons is one bit lookup.
+ *
+ * The plane is split into square tiles of tile_cells x tile_cells cells, and only the tiles
+ * within radius of the last update() center are kept in memory. When the center moves, the tiles
+ * still in range are kept and only the new ones are rasterized, from the polygons whose bounding
+ * box overlaps them. A cell is set if its center is inside a polygon, so the mask is exact up to
+ * half a cell. The points outside the tiles in memory are tested against the polygons instead.
+ */
+class TiledRasterMask
+{
+public:
+  using Polygon = std::vector<Eigen::Vector2d>;
+
+  /** \brief Constructor.
+   * \param resolution the size of a cell [m]
+   * \param tile_cells the number of cells on a side of a tile, rounded up to a multiple of 64
+   * \param radius the distance from the center up to which the tiles are kept [m]
+   */
+  TiledRasterMask(const double resolution, const int tile_cells, const double radius);
+
+  /** \brief Replace the polygons, which drops all the tiles. */
+  void setPolygons(std::vector<Polygon> polygons);
+
+  /** \brief Rasterize the tiles around center which are not in memory yet.
+   * \return the number of rasterized tiles
+   */
+  size_t update(const Eigen::Vector2d & center);
+
+  /** \brief Return true if the cell of (x, y) is inside a polygon. Points outside the tiles kept
+   * by the last update() fall back to polygonsContain(), and non-finite points are reported as
+   * outside. */
+  bool contains(const double x, const double y) const
+  {
+    // the cast of a non-finite cell is undefined
+    if (!std::isfinite(x) || !std::isfinite(y)) {
+      return false;
+    }
+    const auto cell_x = static_cast<int64_t>(std::floor(x * inverse_resolution_));
+    const auto cell_y = static_cast<int64_t>(std::floor(y * inverse_resolution_));
+    const int64_t tile_x = floorDiv(cell_x, tile_cells_);
+    const int64_t tile_y = floorDiv(cell_y, tile_cells_);
+    const int64_t window_x = tile_x - window_min_tile_x_;
+    const int64_t window_y = tile_y - window_min_tile_y_;
+    if (window_x < 0 || window_y < 0 || window_x >= window_size_ || window_y >= window_size_) {
+      return polygonsContain(x, y);
+    }
+
+    const auto & bits = window_[window_y * window_size_ + window_x].bits;
+    if (bits.empty()) {
+      return false;
+    }
+    const int64_t bit =
+      (cell_y - tile_y * tile_cells_) * tile_cells_ + (cell_x - tile_x * tile_cells_);
+    return (bits[bit >> 6] >> (bit & 63)) & 1U;
+  }
+
+  /** \brief Return true if (x, y) is inside a polygon, testing the polygons whose bounding box
+   * contains it with the even-odd rule. This is exact, but much slower than a lookup. */
+  bool polygonsContain(const double x, const double y) const;
+
+private:
+  struct Tile
+  {
+    int64_t x = 0;
+    int64_t y = 0;
+    /** \brief Row-major bits of the cells, empty if no polygon overlaps the tile. */
+    std::vector<uint64_t> bits;
+  };
+
+  struct BoundingBox
+  {
+    Eigen::Vector2d min;
+    Eigen::Vector2d max;
+  };
+
+  double resolution_;
+  double inverse_resolution_;
+  int64_t tile_cells_;
+  double radius_;
+
+  std::vector<Polygon> polygons_;
+  std::vector<BoundingBox> bounding_boxes_;
+
+  /** \brief The tiles kept in memory, a window_size_ x window_size_ square of tiles. */
+  std::vector<Tile> window_;
+  int64_t window_min_tile_x_ = 0;
+  int64_t window_min_tile_y_ = 0;
+  int64_t window_size_ = 0;
+
+  static int64_t floorDiv(const int64_t value, const int64_t divisor)
+  {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+  }
+
+  void rasterizeTile(Tile & tile) const;
+};
+}  // namespace pointcloud_preprocessor
+
+#endif  // POINTCLOUD_PREPROCESSOR__VECTOR_MAP_FILTER__RASTER_MASK_HPP_
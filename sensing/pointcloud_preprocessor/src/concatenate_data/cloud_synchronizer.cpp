@@ -0,0 +1,165 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/concatenate_data/cloud_synchronizer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+CloudSynchronizer::CloudSynchronizer(
+  const size_t num_sensors, const double timeout_sec, const double deadline_margin_sec)
+: timeout_ns_(static_cast<int64_t>(timeout_sec * 1e9)),
+  deadline_margin_ns_(static_cast<int64_t>(deadline_margin_sec * 1e9)),
+  slots_(num_sensors),
+  models_(num_sensors)
+{
+}
+
+int64_t CloudSynchronizer::nowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch())
+    .count();
+}
+
+int64_t CloudSynchronizer::smooth(const int64_t average, const int64_t sample)
+{
+  return average + static_cast<int64_t>(smoothing_ * static_cast<double>(sample - average));
+}
+
+void CloudSynchronizer::push(const size_t sensor_idx, const PointCloud2ConstPtr & cloud)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int64_t now_ns = nowNs();
+  auto & model = models_.at(sensor_idx);
+
+  if (slots_.at(sensor_idx)) {
+    // The sensor already delivered in this frame, so the frame is late: it is closed with the older
+    // cloud, and the newer one opens the next frame
+    ++model.repeated;
+    closeFrame();
+  }
+
+  // The first cloud of a frame opens it
+  if (frame_start_ns_ == 0) {
+    frame_start_ns_ = now_ns;
+  }
+
+  // Learn the arrival offset within the frame and the period of the sensor
+  const int64_t offset_ns = now_ns - frame_start_ns_;
+  const uint64_t received = ++model.received;
+  if (received == 1) {
+    model.expected_offset_ns = offset_ns;
+  } else {
+    const int64_t skew_ns = std::abs(offset_ns - model.expected_offset_ns);
+    model.arrival_skew_ns = smooth(model.arrival_skew_ns, skew_ns);
+    model.expected_offset_ns = smooth(model.expected_offset_ns, offset_ns);
+  }
+  if (model.last_arrival_ns != 0) {
+    const int64_t period_ns = now_ns - model.last_arrival_ns;
+    model.period_ns = received == 2 ? period_ns : smooth(model.period_ns, period_ns);
+  }
+  model.last_arrival_ns = now_ns;
+
+  slots_.at(sensor_idx) = cloud;
+  if (isFrameComplete()) {
+    closeFrame();
+  }
+}
+
+std::vector<CloudSynchronizer::Frame> CloudSynchronizer::takeFrames()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (frame_start_ns_ != 0 && nowNs() >= computeDeadlineNs()) {
+    closeFrame();
+  }
+  std::vector<Frame> frames;
+  frames.swap(closed_frames_);
+  return frames;
+}
+
+std::optional<std::chrono::nanoseconds> CloudSynchronizer::getTimeToDeadline()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (frame_start_ns_ == 0) {
+    return std::nullopt;
+  }
+  return std::chrono::nanoseconds(std::max<int64_t>(computeDeadlineNs() - nowNs(), 0));
+}
+
+bool CloudSynchronizer::isFrameComplete() const
+{
+  return std::all_of(
+    slots_.begin(), slots_.end(), [](const auto & slot) { return slot != nullptr; });
+}
+
+int64_t CloudSynchronizer::computeDeadlineNs() const
+{
+  const int64_t timeout_deadline_ns = frame_start_ns_ + timeout_ns_;
+
+  int64_t latest_offset_ns = 0;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (slots_.at(i) != nullptr) {
+      continue;
+    }
+    const auto & model = models_.at(i);
+    if (model.received < min_samples_) {
+      // not learned yet
+      return timeout_deadline_ns;
+    }
+    // a cloud later than one period after the start of the frame belongs to the next frame
+    const int64_t offset_ns =
+      std::min(model.expected_offset_ns + deadline_margin_ns_, model.period_ns.load());
+    latest_offset_ns = std::max(latest_offset_ns, offset_ns);
+  }
+
+  return std::min(timeout_deadline_ns, frame_start_ns_ + latest_offset_ns);
+}
+
+void CloudSynchronizer::closeFrame()
+{
+  // The slots are emptied and the frame closed at once, so that the next cloud opens the next frame
+  Frame frame(slots_.size());
+  frame.swap(slots_);
+  frame_start_ns_ = 0;
+
+  for (size_t i = 0; i < frame.size(); ++i) {
+    if (!frame.at(i)) {
+      ++models_.at(i).missed;
+    }
+  }
+  closed_frames_.push_back(std::move(frame));
+}
+
+std::vector<CloudSynchronizer::SensorStatistics> CloudSynchronizer::getStatistics() const
+{
+  std::vector<SensorStatistics> statistics;
+  statistics.reserve(models_.size());
+  for (const auto & model : models_) {
+    SensorStatistics sensor_statistics;
+    sensor_statistics.period_sec = static_cast<double>(model.period_ns) * 1e-9;
+    sensor_statistics.expected_offset_sec = static_cast<double>(model.expected_offset_ns) * 1e-9;
+    sensor_statistics.arrival_skew_sec = static_cast<double>(model.arrival_skew_ns) * 1e-9;
+    sensor_statistics.received = model.received;
+    sensor_statistics.repeated = model.repeated;
+    sensor_statistics.missed = model.missed;
+    statistics.push_back(sensor_statistics);
+  }
+  return statistics;
+}
+}  // namespace pointcloud_preprocessor
@@ -55,6 +55,12 @@
 
 #include <pcl_conversions/pcl_conversions.h>
 
+#ifdef ROS_DISTRO_GALACTIC
+#include <tf2_eigen/tf2_eigen.h>
+#else
+#include <tf2_eigen/tf2_eigen.hpp>
+#endif
+
 #include <algorithm>
 #include <memory>
 #include <string>
@@ -106,6 +112,12 @@ PointCloudConcatenateDataSynchronizerComponent::PointCloudConcatenateDataSynchro
       RCLCPP_ERROR(get_logger(), "The number of topics does not match the number of offsets.");
       return;
     }
+
+    use_zero_copy_concatenation_ =
+      static_cast<bool>(declare_parameter("use_zero_copy_concatenation", false));
+    use_deadline_synchronizer_ =
+      static_cast<bool>(declare_parameter("use_deadline_synchronizer", false));
+    deadline_margin_sec_ = static_cast<double>(declare_parameter("deadline_margin_sec", 0.01));
   }
 
   // Initialize not_subscribed_topic_names_
@@ -142,6 +154,11 @@ PointCloudConcatenateDataSynchronizerComponent::PointCloudConcatenateDataSynchro
       RCLCPP_INFO_STREAM(get_logger(), " - " << input_topic);
     }
 
+    if (use_deadline_synchronizer_) {
+      synchronizer_ = std::make_unique<CloudSynchronizer>(
+        input_topics_.size(), timeout_sec_, deadline_margin_sec_);
+    }
+
     // Subscribe to the filters
     filters_.resize(input_topics_.size());
 
@@ -156,8 +173,22 @@ PointCloudConcatenateDataSynchronizerComponent::PointCloudConcatenateDataSynchro
         std::placeholders::_1, input_topics_[d]);
 
       filters_[d].reset();
-      filters_[d] = this->create_subscription<sensor_msgs::msg::PointCloud2>(
-        input_topics_[d], rclcpp::SensorDataQoS().keep_last(maximum_queue_size_), cb);
+      if (synchronizer_) {
+        // one callback group per sensor, so that the sensors do not wait for each other in a
+        // multi-threaded executor
+        filter_callback_groups_.push_back(
+          create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive));
+        rclcpp::SubscriptionOptions options;
+        options.callback_group = filter_callback_groups_.back();
+        cb = std::bind(
+          &PointCloudConcatenateDataSynchronizerComponent::synchronized_cloud_callback, this,
+          std::placeholders::_1, d);
+        filters_[d] = this->create_subscription<sensor_msgs::msg::PointCloud2>(
+          input_topics_[d], rclcpp::SensorDataQoS().keep_last(maximum_queue_size_), cb, options);
+      } else {
+        filters_[d] = this->create_subscription<sensor_msgs::msg::PointCloud2>(
+          input_topics_[d], rclcpp::SensorDataQoS().keep_last(maximum_queue_size_), cb);
+      }
     }
     auto twist_cb = std::bind(
       &PointCloudConcatenateDataSynchronizerComponent::twist_callback, this, std::placeholders::_1);
@@ -166,9 +197,17 @@ PointCloudConcatenateDataSynchronizerComponent::PointCloudConcatenateDataSynchro
   }
 
   // Set timer
-  {
-    const auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-      std::chrono::duration<double>(timeout_sec_));
+  const auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(timeout_sec_));
+  if (synchronizer_) {
+    // the deadline of the synchronizer is measured with the steady clock, and the timer is only
+    // started when a frame is open
+    timer_ = create_wall_timer(
+      period_ns,
+      std::bind(&PointCloudConcatenateDataSynchronizerComponent::deadline_timer_callback, this),
+      create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive));
+    timer_->cancel();
+  } else {
     timer_ = rclcpp::create_timer(
       this, get_clock(), period_ns,
       std::bind(&PointCloudConcatenateDataSynchronizerComponent::timer_callback, this));
@@ -201,17 +240,34 @@ void PointCloudConcatenateDataSynchronizerComponent::transformPointCloud(
   }
 }
 
-void PointCloudConcatenateDataSynchronizerComponent::combineClouds(
-  const PointCloud2::ConstSharedPtr & in1, const PointCloud2::ConstSharedPtr & in2,
-  PointCloud2::SharedPtr & out)
+bool PointCloudConcatenateDataSynchronizerComponent::lookupTransformMatrix(
+  const std::string & source_frame, const rclcpp::Time & stamp, Eigen::Matrix4f & matrix)
+{
+  if (source_frame == output_frame_) {
+    matrix = Eigen::Matrix4f::Identity();
+    return true;
+  }
+
+  geometry_msgs::msg::TransformStamped transform_stamped;
+  try {
+    transform_stamped = tf2_buffer_->lookupTransform(output_frame_, source_frame, stamp);
+  } catch (tf2::TransformException & ex) {
+    RCLCPP_ERROR(
+      this->get_logger(), "[lookupTransformMatrix] Error converting dataset from %s to %s: %s",
+      source_frame.c_str(), output_frame_.c_str(), ex.what());
+    return false;
+  }
+  matrix = tf2::transformToEigen(transform_stamped.transform).matrix().cast<float>();
+  return true;
+}
+
+Eigen::Matrix4f PointCloudConcatenateDataSynchronizerComponent::computeMotionCompensation(
+  const rclcpp::Time & old_stamp, const rclcpp::Time & new_stamp)
 {
   if (twist_ptr_queue_.empty()) {
-    pcl::concatenatePointCloud(*in1, *in2, *out);
-    out->header.stamp = std::min(rclcpp::Time(in1->header.stamp), rclcpp::Time(in2->header.stamp));
-    return;
+    return Eigen::Matrix4f::Identity();
   }
 
-  const auto old_stamp = std::min(rclcpp::Time(in1->header.stamp), rclcpp::Time(in2->header.stamp));
   auto old_twist_ptr_it = std::lower_bound(
     std::begin(twist_ptr_queue_), std::end(twist_ptr_queue_), old_stamp,
     [](const geometry_msgs::msg::TwistStamped::ConstSharedPtr & x_ptr, const rclcpp::Time & t) {
@@ -220,7 +276,6 @@ void PointCloudConcatenateDataSynchronizerComponent::combineClouds(
   old_twist_ptr_it =
     old_twist_ptr_it == twist_ptr_queue_.end() ? (twist_ptr_queue_.end() - 1) : old_twist_ptr_it;
 
-  const auto new_stamp = std::max(rclcpp::Time(in1->header.stamp), rclcpp::Time(in2->header.stamp));
   auto new_twist_ptr_it = std::lower_bound(
     std::begin(twist_ptr_queue_), std::end(twist_ptr_queue_), new_stamp,
     [](const geometry_msgs::msg::TwistStamped::ConstSharedPtr & x_ptr, const rclcpp::Time & t) {
@@ -257,7 +312,22 @@ void PointCloudConcatenateDataSynchronizerComponent::combineClouds(
   Eigen::AngleAxisf rotation_y(0, Eigen::Vector3f::UnitY());
   Eigen::AngleAxisf rotation_z(yaw, Eigen::Vector3f::UnitZ());
   Eigen::Translation3f translation(x, y, 0);
-  Eigen::Matrix4f rotation_matrix = (translation * rotation_z * rotation_y * rotation_x).matrix();
+  return (translation * rotation_z * rotation_y * rotation_x).matrix();
+}
+
+void PointCloudConcatenateDataSynchronizerComponent::combineClouds(
+  const PointCloud2::ConstSharedPtr & in1, const PointCloud2::ConstSharedPtr & in2,
+  PointCloud2::SharedPtr & out)
+{
+  if (twist_ptr_queue_.empty()) {
+    pcl::concatenatePointCloud(*in1, *in2, *out);
+    out->header.stamp = std::min(rclcpp::Time(in1->header.stamp), rclcpp::Time(in2->header.stamp));
+    return;
+  }
+
+  const auto old_stamp = std::min(rclcpp::Time(in1->header.stamp), rclcpp::Time(in2->header.stamp));
+  const auto new_stamp = std::max(rclcpp::Time(in1->header.stamp), rclcpp::Time(in2->header.stamp));
+  const Eigen::Matrix4f rotation_matrix = computeMotionCompensation(old_stamp, new_stamp);
 
   // TODO(YamatoAndo): if output_frame_ is not base_link, we must transform
 
@@ -274,11 +344,10 @@ void PointCloudConcatenateDataSynchronizerComponent::combineClouds(
   }
 }
 
-void PointCloudConcatenateDataSynchronizerComponent::publish()
+std::unique_ptr<sensor_msgs::msg::PointCloud2>
+PointCloudConcatenateDataSynchronizerComponent::concatenateClouds()
 {
-  stop_watch_ptr_->toc("processing_time", true);
   sensor_msgs::msg::PointCloud2::SharedPtr concat_cloud_ptr_ = nullptr;
-  not_subscribed_topic_names_.clear();
 
   for (const auto & e : cloud_stdmap_) {
     if (e.second != nullptr) {
@@ -297,8 +366,70 @@ void PointCloudConcatenateDataSynchronizerComponent::publish()
     }
   }
 
-  if (concat_cloud_ptr_) {
-    auto output = std::make_unique<sensor_msgs::msg::PointCloud2>(*concat_cloud_ptr_);
+  if (!concat_cloud_ptr_) {
+    return nullptr;
+  }
+  return std::make_unique<sensor_msgs::msg::PointCloud2>(*concat_cloud_ptr_);
+}
+
+std::unique_ptr<sensor_msgs::msg::PointCloud2>
+PointCloudConcatenateDataSynchronizerComponent::concatenateCloudsZeroCopy()
+{
+  // all clouds are expressed at the oldest stamp, as the pairwise combination does
+  std::vector<sensor_msgs::msg::PointCloud2::ConstSharedPtr> clouds;
+  for (const auto & e : cloud_stdmap_) {
+    if (e.second != nullptr) {
+      clouds.push_back(e.second);
+    } else {
+      not_subscribed_topic_names_.insert(e.first);
+    }
+  }
+  if (clouds.empty()) {
+    return nullptr;
+  }
+
+  const auto oldest_cloud_it =
+    std::min_element(clouds.begin(), clouds.end(), [](const auto & lhs, const auto & rhs) {
+      return rclcpp::Time(lhs->header.stamp) < rclcpp::Time(rhs->header.stamp);
+    });
+  const rclcpp::Time oldest_stamp = (*oldest_cloud_it)->header.stamp;
+
+  std::vector<ConcatenateSource> sources;
+  sources.reserve(clouds.size());
+  for (const auto & cloud : clouds) {
+    if (!isConcatenatable(*cloud)) {
+      RCLCPP_WARN(
+        this->get_logger(), "Skipping a cloud in frame %s without valid x, y and z fields.",
+        cloud->header.frame_id.c_str());
+      continue;
+    }
+    ConcatenateSource source;
+    source.cloud = cloud;
+    if (!lookupTransformMatrix(cloud->header.frame_id, cloud->header.stamp, source.transform)) {
+      continue;
+    }
+    // TODO(YamatoAndo): if output_frame_ is not base_link, we must transform
+    source.transform =
+      computeMotionCompensation(oldest_stamp, cloud->header.stamp) * source.transform;
+    sources.push_back(std::move(source));
+  }
+
+  auto output = concatenateXYZI(sources, output_frame_);
+  output->header.stamp = oldest_stamp;
+  return output;
+}
+
+void PointCloudConcatenateDataSynchronizerComponent::publish()
+{
+  stop_watch_ptr_->toc("processing_time", true);
+
+  std::unique_ptr<PointCloud2> output;
+  {
+    std::lock_guard<std::mutex> diagnostics_lock(diagnostics_mutex_);
+    not_subscribed_topic_names_.clear();
+    output = use_zero_copy_concatenation_ ? concatenateCloudsZeroCopy() : concatenateClouds();
+  }
+  if (output) {
     pub_output_->publish(std::move(output));
   } else {
     RCLCPP_WARN(this->get_logger(), "concat_cloud_ptr_ is nullptr, skipping pointcloud publish.");
@@ -376,13 +507,24 @@ void PointCloudConcatenateDataSynchronizerComponent::setPeriod(const int64_t new
   }
 }
 
+sensor_msgs::msg::PointCloud2::ConstSharedPtr
+PointCloudConcatenateDataSynchronizerComponent::toConcatenationInput(
+  const sensor_msgs::msg::PointCloud2::ConstSharedPtr & input_ptr)
+{
+  if (use_zero_copy_concatenation_) {
+    return input_ptr;
+  }
+  auto input = std::make_shared<sensor_msgs::msg::PointCloud2>(*input_ptr);
+  sensor_msgs::msg::PointCloud2::SharedPtr xyzi_cloud_ptr(new sensor_msgs::msg::PointCloud2());
+  convertToXYZICloud(input, xyzi_cloud_ptr);
+  return xyzi_cloud_ptr;
+}
+
 void PointCloudConcatenateDataSynchronizerComponent::cloud_callback(
   const sensor_msgs::msg::PointCloud2::ConstSharedPtr & input_ptr, const std::string & topic_name)
 {
   std::lock_guard<std::mutex> lock(mutex_);
-  auto input = std::make_shared<sensor_msgs::msg::PointCloud2>(*input_ptr);
-  sensor_msgs::msg::PointCloud2::SharedPtr xyzi_input_ptr(new sensor_msgs::msg::PointCloud2());
-  convertToXYZICloud(input, xyzi_input_ptr);
+  const auto xyzi_input_ptr = toConcatenationInput(input_ptr);
 
   const bool is_already_subscribed_this = (cloud_stdmap_[topic_name] != nullptr);
   const bool is_already_subscribed_tmp = std::any_of(
@@ -435,6 +577,46 @@ void PointCloudConcatenateDataSynchronizerComponent::cloud_callback(
   }
 }
 
+void PointCloudConcatenateDataSynchronizerComponent::synchronized_cloud_callback(
+  const sensor_msgs::msg::PointCloud2::ConstSharedPtr & input_ptr, const size_t sensor_idx)
+{
+  // the conversion runs in the callback group of the sensor, and the lock of the synchronizer is
+  // only taken to store the result
+  synchronizer_->push(sensor_idx, toConcatenationInput(input_ptr));
+  publishFrames();
+}
+
+void PointCloudConcatenateDataSynchronizerComponent::deadline_timer_callback()
+{
+  publishFrames();
+}
+
+void PointCloudConcatenateDataSynchronizerComponent::publishFrames()
+{
+  // the frames are taken under mutex_, so that they are published in order whichever callback
+  // takes them
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto & frame : synchronizer_->takeFrames()) {
+    for (size_t i = 0; i < frame.size(); ++i) {
+      cloud_stdmap_[input_topics_.at(i)] = frame.at(i);
+    }
+    publish();
+  }
+
+  // wake up at the deadline of the open frame
+  timer_->cancel();
+  const auto time_to_deadline = synchronizer_->getTimeToDeadline();
+  if (time_to_deadline) {
+    try {
+      // a zero period would be a timer firing continuously
+      setPeriod(std::max<int64_t>(time_to_deadline->count(), 1));
+    } catch (rclcpp::exceptions::RCLError & ex) {
+      RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "%s", ex.what());
+    }
+    timer_->reset();
+  }
+}
+
 void PointCloudConcatenateDataSynchronizerComponent::timer_callback()
 {
   using std::chrono_literals::operator""ms;
@@ -456,6 +638,8 @@ void PointCloudConcatenateDataSynchronizerComponent::timer_callback()
 void PointCloudConcatenateDataSynchronizerComponent::twist_callback(
   const autoware_auto_vehicle_msgs::msg::VelocityReport::ConstSharedPtr input)
 {
+  std::lock_guard<std::mutex> lock(mutex_);
+
   // if rosbag restart, clear buffer
   if (!twist_ptr_queue_.empty()) {
     if (rclcpp::Time(twist_ptr_queue_.front()->header.stamp) > rclcpp::Time(input->header.stamp)) {
@@ -484,11 +668,24 @@ void PointCloudConcatenateDataSynchronizerComponent::twist_callback(
 void PointCloudConcatenateDataSynchronizerComponent::checkConcatStatus(
   diagnostic_updater::DiagnosticStatusWrapper & stat)
 {
+  std::lock_guard<std::mutex> diagnostics_lock(diagnostics_mutex_);
   for (const std::string & e : input_topics_) {
     const std::string subscribe_status = not_subscribed_topic_names_.count(e) ? "NG" : "OK";
     stat.add(e, subscribe_status);
   }
 
+  if (synchronizer_) {
+    const auto statistics = synchronizer_->getStatistics();
+    for (size_t i = 0; i < statistics.size(); ++i) {
+      const auto & topic = input_topics_.at(i);
+      stat.add(topic + ": period_ms", statistics.at(i).period_sec * 1e3);
+      stat.add(topic + ": expected_offset_ms", statistics.at(i).expected_offset_sec * 1e3);
+      stat.add(topic + ": arrival_skew_ms", statistics.at(i).arrival_skew_sec * 1e3);
+      stat.add(topic + ": repeated", statistics.at(i).repeated);
+      stat.add(topic + ": missed", statistics.at(i).missed);
+    }
+  }
+
   const int8_t level = not_subscribed_topic_names_.empty()
                          ? diagnostic_msgs::msg::DiagnosticStatus::OK
                          : diagnostic_msgs::msg::DiagnosticStatus::WARN;
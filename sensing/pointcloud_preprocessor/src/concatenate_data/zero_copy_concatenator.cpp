@@ -0,0 +1,158 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/concatenate_data/zero_copy_concatenator.hpp"
+
+#include "autoware_point_types/types.hpp"
+
+#include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
+
+#include <sensor_msgs/msg/point_field.hpp>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+namespace
+{
+using autoware_point_types::PointXYZI;
+using sensor_msgs::msg::PointField;
+
+constexpr int kNoField = -1;
+
+struct FieldLayout
+{
+  int x = kNoField;
+  int y = kNoField;
+  int z = kNoField;
+  int intensity = kNoField;
+  uint8_t intensity_datatype = PointField::FLOAT32;
+};
+
+FieldLayout resolveFieldLayout(const sensor_msgs::msg::PointCloud2 & cloud)
+{
+  FieldLayout layout;
+  for (const auto & field : cloud.fields) {
+    const auto offset = static_cast<int>(field.offset);
+    if (field.datatype == PointField::FLOAT32 && field.name == "x") {
+      layout.x = offset;
+    } else if (field.datatype == PointField::FLOAT32 && field.name == "y") {
+      layout.y = offset;
+    } else if (field.datatype == PointField::FLOAT32 && field.name == "z") {
+      layout.z = offset;
+    } else if (field.name == "intensity") {
+      layout.intensity = offset;
+      layout.intensity_datatype = field.datatype;
+    }
+  }
+  return layout;
+}
+
+template <typename T>
+inline float readAs(const uint8_t * ptr)
+{
+  T value;
+  std::memcpy(&value, ptr, sizeof(T));
+  return static_cast<float>(value);
+}
+
+inline float readIntensity(const uint8_t * ptr, const uint8_t datatype)
+{
+  switch (datatype) {
+    case PointField::FLOAT32:
+      return readAs<float>(ptr);
+    case PointField::FLOAT64:
+      return readAs<double>(ptr);
+    case PointField::UINT8:
+      return readAs<uint8_t>(ptr);
+    case PointField::UINT16:
+      return readAs<uint16_t>(ptr);
+    default:
+      return 0.0f;
+  }
+}
+
+void transformInto(
+  const sensor_msgs::msg::PointCloud2 & input, const Eigen::Matrix4f & transform,
+  uint8_t * output_data, const size_t output_point_step)
+{
+  const auto layout = resolveFieldLayout(input);
+  const size_t num_points = static_cast<size_t>(input.width) * input.height;
+  const Eigen::Matrix3f rotation = transform.topLeftCorner<3, 3>();
+  const Eigen::Vector3f translation = transform.topRightCorner<3, 1>();
+
+  const uint8_t * input_data = input.data.data();
+  for (size_t i = 0; i < num_points; ++i) {
+    const uint8_t * in_point = input_data + i * input.point_step;
+    const Eigen::Vector3f p(
+      readAs<float>(in_point + layout.x), readAs<float>(in_point + layout.y),
+      readAs<float>(in_point + layout.z));
+    const Eigen::Vector3f p_out = rotation * p + translation;
+
+    PointXYZI point;
+    point.x = p_out.x();
+    point.y = p_out.y();
+    point.z = p_out.z();
+    point.intensity = layout.intensity == kNoField
+                        ? 0.0f
+                        : readIntensity(in_point + layout.intensity, layout.intensity_datatype);
+    std::memcpy(output_data + i * output_point_step, &point, sizeof(PointXYZI));
+  }
+}
+}  // namespace
+
+bool isConcatenatable(const sensor_msgs::msg::PointCloud2 & cloud)
+{
+  const auto layout = resolveFieldLayout(cloud);
+  if (layout.x == kNoField || layout.y == kNoField || layout.z == kNoField) {
+    return false;
+  }
+  return static_cast<size_t>(cloud.width) * cloud.height * cloud.point_step == cloud.data.size();
+}
+
+std::unique_ptr<sensor_msgs::msg::PointCloud2> concatenateXYZI(
+  const std::vector<ConcatenateSource> & sources, const std::string & frame_id)
+{
+  // Pre-compute the slice of the output buffer each source is written into
+  std::vector<size_t> point_offsets(sources.size() + 1, 0);
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const auto & cloud = sources.at(i).cloud;
+    const size_t num_points =
+      (cloud && isConcatenatable(*cloud)) ? static_cast<size_t>(cloud->width) * cloud->height : 0;
+    point_offsets.at(i + 1) = point_offsets.at(i) + num_points;
+  }
+
+  auto output = std::make_unique<sensor_msgs::msg::PointCloud2>();
+  point_cloud_msg_wrapper::PointCloud2Modifier<PointXYZI> output_modifier{*output, frame_id};
+  output_modifier.resize(point_offsets.back());
+
+  uint8_t * output_data = output->data.data();
+  const size_t output_point_step = output->point_step;
+  const int num_sources = static_cast<int>(sources.size());
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < num_sources; ++i) {
+    if (point_offsets.at(i + 1) == point_offsets.at(i)) {
+      continue;
+    }
+    transformInto(
+      *sources.at(i).cloud, sources.at(i).transform,
+      output_data + point_offsets.at(i) * output_point_step, output_point_step);
+  }
+
+  return output;
+}
+}  // namespace pointcloud_preprocessor
@@ -14,6 +14,8 @@
 
 #include "pointcloud_preprocessor/distortion_corrector/distortion_corrector.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <deque>
 #include <string>
 #include <utility>
@@ -37,6 +39,8 @@ DistortionCorrectorComponent::DistortionCorrectorComponent(const rclcpp::NodeOpt
   // Parameter
   time_stamp_field_name_ = declare_parameter("time_stamp_field_name", "time_stamp");
   use_imu_ = declare_parameter("use_imu", true);
+  use_fast_path_ = declare_parameter("use_fast_path", false);
+  time_slice_sec_ = declare_parameter("time_slice_sec", 0.0);
 
   // Publisher
   undistorted_points_pub_ =
@@ -124,7 +128,9 @@ void DistortionCorrectorComponent::onPointCloud(PointCloud2::UniquePtr points_ms
   tf2::Transform tf2_base_link_to_sensor{};
   getTransform(points_msg->header.frame_id, base_link_frame_, &tf2_base_link_to_sensor);
 
-  undistortPointCloud(tf2_base_link_to_sensor, *points_msg);
+  if (!use_fast_path_ || !undistortPointCloudFastPath(tf2_base_link_to_sensor, *points_msg)) {
+    undistortPointCloud(tf2_base_link_to_sensor, *points_msg);
+  }
 
   undistorted_points_pub_->publish(std::move(points_msg));
 
@@ -280,6 +286,184 @@ bool DistortionCorrectorComponent::undistortPointCloud(
   return true;
 }
 
+bool DistortionCorrectorComponent::undistortPointCloudFastPath(
+  const tf2::Transform & tf2_base_link_to_sensor, PointCloud2 & points)
+{
+  // Resolve the field offsets once. Returning false lets the caller fall back to the generic
+  // iterator path, which also reports an empty input or a missing time stamp field.
+  int x_offset{-1};
+  int y_offset{-1};
+  int z_offset{-1};
+  int time_stamp_offset{-1};
+  for (const auto & field : points.fields) {
+    using sensor_msgs::msg::PointField;
+    if (field.name == "x" && field.datatype == PointField::FLOAT32) {
+      x_offset = static_cast<int>(field.offset);
+    } else if (field.name == "y" && field.datatype == PointField::FLOAT32) {
+      y_offset = static_cast<int>(field.offset);
+    } else if (field.name == "z" && field.datatype == PointField::FLOAT32) {
+      z_offset = static_cast<int>(field.offset);
+    } else if (field.name == time_stamp_field_name_ && field.datatype == PointField::FLOAT64) {
+      time_stamp_offset = static_cast<int>(field.offset);
+    }
+  }
+  const size_t num_points = static_cast<size_t>(points.width) * points.height;
+  if (
+    x_offset < 0 || y_offset < 0 || z_offset < 0 || time_stamp_offset < 0 || num_points == 0 ||
+    twist_queue_.empty() || num_points * points.point_step != points.data.size()) {
+    return false;
+  }
+
+  uint8_t * data = points.data.data();
+  const size_t point_step = points.point_step;
+  const auto time_stamp_at = [&](const size_t i) {
+    double time_stamp;
+    std::memcpy(&time_stamp, data + i * point_step + time_stamp_offset, sizeof(double));
+    return time_stamp;
+  };
+
+  // Split the scan into time slices and integrate the ego motion once per slice. With
+  // time_slice_sec_ = 0 a slice groups the points sharing the same time stamp, which gives the
+  // same result as the per-point integration of undistortPointCloud().
+  float theta{0.0f};
+  float x{0.0f};
+  float y{0.0f};
+  const double first_point_time_stamp_sec{time_stamp_at(0)};
+  double prev_time_stamp_sec{first_point_time_stamp_sec};
+
+  auto twist_it = std::lower_bound(
+    std::begin(twist_queue_), std::end(twist_queue_), first_point_time_stamp_sec,
+    [](const geometry_msgs::msg::TwistStamped & x, const double t) {
+      return rclcpp::Time(x.header.stamp).seconds() < t;
+    });
+  twist_it = twist_it == std::end(twist_queue_) ? std::end(twist_queue_) - 1 : twist_it;
+
+  const bool use_imu = use_imu_ && !angular_velocity_queue_.empty();
+  decltype(angular_velocity_queue_)::iterator imu_it;
+  if (use_imu) {
+    imu_it = std::lower_bound(
+      std::begin(angular_velocity_queue_), std::end(angular_velocity_queue_),
+      first_point_time_stamp_sec, [](const geometry_msgs::msg::Vector3Stamped & x, const double t) {
+        return rclcpp::Time(x.header.stamp).seconds() < t;
+      });
+    imu_it =
+      imu_it == std::end(angular_velocity_queue_) ? std::end(angular_velocity_queue_) - 1 : imu_it;
+  }
+
+  const tf2::Transform tf2_base_link_to_sensor_inv{tf2_base_link_to_sensor.inverse()};
+  time_slices_.clear();
+  for (size_t slice_begin = 0; slice_begin < num_points;) {
+    const double slice_time_stamp_sec = time_stamp_at(slice_begin);
+    size_t slice_end = slice_begin + 1;
+    while (slice_end < num_points &&
+           std::abs(time_stamp_at(slice_end) - slice_time_stamp_sec) <= time_slice_sec_) {
+      ++slice_end;
+    }
+
+    for (;
+         (twist_it != std::end(twist_queue_) - 1 &&
+          slice_time_stamp_sec > rclcpp::Time(twist_it->header.stamp).seconds());
+         ++twist_it) {
+    }
+
+    float v{static_cast<float>(twist_it->twist.linear.x)};
+    float w{static_cast<float>(twist_it->twist.angular.z)};
+
+    if (std::abs(slice_time_stamp_sec - rclcpp::Time(twist_it->header.stamp).seconds()) > 0.1) {
+      RCLCPP_WARN_STREAM_THROTTLE(
+        get_logger(), *get_clock(), 10000 /* ms */,
+        "twist time_stamp is too late. Could not interpolate.");
+      v = 0.0f;
+      w = 0.0f;
+    }
+
+    if (use_imu) {
+      for (;
+           (imu_it != std::end(angular_velocity_queue_) - 1 &&
+            slice_time_stamp_sec > rclcpp::Time(imu_it->header.stamp).seconds());
+           ++imu_it) {
+      }
+      if (std::abs(slice_time_stamp_sec - rclcpp::Time(imu_it->header.stamp).seconds()) > 0.1) {
+        RCLCPP_WARN_STREAM_THROTTLE(
+          get_logger(), *get_clock(), 10000 /* ms */,
+          "imu time_stamp is too late. Could not interpolate.");
+      } else {
+        w = static_cast<float>(imu_it->vector.z);
+      }
+    }
+
+    const float time_offset = static_cast<float>(slice_time_stamp_sec - prev_time_stamp_sec);
+
+    theta += w * time_offset;
+    tf2::Quaternion baselink_quat{};
+    baselink_quat.setRPY(0.0, 0.0, theta);
+    const float dis = v * time_offset;
+    x += dis * std::cos(theta);
+    y += dis * std::sin(theta);
+
+    tf2::Transform baselinkTF_odom{};
+    baselinkTF_odom.setOrigin(tf2::Vector3(x, y, 0.0));
+    baselinkTF_odom.setRotation(baselink_quat);
+
+    // sensor -> base_link -> moved base_link -> sensor, folded into a single affine transform
+    const tf2::Transform sensorTF_correction{
+      tf2_base_link_to_sensor * baselinkTF_odom * tf2_base_link_to_sensor_inv};
+    const tf2::Matrix3x3 & basis = sensorTF_correction.getBasis();
+    const tf2::Vector3 & origin = sensorTF_correction.getOrigin();
+
+    TimeSlice slice{slice_begin, slice_end, {}};
+    for (int row = 0; row < 3; ++row) {
+      slice.correction[row * 4 + 0] = static_cast<float>(basis[row].getX());
+      slice.correction[row * 4 + 1] = static_cast<float>(basis[row].getY());
+      slice.correction[row * 4 + 2] = static_cast<float>(basis[row].getZ());
+      slice.correction[row * 4 + 3] = static_cast<float>(origin[row]);
+    }
+    time_slices_.push_back(slice);
+
+    prev_time_stamp_sec = slice_time_stamp_sec;
+    slice_begin = slice_end;
+  }
+
+  // Apply the corrections. Points are gathered into small SoA blocks so that the affine transform
+  // is vectorized, and the slices are independent so they are spread over the threads.
+  constexpr size_t block_size = 16;
+  const int num_slices = static_cast<int>(time_slices_.size());
+#pragma omp parallel for schedule(static)
+  for (int s = 0; s < num_slices; ++s) {
+    const auto & slice = time_slices_[s];
+    const auto & m = slice.correction;
+    float block_x[block_size];
+    float block_y[block_size];
+    float block_z[block_size];
+    float block_x_out[block_size];
+    float block_y_out[block_size];
+    float block_z_out[block_size];
+    for (size_t block_begin = slice.begin; block_begin < slice.end; block_begin += block_size) {
+      const size_t n = std::min(block_size, slice.end - block_begin);
+      for (size_t j = 0; j < n; ++j) {
+        const uint8_t * point = data + (block_begin + j) * point_step;
+        std::memcpy(&block_x[j], point + x_offset, sizeof(float));
+        std::memcpy(&block_y[j], point + y_offset, sizeof(float));
+        std::memcpy(&block_z[j], point + z_offset, sizeof(float));
+      }
+      // only the first n elements are filled on the last block of the slice
+#pragma omp simd
+      for (size_t j = 0; j < n; ++j) {
+        block_x_out[j] = m[0] * block_x[j] + m[1] * block_y[j] + m[2] * block_z[j] + m[3];
+        block_y_out[j] = m[4] * block_x[j] + m[5] * block_y[j] + m[6] * block_z[j] + m[7];
+        block_z_out[j] = m[8] * block_x[j] + m[9] * block_y[j] + m[10] * block_z[j] + m[11];
+      }
+      for (size_t j = 0; j < n; ++j) {
+        uint8_t * point = data + (block_begin + j) * point_step;
+        std::memcpy(point + x_offset, &block_x_out[j], sizeof(float));
+        std::memcpy(point + y_offset, &block_y_out[j], sizeof(float));
+        std::memcpy(point + z_offset, &block_z_out[j], sizeof(float));
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace pointcloud_preprocessor
 
 #include <rclcpp_components/register_node_macro.hpp>
@@ -55,6 +55,7 @@
 #include <pcl/search/kdtree.h>
 #include <pcl/segmentation/segment_differences.h>
 
+#include <string>
 #include <vector>
 
 namespace pointcloud_preprocessor
@@ -67,6 +68,15 @@ ApproximateDownsampleFilterComponent::ApproximateDownsampleFilterComponent(
     voxel_size_x_ = static_cast<double>(declare_parameter("voxel_size_x", 0.3));
     voxel_size_y_ = static_cast<double>(declare_parameter("voxel_size_y", 0.3));
     voxel_size_z_ = static_cast<double>(declare_parameter("voxel_size_z", 0.1));
+    use_radix_voxel_grid_ = static_cast<bool>(declare_parameter("use_radix_voxel_grid", false));
+    const auto voxel_representative =
+      static_cast<std::string>(declare_parameter("voxel_representative", "nearest_centroid"));
+    if (!toVoxelRepresentative(voxel_representative, voxel_representative_)) {
+      RCLCPP_WARN(
+        get_logger(), "Unknown voxel_representative '%s', nearest_centroid is used.",
+        voxel_representative.c_str());
+      voxel_representative_ = VoxelRepresentative::NearestCentroid;
+    }
   }
 
   using std::placeholders::_1;
@@ -78,6 +88,20 @@ void ApproximateDownsampleFilterComponent::filter(
   const PointCloud2ConstPtr & input, const IndicesPtr & /*indices*/, PointCloud2 & output)
 {
   std::scoped_lock lock(mutex_);
+  if (use_radix_voxel_grid_) {
+    radix_voxel_grid_.setLeafSize(
+      static_cast<float>(voxel_size_x_), static_cast<float>(voxel_size_y_),
+      static_cast<float>(voxel_size_z_));
+    radix_voxel_grid_.setRepresentative(voxel_representative_);
+    if (radix_voxel_grid_.filter(*input, output)) {
+      output.header = input->header;
+      return;
+    }
+    RCLCPP_WARN_THROTTLE(
+      get_logger(), *get_clock(), 5000,
+      "The input has no float32 x, y and z fields or spans too many voxels, PCL is used instead.");
+  }
+
   pcl::PointCloud<pcl::PointXYZ>::Ptr pcl_input(new pcl::PointCloud<pcl::PointXYZ>);
   pcl::PointCloud<pcl::PointXYZ>::Ptr pcl_output(new pcl::PointCloud<pcl::PointXYZ>);
   pcl::fromROSMsg(*input, *pcl_input);
@@ -108,6 +132,22 @@ rcl_interfaces::msg::SetParametersResult ApproximateDownsampleFilterComponent::p
     RCLCPP_DEBUG(get_logger(), "Setting new distance threshold to: %f.", voxel_size_z_);
   }
 
+  if (get_param(p, "use_radix_voxel_grid", use_radix_voxel_grid_)) {
+    RCLCPP_DEBUG(get_logger(), "Setting new use_radix_voxel_grid to: %d.", use_radix_voxel_grid_);
+  }
+
+  std::string voxel_representative;
+  if (get_param(p, "voxel_representative", voxel_representative)) {
+    if (!toVoxelRepresentative(voxel_representative, voxel_representative_)) {
+      rcl_interfaces::msg::SetParametersResult result;
+      result.successful = false;
+      result.reason = "unknown voxel_representative " + voxel_representative;
+      return result;
+    }
+    RCLCPP_DEBUG(
+      get_logger(), "Setting new voxel_representative to: %s.", voxel_representative.c_str());
+  }
+
   rcl_interfaces::msg::SetParametersResult result;
   result.successful = true;
   result.reason = "success";
@@ -0,0 +1,363 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/downsample_filter/radix_voxel_grid.hpp"
+
+#include "autoware_point_types/types.hpp"
+
+#include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
+
+#include <sensor_msgs/msg/point_field.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+namespace
+{
+using autoware_point_types::PointXYZI;
+using sensor_msgs::msg::PointField;
+
+constexpr int kNoField = -1;
+
+/** \brief Number of key bits sorted by one radix pass. */
+constexpr int kRadixBits = 11;
+constexpr size_t kRadix = size_t{1} << kRadixBits;
+
+/** \brief Upper bound of the number of voxels of the bounding box, so that the keys fit. */
+constexpr double kMaxNumVoxels = static_cast<double>(int64_t{1} << 62);
+
+struct FieldLayout
+{
+  int x = kNoField;
+  int y = kNoField;
+  int z = kNoField;
+  int intensity = kNoField;
+  uint8_t intensity_datatype = PointField::FLOAT32;
+};
+
+FieldLayout resolveFieldLayout(const sensor_msgs::msg::PointCloud2 & cloud)
+{
+  FieldLayout layout;
+  for (const auto & field : cloud.fields) {
+    const auto offset = static_cast<int>(field.offset);
+    if (field.datatype == PointField::FLOAT32 && field.name == "x") {
+      layout.x = offset;
+    } else if (field.datatype == PointField::FLOAT32 && field.name == "y") {
+      layout.y = offset;
+    } else if (field.datatype == PointField::FLOAT32 && field.name == "z") {
+      layout.z = offset;
+    } else if (field.name == "intensity") {
+      layout.intensity = offset;
+      layout.intensity_datatype = field.datatype;
+    }
+  }
+  return layout;
+}
+
+template <typename T>
+inline T readAs(const uint8_t * ptr)
+{
+  T value;
+  std::memcpy(&value, ptr, sizeof(T));
+  return value;
+}
+
+inline float readIntensity(const uint8_t * ptr, const uint8_t datatype)
+{
+  switch (datatype) {
+    case PointField::FLOAT32:
+      return readAs<float>(ptr);
+    case PointField::FLOAT64:
+      return static_cast<float>(readAs<double>(ptr));
+    case PointField::UINT8:
+      return readAs<uint8_t>(ptr);
+    case PointField::UINT16:
+      return readAs<uint16_t>(ptr);
+    default:
+      return 0.0f;
+  }
+}
+
+int bitWidth(uint64_t value)
+{
+  int num_bits = 0;
+  for (; value != 0; value >>= 1) {
+    ++num_bits;
+  }
+  return num_bits;
+}
+}  // namespace
+
+bool toVoxelRepresentative(const std::string & name, VoxelRepresentative & representative)
+{
+  if (name == "centroid") {
+    representative = VoxelRepresentative::Centroid;
+  } else if (name == "first_point") {
+    representative = VoxelRepresentative::FirstPoint;
+  } else if (name == "nearest_centroid") {
+    representative = VoxelRepresentative::NearestCentroid;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void RadixVoxelGrid::setLeafSize(
+  const float leaf_size_x, const float leaf_size_y, const float leaf_size_z)
+{
+  leaf_size_x_ = leaf_size_x;
+  leaf_size_y_ = leaf_size_y;
+  leaf_size_z_ = leaf_size_z;
+}
+
+void RadixVoxelGrid::setRepresentative(const VoxelRepresentative representative)
+{
+  representative_ = representative;
+}
+
+void RadixVoxelGrid::radixSort(const int num_bits)
+{
+  const size_t num_entries = entries_.size();
+  sort_buffer_.resize(num_entries);
+
+  int max_threads = 1;
+#ifdef _OPENMP
+  max_threads = omp_get_max_threads();
+#endif
+  histograms_.resize(kRadix * max_threads);
+
+  for (int shift = 0; shift < num_bits; shift += kRadixBits) {
+#pragma omp parallel
+    {
+      int num_threads = 1;
+      int thread = 0;
+#ifdef _OPENMP
+      num_threads = omp_get_num_threads();
+      thread = omp_get_thread_num();
+#endif
+      const size_t begin = num_entries * thread / num_threads;
+      const size_t end = num_entries * (thread + 1) / num_threads;
+      size_t * histogram = histograms_.data() + kRadix * thread;
+
+      std::fill(histogram, histogram + kRadix, 0);
+      for (size_t i = begin; i < end; ++i) {
+        ++histogram[(entries_[i].key >> shift) & (kRadix - 1)];
+      }
+
+#pragma omp barrier
+#pragma omp single
+      {
+        // digit-major prefix sum, so that every thread scatters its chunk after the chunks of the
+        // previous threads, which keeps the sort stable
+        size_t offset = 0;
+        for (size_t digit = 0; digit < kRadix; ++digit) {
+          for (int t = 0; t < num_threads; ++t) {
+            const size_t count = histograms_[kRadix * t + digit];
+            histograms_[kRadix * t + digit] = offset;
+            offset += count;
+          }
+        }
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+        sort_buffer_[histogram[(entries_[i].key >> shift) & (kRadix - 1)]++] = entries_[i];
+      }
+    }
+    entries_.swap(sort_buffer_);
+  }
+}
+
+bool RadixVoxelGrid::filter(
+  const sensor_msgs::msg::PointCloud2 & input, sensor_msgs::msg::PointCloud2 & output)
+{
+  const auto layout = resolveFieldLayout(input);
+  const size_t num_points = static_cast<size_t>(input.width) * input.height;
+  if (
+    layout.x == kNoField || layout.y == kNoField || layout.z == kNoField ||
+    input.data.size() < num_points * input.point_step ||
+    num_points > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+
+  const uint8_t * input_data = input.data.data();
+  const size_t point_step = input.point_step;
+  const int64_t num_points_signed = static_cast<int64_t>(num_points);
+
+  // bounding box of the finite points
+  float min_x = std::numeric_limits<float>::max();
+  float min_y = std::numeric_limits<float>::max();
+  float min_z = std::numeric_limits<float>::max();
+  float max_x = std::numeric_limits<float>::lowest();
+  float max_y = std::numeric_limits<float>::lowest();
+  float max_z = std::numeric_limits<float>::lowest();
+#pragma omp parallel for reduction(min : min_x, min_y, min_z) reduction(max : max_x, max_y, max_z)
+  for (int64_t i = 0; i < num_points_signed; ++i) {
+    const uint8_t * point = input_data + i * point_step;
+    const auto x = readAs<float>(point + layout.x);
+    const auto y = readAs<float>(point + layout.y);
+    const auto z = readAs<float>(point + layout.z);
+    if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)) {
+      continue;
+    }
+    min_x = std::min(min_x, x);
+    min_y = std::min(min_y, y);
+    min_z = std::min(min_z, z);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+    max_z = std::max(max_z, z);
+  }
+
+  // voxel coordinates are relative to the voxel of the minimum, so that only the extent matters
+  const float inverse_leaf_x = 1.0f / leaf_size_x_;
+  const float inverse_leaf_y = 1.0f / leaf_size_y_;
+  const float inverse_leaf_z = 1.0f / leaf_size_z_;
+  const double min_voxel_x = std::floor(min_x * inverse_leaf_x);
+  const double min_voxel_y = std::floor(min_y * inverse_leaf_y);
+  const double min_voxel_z = std::floor(min_z * inverse_leaf_z);
+  const double size_x = std::max(std::floor(max_x * inverse_leaf_x) - min_voxel_x + 1.0, 1.0);
+  const double size_y = std::max(std::floor(max_y * inverse_leaf_y) - min_voxel_y + 1.0, 1.0);
+  const double size_z = std::max(std::floor(max_z * inverse_leaf_z) - min_voxel_z + 1.0, 1.0);
+  if (!(size_x * size_y * size_z < kMaxNumVoxels)) {
+    return false;
+  }
+  const auto num_voxels_x = static_cast<uint64_t>(size_x);
+  const auto num_voxels_xy = num_voxels_x * static_cast<uint64_t>(size_y);
+  // the non-finite points get one key past the last voxel, so that they are sorted last
+  const uint64_t invalid_key = num_voxels_xy * static_cast<uint64_t>(size_z);
+
+  entries_.resize(num_points);
+#pragma omp parallel for
+  for (int64_t i = 0; i < num_points_signed; ++i) {
+    const uint8_t * point = input_data + i * point_step;
+    const auto x = readAs<float>(point + layout.x);
+    const auto y = readAs<float>(point + layout.y);
+    const auto z = readAs<float>(point + layout.z);
+    auto & entry = entries_[i];
+    entry.index = static_cast<uint32_t>(i);
+    if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)) {
+      entry.key = invalid_key;
+      continue;
+    }
+    const auto voxel_x = static_cast<uint64_t>(std::floor(x * inverse_leaf_x) - min_voxel_x);
+    const auto voxel_y = static_cast<uint64_t>(std::floor(y * inverse_leaf_y) - min_voxel_y);
+    const auto voxel_z = static_cast<uint64_t>(std::floor(z * inverse_leaf_z) - min_voxel_z);
+    entry.key = voxel_x + voxel_y * num_voxels_x + voxel_z * num_voxels_xy;
+  }
+
+  radixSort(bitWidth(invalid_key));
+
+  const size_t num_valid = static_cast<size_t>(
+    std::partition_point(
+      entries_.begin(), entries_.end(),
+      [invalid_key](const KeyIndex & entry) { return entry.key < invalid_key; }) -
+    entries_.begin());
+
+  voxel_begins_.clear();
+  for (size_t i = 0; i < num_valid; ++i) {
+    if (i == 0 || entries_[i].key != entries_[i - 1].key) {
+      voxel_begins_.push_back(i);
+    }
+  }
+  voxel_begins_.push_back(num_valid);
+  const size_t num_voxels = voxel_begins_.size() - 1;
+
+  output = sensor_msgs::msg::PointCloud2();
+  if (representative_ == VoxelRepresentative::Centroid) {
+    point_cloud_msg_wrapper::PointCloud2Modifier<PointXYZI> output_modifier{
+      output, input.header.frame_id};
+    output_modifier.resize(num_voxels);
+  } else {
+    // the representative is an input point, which is copied with all its fields
+    output.header.frame_id = input.header.frame_id;
+    output.fields = input.fields;
+    output.is_bigendian = input.is_bigendian;
+    output.point_step = input.point_step;
+    output.height = 1;
+    output.width = static_cast<uint32_t>(num_voxels);
+    output.row_step = static_cast<uint32_t>(num_voxels * point_step);
+    output.data.resize(num_voxels * point_step);
+  }
+  output.is_dense = true;
+
+  uint8_t * output_data = output.data.data();
+  const size_t output_point_step = output.point_step;
+  const int64_t num_voxels_signed = static_cast<int64_t>(num_voxels);
+#pragma omp parallel for schedule(dynamic, 256)
+  for (int64_t v = 0; v < num_voxels_signed; ++v) {
+    const size_t begin = voxel_begins_[v];
+    const size_t end = voxel_begins_[v + 1];
+    uint8_t * output_point = output_data + v * output_point_step;
+
+    if (representative_ == VoxelRepresentative::FirstPoint) {
+      std::memcpy(output_point, input_data + entries_[begin].index * point_step, point_step);
+      continue;
+    }
+
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    double sum_z = 0.0;
+    double sum_intensity = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+      const uint8_t * point = input_data + entries_[i].index * point_step;
+      sum_x += readAs<float>(point + layout.x);
+      sum_y += readAs<float>(point + layout.y);
+      sum_z += readAs<float>(point + layout.z);
+      if (layout.intensity != kNoField) {
+        sum_intensity += readIntensity(point + layout.intensity, layout.intensity_datatype);
+      }
+    }
+    const double inverse_count = 1.0 / static_cast<double>(end - begin);
+    const auto centroid_x = static_cast<float>(sum_x * inverse_count);
+    const auto centroid_y = static_cast<float>(sum_y * inverse_count);
+    const auto centroid_z = static_cast<float>(sum_z * inverse_count);
+
+    if (representative_ == VoxelRepresentative::Centroid) {
+      PointXYZI centroid;
+      centroid.x = centroid_x;
+      centroid.y = centroid_y;
+      centroid.z = centroid_z;
+      centroid.intensity = static_cast<float>(sum_intensity * inverse_count);
+      std::memcpy(output_point, &centroid, sizeof(PointXYZI));
+      continue;
+    }
+
+    uint32_t nearest_index = entries_[begin].index;
+    float nearest_squared_distance = std::numeric_limits<float>::max();
+    for (size_t i = begin; i < end; ++i) {
+      const uint8_t * point = input_data + entries_[i].index * point_step;
+      const float dx = readAs<float>(point + layout.x) - centroid_x;
+      const float dy = readAs<float>(point + layout.y) - centroid_y;
+      const float dz = readAs<float>(point + layout.z) - centroid_z;
+      const float squared_distance = dx * dx + dy * dy + dz * dz;
+      if (squared_distance < nearest_squared_distance) {
+        nearest_squared_distance = squared_distance;
+        nearest_index = entries_[i].index;
+      }
+    }
+    std::memcpy(output_point, input_data + nearest_index * point_step, point_step);
+  }
+
+  return true;
+}
+}  // namespace pointcloud_preprocessor
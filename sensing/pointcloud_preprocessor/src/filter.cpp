@@ -90,6 +90,7 @@ pointcloud_preprocessor::Filter::Filter(
   {
     pub_output_ = this->create_publisher<PointCloud2>(
       "output", rclcpp::SensorDataQoS().keep_last(max_queue_size_));
+    latency_tracer_ = std::make_unique<tier4_autoware_utils::LatencyTracer>(this, get_name());
   }
 
   subscribe();
@@ -162,6 +163,7 @@ void pointcloud_preprocessor::Filter::unsubscribe()
 void pointcloud_preprocessor::Filter::computePublish(
   const PointCloud2ConstPtr & input, const IndicesPtr & indices)
 {
+  const auto span = latency_tracer_->startSpan(input->header.stamp);
   auto output = std::make_unique<PointCloud2>();
 
   // Call the virtual method in the child
@@ -204,6 +206,7 @@ void pointcloud_preprocessor::Filter::computePublish(
 
   // Publish a boost shared ptr
   pub_output_->publish(std::move(output));
+  latency_tracer_->publishLatency(input->header.stamp);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
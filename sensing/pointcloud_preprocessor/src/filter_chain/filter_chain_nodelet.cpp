@@ -0,0 +1,114 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/filter_chain/filter_chain_nodelet.hpp"
+
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+FilterChainComponent::FilterChainComponent(const rclcpp::NodeOptions & options)
+: Filter("FilterChain", options)
+{
+  // initialize debug tool
+  {
+    using tier4_autoware_utils::DebugPublisher;
+    using tier4_autoware_utils::StopWatch;
+    stop_watch_ptr_ = std::make_unique<StopWatch<std::chrono::milliseconds>>();
+    debug_publisher_ = std::make_unique<DebugPublisher>(this, "filter_chain");
+    stop_watch_ptr_->tic("cyclic_time");
+    stop_watch_ptr_->tic("processing_time");
+  }
+
+  // set stages
+  {
+    const auto stage_names = declare_parameter("stages", std::vector<std::string>());
+    for (const auto & stage_name : stage_names) {
+      const auto type = declare_parameter(stage_name + ".type", std::string(""));
+      auto stage = createFilterStage(type, *this, stage_name);
+      if (!stage) {
+        RCLCPP_ERROR(
+          get_logger(), "Unknown type '%s' for the stage '%s', the stage is ignored.", type.c_str(),
+          stage_name.c_str());
+        continue;
+      }
+      RCLCPP_INFO(get_logger(), "Add stage '%s' of type '%s'.", stage_name.c_str(), type.c_str());
+      stages_.emplace_back(stage_name, std::move(stage));
+    }
+  }
+}
+
+void FilterChainComponent::filter(
+  const PointCloud2ConstPtr & input, const IndicesPtr & indices, PointCloud2 & output)
+{
+  std::scoped_lock lock(mutex_);
+  stop_watch_ptr_->toc("processing_time", true);
+
+  if (indices) {
+    kept_indices_.assign(indices->begin(), indices->end());
+  } else {
+    kept_indices_.resize(static_cast<size_t>(input->width) * input->height);
+    std::iota(kept_indices_.begin(), kept_indices_.end(), 0U);
+  }
+
+  for (const auto & [stage_name, stage] : stages_) {
+    stop_watch_ptr_->tic(stage_name);
+    if (!stage->filter(*input, kept_indices_)) {
+      RCLCPP_WARN_THROTTLE(
+        get_logger(), *get_clock(), 5000,
+        "The input does not have the fields required by the stage '%s', the stage is skipped.",
+        stage_name.c_str());
+    }
+    if (debug_publisher_) {
+      debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+        "debug/" + stage_name + "/processing_time_ms", stop_watch_ptr_->toc(stage_name, true));
+    }
+  }
+
+  // copy the kept points once at the end of the chain
+  const auto point_step = input->point_step;
+  output.data.resize(kept_indices_.size() * point_step);
+  for (size_t i = 0; i < kept_indices_.size(); ++i) {
+    const size_t input_offset = static_cast<size_t>(kept_indices_[i]) * point_step;
+    std::memcpy(&output.data[i * point_step], &input->data[input_offset], point_step);
+  }
+
+  output.header = input->header;
+  output.height = 1;
+  output.fields = input->fields;
+  output.is_bigendian = input->is_bigendian;
+  output.point_step = point_step;
+  output.is_dense = input->is_dense;
+  output.width = static_cast<uint32_t>(kept_indices_.size());
+  output.row_step = static_cast<uint32_t>(output.data.size());
+
+  // add processing time for debug
+  if (debug_publisher_) {
+    const double cyclic_time_ms = stop_watch_ptr_->toc("cyclic_time", true);
+    const double processing_time_ms = stop_watch_ptr_->toc("processing_time", true);
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/cyclic_time_ms", cyclic_time_ms);
+    debug_publisher_->publish<tier4_debug_msgs::msg::Float64Stamped>(
+      "debug/processing_time_ms", processing_time_ms);
+  }
+}
+}  // namespace pointcloud_preprocessor
+
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(pointcloud_preprocessor::FilterChainComponent)
@@ -0,0 +1,204 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/filter_chain/filter_stage.hpp"
+
+#include "pointcloud_preprocessor/outlier_filter/ring_outlier_clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+namespace
+{
+int getFieldOffset(const sensor_msgs::msg::PointCloud2 & cloud, const std::string & name)
+{
+  const auto field_it = std::find_if(
+    cloud.fields.cbegin(), cloud.fields.cend(),
+    [&name](const sensor_msgs::msg::PointField & field) { return field.name == name; });
+  return field_it == cloud.fields.cend() ? -1 : static_cast<int>(field_it->offset);
+}
+
+template <typename T>
+T readField(const sensor_msgs::msg::PointCloud2 & cloud, const uint32_t index, const int offset)
+{
+  T value;
+  const size_t byte_offset = static_cast<size_t>(index) * cloud.point_step + offset;
+  std::memcpy(&value, &cloud.data[byte_offset], sizeof(T));
+  return value;
+}
+
+struct XYZOffsets
+{
+  int x;
+  int y;
+  int z;
+  bool valid() const { return x >= 0 && y >= 0 && z >= 0; }
+};
+
+XYZOffsets getXYZOffsets(const sensor_msgs::msg::PointCloud2 & cloud)
+{
+  return {getFieldOffset(cloud, "x"), getFieldOffset(cloud, "y"), getFieldOffset(cloud, "z")};
+}
+}  // namespace
+
+CropBoxStage::CropBoxStage(rclcpp::Node & node, const std::string & ns)
+{
+  min_x_ = static_cast<float>(node.declare_parameter(ns + ".min_x", -1.0));
+  min_y_ = static_cast<float>(node.declare_parameter(ns + ".min_y", -1.0));
+  min_z_ = static_cast<float>(node.declare_parameter(ns + ".min_z", -1.0));
+  max_x_ = static_cast<float>(node.declare_parameter(ns + ".max_x", 1.0));
+  max_y_ = static_cast<float>(node.declare_parameter(ns + ".max_y", 1.0));
+  max_z_ = static_cast<float>(node.declare_parameter(ns + ".max_z", 1.0));
+  negative_ = static_cast<bool>(node.declare_parameter(ns + ".negative", false));
+}
+
+bool CropBoxStage::filter(
+  const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const
+{
+  const auto offsets = getXYZOffsets(cloud);
+  if (!offsets.valid()) {
+    return false;
+  }
+
+  const auto new_end = std::remove_if(indices.begin(), indices.end(), [&](const uint32_t index) {
+    const auto x = readField<float>(cloud, index, offsets.x);
+    const auto y = readField<float>(cloud, index, offsets.y);
+    const auto z = readField<float>(cloud, index, offsets.z);
+    // as in CropBoxFilterComponent, the box is open when it keeps the points inside and closed
+    // when it removes them, so that a point on a face is removed either way
+    if (negative_) {
+      return min_z_ <= z && z <= max_z_ && min_y_ <= y && y <= max_y_ && min_x_ <= x &&
+             x <= max_x_;
+    }
+    return !(min_z_ < z && z < max_z_ && min_y_ < y && y < max_y_ && min_x_ < x && x < max_x_);
+  });
+  indices.erase(new_end, indices.end());
+  return true;
+}
+
+RingOutlierStage::RingOutlierStage(rclcpp::Node & node, const std::string & ns)
+{
+  distance_ratio_ = static_cast<double>(node.declare_parameter(ns + ".distance_ratio", 1.03));
+  object_length_threshold_ =
+    static_cast<double>(node.declare_parameter(ns + ".object_length_threshold", 0.1));
+  num_points_threshold_ = static_cast<int>(node.declare_parameter(ns + ".num_points_threshold", 4));
+}
+
+bool RingOutlierStage::filter(
+  const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const
+{
+  const auto offsets = getXYZOffsets(cloud);
+  const auto ring_offset = getFieldOffset(cloud, "ring");
+  const auto azimuth_offset = getFieldOffset(cloud, "azimuth");
+  const auto distance_offset = getFieldOffset(cloud, "distance");
+  if (!offsets.valid() || ring_offset < 0 || azimuth_offset < 0 || distance_offset < 0) {
+    return false;
+  }
+
+  std::unordered_map<uint16_t, std::vector<uint32_t>> input_ring_map;
+  input_ring_map.reserve(128);
+  for (const auto index : indices) {
+    input_ring_map[readField<uint16_t>(cloud, index, ring_offset)].push_back(index);
+  }
+
+  const auto point_at = [&](const uint32_t index) {
+    return RingOutlierPoint{
+      readField<float>(cloud, index, offsets.x), readField<float>(cloud, index, offsets.y),
+      readField<float>(cloud, index, offsets.z), readField<float>(cloud, index, azimuth_offset),
+      readField<float>(cloud, index, distance_offset)};
+  };
+  const RingOutlierParams params{distance_ratio_, object_length_threshold_, num_points_threshold_};
+
+  std::vector<uint32_t> output_indices;
+  output_indices.reserve(indices.size());
+  for (const auto & ring_indices : input_ring_map) {
+    forEachRingCluster(
+      ring_indices.second.begin(), ring_indices.second.end(), params, point_at,
+      [&output_indices](const auto cluster_begin, const auto cluster_end) {
+        output_indices.insert(output_indices.end(), cluster_begin, cluster_end);
+      });
+  }
+
+  // keep the input order so that the next stages and the output see the original scan order
+  std::sort(output_indices.begin(), output_indices.end());
+  indices = std::move(output_indices);
+  return true;
+}
+
+VoxelGridStage::VoxelGridStage(rclcpp::Node & node, const std::string & ns)
+{
+  voxel_size_x_ = static_cast<float>(node.declare_parameter(ns + ".voxel_size_x", 0.3));
+  voxel_size_y_ = static_cast<float>(node.declare_parameter(ns + ".voxel_size_y", 0.3));
+  voxel_size_z_ = static_cast<float>(node.declare_parameter(ns + ".voxel_size_z", 0.1));
+}
+
+bool VoxelGridStage::filter(
+  const sensor_msgs::msg::PointCloud2 & cloud, std::vector<uint32_t> & indices) const
+{
+  const auto offsets = getXYZOffsets(cloud);
+  if (!offsets.valid()) {
+    return false;
+  }
+
+  // 21 bits per axis, which covers +-104 km with a 0.1 m voxel
+  constexpr int64_t key_bits = 21;
+  constexpr int64_t key_mask = (int64_t{1} << key_bits) - 1;
+  const auto to_key = [&](const float value, const float voxel_size) {
+    return static_cast<int64_t>(std::floor(value / voxel_size)) & key_mask;
+  };
+
+  std::unordered_set<int64_t> occupied_voxels;
+  occupied_voxels.reserve(indices.size());
+  size_t num_kept = 0;
+  for (const auto index : indices) {
+    const auto x = readField<float>(cloud, index, offsets.x);
+    const auto y = readField<float>(cloud, index, offsets.y);
+    const auto z = readField<float>(cloud, index, offsets.z);
+    // the cast of a non-finite value is undefined, and such a point has no voxel anyway
+    if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)) {
+      continue;
+    }
+    const int64_t key = (to_key(x, voxel_size_x_) << (2 * key_bits)) |
+                        (to_key(y, voxel_size_y_) << key_bits) | to_key(z, voxel_size_z_);
+    if (occupied_voxels.insert(key).second) {
+      indices[num_kept++] = index;
+    }
+  }
+  indices.resize(num_kept);
+  return true;
+}
+
+std::unique_ptr<FilterStage> createFilterStage(
+  const std::string & type, rclcpp::Node & node, const std::string & ns)
+{
+  if (type == "crop_box") {
+    return std::make_unique<CropBoxStage>(node, ns);
+  }
+  if (type == "ring_outlier") {
+    return std::make_unique<RingOutlierStage>(node, ns);
+  }
+  if (type == "voxel_grid") {
+    return std::make_unique<VoxelGridStage>(node, ns);
+  }
+  return nullptr;
+}
+}  // namespace pointcloud_preprocessor
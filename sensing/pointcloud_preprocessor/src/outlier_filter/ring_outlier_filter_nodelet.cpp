@@ -15,9 +15,28 @@
 #include "pointcloud_preprocessor/outlier_filter/ring_outlier_filter_nodelet.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 namespace pointcloud_preprocessor
 {
+namespace
+{
+auto makePointAt(const sensor_msgs::msg::PointCloud2 & input)
+{
+  const auto azimuth_offset =
+    input.fields.at(static_cast<size_t>(autoware_point_types::PointIndex::Azimuth)).offset;
+  const auto distance_offset =
+    input.fields.at(static_cast<size_t>(autoware_point_types::PointIndex::Distance)).offset;
+  return [&input, azimuth_offset, distance_offset](const std::size_t data_idx) {
+    const auto * pt = reinterpret_cast<const PointXYZI *>(&input.data[data_idx]);
+    return RingOutlierPoint{
+      pt->x, pt->y, pt->z,
+      *reinterpret_cast<const float *>(&input.data[data_idx + azimuth_offset]),
+      *reinterpret_cast<const float *>(&input.data[data_idx + distance_offset])};
+  };
+}
+}  // namespace
+
 RingOutlierFilterComponent::RingOutlierFilterComponent(const rclcpp::NodeOptions & options)
 : Filter("RingOutlierFilter", options)
 {
@@ -37,6 +56,7 @@ RingOutlierFilterComponent::RingOutlierFilterComponent(const rclcpp::NodeOptions
     object_length_threshold_ =
       static_cast<double>(declare_parameter("object_length_threshold", 0.1));
     num_points_threshold_ = static_cast<int>(declare_parameter("num_points_threshold", 4));
+    use_ring_spans_ = static_cast<bool>(declare_parameter("use_ring_spans", false));
   }
 
   using std::placeholders::_1;
@@ -50,76 +70,40 @@ void RingOutlierFilterComponent::filter(
 {
   std::scoped_lock lock(mutex_);
   stop_watch_ptr_->toc("processing_time", true);
+  if (use_ring_spans_) {
+    filterRingSpans(input, output);
+    publishProcessingTime();
+    return;
+  }
+
   std::unordered_map<uint16_t, std::vector<std::size_t>> input_ring_map;
   input_ring_map.reserve(128);
-  sensor_msgs::msg::PointCloud2::SharedPtr input_ptr =
-    std::make_shared<sensor_msgs::msg::PointCloud2>(*input);
+  const auto & data = input->data;
 
   const auto ring_offset =
     input->fields.at(static_cast<size_t>(autoware_point_types::PointIndex::Ring)).offset;
-  for (std::size_t idx = 0U; idx < input_ptr->data.size(); idx += input_ptr->point_step) {
-    input_ring_map[*reinterpret_cast<uint16_t *>(&input_ptr->data[idx + ring_offset])].push_back(
-      idx);
+  for (std::size_t idx = 0U; idx < data.size(); idx += input->point_step) {
+    input_ring_map[*reinterpret_cast<const uint16_t *>(&data[idx + ring_offset])].push_back(idx);
   }
 
   PointCloud2Modifier<PointXYZI> output_modifier{output, input->header.frame_id};
   output_modifier.reserve(input->width);
 
-  std::vector<std::size_t> tmp_indices;
-  tmp_indices.reserve(input->width);
-
-  const auto azimuth_offset =
-    input->fields.at(static_cast<size_t>(autoware_point_types::PointIndex::Azimuth)).offset;
-  const auto distance_offset =
-    input->fields.at(static_cast<size_t>(autoware_point_types::PointIndex::Distance)).offset;
+  const auto point_at = makePointAt(*input);
   for (const auto & ring_indices : input_ring_map) {
-    if (ring_indices.second.size() < 2) {
-      continue;
-    }
-
-    for (size_t idx = 0U; idx < ring_indices.second.size() - 1; ++idx) {
-      const auto & current_idx = ring_indices.second.at(idx);
-      const auto & next_idx = ring_indices.second.at(idx + 1);
-      tmp_indices.emplace_back(current_idx);
-
-      // if(std::abs(iter->distance - (iter+1)->distance) <= std::sqrt(iter->distance) * 0.08)
-      const auto current_pt_azimuth =
-        *reinterpret_cast<float *>(&input_ptr->data[current_idx + azimuth_offset]);
-      const auto next_pt_azimuth =
-        *reinterpret_cast<float *>(&input_ptr->data[next_idx + azimuth_offset]);
-      float azimuth_diff = next_pt_azimuth - current_pt_azimuth;
-      azimuth_diff = azimuth_diff < 0.f ? azimuth_diff + 36000.f : azimuth_diff;
-
-      const auto current_pt_distance =
-        *reinterpret_cast<float *>(&input_ptr->data[current_idx + distance_offset]);
-      const auto next_pt_distance =
-        *reinterpret_cast<float *>(&input_ptr->data[next_idx + distance_offset]);
-
-      if (
-        std::max(current_pt_distance, next_pt_distance) <
-          std::min(current_pt_distance, next_pt_distance) * distance_ratio_ &&
-        azimuth_diff < 100.f) {
-        continue;
-      }
-      if (isCluster(input_ptr, tmp_indices)) {
-        for (const auto & tmp_idx : tmp_indices) {
-          output_modifier.push_back(
-            std::move(*reinterpret_cast<PointXYZI *>(&input_ptr->data[tmp_idx])));
+    forEachRingCluster(
+      ring_indices.second.begin(), ring_indices.second.end(), getRingOutlierParams(), point_at,
+      [&](const auto cluster_begin, const auto cluster_end) {
+        for (auto it = cluster_begin; it != cluster_end; ++it) {
+          output_modifier.push_back(*reinterpret_cast<const PointXYZI *>(&data[*it]));
         }
-      }
-      tmp_indices.clear();
-    }
-    if (tmp_indices.empty()) {
-      continue;
-    }
-    if (isCluster(input_ptr, tmp_indices)) {
-      for (const auto & tmp_idx : tmp_indices) {
-        output_modifier.push_back(
-          std::move(*reinterpret_cast<PointXYZI *>(&input_ptr->data[tmp_idx])));
-      }
-    }
-    tmp_indices.clear();
+      });
   }
+  publishProcessingTime();
+}
+
+void RingOutlierFilterComponent::publishProcessingTime()
+{
   // add processing time for debug
   if (debug_publisher_) {
     const double cyclic_time_ms = stop_watch_ptr_->toc("cyclic_time", true);
@@ -131,6 +115,68 @@ void RingOutlierFilterComponent::filter(
   }
 }
 
+void RingOutlierFilterComponent::filterRingSpans(
+  const PointCloud2ConstPtr & input, PointCloud2 & output)
+{
+  const auto ring_offset =
+    input->fields.at(static_cast<size_t>(autoware_point_types::PointIndex::Ring)).offset;
+  const auto point_step = input->point_step;
+  const auto & data = input->data;
+  const auto ring_at = [&](const std::size_t data_idx) {
+    return *reinterpret_cast<const uint16_t *>(&data[data_idx + ring_offset]);
+  };
+
+  // Bucket the points by ring with a counting sort: each ring becomes a contiguous span of
+  // ring_arena_ which keeps the scan order of the ring, whatever the order of the driver.
+  const std::size_t num_points = data.size() / point_step;
+  uint16_t max_ring = 0;
+  for (std::size_t data_idx = 0U; data_idx < data.size(); data_idx += point_step) {
+    max_ring = std::max(max_ring, ring_at(data_idx));
+  }
+  ring_offsets_.assign(static_cast<std::size_t>(max_ring) + 2, 0U);
+  for (std::size_t data_idx = 0U; data_idx < data.size(); data_idx += point_step) {
+    ++ring_offsets_[ring_at(data_idx) + 1];
+  }
+  for (std::size_t ring = 1U; ring < ring_offsets_.size(); ++ring) {
+    ring_offsets_[ring] += ring_offsets_[ring - 1];
+  }
+  ring_arena_.resize(num_points);
+  ring_write_positions_.assign(ring_offsets_.begin(), ring_offsets_.end() - 1);
+  for (std::size_t data_idx = 0U; data_idx < data.size(); data_idx += point_step) {
+    ring_arena_[ring_write_positions_[ring_at(data_idx)]++] = data_idx;
+  }
+
+  // Walk every ring independently, marking the kept points in keep_mask_ (indexed by arena slot)
+  keep_mask_.assign(num_points, uint8_t{0});
+  const auto point_at = makePointAt(*input);
+  const auto params = getRingOutlierParams();
+  const int num_rings = static_cast<int>(ring_offsets_.size()) - 1;
+#pragma omp parallel for schedule(dynamic)
+  for (int ring = 0; ring < num_rings; ++ring) {
+    const auto arena_begin = ring_arena_.cbegin();
+    forEachRingCluster(
+      arena_begin + ring_offsets_[ring], arena_begin + ring_offsets_[ring + 1], params, point_at,
+      [&](const auto cluster_begin, const auto cluster_end) {
+        std::fill(
+          keep_mask_.begin() + (cluster_begin - arena_begin),
+          keep_mask_.begin() + (cluster_end - arena_begin), uint8_t{1});
+      });
+  }
+
+  // Write the kept points ring by ring into an output sized once
+  const auto num_kept =
+    static_cast<std::size_t>(std::count(keep_mask_.begin(), keep_mask_.end(), uint8_t{1}));
+  PointCloud2Modifier<PointXYZI> output_modifier{output, input->header.frame_id};
+  output_modifier.resize(num_kept);
+  auto * output_data = output.data.data();
+  for (std::size_t idx = 0U; idx < num_points; ++idx) {
+    if (keep_mask_[idx]) {
+      std::memcpy(output_data, &data[ring_arena_[idx]], sizeof(PointXYZI));
+      output_data += output.point_step;
+    }
+  }
+}
+
 rcl_interfaces::msg::SetParametersResult RingOutlierFilterComponent::paramCallback(
   const std::vector<rclcpp::Parameter> & p)
 {
@@ -146,6 +192,9 @@ rcl_interfaces::msg::SetParametersResult RingOutlierFilterComponent::paramCallba
   if (get_param(p, "num_points_threshold", num_points_threshold_)) {
     RCLCPP_DEBUG(get_logger(), "Setting new num_points_threshold to: %d.", num_points_threshold_);
   }
+  if (get_param(p, "use_ring_spans", use_ring_spans_)) {
+    RCLCPP_DEBUG(get_logger(), "Setting new use_ring_spans to: %d.", use_ring_spans_);
+  }
 
   rcl_interfaces::msg::SetParametersResult result;
   result.successful = true;
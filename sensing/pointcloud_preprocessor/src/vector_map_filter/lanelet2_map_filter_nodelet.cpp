@@ -24,6 +24,7 @@
 #include <lanelet2_core/geometry/Polygon.h>
 #include <tf2_ros/create_timer_ros.h>
 
+#include <cstring>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -41,6 +42,13 @@ Lanelet2MapFilterComponent::Lanelet2MapFilterComponent(const rclcpp::NodeOptions
   {
     voxel_size_x_ = declare_parameter("voxel_size_x", 0.04);
     voxel_size_y_ = declare_parameter("voxel_size_y", 0.04);
+    use_raster_mask_ = declare_parameter("use_raster_mask", false);
+    if (use_raster_mask_) {
+      raster_mask_ = std::make_unique<TiledRasterMask>(
+        declare_parameter("raster_mask_resolution", 0.1),
+        static_cast<int>(declare_parameter("raster_mask_tile_cells", 256)),
+        declare_parameter("raster_mask_radius", 150.0));
+    }
   }
 
   // Set publisher
@@ -216,11 +224,92 @@ pcl::PointCloud<pcl::PointXYZ> Lanelet2MapFilterComponent::getLaneFilteredPointC
   return filtered_cloud;
 }
 
+void Lanelet2MapFilterComponent::filterWithRasterMask(const PointCloud2ConstPtr & cloud_msg)
+{
+  geometry_msgs::msg::TransformStamped transform_stamped;
+  try {
+    transform_stamped = tf_buffer_->lookupTransform(
+      "map", cloud_msg->header.frame_id, cloud_msg->header.stamp,
+      rclcpp::Duration::from_seconds(1.0));
+  } catch (tf2::TransformException & ex) {
+    RCLCPP_ERROR_STREAM_THROTTLE(
+      this->get_logger(), *this->get_clock(), std::chrono::milliseconds(10000).count(),
+      "Failed transform from "
+        << "map"
+        << " to " << cloud_msg->header.frame_id << ": " << ex.what());
+    return;
+  }
+  const Eigen::Matrix4d transform = tf2::transformToEigen(transform_stamped.transform).matrix();
+
+  // the sensor is at the origin of the input frame
+  raster_mask_->update(transform.topRightCorner<2, 1>());
+
+  int x_offset = -1;
+  int y_offset = -1;
+  int z_offset = -1;
+  for (const auto & field : cloud_msg->fields) {
+    if (field.datatype != sensor_msgs::msg::PointField::FLOAT32) {
+      continue;
+    }
+    if (field.name == "x") {
+      x_offset = static_cast<int>(field.offset);
+    } else if (field.name == "y") {
+      y_offset = static_cast<int>(field.offset);
+    } else if (field.name == "z") {
+      z_offset = static_cast<int>(field.offset);
+    }
+  }
+  if (x_offset < 0 || y_offset < 0 || z_offset < 0) {
+    RCLCPP_ERROR_THROTTLE(
+      this->get_logger(), *this->get_clock(), std::chrono::milliseconds(10000).count(),
+      "The input pointcloud does not have float32 x, y and z fields.");
+    return;
+  }
+
+  // the points are tested in the map frame, but the kept points are copied from the input as they
+  // are, so that there is no transform back and all the fields are kept
+  auto output = std::make_unique<sensor_msgs::msg::PointCloud2>();
+  output->header = cloud_msg->header;
+  output->fields = cloud_msg->fields;
+  output->is_bigendian = cloud_msg->is_bigendian;
+  output->point_step = cloud_msg->point_step;
+  output->is_dense = cloud_msg->is_dense;
+  output->data.reserve(cloud_msg->data.size());
+
+  const size_t point_step = cloud_msg->point_step;
+  const size_t num_points = static_cast<size_t>(cloud_msg->width) * cloud_msg->height;
+  for (size_t i = 0; i < num_points; ++i) {
+    const uint8_t * point = &cloud_msg->data[i * point_step];
+    float x;
+    float y;
+    float z;
+    std::memcpy(&x, point + x_offset, sizeof(float));
+    std::memcpy(&y, point + y_offset, sizeof(float));
+    std::memcpy(&z, point + z_offset, sizeof(float));
+    const double map_x =
+      transform(0, 0) * x + transform(0, 1) * y + transform(0, 2) * z + transform(0, 3);
+    const double map_y =
+      transform(1, 0) * x + transform(1, 1) * y + transform(1, 2) * z + transform(1, 3);
+    if (raster_mask_->contains(map_x, map_y)) {
+      output->data.insert(output->data.end(), point, point + point_step);
+    }
+  }
+  output->height = 1;
+  output->width = static_cast<uint32_t>(output->data.size() / point_step);
+  output->row_step = static_cast<uint32_t>(output->data.size());
+
+  filtered_pointcloud_pub_->publish(std::move(output));
+}
+
 void Lanelet2MapFilterComponent::pointcloudCallback(const PointCloud2ConstPtr cloud_msg)
 {
   if (!lanelet_map_ptr_) {
     return;
   }
+  if (use_raster_mask_) {
+    filterWithRasterMask(cloud_msg);
+    return;
+  }
   // transform pointcloud to map frame
   PointCloud2Ptr input_transformed_cloud_ptr(new sensor_msgs::msg::PointCloud2);
   if (!transformPointCloud("map", cloud_msg, input_transformed_cloud_ptr.get())) {
@@ -265,6 +354,16 @@ void Lanelet2MapFilterComponent::mapCallback(
   lanelet::utils::conversion::fromBinMsg(*map_msg, lanelet_map_ptr_);
   const lanelet::ConstLanelets all_lanelets = lanelet::utils::query::laneletLayer(lanelet_map_ptr_);
   road_lanelets_ = lanelet::utils::query::roadLanelets(all_lanelets);
+
+  if (use_raster_mask_) {
+    std::vector<TiledRasterMask::Polygon> polygons;
+    polygons.reserve(road_lanelets_.size());
+    for (const auto & road_lanelet : road_lanelets_) {
+      const auto polygon = road_lanelet.polygon2d().basicPolygon();
+      polygons.emplace_back(polygon.begin(), polygon.end());
+    }
+    raster_mask_->setPolygons(std::move(polygons));
+  }
 }
 
 }  // namespace pointcloud_preprocessor
@@ -0,0 +1,182 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/vector_map_filter/raster_mask.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace pointcloud_preprocessor
+{
+TiledRasterMask::TiledRasterMask(const double resolution, const int tile_cells, const double radius)
+: resolution_(resolution),
+  inverse_resolution_(1.0 / resolution),
+  tile_cells_((std::max(tile_cells, 1) + 63) / 64 * 64),
+  radius_(radius)
+{
+}
+
+void TiledRasterMask::setPolygons(std::vector<Polygon> polygons)
+{
+  polygons_ = std::move(polygons);
+  bounding_boxes_.clear();
+  bounding_boxes_.reserve(polygons_.size());
+  for (const auto & polygon : polygons_) {
+    BoundingBox bounding_box{
+      Eigen::Vector2d::Constant(std::numeric_limits<double>::max()),
+      Eigen::Vector2d::Constant(std::numeric_limits<double>::lowest())};
+    for (const auto & vertex : polygon) {
+      bounding_box.min = bounding_box.min.cwiseMin(vertex);
+      bounding_box.max = bounding_box.max.cwiseMax(vertex);
+    }
+    bounding_boxes_.push_back(bounding_box);
+  }
+
+  window_.clear();
+  window_size_ = 0;
+}
+
+size_t TiledRasterMask::update(const Eigen::Vector2d & center)
+{
+  const double tile_size = static_cast<double>(tile_cells_) * resolution_;
+  const auto min_tile_x = static_cast<int64_t>(std::floor((center.x() - radius_) / tile_size));
+  const auto min_tile_y = static_cast<int64_t>(std::floor((center.y() - radius_) / tile_size));
+  const auto max_tile_x = static_cast<int64_t>(std::floor((center.x() + radius_) / tile_size));
+  const auto max_tile_y = static_cast<int64_t>(std::floor((center.y() + radius_) / tile_size));
+  const int64_t window_size = std::max(max_tile_x - min_tile_x, max_tile_y - min_tile_y) + 1;
+  if (
+    window_size == window_size_ && min_tile_x == window_min_tile_x_ &&
+    min_tile_y == window_min_tile_y_) {
+    return 0;
+  }
+
+  std::vector<Tile> window(window_size * window_size);
+  std::vector<size_t> new_tiles;
+  for (int64_t window_y = 0; window_y < window_size; ++window_y) {
+    for (int64_t window_x = 0; window_x < window_size; ++window_x) {
+      auto & tile = window[window_y * window_size + window_x];
+      tile.x = min_tile_x + window_x;
+      tile.y = min_tile_y + window_y;
+
+      // keep the tile if it is already rasterized
+      const int64_t old_window_x = tile.x - window_min_tile_x_;
+      const int64_t old_window_y = tile.y - window_min_tile_y_;
+      if (
+        old_window_x >= 0 && old_window_y >= 0 && old_window_x < window_size_ &&
+        old_window_y < window_size_) {
+        tile = std::move(window_[old_window_y * window_size_ + old_window_x]);
+        continue;
+      }
+      new_tiles.push_back(window_y * window_size + window_x);
+    }
+  }
+
+  const int num_new_tiles = static_cast<int>(new_tiles.size());
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < num_new_tiles; ++i) {
+    rasterizeTile(window[new_tiles[i]]);
+  }
+
+  window_ = std::move(window);
+  window_min_tile_x_ = min_tile_x;
+  window_min_tile_y_ = min_tile_y;
+  window_size_ = window_size;
+  return new_tiles.size();
+}
+
+bool TiledRasterMask::polygonsContain(const double x, const double y) const
+{
+  for (size_t polygon_idx = 0; polygon_idx < polygons_.size(); ++polygon_idx) {
+    const auto & bounding_box = bounding_boxes_[polygon_idx];
+    if (
+      x < bounding_box.min.x() || x > bounding_box.max.x() || y < bounding_box.min.y() ||
+      y > bounding_box.max.y()) {
+      continue;
+    }
+
+    // the same crossings as the scanline fill, counted on the left of the point
+    const auto & polygon = polygons_[polygon_idx];
+    bool inside = false;
+    for (size_t i = 0; i < polygon.size(); ++i) {
+      const auto & a = polygon[i];
+      const auto & b = polygon[(i + 1) % polygon.size()];
+      if (
+        (a.y() > y) != (b.y() > y) &&
+        a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()) < x) {
+        inside = !inside;
+      }
+    }
+    if (inside) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TiledRasterMask::rasterizeTile(Tile & tile) const
+{
+  const double tile_size = static_cast<double>(tile_cells_) * resolution_;
+  const Eigen::Vector2d tile_min(
+    static_cast<double>(tile.x) * tile_size, static_cast<double>(tile.y) * tile_size);
+  const Eigen::Vector2d tile_max = tile_min + Eigen::Vector2d::Constant(tile_size);
+  const int64_t words_per_row = tile_cells_ / 64;
+
+  tile.bits.clear();
+  std::vector<double> crossings;
+  for (size_t polygon_idx = 0; polygon_idx < polygons_.size(); ++polygon_idx) {
+    const auto & bounding_box = bounding_boxes_[polygon_idx];
+    if (
+      bounding_box.max.x() < tile_min.x() || bounding_box.min.x() > tile_max.x() ||
+      bounding_box.max.y() < tile_min.y() || bounding_box.min.y() > tile_max.y()) {
+      continue;
+    }
+    if (tile.bits.empty()) {
+      tile.bits.assign(tile_cells_ * words_per_row, 0);
+    }
+
+    // even-odd scanline fill of the cell centers of every row
+    const auto & polygon = polygons_[polygon_idx];
+    for (int64_t row = 0; row < tile_cells_; ++row) {
+      const double y = tile_min.y() + (static_cast<double>(row) + 0.5) * resolution_;
+      if (y < bounding_box.min.y() || y > bounding_box.max.y()) {
+        continue;
+      }
+
+      crossings.clear();
+      for (size_t i = 0; i < polygon.size(); ++i) {
+        const auto & a = polygon[i];
+        const auto & b = polygon[(i + 1) % polygon.size()];
+        if ((a.y() > y) != (b.y() > y)) {
+          crossings.push_back(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+        }
+      }
+      std::sort(crossings.begin(), crossings.end());
+
+      uint64_t * row_bits = tile.bits.data() + row * words_per_row;
+      for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+        // the cells whose center is between the two crossings
+        const double first = (crossings[i] - tile_min.x()) * inverse_resolution_ - 0.5;
+        const double last = (crossings[i + 1] - tile_min.x()) * inverse_resolution_ - 0.5;
+        const auto begin = std::max<int64_t>(static_cast<int64_t>(std::ceil(first)), 0);
+        const auto end = std::min<int64_t>(static_cast<int64_t>(std::floor(last)), tile_cells_ - 1);
+        for (int64_t column = begin; column <= end; ++column) {
+          row_bits[column >> 6] |= uint64_t{1} << (column & 63);
+        }
+      }
+    }
+  }
+}
+}  // namespace pointcloud_preprocessor
@@ -0,0 +1,199 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware_point_types/types.hpp"
+#include "pointcloud_preprocessor/concatenate_data/zero_copy_concatenator.hpp"
+
+#include <pcl_ros/transforms.hpp>
+#include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
+#include <tier4_autoware_utils/system/stop_watch.hpp>
+
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <Eigen/Geometry>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Bytes allocated with operator new, which allocates the data of the point clouds, so that the
+// buffers written by each mode are measured rather than assumed
+std::atomic<size_t> allocated_bytes{0};
+}  // namespace
+
+void * operator new(std::size_t size)
+{
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void * ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+using autoware_point_types::PointXYZI;
+using autoware_point_types::PointXYZIRADRT;
+using autoware_point_types::PointXYZIRADRTGenerator;
+using sensor_msgs::msg::PointCloud2;
+
+PointCloud2::SharedPtr makeCloud(const size_t num_points, std::default_random_engine & engine)
+{
+  std::uniform_real_distribution<float> dist(-50.0f, 50.0f);
+  auto cloud = std::make_shared<PointCloud2>();
+  point_cloud_msg_wrapper::PointCloud2Modifier<PointXYZIRADRT, PointXYZIRADRTGenerator> modifier{
+    *cloud, "sensor"};
+  modifier.reserve(num_points);
+  for (size_t i = 0; i < num_points; ++i) {
+    PointXYZIRADRT point;
+    point.x = dist(engine);
+    point.y = dist(engine);
+    point.z = dist(engine) * 0.05f;
+    point.intensity = 10.0f;
+    point.ring = static_cast<uint16_t>(i % 128);
+    modifier.push_back(std::move(point));
+  }
+  return cloud;
+}
+
+// Same conversion as PointCloudConcatenateDataSynchronizerComponent::convertToXYZICloud
+void convertToXYZICloud(const PointCloud2::SharedPtr & input_ptr, PointCloud2::SharedPtr & output)
+{
+  output->header = input_ptr->header;
+  point_cloud_msg_wrapper::PointCloud2Modifier<PointXYZI> output_modifier{
+    *output, input_ptr->header.frame_id};
+  output_modifier.reserve(input_ptr->width);
+  sensor_msgs::PointCloud2Iterator<float> it_x(*input_ptr, "x");
+  sensor_msgs::PointCloud2Iterator<float> it_y(*input_ptr, "y");
+  sensor_msgs::PointCloud2Iterator<float> it_z(*input_ptr, "z");
+  sensor_msgs::PointCloud2Iterator<float> it_i(*input_ptr, "intensity");
+  for (; it_x != it_x.end(); ++it_x, ++it_y, ++it_z, ++it_i) {
+    PointXYZI point;
+    point.x = *it_x;
+    point.y = *it_y;
+    point.z = *it_z;
+    point.intensity = *it_i;
+    output_modifier.push_back(std::move(point));
+  }
+}
+
+// Reproduces the processing of cloud_callback() and publish() in the pairwise mode
+std::unique_ptr<PointCloud2> concatenatePairwise(
+  const std::vector<PointCloud2::SharedPtr> & inputs, const Eigen::Matrix4f & transform)
+{
+  PointCloud2::SharedPtr concat_cloud_ptr = nullptr;
+  for (const auto & input_ptr : inputs) {
+    auto input = std::make_shared<PointCloud2>(*input_ptr);
+    auto xyzi_input_ptr = std::make_shared<PointCloud2>();
+    convertToXYZICloud(input, xyzi_input_ptr);
+    auto transformed_cloud_ptr = std::make_shared<PointCloud2>();
+    pcl_ros::transformPointCloud(transform, *xyzi_input_ptr, *transformed_cloud_ptr);
+    if (concat_cloud_ptr == nullptr) {
+      concat_cloud_ptr = transformed_cloud_ptr;
+    } else {
+      auto motion_compensated_ptr = std::make_shared<PointCloud2>();
+      pcl_ros::transformPointCloud(transform, *transformed_cloud_ptr, *motion_compensated_ptr);
+      auto combined_ptr = std::make_shared<PointCloud2>();
+      pcl::concatenatePointCloud(*concat_cloud_ptr, *motion_compensated_ptr, *combined_ptr);
+      concat_cloud_ptr = combined_ptr;
+    }
+  }
+  return std::make_unique<PointCloud2>(*concat_cloud_ptr);
+}
+
+std::unique_ptr<PointCloud2> concatenateZeroCopy(
+  const std::vector<PointCloud2::SharedPtr> & inputs, const Eigen::Matrix4f & transform)
+{
+  std::vector<pointcloud_preprocessor::ConcatenateSource> sources;
+  for (const auto & input_ptr : inputs) {
+    pointcloud_preprocessor::ConcatenateSource source;
+    source.cloud = input_ptr;
+    source.transform = transform * transform;
+    sources.push_back(std::move(source));
+  }
+  return pointcloud_preprocessor::concatenateXYZI(sources, "base_link");
+}
+}  // namespace
+
+int main()
+{
+  constexpr auto nb_iterations = 20;
+  constexpr size_t points_per_lidar = 60000;
+  std::default_random_engine engine(0);
+  tier4_autoware_utils::StopWatch<std::chrono::milliseconds> stopwatch;
+
+  const Eigen::Affine3f transform =
+    Eigen::Translation3f(1.0f, 0.5f, 2.0f) * Eigen::AngleAxisf(0.3f, Eigen::Vector3f::UnitZ());
+
+  // the allocated memory is given per frame, in units of the size of all the input clouds
+  std::cout << "#LiDARs PointsPerLiDAR pairwise_allocated pairwise_ms zero_copy_allocated "
+               "zero_copy_ms"
+            << std::endl;
+  for (size_t nb_lidars = 2; nb_lidars <= 6; ++nb_lidars) {
+    std::vector<PointCloud2::SharedPtr> inputs;
+    for (size_t i = 0; i < nb_lidars; ++i) {
+      inputs.push_back(makeCloud(points_per_lidar, engine));
+    }
+
+    size_t input_bytes = 0;
+    for (const auto & input : inputs) {
+      input_bytes += input->data.size();
+    }
+
+    size_t pairwise_bytes = 0;
+    size_t zero_copy_bytes = 0;
+    double pairwise_duration{};
+    double zero_copy_duration{};
+    for (auto iteration = 0; iteration < nb_iterations; ++iteration) {
+      size_t allocated_bytes_before = allocated_bytes.load();
+      stopwatch.tic("pairwise");
+      const auto pairwise_output = concatenatePairwise(inputs, transform.matrix());
+      pairwise_duration += stopwatch.toc("pairwise");
+      pairwise_bytes += allocated_bytes.load() - allocated_bytes_before;
+
+      allocated_bytes_before = allocated_bytes.load();
+      stopwatch.tic("zero_copy");
+      const auto zero_copy_output = concatenateZeroCopy(inputs, transform.matrix());
+      zero_copy_duration += stopwatch.toc("zero_copy");
+      zero_copy_bytes += allocated_bytes.load() - allocated_bytes_before;
+
+      if (pairwise_output->data.size() != zero_copy_output->data.size()) {
+        std::cerr << "Output sizes differ: " << pairwise_output->data.size() << " vs "
+                  << zero_copy_output->data.size() << std::endl;
+        return 1;
+      }
+    }
+
+    const double frame_bytes = static_cast<double>(input_bytes) * nb_iterations;
+    std::cout << nb_lidars << " " << points_per_lidar << " "
+              << static_cast<double>(pairwise_bytes) / frame_bytes << " "
+              << pairwise_duration / nb_iterations << " "
+              << static_cast<double>(zero_copy_bytes) / frame_bytes << " "
+              << zero_copy_duration / nb_iterations << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware_point_types/types.hpp"
+#include "pointcloud_preprocessor/downsample_filter/radix_voxel_grid.hpp"
+
+#include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
+#include <tier4_autoware_utils/system/stop_watch.hpp>
+
+#include <pcl/filters/voxel_grid.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+
+namespace
+{
+using autoware_point_types::PointXYZI;
+using sensor_msgs::msg::PointCloud2;
+
+// Points on a ground plane and on a few walls, roughly as dense as a concatenated cloud
+PointCloud2 makeCloud(const size_t num_points, std::default_random_engine & engine)
+{
+  std::uniform_real_distribution<float> horizontal(-80.0f, 80.0f);
+  std::uniform_real_distribution<float> vertical(0.0f, 3.0f);
+  std::normal_distribution<float> noise(0.0f, 0.02f);
+  PointCloud2 cloud;
+  point_cloud_msg_wrapper::PointCloud2Modifier<PointXYZI> modifier{cloud, "base_link"};
+  modifier.reserve(num_points);
+  for (size_t i = 0; i < num_points; ++i) {
+    PointXYZI point;
+    point.x = horizontal(engine);
+    point.y = horizontal(engine);
+    point.z = i % 4 == 0 ? vertical(engine) : noise(engine);
+    if (i % 4 == 0) {
+      point.y = static_cast<float>(static_cast<int>(point.y / 20.0f)) * 20.0f + noise(engine);
+    }
+    point.intensity = static_cast<float>(i % 256);
+    modifier.push_back(std::move(point));
+  }
+  return cloud;
+}
+
+// Same as VoxelGridDownsampleFilterComponent::filter without use_radix_voxel_grid
+PointCloud2 filterPcl(const PointCloud2 & input)
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr pcl_input(new pcl::PointCloud<pcl::PointXYZ>);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr pcl_output(new pcl::PointCloud<pcl::PointXYZ>);
+  pcl::fromROSMsg(input, *pcl_input);
+  pcl_output->points.reserve(pcl_input->points.size());
+  pcl::VoxelGrid<pcl::PointXYZ> filter;
+  filter.setInputCloud(pcl_input);
+  filter.setLeafSize(0.3f, 0.3f, 0.1f);
+  filter.filter(*pcl_output);
+  PointCloud2 output;
+  pcl::toROSMsg(*pcl_output, output);
+  return output;
+}
+}  // namespace
+
+int main()
+{
+  constexpr auto nb_iterations = 20;
+  std::default_random_engine engine(0);
+  tier4_autoware_utils::StopWatch<std::chrono::milliseconds> stopwatch;
+
+  pointcloud_preprocessor::RadixVoxelGrid radix_voxel_grid;
+  radix_voxel_grid.setLeafSize(0.3f, 0.3f, 0.1f);
+
+  std::cout << "#Points pcl_voxels pcl_ms centroid_voxels centroid_ms first_point_ms "
+               "nearest_centroid_ms"
+            << std::endl;
+  for (size_t num_points = 100000; num_points <= 500000; num_points += 100000) {
+    const auto input = makeCloud(num_points, engine);
+
+    PointCloud2 pcl_output;
+    stopwatch.tic("pcl");
+    for (auto iteration = 0; iteration < nb_iterations; ++iteration) {
+      pcl_output = filterPcl(input);
+    }
+    const double pcl_duration = stopwatch.toc("pcl") / nb_iterations;
+
+    double durations[3]{};
+    PointCloud2 centroid_output;
+    const pointcloud_preprocessor::VoxelRepresentative representatives[3] = {
+      pointcloud_preprocessor::VoxelRepresentative::Centroid,
+      pointcloud_preprocessor::VoxelRepresentative::FirstPoint,
+      pointcloud_preprocessor::VoxelRepresentative::NearestCentroid};
+    for (size_t r = 0; r < 3; ++r) {
+      radix_voxel_grid.setRepresentative(representatives[r]);
+      PointCloud2 output;
+      stopwatch.tic("radix");
+      for (auto iteration = 0; iteration < nb_iterations; ++iteration) {
+        radix_voxel_grid.filter(input, output);
+      }
+      durations[r] = stopwatch.toc("radix") / nb_iterations;
+      if (r == 0) {
+        centroid_output = std::move(output);
+      }
+    }
+
+    if (pcl_output.width != centroid_output.width) {
+      std::cerr << "Voxel counts differ: " << pcl_output.width << " vs " << centroid_output.width
+                << std::endl;
+      return 1;
+    }
+
+    std::cout << num_points << " " << pcl_output.width << " " << pcl_duration << " "
+              << centroid_output.width << " " << durations[0] << " " << durations[1] << " "
+              << durations[2] << std::endl;
+  }
+  return 0;
+}
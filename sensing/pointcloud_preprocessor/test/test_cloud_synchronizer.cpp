@@ -0,0 +1,101 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/concatenate_data/cloud_synchronizer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using pointcloud_preprocessor::CloudSynchronizer;
+using sensor_msgs::msg::PointCloud2;
+
+namespace
+{
+CloudSynchronizer::PointCloud2ConstPtr makeCloud()
+{
+  return std::make_shared<const PointCloud2>();
+}
+}  // namespace
+
+TEST(CloudSynchronizer, ClosesCompleteFrame)
+{
+  CloudSynchronizer synchronizer(3, 10.0, 0.01);
+  const auto cloud0 = makeCloud();
+  const auto cloud1 = makeCloud();
+  const auto cloud2 = makeCloud();
+
+  synchronizer.push(2, cloud2);
+  synchronizer.push(0, cloud0);
+  EXPECT_TRUE(synchronizer.takeFrames().empty());
+  EXPECT_TRUE(synchronizer.getTimeToDeadline().has_value());
+
+  synchronizer.push(1, cloud1);
+  const auto frames = synchronizer.takeFrames();
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(frames.front(), CloudSynchronizer::Frame({cloud0, cloud1, cloud2}));
+  EXPECT_FALSE(synchronizer.getTimeToDeadline().has_value());
+  EXPECT_TRUE(synchronizer.takeFrames().empty());
+}
+
+TEST(CloudSynchronizer, StartsNextFrameWhenSensorDeliversTwice)
+{
+  CloudSynchronizer synchronizer(2, 10.0, 0.01);
+  const auto older_cloud = makeCloud();
+  const auto newer_cloud = makeCloud();
+  const auto other_cloud = makeCloud();
+
+  // the current frame is closed with the older cloud, long before the timeout
+  synchronizer.push(0, older_cloud);
+  synchronizer.push(0, newer_cloud);
+  auto frames = synchronizer.takeFrames();
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(frames.front(), CloudSynchronizer::Frame({older_cloud, nullptr}));
+
+  // and the newer cloud is in the next frame
+  EXPECT_TRUE(synchronizer.getTimeToDeadline().has_value());
+  synchronizer.push(1, other_cloud);
+  frames = synchronizer.takeFrames();
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(frames.front(), CloudSynchronizer::Frame({newer_cloud, other_cloud}));
+
+  const auto statistics = synchronizer.getStatistics();
+  EXPECT_EQ(statistics.at(0).received, 2U);
+  EXPECT_EQ(statistics.at(0).repeated, 1U);
+  EXPECT_EQ(statistics.at(0).missed, 0U);
+  EXPECT_EQ(statistics.at(1).received, 1U);
+  EXPECT_EQ(statistics.at(1).repeated, 0U);
+  EXPECT_EQ(statistics.at(1).missed, 1U);
+}
+
+TEST(CloudSynchronizer, ClosesFrameAtTimeout)
+{
+  CloudSynchronizer synchronizer(2, 0.02, 0.01);
+  const auto cloud = makeCloud();
+
+  synchronizer.push(1, cloud);
+  EXPECT_TRUE(synchronizer.takeFrames().empty());
+  const auto time_to_deadline = synchronizer.getTimeToDeadline();
+  ASSERT_TRUE(time_to_deadline.has_value());
+  EXPECT_LE(*time_to_deadline, std::chrono::milliseconds(20));
+
+  std::this_thread::sleep_for(*time_to_deadline);
+  const auto frames = synchronizer.takeFrames();
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(frames.front(), CloudSynchronizer::Frame({nullptr, cloud}));
+  EXPECT_FALSE(synchronizer.getTimeToDeadline().has_value());
+  EXPECT_EQ(synchronizer.getStatistics().at(0).missed, 1U);
+}
@@ -0,0 +1,172 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pointcloud_preprocessor/vector_map_filter/raster_mask.hpp"
+
+#include <boost/geometry.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using pointcloud_preprocessor::TiledRasterMask;
+
+namespace
+{
+namespace bg = boost::geometry;
+using Point2d = bg::model::d2::point_xy<double>;
+using Polygon2d = bg::model::polygon<Point2d, true, false>;
+using LineString2d = bg::model::linestring<Point2d>;
+
+// cells of 0.1 m, tiles of 6.4 m, and a window from -25.6 m to 25.6 m around the origin
+constexpr double resolution = 0.1;
+constexpr int tile_cells = 64;
+constexpr double radius = 20.0;
+constexpr double window_edge = 25.6;
+
+// a long straight lane along x, a rotated lane and a concave crossing, as open polygons like the
+// lanelets
+const std::vector<TiledRasterMask::Polygon> polygons = {
+  {{-60.0, -2.0}, {60.0, -2.0}, {60.0, 2.0}, {-60.0, 2.0}},
+  {{-3.0, -40.0}, {3.0, -40.0}, {13.0, 40.0}, {7.0, 40.0}},
+  {{-20.0, 10.0}, {-10.0, 10.0}, {-10.0, 20.0}, {-15.0, 15.0}, {-20.0, 20.0}}};
+
+// the polygon test of the default mode of the filter
+struct PolygonReference
+{
+  std::vector<Polygon2d> polygons;
+  std::vector<LineString2d> boundaries;
+
+  explicit PolygonReference(const std::vector<TiledRasterMask::Polygon> & input)
+  {
+    for (const auto & vertices : input) {
+      Polygon2d polygon;
+      LineString2d boundary;
+      for (const auto & vertex : vertices) {
+        bg::append(polygon.outer(), Point2d(vertex.x(), vertex.y()));
+        bg::append(boundary, Point2d(vertex.x(), vertex.y()));
+      }
+      bg::append(boundary, Point2d(vertices.front().x(), vertices.front().y()));
+      bg::correct(polygon);
+      polygons.push_back(polygon);
+      boundaries.push_back(boundary);
+    }
+  }
+
+  bool within(const double x, const double y) const
+  {
+    for (const auto & polygon : polygons) {
+      if (bg::within(Point2d(x, y), polygon)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  double distanceToBoundary(const double x, const double y) const
+  {
+    double distance = std::numeric_limits<double>::max();
+    for (const auto & boundary : boundaries) {
+      distance = std::min(distance, bg::distance(Point2d(x, y), boundary));
+    }
+    return distance;
+  }
+};
+
+// compare the mask with the polygons on a grid which is not aligned with the cells, where the mask
+// may differ only within half a cell diagonal of the boundaries
+void expectMatchesPolygons(const TiledRasterMask & mask, const PolygonReference & reference)
+{
+  const double tolerance = resolution * std::sqrt(0.5) + 1e-6;
+  for (double y = -50.0; y < 50.0; y += 0.37) {
+    for (double x = -50.0; x < 50.0; x += 0.37) {
+      if (reference.distanceToBoundary(x, y) <= tolerance) {
+        continue;
+      }
+      EXPECT_EQ(mask.contains(x, y), reference.within(x, y)) << "at (" << x << ", " << y << ")";
+    }
+  }
+}
+}  // namespace
+
+TEST(TiledRasterMask, MatchesPolygons)
+{
+  const PolygonReference reference(polygons);
+  TiledRasterMask mask(resolution, tile_cells, radius);
+  mask.setPolygons(polygons);
+
+  // before the first update, every point is tested against the polygons
+  expectMatchesPolygons(mask, reference);
+
+  EXPECT_EQ(mask.update(Eigen::Vector2d::Zero()), 64U);
+  expectMatchesPolygons(mask, reference);
+
+  // the tiles still in range are kept
+  EXPECT_EQ(mask.update(Eigen::Vector2d(7.0, 0.0)), 8U);
+  expectMatchesPolygons(mask, reference);
+}
+
+TEST(TiledRasterMask, FallsBackToPolygonsOutsideWindow)
+{
+  TiledRasterMask mask(resolution, tile_cells, radius);
+  mask.setPolygons(polygons);
+  mask.update(Eigen::Vector2d::Zero());
+
+  // on both sides of the window edges, on the straight lane and beside it
+  for (const double x : {window_edge - 0.05, window_edge + 0.05, 40.0, 59.95}) {
+    EXPECT_TRUE(mask.contains(x, 0.0)) << "at x = " << x;
+    EXPECT_TRUE(mask.contains(-x, 1.95)) << "at x = " << -x;
+    EXPECT_FALSE(mask.contains(x, 2.5)) << "at x = " << x;
+    EXPECT_FALSE(mask.contains(-x, -2.5)) << "at x = " << -x;
+  }
+  EXPECT_FALSE(mask.contains(60.05, 0.0));
+  EXPECT_FALSE(mask.contains(-60.05, 0.0));
+
+  // the window is exact up to half a cell, the polygons beyond it are exact
+  EXPECT_TRUE(mask.contains(0.0, -1.99));
+  EXPECT_FALSE(mask.contains(window_edge + 0.05, -2.01));
+  EXPECT_TRUE(mask.contains(window_edge + 0.05, -1.99));
+
+  // the concave part of the crossing
+  EXPECT_TRUE(mask.contains(-18.0, 17.0));
+  EXPECT_FALSE(mask.contains(-15.0, 17.0));
+  mask.update(Eigen::Vector2d(100.0, 100.0));
+  EXPECT_TRUE(mask.contains(-18.0, 17.0));
+  EXPECT_FALSE(mask.contains(-15.0, 17.0));
+}
+
+TEST(TiledRasterMask, RejectsNonFinitePoints)
+{
+  constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+  constexpr double inf = std::numeric_limits<double>::infinity();
+
+  TiledRasterMask mask(resolution, tile_cells, radius);
+  mask.setPolygons(polygons);
+  // inside and outside the window
+  for (const auto & center : {Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(1000.0, 0.0)}) {
+    mask.update(center);
+    EXPECT_FALSE(mask.contains(nan, 0.0));
+    EXPECT_FALSE(mask.contains(0.0, nan));
+    EXPECT_FALSE(mask.contains(inf, 0.0));
+    EXPECT_FALSE(mask.contains(-inf, 0.0));
+    EXPECT_FALSE(mask.contains(0.0, inf));
+    EXPECT_FALSE(mask.contains(0.0, -inf));
+    EXPECT_FALSE(mask.polygonsContain(nan, 0.0));
+    EXPECT_FALSE(mask.polygonsContain(0.0, nan));
+    EXPECT_FALSE(mask.polygonsContain(inf, 0.0));
+    EXPECT_FALSE(mask.polygonsContain(0.0, -inf));
+  }
+}